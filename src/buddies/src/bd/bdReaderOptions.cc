@@ -37,6 +37,7 @@ GenericReaderOptions::GenericReaderOptions ()
 
   m_common_enable_text_objects = load_options.get_option_by_name ("text_enabled").to_bool ();
   m_common_enable_properties = load_options.get_option_by_name ("properties_enabled").to_bool ();
+  m_common_threads = load_options.get_option_by_name ("gds2_threads").to_uint ();
 
   m_gds2_box_mode = load_options.get_option_by_name ("gds2_box_mode").to_uint ();
   m_gds2_allow_big_records = load_options.get_option_by_name ("gds2_allow_big_records").to_bool ();
@@ -175,6 +176,12 @@ GenericReaderOptions::add_options (tl::CommandLineOptions &cmd)
                     "#!--" + m_long_prefix + "no-properties", &m_common_enable_properties, "Skips properties",
                     "With this option set, properties won't be read."
                    )
+        << tl::arg (group +
+                    "#--" + m_long_prefix + "threads=threads", &m_common_threads, "Specifies the number of threads to use for reading",
+                    "With a value other than 0 (the default), the GDS2 cell bodies are decoded and the OASIS "
+                    "compressed blocks are inflated in the given number of worker threads. The result is identical "
+                    "to that of the single-threaded reader."
+                   )
       ;
   }
 
@@ -631,9 +638,11 @@ GenericReaderOptions::configure (db::LoadLayoutOptions &load_options) const
   load_options.set_option_by_name ("gds2_box_mode", m_gds2_box_mode);
   load_options.set_option_by_name ("gds2_allow_big_records", m_gds2_allow_big_records);
   load_options.set_option_by_name ("gds2_allow_multi_xy_records", m_gds2_allow_multi_xy_records);
+  load_options.set_option_by_name ("gds2_threads", m_common_threads);
 
   load_options.set_option_by_name ("oasis_read_all_properties", m_oasis_read_all_properties);
   load_options.set_option_by_name ("oasis_expect_strict_mode", m_oasis_expect_strict_mode ? 1 : 0);
+  load_options.set_option_by_name ("oasis_threads", m_common_threads);
 
   load_options.set_option_by_name ("cif_layer_map", tl::Variant::make_variant (m_layer_map));
   load_options.set_option_by_name ("cif_create_other_layers", m_create_other_layers);
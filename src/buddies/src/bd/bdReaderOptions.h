@@ -105,6 +105,7 @@ private:
   //  common GDS2+OASIS
   bool m_common_enable_text_objects;
   bool m_common_enable_properties;
+  unsigned int m_common_threads;
 
   //  GDS2
   unsigned int m_gds2_box_mode;
@@ -51,6 +51,7 @@ GenericWriterOptions::GenericWriterOptions ()
     m_oasis_permissive (false),
     m_oasis_write_std_properties (1),
     m_oasis_subst_char ("*"),
+    m_oasis_threads (0),
     m_cif_dummy_calls (false),
     m_cif_blank_separator (false),
     m_magic_lambda (1.0),
@@ -229,6 +230,11 @@ GenericWriterOptions::add_options (tl::CommandLineOptions &cmd, const std::strin
                     "The first character of the string specified with this option will be used in placed of illegal "
                     "characters in n-strings and a-strings."
                    )
+        << tl::arg (group +
+                    "#--write-threads=threads", &m_oasis_threads, "Specifies the number of threads to use for writing",
+                    "With a value other than 0 (the default), the cell bodies are produced and CBLOCK-compressed in "
+                    "the given number of worker threads. The file is identical to the one written by the single-threaded writer."
+                   )
       ;
 
   }
@@ -364,6 +370,7 @@ GenericWriterOptions::configure (db::SaveLayoutOptions &save_options, const db::
   //  Note: "..._ext" is a version taking the real value (not just a boolean)
   save_options.set_option_by_name ("oasis_write_std_properties_ext", m_oasis_write_std_properties);
   save_options.set_option_by_name ("oasis_substitution_char", m_oasis_subst_char);
+  save_options.set_option_by_name ("oasis_threads", m_oasis_threads);
 
   save_options.set_option_by_name ("cif_dummy_calls", m_cif_dummy_calls);
   save_options.set_option_by_name ("cif_blank_separator", m_cif_blank_separator);
@@ -130,6 +130,7 @@ private:
   bool m_oasis_permissive;
   int m_oasis_write_std_properties;
   std::string m_oasis_subst_char;
+  unsigned int m_oasis_threads;
 
   bool m_cif_dummy_calls;
   bool m_cif_blank_separator;
@@ -79,7 +79,7 @@ private:
 struct ResultDescriptor
 {
   ResultDescriptor ()
-    : shape_count (0), layer_a (-1), layer_b (-1), layer_output (-1), layout (0), top_cell (0)
+    : shape_count (0), layer_a (-1), layer_b (-1), layer_output (-1), layout (0), top_cell (0), output_stream (0)
   {
     //  .. nothing yet ..
   }
@@ -90,10 +90,13 @@ struct ResultDescriptor
   int layer_output;
   db::Layout *layout;
   db::cell_index_type top_cell;
+  db::TileOutputStreamWriter *output_stream;
 
   size_t count () const
   {
-    if (layout && layer_output >= 0) {
+    if (output_stream && layer_output >= 0) {
+      return output_stream->shape_count (layer_output);
+    } else if (layout && layer_output >= 0) {
       size_t res = 0;
       for (db::Layout::const_iterator c = layout->begin (); c != layout->end (); ++c) {
         res += c->shapes (layer_output).size ();
@@ -106,7 +109,9 @@ struct ResultDescriptor
 
   bool is_empty () const
   {
-    if (layout && layer_output >= 0) {
+    if (output_stream && layer_output >= 0) {
+      return output_stream->shape_count (layer_output) == 0;
+    } else if (layout && layer_output >= 0) {
       for (db::Layout::const_iterator c = layout->begin (); c != layout->end (); ++c) {
         if (! c->shapes (layer_output).empty ()) {
           return false;
@@ -126,7 +131,7 @@ struct XORData
       tolerance_bump (0),
       dont_summarize_missing_layers (false), silent (false), no_summary (false),
       threads (0),
-      tile_size (0.0), output_layout (0), output_cell (0)
+      tile_size (0.0), output_layout (0), output_cell (0), output_stream (0)
   { }
 
   db::Layout *layout_a, *layout_b;
@@ -140,6 +145,7 @@ struct XORData
   double tile_size;
   db::Layout *output_layout;
   db::cell_index_type output_cell;
+  db::TileOutputStreamWriter *output_stream;
   std::map<db::LayerProperties, std::pair<int, int>, db::LPLogicalLessFunc> l2l_map;
   std::map<std::pair<int, db::LayerProperties>, ResultDescriptor> *results;
 };
@@ -216,7 +222,11 @@ BD_PUBLIC int strmxor (int argc, char *argv[])
                  )
       << tl::arg ("-p|--tiles=size",           &tile_size, "Specifies tiling mode",
                   "In tiling mode, the layout is divided into tiles of the given size. Each tile is computed "
-                  "individually. Multiple tiles can be processed in parallel on multiple cores."
+                  "individually. Multiple tiles can be processed in parallel on multiple cores. In tiling mode, "
+                  "the number given with '-n' specifies the number of worker processes to use (on Windows: threads). "
+                  "If the output is written in GDS2 format, the differences are written while the tiles are computed "
+                  "and don't need to be kept in memory. In this case, the differences are written in several cells "
+                  "below the top cell."
                  )
       << tl::arg ("-b|--layer-bump=offset",    &tolerance_bump, "Specifies the layer number offset to add for every tolerance",
                   "This value is the number added to the original layer number to form a layer set for each tolerance "
@@ -311,9 +321,23 @@ BD_PUBLIC int strmxor (int argc, char *argv[])
   std::auto_ptr<db::Layout> output_layout;
   db::cell_index_type output_top = 0;
 
+  db::SaveLayoutOptions save_options;
+  std::auto_ptr<tl::OutputStream> output_stream;
+  std::auto_ptr<db::TileOutputStreamWriter> output_stream_writer;
+
   if (! output.empty ()) {
-    output_layout.reset (new db::Layout ());
-    output_top = output_layout->add_cell ("XOR");
+
+    save_options.set_format_from_filename (output);
+
+    if (! deep && save_options.format () == "GDS2") {
+      //  in tiled mode, GDS2 output is written while the tiles are computed
+      output_stream.reset (new tl::OutputStream (output));
+      output_stream_writer.reset (new db::TileOutputStreamWriter (*output_stream, save_options, std::min (layout_a.dbu (), layout_b.dbu ()), "XOR"));
+    } else {
+      output_layout.reset (new db::Layout ());
+      output_top = output_layout->add_cell ("XOR");
+    }
+
   }
 
   std::map<std::pair<int, db::LayerProperties>, ResultDescriptor> results;
@@ -332,6 +356,7 @@ BD_PUBLIC int strmxor (int argc, char *argv[])
   xor_data.tile_size = tile_size;
   xor_data.output_layout = output_layout.get ();
   xor_data.output_cell = output_top;
+  xor_data.output_stream = output_stream_writer.get ();
   xor_data.l2l_map = l2l_map;
   xor_data.results = &results;
 
@@ -349,13 +374,15 @@ BD_PUBLIC int strmxor (int argc, char *argv[])
 
   if (output_layout.get ()) {
 
-    db::SaveLayoutOptions save_options;
-    save_options.set_format_from_filename (output);
-
     tl::OutputStream stream (output);
     db::Writer writer (save_options);
     writer.write (*output_layout, stream);
 
+  } else if (output_stream_writer.get ()) {
+
+    output_stream_writer->finish ();
+    output_stream->close ();
+
   }
 
   if (! silent && ! no_summary) {
@@ -388,7 +415,9 @@ BD_PUBLIC int strmxor (int argc, char *argv[])
         } else if (r->second.layer_b < 0 && ! dont_summarize_missing_layers) {
           value = "(no such layer in second layout)";
         } else if (! r->second.is_empty ()) {
-          if (r->second.layer_output >= 0 && r->second.layout) {
+          if (r->second.layer_output >= 0 && r->second.output_stream) {
+            out = r->second.output_stream->layer_properties (r->second.layer_output).to_string ();
+          } else if (r->second.layer_output >= 0 && r->second.layout) {
             out = r->second.layout->get_properties (r->second.layer_output).to_string ();
           }
           value = tl::to_string (r->second.count ());
@@ -414,6 +443,8 @@ bool run_tiled_xor (const XORData &xor_data)
   db::TilingProcessor proc;
   proc.set_dbu (std::min (xor_data.layout_a->dbu (), xor_data.layout_b->dbu ()));
   proc.set_threads (std::max (1, xor_data.threads));
+  //  tiles are preferably computed in worker processes which scale better than threads
+  proc.set_processes (std::max (0, xor_data.threads));
   if (xor_data.tile_size > db::epsilon) {
     if (tl::verbosity () >= 20) {
       tl::log << "Tile size: " << xor_data.tile_size;
@@ -435,6 +466,9 @@ bool run_tiled_xor (const XORData &xor_data)
   if (xor_data.output_layout) {
     xor_data.output_layout->dbu (proc.dbu ());
   }
+  if (xor_data.output_stream) {
+    xor_data.output_stream->set_dbu (proc.dbu ());
+  }
 
   bool result = true;
 
@@ -501,8 +535,12 @@ bool run_tiled_xor (const XORData &xor_data)
         result.layer_b = ll->second.second;
         result.layout = xor_data.output_layout;
         result.top_cell = xor_data.output_cell;
+        result.output_stream = xor_data.output_stream;
 
-        if (result.layout) {
+        if (result.output_stream) {
+          result.layer_output = result.output_stream->add_layer (lp);
+          proc.output (out, 0, new db::TileStreamOutputReceiver (result.output_stream, result.layer_output), db::ICplxTrans ());
+        } else if (result.layout) {
           result.layer_output = result.layout->insert_layer (lp);
           proc.output (out, *result.layout, result.top_cell, result.layer_output);
         } else {
@@ -533,7 +571,7 @@ bool run_tiled_xor (const XORData &xor_data)
 
   //  Runs the processor
 
-  if ((! xor_data.silent && ! xor_data.no_summary) || result || xor_data.output_layout) {
+  if ((! xor_data.silent && ! xor_data.no_summary) || result || xor_data.output_layout || xor_data.output_stream) {
     proc.execute ("Running XOR");
   }
 
@@ -11,6 +11,7 @@ SOURCES = \
   dbBox.cc \
   dbBoxConvert.cc \
   dbBoxScanner.cc \
+  dbBoxTree.cc \
   dbCell.cc \
   dbCellGraphUtils.cc \
   dbCellHullGenerator.cc \
@@ -20,6 +21,7 @@ SOURCES = \
   dbClipboardData.cc \
   dbClip.cc \
   dbCommonReader.cc \
+  dbContourAllocator.cc \
   dbEdge.cc \
   dbEdgePair.cc \
   dbEdgePairRelations.cc \
@@ -206,6 +208,7 @@ HEADERS = \
   dbBox.h \
   dbBoxScanner.h \
   dbBoxTree.h \
+  dbPackedBoxTree.h \
   dbCellGraphUtils.h \
   dbCell.h \
   dbCellHullGenerator.h \
@@ -215,6 +218,7 @@ HEADERS = \
   dbClipboard.h \
   dbClip.h \
   dbCommonReader.h \
+  dbContourAllocator.h \
   dbEdge.h \
   dbEdgePair.h \
   dbEdgePairRelations.h \
@@ -27,11 +27,13 @@ namespace db
 {
 
 ArrayRepository::ArrayRepository ()
+  : mp_lock (0)
 {
   //  .. nothing yet ..
 }
 
 ArrayRepository::ArrayRepository (const ArrayRepository &d)
+  : mp_lock (0)
 {
   operator= (d);
 }
@@ -39,6 +39,7 @@
 #include "dbTrans.h"
 #include "dbShapeRepository.h"
 #include "tlException.h"
+#include "tlThreads.h"
 
 namespace db
 {
@@ -258,8 +259,38 @@ public:
 
   ArrayRepository &operator= (const ArrayRepository &d);
 
+  /**
+   *  @brief Sets the lock used for guarding insert
+   *
+   *  If a lock is set, "insert" can be called from multiple threads.
+   *  Pass 0 to disable locking. The lock is not copied.
+   */
+  void set_lock (tl::Mutex *lock)
+  {
+    mp_lock = lock;
+  }
+
   template <class Coord>
   basic_array<Coord> *insert (const basic_array<Coord> &base)
+  {
+    if (mp_lock) {
+      tl::MutexLocker locker (mp_lock);
+      return do_insert (base);
+    } else {
+      return do_insert (base);
+    }
+  }
+
+  void mem_stat (MemStatistics *stat, MemStatistics::purpose_t purpose, int cat, bool no_self = false, void *parent = 0) const;
+
+private:
+  repositories m_reps;
+  tl::Mutex *mp_lock;
+
+  void clear ();
+
+  template <class Coord>
+  basic_array<Coord> *do_insert (const basic_array<Coord> &base)
   {
     repositories::iterator r;
     for (r = m_reps.begin (); r != m_reps.end (); ++r) {
@@ -283,13 +314,6 @@ public:
       return bb;
     }
   }
-
-  void mem_stat (MemStatistics *stat, MemStatistics::purpose_t purpose, int cat, bool no_self = false, void *parent = 0) const;
-
-private:
-  repositories m_reps;
-
-  void clear ();
 };
 
 /**
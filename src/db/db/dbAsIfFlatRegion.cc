@@ -727,6 +727,25 @@ AsIfFlatRegion::angle_check (double min, double max, bool inverse) const
   return res.release ();
 }
 
+RegionDelegate *
+AsIfFlatRegion::density_check (db::Coord wx, db::Coord wy, db::Coord sx, db::Coord sy, double min_density, double max_density, bool inverse, const Region &boundary) const
+{
+  std::vector<db::Box> windows;
+  compute_density_windows (begin_merged_iter (), boundary.empty () ? bbox () : boundary.bbox (), wx, wy, sx, sy, min_density, max_density, inverse, threads (), windows);
+
+  std::auto_ptr<FlatRegion> new_region (new FlatRegion (false));
+  for (std::vector<db::Box>::const_iterator w = windows.begin (); w != windows.end (); ++w) {
+    new_region->raw_polygons ().insert (db::Polygon (*w));
+  }
+
+  if (! boundary.empty () && ! boundary.is_box ()) {
+    //  windows outside a non-rectangular boundary are not considered
+    return new_region->selected_overlapping (boundary);
+  } else {
+    return new_region.release ();
+  }
+}
+
 RegionDelegate *
 AsIfFlatRegion::snapped (db::Coord gx, db::Coord gy)
 {
@@ -868,6 +887,7 @@ AsIfFlatRegion::merged (bool min_coherence, unsigned int min_wc) const
 
     db::EdgeProcessor ep (report_progress (), progress_desc ());
     ep.set_base_verbosity (base_verbosity ());
+    ep.set_threads (threads ());
 
     //  count edges and reserve memory
     size_t n = 0;
@@ -946,6 +966,7 @@ AsIfFlatRegion::sized (coord_type dx, coord_type dy, unsigned int mode) const
     //  Generic case - the size operation will merge first
     db::EdgeProcessor ep (report_progress (), progress_desc ());
     ep.set_base_verbosity (base_verbosity ());
+    ep.set_threads (threads ());
 
     //  count edges and reserve memory
     size_t n = 0;
@@ -1028,6 +1049,7 @@ AsIfFlatRegion::and_with (const Region &other) const
     //  Generic case
     db::EdgeProcessor ep (report_progress (), progress_desc ());
     ep.set_base_verbosity (base_verbosity ());
+    ep.set_threads (threads ());
 
     //  count edges and reserve memory
     size_t n = 0;
@@ -1083,6 +1105,7 @@ AsIfFlatRegion::not_with (const Region &other) const
     //  Generic case
     db::EdgeProcessor ep (report_progress (), progress_desc ());
     ep.set_base_verbosity (base_verbosity ());
+    ep.set_threads (threads ());
 
     //  count edges and reserve memory
     size_t n = 0;
@@ -1136,6 +1159,7 @@ AsIfFlatRegion::xor_with (const Region &other) const
     //  Generic case
     db::EdgeProcessor ep (report_progress (), progress_desc ());
     ep.set_base_verbosity (base_verbosity ());
+    ep.set_threads (threads ());
 
     //  count edges and reserve memory
     size_t n = 0;
@@ -1190,6 +1214,7 @@ AsIfFlatRegion::or_with (const Region &other) const
     //  Generic case
     db::EdgeProcessor ep (report_progress (), progress_desc ());
     ep.set_base_verbosity (base_verbosity ());
+    ep.set_threads (threads ());
 
     //  count edges and reserve memory
     size_t n = 0;
@@ -0,0 +1,41 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2020 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "dbBoxTree.h"
+
+namespace db
+{
+
+static unsigned int s_sort_threads = 1;
+
+void set_sort_threads (unsigned int n)
+{
+  s_sort_threads = std::max ((unsigned int) 1, n);
+}
+
+unsigned int sort_threads ()
+{
+  return s_sort_threads;
+}
+
+}
@@ -26,6 +26,8 @@
 
 #include "tlVector.h"
 #include "tlReuseVector.h"
+#include "tlThreads.h"
+#include "dbCommon.h"
 #include "dbBox.h"
 #include "dbMemStatistics.h"
 
@@ -39,6 +41,53 @@ namespace db
 struct simple_bbox_tag;
 struct complex_bbox_tag;
 
+/**
+ *  @brief Sets the number of threads used for sorting box trees
+ *
+ *  With more than one thread, big box trees are sorted in parallel: after the top-level
+ *  partitioning, the quads are independent and are sorted in separate threads.
+ *  This setting also applies to Layout::update which sorts the shapes of different
+ *  cells and layers in parallel then.
+ *  The default is 1 (no parallel sorting).
+ */
+DB_PUBLIC void set_sort_threads (unsigned int n);
+
+/**
+ *  @brief Gets the number of threads used for sorting box trees
+ */
+DB_PUBLIC unsigned int sort_threads ();
+
+/**
+ *  @brief The minimum number of elements from which on the quads of a box tree are sorted in parallel
+ */
+const size_t box_tree_parallel_sort_min = 100000;
+
+/**
+ *  @brief A helper thread for the parallel sorting of box trees
+ *
+ *  The job is a functor which is executed in the thread.
+ */
+template <class Job>
+class box_tree_sort_thread
+  : public tl::Thread
+{
+public:
+  box_tree_sort_thread (const Job &job)
+    : m_job (job)
+  {
+    //  .. nothing yet ..
+  }
+
+protected:
+  virtual void run ()
+  {
+    m_job ();
+  }
+
+private:
+  Job m_job;
+};
+
 /// @brief a helper class required for the box_tree implementation
 
 template <class Box, class Obj, class BoxConv, class Vector>
@@ -1181,7 +1230,7 @@ private:
 
       //  TODO: resize m_elements to actual size ?
 
-      tree_sort (0, m_elements.begin (), m_elements.end (), picker, bbox, 0);
+      tree_sort (0, m_elements.begin (), m_elements.end (), picker, bbox, 0, sort_threads ());
 
     }
   }
@@ -1207,13 +1256,34 @@ private:
 
       //  TODO: resize m_elements to actual size ?
 
-      tree_sort (0, m_elements.begin (), m_elements.end (), picker, picker.bbox (), 0);
+      tree_sort (0, m_elements.begin (), m_elements.end (), picker, picker.bbox (), 0, sort_threads ());
 
     }
   }
 
   template <class CoordPicker>
-  void tree_sort (box_tree_node *parent, element_iterator from, element_iterator to, const CoordPicker &picker, const box_type &bbox, int quad)
+  struct quad_sort_job
+  {
+    quad_sort_job (box_tree *_tree, box_tree_node *_node, element_iterator _from, element_iterator _to, const CoordPicker *_picker, const box_type &_bbox, int _quad, unsigned int _nthreads)
+      : tree (_tree), node (_node), from (_from), to (_to), picker (_picker), bbox (_bbox), quad (_quad), nthreads (_nthreads)
+    { }
+
+    void operator() () const
+    {
+      tree->tree_sort (node, from, to, *picker, bbox, quad, nthreads);
+    }
+
+    box_tree *tree;
+    box_tree_node *node;
+    element_iterator from, to;
+    const CoordPicker *picker;
+    box_type bbox;
+    int quad;
+    unsigned int nthreads;
+  };
+
+  template <class CoordPicker>
+  void tree_sort (box_tree_node *parent, element_iterator from, element_iterator to, const CoordPicker &picker, const box_type &bbox, int quad, unsigned int nthreads)
   {
     size_t ntot = size_t (to - from);
     if (ntot <= min_bin || (bbox.width () < 2 && bbox.height () < 2)) {
@@ -1297,10 +1367,42 @@ private:
       for (unsigned int q = 0; q < 4; ++q) {
         if (n[q] > 0) {
           node->lenq (q, n[q]);
-          tree_sort (node, qloc[q], qloc[q + 1], picker, qboxes [q], int (q));
         }
       }
 
+      if (nthreads > 1 && nn >= box_tree_parallel_sort_min) {
+
+        //  The quads are independent element ranges and each quad only modifies its own
+        //  child slot of the node. Hence we can sort them in parallel.
+        std::vector<box_tree_sort_thread<quad_sort_job<CoordPicker> > *> threads;
+        unsigned int nthreads_per_quad = std::max ((unsigned int) 1, nthreads / 4);
+
+        for (unsigned int q = 1; q < 4; ++q) {
+          if (n[q] > 0) {
+            threads.push_back (new box_tree_sort_thread<quad_sort_job<CoordPicker> > (quad_sort_job<CoordPicker> (this, node, qloc[q], qloc[q + 1], &picker, qboxes [q], int (q), nthreads_per_quad)));
+            threads.back ()->start ();
+          }
+        }
+
+        if (n[0] > 0) {
+          tree_sort (node, qloc[0], qloc[1], picker, qboxes [0], 0, nthreads_per_quad);
+        }
+
+        for (typename std::vector<box_tree_sort_thread<quad_sort_job<CoordPicker> > *>::const_iterator t = threads.begin (); t != threads.end (); ++t) {
+          (*t)->wait ();
+          delete *t;
+        }
+
+      } else {
+
+        for (unsigned int q = 0; q < 4; ++q) {
+          if (n[q] > 0) {
+            tree_sort (node, qloc[q], qloc[q + 1], picker, qboxes [q], int (q), nthreads);
+          }
+        }
+
+      }
+
     } 
 
   }
@@ -2114,7 +2216,7 @@ private:
       }
     }
 
-    tree_sort (0, m_objects.begin (), m_objects.end (), picker, bbox, 0);
+    tree_sort (0, m_objects.begin (), m_objects.end (), picker, bbox, 0, sort_threads ());
   }
 
   /// Sort implementation for complex bboxes - with caching
@@ -2131,11 +2233,32 @@ private:
     }
     mp_root = 0;
 
-    tree_sort (0, m_objects.begin (), m_objects.end (), picker, picker.bbox (), 0);
+    tree_sort (0, m_objects.begin (), m_objects.end (), picker, picker.bbox (), 0, sort_threads ());
   }
 
   template <class CoordPicker>
-  void tree_sort (box_tree_node *parent, obj_iterator from, obj_iterator to, CoordPicker &picker, const box_type &bbox, int quad)
+  struct quad_sort_job
+  {
+    quad_sort_job (unstable_box_tree *_tree, box_tree_node *_node, obj_iterator _from, obj_iterator _to, CoordPicker *_picker, const box_type &_bbox, int _quad, unsigned int _nthreads)
+      : tree (_tree), node (_node), from (_from), to (_to), picker (_picker), bbox (_bbox), quad (_quad), nthreads (_nthreads)
+    { }
+
+    void operator() () const
+    {
+      tree->tree_sort (node, from, to, *picker, bbox, quad, nthreads);
+    }
+
+    unstable_box_tree *tree;
+    box_tree_node *node;
+    obj_iterator from, to;
+    CoordPicker *picker;
+    box_type bbox;
+    int quad;
+    unsigned int nthreads;
+  };
+
+  template <class CoordPicker>
+  void tree_sort (box_tree_node *parent, obj_iterator from, obj_iterator to, CoordPicker &picker, const box_type &bbox, int quad, unsigned int nthreads)
   {
     size_t ntot = size_t (to - from);
     if (ntot <= min_bin || (bbox.width () < 2 && bbox.height () < 2)) {
@@ -2224,10 +2347,43 @@ private:
       for (unsigned int q = 0; q < 4; ++q) {
         if (n[q] > 0) {
           node->lenq (q, n[q]);
-          tree_sort (node, qloc[q], qloc[q + 1], picker, qboxes [q], int (q));
         }
       }
 
+      if (nthreads > 1 && nn >= box_tree_parallel_sort_min) {
+
+        //  The quads are independent object ranges and each quad only modifies its own
+        //  child slot of the node and its own part of the picker's box cache. Hence we
+        //  can sort them in parallel.
+        std::vector<box_tree_sort_thread<quad_sort_job<CoordPicker> > *> threads;
+        unsigned int nthreads_per_quad = std::max ((unsigned int) 1, nthreads / 4);
+
+        for (unsigned int q = 1; q < 4; ++q) {
+          if (n[q] > 0) {
+            threads.push_back (new box_tree_sort_thread<quad_sort_job<CoordPicker> > (quad_sort_job<CoordPicker> (this, node, qloc[q], qloc[q + 1], &picker, qboxes [q], int (q), nthreads_per_quad)));
+            threads.back ()->start ();
+          }
+        }
+
+        if (n[0] > 0) {
+          tree_sort (node, qloc[0], qloc[1], picker, qboxes [0], 0, nthreads_per_quad);
+        }
+
+        for (typename std::vector<box_tree_sort_thread<quad_sort_job<CoordPicker> > *>::const_iterator t = threads.begin (); t != threads.end (); ++t) {
+          (*t)->wait ();
+          delete *t;
+        }
+
+      } else {
+
+        for (unsigned int q = 0; q < 4; ++q) {
+          if (n[q] > 0) {
+            tree_sort (node, qloc[q], qloc[q + 1], picker, qboxes [q], int (q), nthreads);
+          }
+        }
+
+      }
+
     } 
 
   }
@@ -382,6 +382,14 @@ Cell::sort_shapes ()
   }
 }
 
+void
+Cell::collect_shapes (std::vector<shapes_type *> &shapes)
+{
+  for (shapes_map::iterator s = m_shapes_map.begin (); s != m_shapes_map.end (); ++s) {
+    shapes.push_back (&s->second);
+  }
+}
+
 void
 Cell::prop_id (db::properties_id_type id) 
 {
@@ -506,6 +506,14 @@ public:
    */
   void sort_shapes ();
 
+  /**
+   *  @brief Collects the shapes lists of this cell
+   *
+   *  The shapes lists are appended to the given vector. This method
+   *  is used to sort the shapes lists of multiple cells in parallel.
+   */
+  void collect_shapes (std::vector<shapes_type *> &shapes);
+
   /**
    *  @brief Retrieve the bounding box of the cell
    *
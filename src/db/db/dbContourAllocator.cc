@@ -0,0 +1,499 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2020 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "dbContourAllocator.h"
+#include "tlThreads.h"
+#include "atomic/atomic.h"
+
+#include <vector>
+#include <map>
+#include <new>
+
+namespace db
+{
+
+namespace
+{
+
+//  Block sizes are multiples of 8 bytes up to 256 bytes
+const size_t block_granularity = 8;
+const size_t num_block_classes = 32;
+const size_t max_pooled_block_size = block_granularity * num_block_classes;
+
+//  The size of the chunks from which the blocks are taken
+const size_t chunk_size = 64 * 1024;
+
+//  The number of free blocks per class a thread keeps before handing them over to the depot
+const size_t max_local_free_blocks = 4096;
+
+//  The amount of free memory collected by the depot after which unused chunks are released
+const size_t release_interval = 16 * 1024 * 1024;
+
+struct FreeBlock
+{
+  FreeBlock *next;
+};
+
+inline size_t block_class (size_t bytes)
+{
+  return bytes == 0 ? 0 : (bytes - 1) / block_granularity;
+}
+
+inline size_t block_size (size_t c)
+{
+  return (c + 1) * block_granularity;
+}
+
+/**
+ *  @brief Describes a chunk
+ *
+ *  "used" is the number of bytes handed out from the chunk. While a pool takes blocks
+ *  from the chunk, the chunk is "active" and "used" is not up to date.
+ */
+struct ContourPointChunk
+{
+  ContourPointChunk ()
+    : used (0), free (0), active (true)
+  { }
+
+  size_t used;
+  size_t free;
+  bool active;
+};
+
+/**
+ *  @brief The depot owns the chunks and keeps lists of free blocks shared between threads
+ *
+ *  Threads hand over their free blocks to the depot when they collected too
+ *  many of them or when they terminate. Threads running out of free blocks
+ *  take them from the depot before new chunks are allocated. The partially
+ *  used chunk of a terminating thread is kept for the next thread needing
+ *  a chunk.
+ *
+ *  Chunks whose blocks all went back to the depot are released to the system
+ *  when enough free memory has been collected or on "release_unused_contour_points".
+ */
+class ContourPointDepot
+{
+public:
+  ContourPointDepot ()
+    : m_free_bytes (0), m_release_threshold (release_interval)
+  {
+    for (size_t c = 0; c < num_block_classes; ++c) {
+      m_available [c].store (0);
+    }
+  }
+
+  void put (size_t c, FreeBlock *head, size_t count)
+  {
+    tl::MutexLocker locker (&m_lock);
+    m_batches [c].push_back (std::make_pair (head, count));
+    m_available [c].store (int (m_batches [c].size ()));
+
+    m_free_bytes += count * block_size (c);
+    if (m_free_bytes > m_release_threshold) {
+      release_unused ();
+    }
+  }
+
+  bool get (size_t c, FreeBlock *&head, size_t &count)
+  {
+    //  NOTE: checking the counter first avoids taking the lock in the common case
+    if (m_available [c].load () == 0) {
+      return false;
+    }
+
+    tl::MutexLocker locker (&m_lock);
+    if (m_batches [c].empty ()) {
+      return false;
+    }
+
+    head = m_batches [c].back ().first;
+    count = m_batches [c].back ().second;
+    m_batches [c].pop_back ();
+    m_available [c].store (int (m_batches [c].size ()));
+
+    m_free_bytes -= count * block_size (c);
+    return true;
+  }
+
+  /**
+   *  @brief Provides a chunk with at least the given number of bytes left
+   *
+   *  The chunk becomes active. "used" receives the number of bytes already taken from it.
+   */
+  char *take_chunk (size_t bytes, size_t &used)
+  {
+    tl::MutexLocker locker (&m_lock);
+
+    for (std::vector<char *>::iterator p = m_partial_chunks.begin (); p != m_partial_chunks.end (); ++p) {
+      ContourPointChunk &chunk = m_chunks [*p];
+      if (chunk.used + bytes <= chunk_size) {
+        char *c = *p;
+        m_partial_chunks.erase (p);
+        chunk.active = true;
+        used = chunk.used;
+        return c;
+      }
+    }
+
+    char *c = (char *) ::operator new (chunk_size);
+    m_chunks.insert (std::make_pair (c, ContourPointChunk ()));
+    used = 0;
+    return c;
+  }
+
+  /**
+   *  @brief Hands back a chunk when a pool stops taking blocks from it
+   */
+  void return_chunk (char *c, size_t used)
+  {
+    tl::MutexLocker locker (&m_lock);
+
+    ContourPointChunk &chunk = m_chunks [c];
+    chunk.used = used;
+    chunk.active = false;
+    if (used + block_granularity <= chunk_size) {
+      m_partial_chunks.push_back (c);
+    }
+  }
+
+  void release ()
+  {
+    tl::MutexLocker locker (&m_lock);
+    release_unused ();
+  }
+
+  size_t size ()
+  {
+    tl::MutexLocker locker (&m_lock);
+    return m_chunks.size () * chunk_size;
+  }
+
+private:
+  tl::Mutex m_lock;
+  std::vector<std::pair<FreeBlock *, size_t> > m_batches [num_block_classes];
+  atomic::atomic<int> m_available [num_block_classes];
+  std::map<char *, ContourPointChunk> m_chunks;
+  std::vector<char *> m_partial_chunks;
+  size_t m_free_bytes, m_release_threshold;
+
+  std::map<char *, ContourPointChunk>::iterator chunk_for (FreeBlock *b)
+  {
+    std::map<char *, ContourPointChunk>::iterator c = m_chunks.upper_bound ((char *) b);
+    if (c != m_chunks.begin ()) {
+      --c;
+      if ((char *) b < c->first + chunk_size) {
+        return c;
+      }
+    }
+    return m_chunks.end ();
+  }
+
+  bool is_unused (std::map<char *, ContourPointChunk>::const_iterator c) const
+  {
+    return c != m_chunks.end () && ! c->second.active && c->second.free == c->second.used;
+  }
+
+  //  NOTE: needs to be called with the lock held
+  void release_unused ()
+  {
+    //  sum up the free bytes per chunk
+    for (size_t c = 0; c < num_block_classes; ++c) {
+      for (std::vector<std::pair<FreeBlock *, size_t> >::const_iterator b = m_batches [c].begin (); b != m_batches [c].end (); ++b) {
+        for (FreeBlock *fb = b->first; fb; fb = fb->next) {
+          std::map<char *, ContourPointChunk>::iterator ch = chunk_for (fb);
+          if (ch != m_chunks.end ()) {
+            ch->second.free += block_size (c);
+          }
+        }
+      }
+    }
+
+    //  drop the free blocks of unused chunks
+    m_free_bytes = 0;
+    for (size_t c = 0; c < num_block_classes; ++c) {
+
+      FreeBlock *head = 0;
+      size_t count = 0;
+
+      for (std::vector<std::pair<FreeBlock *, size_t> >::const_iterator b = m_batches [c].begin (); b != m_batches [c].end (); ++b) {
+        FreeBlock *fb = b->first;
+        while (fb) {
+          FreeBlock *next = fb->next;
+          if (! is_unused (chunk_for (fb))) {
+            fb->next = head;
+            head = fb;
+            ++count;
+          }
+          fb = next;
+        }
+      }
+
+      m_batches [c].clear ();
+      if (head) {
+        m_batches [c].push_back (std::make_pair (head, count));
+      }
+      m_available [c].store (int (m_batches [c].size ()));
+      m_free_bytes += count * block_size (c);
+
+    }
+
+    //  release the unused chunks
+    std::vector<char *> partial_chunks;
+    for (std::vector<char *>::const_iterator p = m_partial_chunks.begin (); p != m_partial_chunks.end (); ++p) {
+      if (! is_unused (m_chunks.find (*p))) {
+        partial_chunks.push_back (*p);
+      }
+    }
+    m_partial_chunks.swap (partial_chunks);
+
+    for (std::map<char *, ContourPointChunk>::iterator c = m_chunks.begin (); c != m_chunks.end (); ) {
+      std::map<char *, ContourPointChunk>::iterator cc = c;
+      ++c;
+      if (is_unused (cc)) {
+        ::operator delete ((void *) cc->first);
+        m_chunks.erase (cc);
+      } else {
+        cc->second.free = 0;
+      }
+    }
+
+    m_release_threshold = m_free_bytes + release_interval;
+  }
+};
+
+ContourPointDepot &depot ()
+{
+  //  NOTE: the depot is never destroyed, so blocks can be released during static destruction
+  static ContourPointDepot *s_depot = new ContourPointDepot ();
+  return *s_depot;
+}
+
+/**
+ *  @brief The per-thread pool of contour point blocks
+ */
+class ContourPointPool
+{
+public:
+  ContourPointPool ()
+    : ref_count (0), mp_chunk (0), m_chunk_used (0)
+  {
+    for (size_t c = 0; c < num_block_classes; ++c) {
+      m_free [c] = 0;
+      m_free_count [c] = 0;
+    }
+  }
+
+  ~ContourPointPool ()
+  {
+    //  hand over the free blocks and the current chunk, so other threads can use them
+    flush ();
+    if (mp_chunk) {
+      depot ().return_chunk (mp_chunk, m_chunk_used);
+    }
+  }
+
+  void *allocate (size_t c)
+  {
+    if (! m_free [c]) {
+      depot ().get (c, m_free [c], m_free_count [c]);
+    }
+
+    FreeBlock *b = m_free [c];
+    if (b) {
+      m_free [c] = b->next;
+      --m_free_count [c];
+      return (void *) b;
+    }
+
+    size_t bs = block_size (c);
+    if (! mp_chunk || m_chunk_used + bs > chunk_size) {
+      if (mp_chunk) {
+        depot ().return_chunk (mp_chunk, m_chunk_used);
+      }
+      mp_chunk = depot ().take_chunk (bs, m_chunk_used);
+    }
+
+    void *p = (void *) (mp_chunk + m_chunk_used);
+    m_chunk_used += bs;
+    return p;
+  }
+
+  void release (void *p, size_t c)
+  {
+    FreeBlock *b = (FreeBlock *) p;
+    b->next = m_free [c];
+    m_free [c] = b;
+
+    if (++m_free_count [c] >= max_local_free_blocks) {
+      depot ().put (c, m_free [c], m_free_count [c]);
+      m_free [c] = 0;
+      m_free_count [c] = 0;
+    }
+  }
+
+  void flush ()
+  {
+    for (size_t c = 0; c < num_block_classes; ++c) {
+      if (m_free [c]) {
+        depot ().put (c, m_free [c], m_free_count [c]);
+        m_free [c] = 0;
+        m_free_count [c] = 0;
+      }
+    }
+  }
+
+  int ref_count;
+
+private:
+  FreeBlock *m_free [num_block_classes];
+  size_t m_free_count [num_block_classes];
+  char *mp_chunk;
+  size_t m_chunk_used;
+};
+
+/**
+ *  @brief A reference to the pool of a thread
+ *
+ *  The thread storage keeps a copy of this object and destroys it when the thread
+ *  terminates. The last reference destroys the pool. All copies live in the same
+ *  thread, hence the reference count does not need to be atomic.
+ */
+class ContourPointPoolRef
+{
+public:
+  ContourPointPoolRef ()
+    : mp_pool (0)
+  { }
+
+  ContourPointPoolRef (ContourPointPool *pool)
+    : mp_pool (pool)
+  {
+    add_ref ();
+  }
+
+  ContourPointPoolRef (const ContourPointPoolRef &other)
+    : mp_pool (other.mp_pool)
+  {
+    add_ref ();
+  }
+
+  ContourPointPoolRef &operator= (const ContourPointPoolRef &other)
+  {
+    if (this != &other) {
+      release ();
+      mp_pool = other.mp_pool;
+      add_ref ();
+    }
+    return *this;
+  }
+
+  ~ContourPointPoolRef ()
+  {
+    release ();
+  }
+
+  ContourPointPool *pool () const
+  {
+    return mp_pool;
+  }
+
+private:
+  ContourPointPool *mp_pool;
+
+  void add_ref ()
+  {
+    if (mp_pool) {
+      ++mp_pool->ref_count;
+    }
+  }
+
+  void release ()
+  {
+    if (mp_pool && --mp_pool->ref_count == 0) {
+      delete mp_pool;
+    }
+    mp_pool = 0;
+  }
+};
+
+tl::ThreadStorage<ContourPointPoolRef> &pools ()
+{
+  //  NOTE: like the depot, the thread storage is never destroyed
+  static tl::ThreadStorage<ContourPointPoolRef> *s_pools = new tl::ThreadStorage<ContourPointPoolRef> ();
+  return *s_pools;
+}
+
+/**
+ *  @brief Gets the pool of the current thread
+ *
+ *  If the pool is used again while the thread terminates, a new pool is created
+ *  and handed over to the depot again.
+ */
+inline ContourPointPool *local_pool ()
+{
+  tl::ThreadStorage<ContourPointPoolRef> &p = pools ();
+  if (! p.hasLocalData ()) {
+    p.setLocalData (ContourPointPoolRef (new ContourPointPool ()));
+  }
+  return p.localData ().pool ();
+}
+
+}
+
+void *allocate_contour_points (size_t bytes)
+{
+  if (bytes > max_pooled_block_size) {
+    return ::operator new (bytes);
+  }
+
+  return local_pool ()->allocate (block_class (bytes));
+}
+
+void release_contour_points (void *p, size_t bytes)
+{
+  if (! p) {
+    return;
+  }
+
+  if (bytes > max_pooled_block_size) {
+    ::operator delete (p);
+    return;
+  }
+
+  local_pool ()->release (p, block_class (bytes));
+}
+
+void release_unused_contour_points ()
+{
+  local_pool ()->flush ();
+  depot ().release ();
+}
+
+size_t contour_point_pool_size ()
+{
+  return depot ().size ();
+}
+
+}
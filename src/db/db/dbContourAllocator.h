@@ -0,0 +1,75 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2020 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#ifndef HDR_dbContourAllocator
+#define HDR_dbContourAllocator
+
+#include "dbCommon.h"
+
+#include <cstddef>
+
+namespace db
+{
+
+/**
+ *  @brief Allocates memory for the point array of a polygon contour
+ *
+ *  Small blocks are taken from per-thread pools of fixed-size blocks. This
+ *  avoids the per-block overhead of the heap and the lock contention of the
+ *  global heap if many threads create shapes concurrently. Larger blocks are
+ *  taken from the heap directly.
+ *
+ *  The pools carve the blocks from chunks which are shared by all threads.
+ *  When a thread terminates, its free blocks and its partially used chunk
+ *  are handed over to other threads.
+ *
+ *  The memory must be released with "release_contour_points" using the same size.
+ *  Blocks may be released by a different thread than the one which allocated them.
+ */
+DB_PUBLIC void *allocate_contour_points (size_t bytes);
+
+/**
+ *  @brief Releases memory allocated with "allocate_contour_points"
+ *
+ *  Released small blocks are kept for reuse. Chunks whose blocks have all been
+ *  released are returned to the system once enough free memory has been collected.
+ */
+DB_PUBLIC void release_contour_points (void *p, size_t bytes);
+
+/**
+ *  @brief Gives the memory of chunks without blocks in use back to the system
+ *
+ *  The free blocks of the calling thread are included. Free blocks kept by other
+ *  running threads keep their chunks alive.
+ */
+DB_PUBLIC void release_unused_contour_points ();
+
+/**
+ *  @brief Gets the number of bytes held in chunks
+ */
+DB_PUBLIC size_t contour_point_pool_size ();
+
+}
+
+#endif
+
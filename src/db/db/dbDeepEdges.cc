@@ -661,6 +661,7 @@ DeepEdges::and_or_not_with (const DeepEdges *other, EdgeBoolOp op) const
   db::local_processor<db::Edge, db::Edge, db::Edge> proc (const_cast<db::Layout *> (&deep_layer ().layout ()), const_cast<db::Cell *> (&deep_layer ().initial_cell ()), &other->deep_layer ().layout (), &other->deep_layer ().initial_cell ());
   proc.set_base_verbosity (base_verbosity ());
   proc.set_threads (deep_layer ().store ()->threads ());
+  proc.set_thread_affinity (deep_layer ().store ()->thread_affinity ());
   proc.set_area_ratio (deep_layer ().store ()->max_area_ratio ());
   proc.set_max_vertex_count (deep_layer ().store ()->max_vertex_count ());
 
@@ -679,6 +680,7 @@ DeepEdges::edge_region_op (const DeepRegion *other, bool outside, bool include_b
   db::local_processor<db::Edge, db::PolygonRef, db::Edge> proc (const_cast<db::Layout *> (&deep_layer ().layout ()), const_cast<db::Cell *> (&deep_layer ().initial_cell ()), &other->deep_layer ().layout (), &other->deep_layer ().initial_cell ());
   proc.set_base_verbosity (base_verbosity ());
   proc.set_threads (deep_layer ().store ()->threads ());
+  proc.set_thread_affinity (deep_layer ().store ()->thread_affinity ());
   proc.set_area_ratio (deep_layer ().store ()->max_area_ratio ());
   proc.set_max_vertex_count (deep_layer ().store ()->max_vertex_count ());
 
@@ -1092,6 +1094,11 @@ public:
     }
   }
 
+  virtual bool allows_clipped_intruders () const
+  {
+    return true;
+  }
+
   virtual std::string description () const
   {
     return tl::to_string (tr ("Select interacting edges"));
@@ -1220,6 +1227,11 @@ public:
     }
   }
 
+  virtual bool allows_clipped_intruders () const
+  {
+    return true;
+  }
+
   virtual std::string description () const
   {
     return tl::to_string (tr ("Select interacting edges"));
@@ -1324,6 +1336,7 @@ DeepEdges::selected_interacting_generic (const Region &other, bool inverse) cons
   db::local_processor<db::Edge, db::PolygonRef, db::Edge> proc (const_cast<db::Layout *> (&edges.layout ()), const_cast<db::Cell *> (&edges.initial_cell ()), &other_deep->deep_layer ().layout (), &other_deep->deep_layer ().initial_cell ());
   proc.set_base_verbosity (base_verbosity ());
   proc.set_threads (edges.store ()->threads ());
+  proc.set_thread_affinity (edges.store ()->thread_affinity ());
 
   proc.run (&op, edges.layer (), other_deep->deep_layer ().layer (), dl_out.layer ());
 
@@ -1350,6 +1363,7 @@ DeepEdges::selected_interacting_generic (const Edges &other, bool inverse) const
   db::local_processor<db::Edge, db::Edge, db::Edge> proc (const_cast<db::Layout *> (&edges.layout ()), const_cast<db::Cell *> (&edges.initial_cell ()), &other_deep->deep_layer ().layout (), &other_deep->deep_layer ().initial_cell ());
   proc.set_base_verbosity (base_verbosity ());
   proc.set_threads (edges.store ()->threads ());
+  proc.set_thread_affinity (edges.store ()->thread_affinity ());
 
   proc.run (&op, edges.layer (), other_deep->deep_layer ().layer (), dl_out.layer ());
 
@@ -1376,6 +1390,7 @@ RegionDelegate *DeepEdges::pull_generic (const Region &other) const
   db::local_processor<db::Edge, db::PolygonRef, db::PolygonRef> proc (const_cast<db::Layout *> (&edges.layout ()), const_cast<db::Cell *> (&edges.initial_cell ()), &other_polygons.layout (), &other_polygons.initial_cell ());
   proc.set_base_verbosity (base_verbosity ());
   proc.set_threads (edges.store ()->threads ());
+  proc.set_thread_affinity (edges.store ()->thread_affinity ());
 
   proc.run (&op, edges.layer (), other_polygons.layer (), dl_out.layer ());
 
@@ -1402,6 +1417,7 @@ EdgesDelegate *DeepEdges::pull_generic (const Edges &other) const
   db::local_processor<db::Edge, db::Edge, db::Edge> proc (const_cast<db::Layout *> (&edges.layout ()), const_cast<db::Cell *> (&edges.initial_cell ()), &other_edges.layout (), &other_edges.initial_cell ());
   proc.set_base_verbosity (base_verbosity ());
   proc.set_threads (edges.store ()->threads ());
+  proc.set_thread_affinity (edges.store ()->thread_affinity ());
 
   proc.run (&op, edges.layer (), other_edges.layer (), dl_out.layer ());
 
@@ -1529,6 +1545,7 @@ DeepEdges::run_check (db::edge_relation_type rel, const Edges *other, db::Coord
 
   proc.set_base_verbosity (base_verbosity ());
   proc.set_threads (edges.store ()->threads ());
+  proc.set_thread_affinity (edges.store ()->thread_affinity ());
 
   proc.run (&op, edges.layer (), other_deep ? other_deep->deep_layer ().layer () : edges.layer (), res->deep_layer ().layer ());
 
@@ -552,6 +552,7 @@ DeepRegion::and_or_not_with (const DeepRegion *other, bool and_op) const
   db::local_processor<db::PolygonRef, db::PolygonRef, db::PolygonRef> proc (const_cast<db::Layout *> (&deep_layer ().layout ()), const_cast<db::Cell *> (&deep_layer ().initial_cell ()), &other->deep_layer ().layout (), &other->deep_layer ().initial_cell (), deep_layer ().breakout_cells (), other->deep_layer ().breakout_cells ());
   proc.set_base_verbosity (base_verbosity ());
   proc.set_threads (deep_layer ().store ()->threads ());
+  proc.set_thread_affinity (deep_layer ().store ()->thread_affinity ());
   proc.set_area_ratio (deep_layer ().store ()->max_area_ratio ());
   proc.set_max_vertex_count (deep_layer ().store ()->max_vertex_count ());
 
@@ -839,6 +840,37 @@ DeepRegion::angle_check (double min, double max, bool inverse) const
   return res.release ();
 }
 
+RegionDelegate *
+DeepRegion::density_check (db::Coord wx, db::Coord wy, db::Coord sx, db::Coord sy, double min_density, double max_density, bool inverse, const Region &boundary) const
+{
+  const db::DeepLayer &polygons = merged_deep_layer ();
+  const db::Layout &layout = polygons.layout ();
+
+  //  The hierarchy is not flattened - the stripes pick the shapes through the
+  //  cell tree using the region-confined recursive shape iterator
+  std::pair<db::RecursiveShapeIterator, db::ICplxTrans> source;
+  if (layout.cells () > 0) {
+    source.first = db::RecursiveShapeIterator (layout, polygons.initial_cell (), polygons.layer ());
+  }
+
+  std::vector<db::Box> windows;
+  compute_density_windows (source, boundary.empty () ? bbox () : boundary.bbox (), wx, wy, sx, sy, min_density, max_density, inverse, polygons.store ()->threads (), windows);
+
+  db::DeepLayer new_layer = polygons.derived ();
+  db::Shapes &shapes = new_layer.initial_cell ().shapes (new_layer.layer ());
+  for (std::vector<db::Box>::const_iterator w = windows.begin (); w != windows.end (); ++w) {
+    shapes.insert (db::PolygonRef (db::Polygon (*w), new_layer.layout ().shape_repository ()));
+  }
+
+  std::auto_ptr<DeepRegion> res (new DeepRegion (new_layer));
+
+  if (! boundary.empty () && ! boundary.is_box ()) {
+    return res->selected_overlapping (boundary);
+  } else {
+    return res.release ();
+  }
+}
+
 RegionDelegate *
 DeepRegion::snapped (db::Coord gx, db::Coord gy)
 {
@@ -1380,6 +1412,7 @@ DeepRegion::run_check (db::edge_relation_type rel, bool different_polygons, cons
 
   proc.set_base_verbosity (base_verbosity ());
   proc.set_threads (polygons.store ()->threads ());
+  proc.set_thread_affinity (polygons.store ()->thread_affinity ());
 
   proc.run (&op, polygons.layer (), other_deep ? other_deep->deep_layer ().layer () : polygons.layer (), res->deep_layer ().layer ());
 
@@ -1499,6 +1532,16 @@ public:
     }
   }
 
+  virtual bool requests_single_subjects () const
+  {
+    return true;
+  }
+
+  virtual bool allows_clipped_intruders () const
+  {
+    return true;
+  }
+
   virtual std::string description () const
   {
     return tl::to_string (tr ("Select regions by their geometric relation (interacting, inside, outside ..)"));
@@ -1576,6 +1619,11 @@ public:
     return Drop;
   }
 
+  virtual bool requests_single_subjects () const
+  {
+    return true;
+  }
+
   virtual std::string description () const
   {
     return tl::to_string (tr ("Pull regions by their geometrical relation to first"));
@@ -1682,6 +1730,16 @@ public:
     }
   }
 
+  virtual bool requests_single_subjects () const
+  {
+    return true;
+  }
+
+  virtual bool allows_clipped_intruders () const
+  {
+    return true;
+  }
+
   virtual std::string description () const
   {
     return tl::to_string (tr ("Select regions by their geometric relation to edges"));
@@ -1737,6 +1795,11 @@ public:
     return Drop;
   }
 
+  virtual bool requests_single_subjects () const
+  {
+    return true;
+  }
+
   virtual std::string description () const
   {
     return tl::to_string (tr ("Pull edges from second by their geometric relation to first"));
@@ -1808,6 +1871,11 @@ public:
     return Drop;
   }
 
+  virtual bool requests_single_subjects () const
+  {
+    return true;
+  }
+
   virtual std::string description () const
   {
     return tl::to_string (tr ("Pull texts from second by their geometric relation to first"));
@@ -1871,6 +1939,16 @@ public:
     }
   }
 
+  virtual bool requests_single_subjects () const
+  {
+    return true;
+  }
+
+  virtual bool allows_clipped_intruders () const
+  {
+    return true;
+  }
+
   virtual std::string description () const
   {
     return tl::to_string (tr ("Select regions by their geometric relation to texts"));
@@ -1907,6 +1985,7 @@ DeepRegion::selected_interacting_generic (const Region &other, int mode, bool to
   db::local_processor<db::PolygonRef, db::PolygonRef, db::PolygonRef> proc (const_cast<db::Layout *> (&polygons.layout ()), const_cast<db::Cell *> (&polygons.initial_cell ()), &other_polygons.layout (), &other_polygons.initial_cell (), polygons.breakout_cells (), other_polygons.breakout_cells ());
   proc.set_base_verbosity (base_verbosity ());
   proc.set_threads (polygons.store ()->threads ());
+  proc.set_thread_affinity (polygons.store ()->thread_affinity ());
   if (split_after) {
     proc.set_area_ratio (polygons.store ()->max_area_ratio ());
     proc.set_max_vertex_count (polygons.store ()->max_vertex_count ());
@@ -1944,6 +2023,7 @@ DeepRegion::selected_interacting_generic (const Edges &other, bool inverse) cons
   db::local_processor<db::PolygonRef, db::Edge, db::PolygonRef> proc (const_cast<db::Layout *> (&polygons.layout ()), const_cast<db::Cell *> (&polygons.initial_cell ()), &other_deep->deep_layer ().layout (), &other_deep->deep_layer ().initial_cell (), polygons.breakout_cells (), other_deep->deep_layer ().breakout_cells ());
   proc.set_base_verbosity (base_verbosity ());
   proc.set_threads (polygons.store ()->threads ());
+  proc.set_thread_affinity (polygons.store ()->thread_affinity ());
   if (split_after) {
     proc.set_area_ratio (polygons.store ()->max_area_ratio ());
     proc.set_max_vertex_count (polygons.store ()->max_vertex_count ());
@@ -1983,6 +2063,7 @@ DeepRegion::pull_generic (const Region &other, int mode, bool touching) const
   db::local_processor<db::PolygonRef, db::PolygonRef, db::PolygonRef> proc (const_cast<db::Layout *> (&polygons.layout ()), const_cast<db::Cell *> (&polygons.initial_cell ()), &other_polygons.layout (), &other_polygons.initial_cell (), polygons.breakout_cells (), other_polygons.breakout_cells ());
   proc.set_base_verbosity (base_verbosity ());
   proc.set_threads (polygons.store ()->threads ());
+  proc.set_thread_affinity (polygons.store ()->thread_affinity ());
   if (split_after) {
     proc.set_area_ratio (polygons.store ()->max_area_ratio ());
     proc.set_max_vertex_count (polygons.store ()->max_vertex_count ());
@@ -2019,6 +2100,7 @@ DeepRegion::pull_generic (const Edges &other) const
   db::local_processor<db::PolygonRef, db::Edge, db::Edge> proc (const_cast<db::Layout *> (&polygons.layout ()), const_cast<db::Cell *> (&polygons.initial_cell ()), &other_edges.layout (), &other_edges.initial_cell (), polygons.breakout_cells (), other_edges.breakout_cells ());
   proc.set_base_verbosity (base_verbosity ());
   proc.set_threads (polygons.store ()->threads ());
+  proc.set_thread_affinity (polygons.store ()->thread_affinity ());
   proc.run (&op, polygons.layer (), other_edges.layer (), dl_out.layer ());
 
   db::DeepEdges *res = new db::DeepEdges (dl_out);
@@ -2048,6 +2130,7 @@ DeepRegion::pull_generic (const Texts &other) const
   db::local_processor<db::PolygonRef, db::TextRef, db::TextRef> proc (const_cast<db::Layout *> (&polygons.layout ()), const_cast<db::Cell *> (&polygons.initial_cell ()), &other_texts.layout (), &other_texts.initial_cell (), polygons.breakout_cells (), other_texts.breakout_cells ());
   proc.set_base_verbosity (base_verbosity ());
   proc.set_threads (polygons.store ()->threads ());
+  proc.set_thread_affinity (polygons.store ()->thread_affinity ());
   proc.run (&op, polygons.layer (), other_texts.layer (), dl_out.layer ());
 
   db::DeepTexts *res = new db::DeepTexts (dl_out);
@@ -2078,6 +2161,7 @@ DeepRegion::selected_interacting_generic (const Texts &other, bool inverse) cons
   db::local_processor<db::PolygonRef, db::TextRef, db::PolygonRef> proc (const_cast<db::Layout *> (&polygons.layout ()), const_cast<db::Cell *> (&polygons.initial_cell ()), &other_deep->deep_layer ().layout (), &other_deep->deep_layer ().initial_cell (), polygons.breakout_cells (), other_deep->deep_layer ().breakout_cells ());
   proc.set_base_verbosity (base_verbosity ());
   proc.set_threads (polygons.store ()->threads ());
+  proc.set_thread_affinity (polygons.store ()->thread_affinity ());
   if (split_after) {
     proc.set_area_ratio (polygons.store ()->max_area_ratio ());
     proc.set_max_vertex_count (polygons.store ()->max_vertex_count ());
@@ -129,6 +129,7 @@ public:
 
   virtual EdgePairsDelegate *grid_check (db::Coord gx, db::Coord gy) const;
   virtual EdgePairsDelegate *angle_check (double min, double max, bool inverse) const;
+  virtual RegionDelegate *density_check (db::Coord wx, db::Coord wy, db::Coord sx, db::Coord sy, double min_density, double max_density, bool inverse, const Region &boundary) const;
 
   virtual RegionDelegate *snapped_in_place (db::Coord gx, db::Coord gy)
   {
@@ -33,8 +33,21 @@
 #include "dbDeepEdgePairs.h"
 #include "dbDeepTexts.h"
 #include "dbShapeCollection.h"
+#include "dbHash.h"
+#include "dbContourAllocator.h"
 
 #include "tlTimer.h"
+#include "tlStream.h"
+#include "tlFileUtils.h"
+#include "tlEnv.h"
+
+#include <algorithm>
+
+#if defined(_WIN32)
+#  include <process.h>
+#else
+#  include <unistd.h>
+#endif
 
 namespace db
 {
@@ -130,8 +143,7 @@ DeepLayer::copy () const
 {
   DeepLayer new_layer (derived ());
 
-  db::DeepShapeStore *non_const_store = const_cast<db::DeepShapeStore *> (mp_store.get ());
-  non_const_store->layout (m_layout).copy_layer (m_layer, new_layer.layer ());
+  const_cast <db::Layout &> (layout ()).copy_layer (m_layer, new_layer.layer ());
 
   return new_layer;
 }
@@ -221,28 +233,30 @@ db::Layout &
 DeepLayer::layout ()
 {
   check_dss ();
-  return mp_store->layout (m_layout);
+  return mp_store->layout_for_layer (m_layout, m_layer, true);
 }
 
 const db::Layout &
 DeepLayer::layout () const
 {
   check_dss ();
-  return const_cast<db::DeepShapeStore *> (mp_store.get ())->layout (m_layout);
+  return const_cast<db::DeepShapeStore *> (mp_store.get ())->layout_for_layer (m_layout, m_layer, false);
 }
 
 db::Cell &
 DeepLayer::initial_cell ()
 {
-  check_dss ();
-  return mp_store->initial_cell (m_layout);
+  db::Layout &ly = layout ();
+  tl_assert (ly.cells () > 0);
+  return ly.cell (*ly.begin_top_down ());
 }
 
 const db::Cell &
 DeepLayer::initial_cell () const
 {
-  check_dss ();
-  return mp_store->const_initial_cell (m_layout);
+  const db::Layout &ly = layout ();
+  tl_assert (ly.cells () > 0);
+  return ly.cell (*ly.begin_top_down ());
 }
 
 void
@@ -258,11 +272,18 @@ DeepLayer::check_dss () const
 struct DeepShapeStore::LayoutHolder
 {
   LayoutHolder (const db::ICplxTrans &trans)
-    : refs (0), layout (false), builder (&layout, trans)
+    : refs (0), layout (false), builder (&layout, trans), repository_locks (0)
   {
     //  .. nothing yet ..
   }
 
+  ~LayoutHolder ()
+  {
+    for (std::map<unsigned int, std::string>::const_iterator s = spilled_layers.begin (); s != spilled_layers.end (); ++s) {
+      tl::rm_file (s->second);
+    }
+  }
+
   void add_layer_ref (unsigned int layer)
   {
     layer_refs [layer] += 1;
@@ -271,9 +292,21 @@ struct DeepShapeStore::LayoutHolder
   bool remove_layer_ref (unsigned int layer)
   {
     if ((layer_refs[layer] -= 1) <= 0) {
+
       layout.delete_layer (layer);
       layer_refs.erase (layer);
+      layer_stamps.erase (layer);
+      layer_sizes.erase (layer);
+
+      //  the layer index may be reused, so the spill file must not survive
+      std::map<unsigned int, std::string>::iterator s = spilled_layers.find (layer);
+      if (s != spilled_layers.end ()) {
+        tl::rm_file (s->second);
+        spilled_layers.erase (s);
+      }
+
       return true;
+
     } else {
       return false;
     }
@@ -283,16 +316,661 @@ struct DeepShapeStore::LayoutHolder
   db::Layout layout;
   db::HierarchyBuilder builder;
   std::map<unsigned int, int> layer_refs;
+  std::map<unsigned int, size_t> layer_stamps;
+  std::map<unsigned int, size_t> layer_sizes;
+  std::map<unsigned int, std::string> spilled_layers;
+  int repository_locks;
+
+  size_t layer_size (unsigned int layer);
 };
 
+// ----------------------------------------------------------------------------------
+//  Spill file I/O
+
+namespace
+{
+
+/**
+ *  @brief The shape type codes inside the spill file
+ */
+enum SpillShapeType
+{
+  SST_End = 0,
+  SST_PolygonRef = 1,
+  SST_Polygon = 2,
+  SST_SimplePolygon = 3,
+  SST_Box = 4,
+  SST_Edge = 5,
+  SST_EdgePair = 6,
+  SST_TextRef = 7,
+  SST_Text = 8
+};
+
+/**
+ *  @brief Writes the shapes of a layer to a spill file
+ *
+ *  The format is a sequence of cell records. Each cell record starts with the
+ *  cell index + 1 and is followed by the shapes, each with the type code and
+ *  the properties ID. SST_End terminates the cell record, a cell index of 0
+ *  terminates the file. Integers are written as variable-length unsigned values,
+ *  coordinates are delta-encoded and zig-zag coded. This gives a compact
+ *  representation for the typical short-edged polygons.
+ */
+class DeepLayerSpillWriter
+{
+public:
+  DeepLayerSpillWriter (tl::OutputStream &os)
+    : mp_os (&os)
+  {
+    //  .. nothing yet ..
+  }
+
+  static bool can_write (const db::Shapes &shapes)
+  {
+    for (db::Shapes::shape_iterator s = shapes.begin (db::ShapeIterator::All); ! s.at_end (); ++s) {
+      if (shape_type (*s) == SST_End) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void write_cell (db::cell_index_type ci, const db::Shapes &shapes)
+  {
+    write (size_t (ci) + 1);
+    write_shapes (shapes);
+  }
+
+  void finish ()
+  {
+    write (size_t (0));
+  }
+
+  void write (size_t n)
+  {
+    char b [16];
+    size_t i = 0;
+    while (n >= 0x80) {
+      b [i++] = char ((n & 0x7f) | 0x80);
+      n >>= 7;
+    }
+    b [i++] = char (n);
+    mp_os->put (b, i);
+  }
+
+  void write (const std::string &s)
+  {
+    write (s.size ());
+    mp_os->put (s.c_str (), s.size ());
+  }
+
+  void write_shapes (const db::Shapes &shapes)
+  {
+    for (db::Shapes::shape_iterator s = shapes.begin (db::ShapeIterator::All); ! s.at_end (); ++s) {
+
+      SpillShapeType st = shape_type (*s);
+      write (size_t (st));
+      write (size_t (s->prop_id ()));
+
+      switch (st) {
+      case SST_PolygonRef:
+        {
+          db::Shape::polygon_ref_type pr = s->polygon_ref ();
+          write (pr.trans ().disp ());
+          write (pr.obj ());
+        }
+        break;
+      case SST_Polygon:
+        write (s->polygon ());
+        break;
+      case SST_SimplePolygon:
+        write (s->simple_polygon ().hull ());
+        break;
+      case SST_Box:
+        {
+          db::Box b = s->box ();
+          write (b.p1 () - db::Point ());
+          write (b.p2 () - b.p1 ());
+        }
+        break;
+      case SST_Edge:
+        write (s->edge ());
+        break;
+      case SST_EdgePair:
+        write (s->edge_pair ().first ());
+        write (s->edge_pair ().second ());
+        break;
+      case SST_TextRef:
+        {
+          db::Shape::text_ref_type tr = s->text_ref ();
+          write (tr.trans ().disp ());
+          write (tr.obj ());
+        }
+        break;
+      case SST_Text:
+        write (s->text ());
+        break;
+      default:
+        tl_assert (false);
+      }
+
+    }
+
+    write (size_t (SST_End));
+  }
+
+private:
+  tl::OutputStream *mp_os;
+
+  static SpillShapeType shape_type (const db::Shape &s)
+  {
+    switch (s.type ()) {
+    case db::Shape::PolygonRef:
+      return SST_PolygonRef;
+    case db::Shape::Polygon:
+      return SST_Polygon;
+    case db::Shape::SimplePolygon:
+      return SST_SimplePolygon;
+    case db::Shape::Box:
+    case db::Shape::ShortBox:
+      return SST_Box;
+    case db::Shape::Edge:
+      return SST_Edge;
+    case db::Shape::EdgePair:
+      return SST_EdgePair;
+    case db::Shape::TextRef:
+      return SST_TextRef;
+    case db::Shape::Text:
+      return SST_Text;
+    default:
+      return SST_End;
+    }
+  }
+
+  void write_signed (db::Coord c)
+  {
+    //  zig-zag encoding
+    int64_t v = c;
+    write (size_t ((uint64_t (v) << 1) ^ uint64_t (v >> 63)));
+  }
+
+  void write (const db::Vector &v)
+  {
+    write_signed (v.x ());
+    write_signed (v.y ());
+  }
+
+  void write (const db::Edge &e)
+  {
+    write (e.p1 () - db::Point ());
+    write (e.p2 () - e.p1 ());
+  }
+
+  void write (const db::Polygon::contour_type &c)
+  {
+    write (c.size ());
+    db::Point pl;
+    for (size_t i = 0; i < c.size (); ++i) {
+      db::Point p = c [i];
+      write (p - pl);
+      pl = p;
+    }
+  }
+
+  void write (const db::Polygon &poly)
+  {
+    write (poly.holes ());
+    for (unsigned int c = 0; c <= poly.holes (); ++c) {
+      write (poly.contour (c));
+    }
+  }
+
+  void write (const db::Text &text)
+  {
+    write (std::string (text.string ()));
+    write (size_t (text.trans ().rot ()));
+    write (text.trans ().disp ());
+    write_signed (text.size ());
+    write_signed (db::Coord (text.font ()));
+    write_signed (db::Coord (text.halign ()));
+    write_signed (db::Coord (text.valign ()));
+  }
+};
+
+/**
+ *  @brief Reads the shapes of a layer from a spill file
+ *
+ *  See DeepLayerSpillWriter for the format.
+ */
+class DeepLayerSpillReader
+{
+public:
+  DeepLayerSpillReader (tl::InputStream &is)
+    : mp_is (&is)
+  {
+    //  .. nothing yet ..
+  }
+
+  void read (db::Layout &layout, unsigned int layer)
+  {
+    db::LayoutLocker locker (&layout);
+
+    while (true) {
+
+      size_t ci = read ();
+      if (ci == 0) {
+        break;
+      }
+      --ci;
+
+      //  NOTE: cells are not deleted while the layer is spilled, but if they are, their shapes are dropped.
+      //  Cell indexes are not reused by db::Layout, so there is no risk of confusion.
+      db::Shapes *shapes = layout.is_valid_cell_index (ci) ? &layout.cell (ci).shapes (layer) : &m_dummy;
+      read_shapes (layout, shapes);
+
+    }
+
+    m_dummy.clear ();
+  }
+
+  void read_shapes (db::Layout &layout, db::Shapes *shapes)
+  {
+    while (true) {
+
+      SpillShapeType st = SpillShapeType (read ());
+      if (st == SST_End) {
+        break;
+      }
+
+      db::properties_id_type prop_id = db::properties_id_type (read ());
+
+      switch (st) {
+      case SST_PolygonRef:
+        {
+          db::Vector d = read_vector ();
+          db::Polygon poly;
+          read_polygon (poly);
+          insert (shapes, db::PolygonRef (poly.transformed (db::Disp (d)), layout.shape_repository ()), prop_id);
+        }
+        break;
+      case SST_Polygon:
+        {
+          db::Polygon poly;
+          read_polygon (poly);
+          insert (shapes, poly, prop_id);
+        }
+        break;
+      case SST_SimplePolygon:
+        {
+          std::vector<db::Point> pts;
+          read_contour (pts);
+          db::SimplePolygon poly;
+          poly.assign_hull (pts.begin (), pts.end (), false);
+          insert (shapes, poly, prop_id);
+        }
+        break;
+      case SST_Box:
+        {
+          db::Point p1 = db::Point () + read_vector ();
+          db::Point p2 = p1 + read_vector ();
+          insert (shapes, db::Box (p1, p2), prop_id);
+        }
+        break;
+      case SST_Edge:
+        insert (shapes, read_edge (), prop_id);
+        break;
+      case SST_EdgePair:
+        {
+          db::Edge e1 = read_edge ();
+          db::Edge e2 = read_edge ();
+          insert (shapes, db::EdgePair (e1, e2), prop_id);
+        }
+        break;
+      case SST_TextRef:
+        {
+          db::Vector d = read_vector ();
+          db::Text text = read_text ();
+          insert (shapes, db::TextRef (text.transformed (db::Disp (d)), layout.shape_repository ()), prop_id);
+        }
+        break;
+      case SST_Text:
+        insert (shapes, read_text (), prop_id);
+        break;
+      default:
+        throw tl::Exception (tl::to_string (tr ("Corrupt deep shape store spill file: %s")), mp_is->source ());
+      }
+
+    }
+  }
+
+  size_t read ()
+  {
+    size_t n = 0;
+    unsigned int shift = 0;
+    while (true) {
+      unsigned char c = (unsigned char) *get (1);
+      n |= size_t (c & 0x7f) << shift;
+      if ((c & 0x80) == 0) {
+        return n;
+      }
+      shift += 7;
+    }
+  }
+
+  std::string read_string ()
+  {
+    size_t n = read ();
+    return std::string (n > 0 ? get (n) : "", n);
+  }
+
+private:
+  tl::InputStream *mp_is;
+  db::Shapes m_dummy;
+
+  template <class Sh>
+  void insert (db::Shapes *shapes, const Sh &sh, db::properties_id_type prop_id)
+  {
+    if (prop_id != 0) {
+      shapes->insert (db::object_with_properties<Sh> (sh, prop_id));
+    } else {
+      shapes->insert (sh);
+    }
+  }
+
+  const char *get (size_t n)
+  {
+    const char *b = mp_is->get (n);
+    if (! b) {
+      throw tl::Exception (tl::to_string (tr ("Unexpected end of deep shape store spill file: %s")), mp_is->source ());
+    }
+    return b;
+  }
+
+  db::Coord read_signed ()
+  {
+    uint64_t v = uint64_t (read ());
+    return db::Coord (int64_t (v >> 1) ^ -int64_t (v & 1));
+  }
+
+  db::Vector read_vector ()
+  {
+    db::Coord x = read_signed ();
+    db::Coord y = read_signed ();
+    return db::Vector (x, y);
+  }
+
+  db::Edge read_edge ()
+  {
+    db::Point p1 = db::Point () + read_vector ();
+    db::Point p2 = p1 + read_vector ();
+    return db::Edge (p1, p2);
+  }
+
+  void read_contour (std::vector<db::Point> &pts)
+  {
+    size_t n = read ();
+    pts.clear ();
+    pts.reserve (n);
+    db::Point pl;
+    for (size_t i = 0; i < n; ++i) {
+      pl += read_vector ();
+      pts.push_back (pl);
+    }
+  }
+
+  void read_polygon (db::Polygon &poly)
+  {
+    size_t holes = read ();
+    std::vector<db::Point> pts;
+    read_contour (pts);
+    poly.assign_hull (pts.begin (), pts.end (), false);
+    for (size_t h = 0; h < holes; ++h) {
+      read_contour (pts);
+      poly.insert_hole (pts.begin (), pts.end (), false);
+    }
+  }
+
+  db::Text read_text ()
+  {
+    std::string s = read_string ();
+    int rot = int (read ());
+    db::Vector d = read_vector ();
+    db::Coord size = read_signed ();
+    db::Font font = db::Font (read_signed ());
+    db::HAlign halign = db::HAlign (read_signed ());
+    db::VAlign valign = db::VAlign (read_signed ());
+    return db::Text (s, db::Trans (rot, d), size, font, halign, valign);
+  }
+};
+
+/**
+ *  @brief Computes the memory used by the shape containers of a layer
+ */
+class LayerMemoryStatistics
+  : public db::MemStatistics
+{
+public:
+  LayerMemoryStatistics ()
+    : m_size (0)
+  {
+    //  .. nothing yet ..
+  }
+
+  virtual void add (const std::type_info & /*ti*/, void * /*ptr*/, size_t size, size_t /*used*/, void * /*parent*/, purpose_t /*purpose*/, int /*cat*/)
+  {
+    m_size += size;
+  }
+
+  size_t size () const
+  {
+    return m_size;
+  }
+
+private:
+  size_t m_size;
+};
+
+size_t layer_memory (const db::Layout &layout, unsigned int layer)
+{
+  LayerMemoryStatistics ms;
+  for (db::Layout::const_iterator c = layout.begin (); c != layout.end (); ++c) {
+
+    const db::Shapes &shapes = c->shapes (layer);
+    if (shapes.empty ()) {
+      continue;
+    }
+
+    db::mem_stat (&ms, db::MemStatistics::None, 0, shapes);
+
+    //  the objects referenced live in the shape repository - shared ones are counted once per reference
+    for (db::Shapes::shape_iterator s = shapes.begin (db::ShapeIterator::Polygons | db::ShapeIterator::Texts); ! s.at_end (); ++s) {
+      if (s->type () == db::Shape::PolygonRef) {
+        db::mem_stat (&ms, db::MemStatistics::None, 0, s->polygon_ref ().obj ());
+      } else if (s->type () == db::Shape::TextRef) {
+        db::mem_stat (&ms, db::MemStatistics::None, 0, s->text_ref ().obj ());
+      }
+    }
+
+  }
+  return ms.size ();
+}
+
+/**
+ *  @brief Removes the polygons and texts not referenced by any layer from the layout's shape repository
+ *
+ *  Clearing a layer leaves its polygons and texts in the repository. Pointers to the
+ *  objects still referenced are not affected. Returns false if the repository could
+ *  not be compacted because some shapes refer to it in a way not handled here.
+ */
+bool compact_shape_repository (db::Layout &layout)
+{
+  std::vector<const db::Polygon *> polygons;
+  std::vector<const db::Text *> texts;
+
+  for (db::Layout::const_iterator c = layout.begin (); c != layout.end (); ++c) {
+
+    for (unsigned int l = 0; l < layout.layers (); ++l) {
+
+      if (! layout.is_valid_layer (l)) {
+        continue;
+      }
+
+      const db::Shapes &shapes = c->shapes (l);
+      if (shapes.empty ()) {
+        continue;
+      }
+
+      for (db::Shapes::shape_iterator s = shapes.begin (db::ShapeIterator::Polygons | db::ShapeIterator::Texts); ! s.at_end (); ++s) {
+        switch (s->type ()) {
+        case db::Shape::PolygonRef:
+          polygons.push_back (&s->polygon_ref ().obj ());
+          break;
+        case db::Shape::TextRef:
+          texts.push_back (&s->text_ref ().obj ());
+          break;
+        case db::Shape::PolygonPtrArray:
+        case db::Shape::PolygonPtrArrayMember:
+        case db::Shape::TextPtrArray:
+        case db::Shape::TextPtrArrayMember:
+          return false;
+        default:
+          break;
+        }
+      }
+
+    }
+
+  }
+
+  std::sort (polygons.begin (), polygons.end ());
+  polygons.erase (std::unique (polygons.begin (), polygons.end ()), polygons.end ());
+  layout.shape_repository ().repository (db::Polygon::tag ()).erase_unused (polygons);
+
+  std::sort (texts.begin (), texts.end ());
+  texts.erase (std::unique (texts.begin (), texts.end ()), texts.end ());
+  layout.shape_repository ().repository (db::Text::tag ()).erase_unused (texts);
+
+  return true;
+}
+
+/**
+ *  @brief Computes a hash value for the shapes of a shape container
+ */
+size_t shapes_hash (const db::Shapes &shapes, size_t h)
+{
+  for (db::Shapes::shape_iterator s = shapes.begin (db::ShapeIterator::All); ! s.at_end (); ++s) {
+
+    h = std::hfunc (size_t (s->prop_id ()), h);
+
+    switch (s->type ()) {
+    case db::Shape::PolygonRef:
+      h = std::hfunc (s->polygon_ref (), h);
+      break;
+    case db::Shape::Polygon:
+      h = std::hfunc (s->polygon (), h);
+      break;
+    case db::Shape::SimplePolygon:
+      h = std::hfunc (s->simple_polygon (), h);
+      break;
+    case db::Shape::Box:
+    case db::Shape::ShortBox:
+      h = std::hfunc (s->box (), h);
+      break;
+    case db::Shape::Edge:
+      h = std::hfunc (s->edge (), h);
+      break;
+    case db::Shape::EdgePair:
+      h = std::hfunc (s->edge_pair (), h);
+      break;
+    case db::Shape::Path:
+      h = std::hfunc (s->path (), h);
+      break;
+    case db::Shape::TextRef:
+    case db::Shape::Text:
+      h = std::hfunc (s->text (), h);
+      break;
+    default:
+      h = std::hfunc (int (s->type ()), h);
+      break;
+    }
+
+  }
+
+  return h;
+}
+
+/**
+ *  @brief Computes a hash value for a cell's instances and its shapes on the given layer
+ *
+ *  Child cells are identified by their names, so the hash value does not depend
+ *  on the cell indexes.
+ */
+size_t cell_hash (const db::Layout &layout, const db::Cell &cell, unsigned int layer)
+{
+  size_t h = std::hfunc (std::string (layout.cell_name (cell.cell_index ())));
+
+  for (db::Cell::const_iterator i = cell.begin (); ! i.at_end (); ++i) {
+    db::CellInstArray inst = i->cell_inst ();
+    h = std::hfunc (std::string (layout.cell_name (inst.object ().cell_index ())), h);
+    inst.object () = db::CellInst (0);
+    h = std::hfunc (inst, h);
+  }
+
+  return shapes_hash (cell.shapes (layer), h);
+}
+
+std::string spill_file_name ()
+{
+  static tl::Mutex lock;
+  static unsigned int id = 0;
+
+  unsigned int this_id = 0;
+  {
+    tl::MutexLocker locker (&lock);
+    this_id = ++id;
+  }
+
+#if defined(_WIN32)
+  int pid = _getpid ();
+  std::string tmp = tl::get_env ("TEMP", tl::get_env ("TMP", "."));
+#else
+  int pid = getpid ();
+  std::string tmp = tl::get_env ("TMPDIR", "/tmp");
+#endif
+
+  return tl::combine_path (tmp, tl::sprintf ("klayout-dss-%d-%u.bin", pid, this_id));
+}
+
+}
+
+size_t
+DeepShapeStore::LayoutHolder::layer_size (unsigned int layer)
+{
+  std::map<unsigned int, size_t>::const_iterator s = layer_sizes.find (layer);
+  if (s == layer_sizes.end ()) {
+    s = layer_sizes.insert (std::make_pair (layer, layer_memory (layout, layer))).first;
+  }
+  return s->second;
+}
+
 // ----------------------------------------------------------------------------------
 
 DeepShapeStoreState::DeepShapeStoreState ()
-  : m_threads (1), m_max_area_ratio (3.0), m_max_vertex_count (16), m_text_property_name (), m_text_enlargement (-1)
+  : m_threads (1), m_thread_affinity (), m_max_area_ratio (3.0), m_max_vertex_count (16), m_text_property_name (), m_text_enlargement (-1), m_memory_limit (0)
 {
   //  .. nothing yet ..
 }
 
+void DeepShapeStoreState::set_memory_limit (size_t limit)
+{
+  m_memory_limit = limit;
+}
+
+size_t DeepShapeStoreState::memory_limit () const
+{
+  return m_memory_limit;
+}
+
 void DeepShapeStoreState::set_text_enlargement (int enl)
 {
   m_text_enlargement = enl;
@@ -361,6 +1039,18 @@ DeepShapeStoreState::threads () const
   return m_threads;
 }
 
+void
+DeepShapeStoreState::set_thread_affinity (const std::vector<int> &cpus)
+{
+  m_thread_affinity = cpus;
+}
+
+const std::vector<int> &
+DeepShapeStoreState::thread_affinity () const
+{
+  return m_thread_affinity;
+}
+
 void
 DeepShapeStoreState::set_max_area_ratio (double ar)
 {
@@ -390,11 +1080,13 @@ DeepShapeStoreState::max_vertex_count () const
 static size_t s_instance_count = 0;
 
 DeepShapeStore::DeepShapeStore ()
+  : m_use_stamp (0), m_spilled_layers (0), m_spill_count (0), m_reload_count (0), m_reload_time (0.0)
 {
   ++s_instance_count;
 }
 
 DeepShapeStore::DeepShapeStore (const std::string &topcell_name, double dbu)
+  : m_use_stamp (0), m_spilled_layers (0), m_spill_count (0), m_reload_count (0), m_reload_time (0.0)
 {
   ++s_instance_count;
 
@@ -621,6 +1313,16 @@ int DeepShapeStore::threads () const
   return m_state.threads ();
 }
 
+void DeepShapeStore::set_thread_affinity (const std::vector<int> &cpus)
+{
+  m_state.set_thread_affinity (cpus);
+}
+
+const std::vector<int> &DeepShapeStore::thread_affinity () const
+{
+  return m_state.thread_affinity ();
+}
+
 void DeepShapeStore::set_max_area_ratio (double ar)
 {
   m_state.set_max_area_ratio (ar);
@@ -641,6 +1343,358 @@ size_t DeepShapeStore::max_vertex_count () const
   return m_state.max_vertex_count ();
 }
 
+void DeepShapeStore::set_memory_limit (size_t limit)
+{
+  if (limit != m_state.memory_limit ()) {
+    clear_layer_sizes ();
+  }
+  m_state.set_memory_limit (limit);
+}
+
+size_t DeepShapeStore::memory_limit () const
+{
+  return m_state.memory_limit ();
+}
+
+void DeepShapeStore::clear_layer_sizes ()
+{
+  //  without a memory limit, modifications are not tracked, so the layer sizes may be outdated
+  tl::MutexLocker locker (&m_lock);
+  for (std::vector<LayoutHolder *>::const_iterator h = m_layouts.begin (); h != m_layouts.end (); ++h) {
+    if (*h) {
+      (*h)->layer_sizes.clear ();
+    }
+  }
+}
+
+size_t DeepShapeStore::memory_used () const
+{
+  tl::MutexLocker locker (&const_cast<DeepShapeStore *> (this)->m_lock);
+
+  size_t total = 0;
+
+  for (std::vector<LayoutHolder *>::const_iterator h = m_layouts.begin (); h != m_layouts.end (); ++h) {
+    if (*h) {
+      for (std::map<unsigned int, int>::const_iterator l = (*h)->layer_refs.begin (); l != (*h)->layer_refs.end (); ++l) {
+        if ((*h)->spilled_layers.find (l->first) == (*h)->spilled_layers.end ()) {
+          total += (*h)->layer_size (l->first);
+        }
+      }
+    }
+  }
+
+  return total;
+}
+
+void DeepShapeStore::lock_shape_repository (unsigned int layout_index)
+{
+  tl::MutexLocker locker (&m_lock);
+  tl_assert (is_valid_layout_index (layout_index));
+  m_layouts [layout_index]->repository_locks += 1;
+}
+
+void DeepShapeStore::unlock_shape_repository (unsigned int layout_index)
+{
+  tl::MutexLocker locker (&m_lock);
+  if (is_valid_layout_index (layout_index) && m_layouts [layout_index]->repository_locks > 0) {
+    m_layouts [layout_index]->repository_locks -= 1;
+  }
+}
+
+size_t DeepShapeStore::spill ()
+{
+  size_t limit = m_state.memory_limit ();
+  if (limit == 0) {
+    return 0;
+  }
+
+  tl::MutexLocker locker (&m_lock);
+
+  //  collect the resident layers and order them by last use - the layer sizes are
+  //  cached, so only layers which are new or have been modified are scanned here
+  std::vector<std::pair<size_t, std::pair<unsigned int, unsigned int> > > candidates;
+  size_t total = 0;
+
+  for (unsigned int n = 0; n < (unsigned int) m_layouts.size (); ++n) {
+
+    LayoutHolder *holder = m_layouts [n];
+    if (! holder) {
+      continue;
+    }
+
+    for (std::map<unsigned int, int>::const_iterator l = holder->layer_refs.begin (); l != holder->layer_refs.end (); ++l) {
+
+      if (holder->spilled_layers.find (l->first) != holder->spilled_layers.end ()) {
+        continue;
+      }
+
+      total += holder->layer_size (l->first);
+
+      std::map<unsigned int, size_t>::const_iterator s = holder->layer_stamps.find (l->first);
+      candidates.push_back (std::make_pair (s != holder->layer_stamps.end () ? s->second : 0, std::make_pair (n, l->first)));
+
+    }
+
+  }
+
+  if (total <= limit) {
+    return 0;
+  }
+
+  //  spill down to three quarters of the limit, so the next operations do not
+  //  immediately exceed the limit again
+  size_t target = limit - limit / 4;
+
+  std::sort (candidates.begin (), candidates.end ());
+
+  size_t spilled = 0;
+  std::set<unsigned int> spilled_layouts;
+
+  for (std::vector<std::pair<size_t, std::pair<unsigned int, unsigned int> > >::const_iterator c = candidates.begin (); c != candidates.end () && total > target; ++c) {
+    size_t mem = m_layouts [c->second.first]->layer_size (c->second.second);
+    if (spill_layer (c->second.first, c->second.second)) {
+      total -= mem;
+      ++spilled;
+      spilled_layouts.insert (c->second.first);
+    }
+  }
+
+  //  release the polygons and texts of the spilled layers
+  for (std::set<unsigned int>::const_iterator n = spilled_layouts.begin (); n != spilled_layouts.end (); ++n) {
+    if (m_layouts [*n]->repository_locks == 0) {
+      compact_shape_repository (m_layouts [*n]->layout);
+    }
+  }
+
+  if (spilled > 0) {
+    db::release_unused_contour_points ();
+  }
+
+  m_spill_count += spilled;
+  update_spilled_layers ();
+
+  return spilled;
+}
+
+bool DeepShapeStore::spill_layer (unsigned int n, unsigned int layer)
+{
+  LayoutHolder *holder = m_layouts [n];
+  db::Layout &ly = holder->layout;
+
+  bool any = false;
+  for (db::Layout::const_iterator c = ly.begin (); c != ly.end (); ++c) {
+    const db::Shapes &shapes = c->shapes (layer);
+    if (! shapes.empty ()) {
+      if (! DeepLayerSpillWriter::can_write (shapes)) {
+        return false;
+      }
+      any = true;
+    }
+  }
+
+  if (! any) {
+    //  nothing to gain
+    return false;
+  }
+
+  std::string fn = spill_file_name ();
+
+  try {
+
+    tl::OutputStream os (fn, tl::OutputStream::OM_Plain);
+    DeepLayerSpillWriter writer (os);
+
+    for (db::Layout::const_iterator c = ly.begin (); c != ly.end (); ++c) {
+      const db::Shapes &shapes = c->shapes (layer);
+      if (! shapes.empty ()) {
+        writer.write_cell (c->cell_index (), shapes);
+      }
+    }
+
+    writer.finish ();
+
+  } catch (...) {
+    tl::rm_file (fn);
+    throw;
+  }
+
+  for (db::Layout::iterator c = ly.begin (); c != ly.end (); ++c) {
+    c->clear (layer);
+  }
+
+  holder->spilled_layers [layer] = fn;
+  return true;
+}
+
+void DeepShapeStore::restore_layer (unsigned int n, unsigned int layer)
+{
+  LayoutHolder *holder = m_layouts [n];
+
+  std::map<unsigned int, std::string>::iterator s = holder->spilled_layers.find (layer);
+  if (s == holder->spilled_layers.end ()) {
+    return;
+  }
+
+  tl::Timer timer;
+  timer.start ();
+
+  {
+    tl::InputStream is (s->second);
+    DeepLayerSpillReader reader (is);
+    reader.read (holder->layout, layer);
+  }
+
+  timer.stop ();
+
+  tl::rm_file (s->second);
+  holder->spilled_layers.erase (s);
+  update_spilled_layers ();
+
+  m_reload_count += 1;
+  m_reload_time += timer.sec_wall ();
+}
+
+void DeepShapeStore::restore_layers (unsigned int n, bool for_update)
+{
+  tl::MutexLocker locker (&m_lock);
+
+  if (for_update) {
+    //  any layer may be modified
+    m_layouts [n]->layer_sizes.clear ();
+  }
+
+  std::vector<unsigned int> layers;
+  for (std::map<unsigned int, std::string>::const_iterator s = m_layouts [n]->spilled_layers.begin (); s != m_layouts [n]->spilled_layers.end (); ++s) {
+    layers.push_back (s->first);
+  }
+
+  for (std::vector<unsigned int>::const_iterator l = layers.begin (); l != layers.end (); ++l) {
+    restore_layer (n, *l);
+  }
+}
+
+void DeepShapeStore::require_layer (unsigned int n, unsigned int layer, bool for_update)
+{
+  //  shortcut for the normal case of no memory limit
+  if (m_state.memory_limit () == 0 && m_spilled_layers == 0) {
+    return;
+  }
+
+  tl::MutexLocker locker (&m_lock);
+
+  LayoutHolder *holder = (n < (unsigned int) m_layouts.size ()) ? m_layouts [n] : 0;
+  if (holder) {
+    holder->layer_stamps [layer] = ++m_use_stamp;
+    if (for_update) {
+      holder->layer_sizes.erase (layer);
+    }
+    restore_layer (n, layer);
+  }
+}
+
+void DeepShapeStore::update_spilled_layers ()
+{
+  size_t n = 0;
+  for (std::vector<LayoutHolder *>::const_iterator h = m_layouts.begin (); h != m_layouts.end (); ++h) {
+    if (*h) {
+      n += (*h)->spilled_layers.size ();
+    }
+  }
+  m_spilled_layers = n;
+}
+
+size_t DeepShapeStore::layer_hash (const DeepLayer &dl)
+{
+  const db::Layout &ly = dl.layout ();
+  unsigned int layer = dl.layer ();
+
+  size_t h = 0;
+  for (db::Layout::top_down_const_iterator c = ly.begin_top_down (); c != ly.end_top_down (); ++c) {
+    h = std::hcombine (h, cell_hash (ly, ly.cell (*c), layer));
+  }
+
+  return h;
+}
+
+static const char *layer_file_magic = "KLayout-DeepLayer-1";
+
+void DeepShapeStore::save_layer (const DeepLayer &dl, const std::string &key, const std::string &path)
+{
+  const db::Layout &ly = dl.layout ();
+  unsigned int layer = dl.layer ();
+
+  for (db::Layout::const_iterator c = ly.begin (); c != ly.end (); ++c) {
+    if (! DeepLayerSpillWriter::can_write (c->shapes (layer))) {
+      throw tl::Exception (tl::to_string (tr ("Layer contains shapes which cannot be saved")));
+    }
+  }
+
+  tl::OutputStream os (path, tl::OutputStream::OM_Plain);
+  DeepLayerSpillWriter writer (os);
+
+  writer.write (std::string (layer_file_magic));
+  writer.write (key);
+
+  size_t n = 0;
+  for (db::Layout::const_iterator c = ly.begin (); c != ly.end (); ++c) {
+    if (! c->shapes (layer).empty ()) {
+      ++n;
+    }
+  }
+
+  //  cells are identified by name, so the file can be read into another layout with the same cells
+  writer.write (n);
+  for (db::Layout::const_iterator c = ly.begin (); c != ly.end (); ++c) {
+    const db::Shapes &shapes = c->shapes (layer);
+    if (! shapes.empty ()) {
+      writer.write (std::string (ly.cell_name (c->cell_index ())));
+      writer.write_shapes (shapes);
+    }
+  }
+}
+
+bool DeepShapeStore::load_layer (DeepLayer &dl, const std::string &key, const std::string &path)
+{
+  db::Layout &ly = dl.layout ();
+  unsigned int layer = dl.layer ();
+
+  tl::InputStream is (path);
+  DeepLayerSpillReader reader (is);
+
+  if (reader.read_string () != layer_file_magic || reader.read_string () != key) {
+    return false;
+  }
+
+  try {
+
+    db::LayoutLocker locker (&ly);
+
+    size_t n = reader.read ();
+    while (n-- > 0) {
+
+      std::pair<bool, db::cell_index_type> cbn = ly.cell_by_name (reader.read_string ().c_str ());
+      if (! cbn.first) {
+        //  the cell tree does not match
+        for (db::Layout::iterator c = ly.begin (); c != ly.end (); ++c) {
+          c->clear (layer);
+        }
+        return false;
+      }
+
+      reader.read_shapes (ly, &ly.cell (cbn.second).shapes (layer));
+
+    }
+
+  } catch (...) {
+    for (db::Layout::iterator c = ly.begin (); c != ly.end (); ++c) {
+      c->clear (layer);
+    }
+    throw;
+  }
+
+  return true;
+}
+
 void DeepShapeStore::push_state ()
 {
   m_state_stack.push_back (m_state);
@@ -649,6 +1703,9 @@ void DeepShapeStore::push_state ()
 void DeepShapeStore::pop_state ()
 {
   if (! m_state_stack.empty ()) {
+    if (m_state_stack.back ().memory_limit () != m_state.memory_limit ()) {
+      clear_layer_sizes ();
+    }
     m_state = m_state_stack.back ();
     m_state_stack.pop_back ();
   }
@@ -662,12 +1719,27 @@ bool DeepShapeStore::is_valid_layout_index (unsigned int n) const
 const db::Layout &DeepShapeStore::const_layout (unsigned int n) const
 {
   tl_assert (is_valid_layout_index (n));
+  if (m_spilled_layers > 0) {
+    //  the caller may access any layer
+    const_cast<DeepShapeStore *> (this)->restore_layers (n, false);
+  }
   return m_layouts [n]->layout;
 }
 
 db::Layout &DeepShapeStore::layout (unsigned int n)
 {
   tl_assert (is_valid_layout_index (n));
+  if (m_spilled_layers > 0 || m_state.memory_limit () > 0) {
+    //  the caller may access and modify any layer
+    restore_layers (n, true);
+  }
+  return m_layouts [n]->layout;
+}
+
+db::Layout &DeepShapeStore::layout_for_layer (unsigned int n, unsigned int layer, bool for_update)
+{
+  tl_assert (is_valid_layout_index (n));
+  require_layer (n, layer, for_update);
   return m_layouts [n]->layout;
 }
 
@@ -708,6 +1780,10 @@ void DeepShapeStore::remove_ref (unsigned int layout, unsigned int layer)
     m_layouts[layout] = 0;
     clear_breakout_cells (layout);
   }
+
+  if (m_spilled_layers > 0) {
+    update_spilled_layers ();
+  }
 }
 
 unsigned int
@@ -971,6 +2047,11 @@ DeepShapeStore::cell_mapping_to_original (unsigned int layout_index, db::Layout
 
     } else {
 
+      //  geometrical mapping needs the full cell bounding boxes
+      if (m_spilled_layers > 0) {
+        restore_layers (layout_index, false);
+      }
+
       cm->second.create_from_geometry (*into_layout, into_cell, *source_layout, source_top);
 
     }
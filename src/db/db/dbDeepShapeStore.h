@@ -119,11 +119,15 @@ public:
   /**
    *  @brief Gets the layout object
    *  The return value is guaranteed to be non-null.
+   *  If the layer's shapes have been spilled to disk, this method will bring them back.
+   *  As the layer may be modified through the non-const layout, the store's memory
+   *  estimate for this layer is recomputed on the next "spill".
    */
   Layout &layout();
 
   /**
    *  @brief Gets the layout object (const version)
+   *  If the layer's shapes have been spilled to disk, this method will bring them back.
    */
   const db::Layout &layout () const;
 
@@ -240,6 +244,9 @@ public:
   void set_threads (int n);
   int threads () const;
 
+  void set_thread_affinity (const std::vector<int> &cpus);
+  const std::vector<int> &thread_affinity () const;
+
   void set_max_vertex_count (size_t n);
   size_t max_vertex_count () const;
 
@@ -252,6 +259,9 @@ public:
   void set_text_enlargement (int enl);
   int text_enlargement () const;
 
+  void set_memory_limit (size_t limit);
+  size_t memory_limit () const;
+
   const std::set<db::cell_index_type> *breakout_cells (unsigned int layout_index) const;
   void clear_breakout_cells (unsigned int layout_index);
   void set_breakout_cells (unsigned int layout_index, const std::set<db::cell_index_type> &boc);
@@ -260,11 +270,13 @@ public:
 
 private:
   int m_threads;
+  std::vector<int> m_thread_affinity;
   double m_max_area_ratio;
   size_t m_max_vertex_count;
   tl::Variant m_text_property_name;
   std::vector<std::set<db::cell_index_type> > m_breakout_cells;
   int m_text_enlargement;
+  size_t m_memory_limit;
 
   std::set<db::cell_index_type> &ensure_breakout_cells (unsigned int layout_index)
   {
@@ -486,6 +498,7 @@ public:
   {
     tl_assert (is_valid_layout_index (layout_index));
 
+    //  NOTE: layout () brings back all spilled layers - variant separation needs to copy all of them
     std::map<db::cell_index_type, std::map<db::ICplxTrans, db::cell_index_type> > var_map;
     coll.separate_variants (layout (layout_index), initial_cell (layout_index), &var_map);
     if (var_map.empty ()) {
@@ -508,7 +521,8 @@ public:
   {
     tl_assert (is_valid_layout_index (layout_index));
 
-    coll.commit_shapes (layout (layout_index), initial_cell (layout_index), layer, to_commit);
+    db::Layout &ly = layout_for_layer (layout_index, layer, true);
+    coll.commit_shapes (ly, ly.cell (*ly.begin_top_down ()), layer, to_commit);
   }
 
   /**
@@ -518,6 +532,8 @@ public:
 
   /**
    *  @brief Gets the nth layout (const version)
+   *
+   *  Layers of this layout which have been spilled to disk are brought back.
    */
   const db::Layout &const_layout (unsigned int n) const;
 
@@ -525,6 +541,7 @@ public:
    *  @brief Gets the nth layout (non-const version)
    *
    *  Don't try to mess too much with the layout object, you'll screw up the internals.
+   *  Layers of this layout which have been spilled to disk are brought back.
    */
   db::Layout &layout (unsigned int n);
 
@@ -611,6 +628,20 @@ public:
    */
   int threads () const;
 
+  /**
+   *  @brief Sets the CPUs the threads of the hierarchical processor are pinned to
+   *
+   *  Thread n is pinned to CPU cpus[n % cpus.size ()]. An empty list (the default) 
+   *  disables pinning. See tl::thread_affinity_layout for a way to compute a 
+   *  NUMA-aware assignment.
+   */
+  void set_thread_affinity (const std::vector<int> &cpus);
+
+  /**
+   *  @brief Gets the CPUs the threads are pinned to
+   */
+  const std::vector<int> &thread_affinity () const;
+
   /**
    *  @brief Sets the maximum vertex count default value
    *
@@ -669,6 +700,114 @@ public:
    */
   int text_enlargement () const;
 
+  /**
+   *  @brief Sets the memory limit in bytes
+   *
+   *  If a memory limit is set, "spill" will write the shapes of the least recently
+   *  used layers to temporary files until the remaining layers fit into this budget.
+   *  Spilled layers are brought back automatically when they are used again.
+   *  A value of 0 (the default) disables spilling.
+   */
+  void set_memory_limit (size_t limit);
+
+  /**
+   *  @brief Gets the memory limit
+   */
+  size_t memory_limit () const;
+
+  /**
+   *  @brief Spills layers to disk if the memory limit is exceeded
+   *
+   *  This method must only be called when no operation is working on the store.
+   *  If the memory used by the layers held in memory exceeds the limit, the least
+   *  recently used layers are spilled until three quarters of the limit are reached.
+   *  The polygons and texts of the spilled layers are removed from the layout's
+   *  shape repository unless the repository is locked (see "lock_shape_repository").
+   *  Returns the number of layers spilled.
+   */
+  size_t spill ();
+
+  /**
+   *  @brief Locks the shape repository of the given layout
+   *
+   *  Objects holding references to the polygons or texts of a working layout outside
+   *  of its layers (e.g. the net clusters of LayoutToNetlist) need to lock the shape
+   *  repository of this layout. Spilling will then keep the polygons and texts of the
+   *  spilled layers in memory. Each call needs to be balanced by "unlock_shape_repository".
+   */
+  void lock_shape_repository (unsigned int layout_index);
+
+  /**
+   *  @brief Unlocks the shape repository of the given layout (see "lock_shape_repository")
+   */
+  void unlock_shape_repository (unsigned int layout_index);
+
+  /**
+   *  @brief Gets the total number of layers spilled so far
+   */
+  size_t spill_count () const
+  {
+    return m_spill_count;
+  }
+
+  /**
+   *  @brief Gets the total number of layers reloaded from disk so far
+   */
+  size_t reload_count () const
+  {
+    return m_reload_count;
+  }
+
+  /**
+   *  @brief Gets the total time spent for reloading layers in seconds
+   */
+  double reload_time () const
+  {
+    return m_reload_time;
+  }
+
+  /**
+   *  @brief Gets the number of layers currently spilled to disk
+   */
+  size_t spilled_layers () const
+  {
+    return m_spilled_layers;
+  }
+
+  /**
+   *  @brief Gets the memory used by the layers held in memory
+   *
+   *  This is the estimate "spill" compares against the memory limit. It covers the
+   *  shape containers and the polygons and texts referenced. The memory of a layer
+   *  is computed once and again only after the layer was accessed for modification.
+   */
+  size_t memory_used () const;
+
+  /**
+   *  @brief Computes a content hash value for the given layer
+   *
+   *  The hash value covers the shapes of the layer and the cell tree. Cells are identified
+   *  by their names, so the hash value can be compared against hash values from other runs.
+   */
+  static size_t layer_hash (const DeepLayer &dl);
+
+  /**
+   *  @brief Writes the shapes of the given layer to a file
+   *
+   *  The key is stored inside the file and is checked when the file is loaded.
+   *  Cells are identified by name.
+   */
+  static void save_layer (const DeepLayer &dl, const std::string &key, const std::string &path);
+
+  /**
+   *  @brief Reads the shapes of a layer from a file written by "save_layer"
+   *
+   *  The shapes are added to the (usually empty) layer given by "dl". Returns false if
+   *  the file was written with a different key or the file refers to a cell which is not
+   *  present in the target layout. In this case, the layer will be empty.
+   */
+  static bool load_layer (DeepLayer &dl, const std::string &key, const std::string &path);
+
   /**
    *  @brief Gets the breakout cells for a given layout
    *  Returns 0 if there are no breakout cells for this layout.
@@ -697,7 +836,7 @@ public:
 
   /**
    *  @brief Pushes the state on the state stack
-   *  The state involves threads, max_area_ratio, max_vertex_count, the breakout cells and
+   *  The state involves threads, max_area_ratio, max_vertex_count, the memory limit, the breakout cells and
    *  the text representation properties (enlargement, property name).
    */
   void push_state ();
@@ -722,6 +861,14 @@ private:
 
   void issue_variants (unsigned int layout, const std::map<db::cell_index_type, std::map<db::ICplxTrans, db::cell_index_type> > &var_map);
 
+  db::Layout &layout_for_layer (unsigned int layout, unsigned int layer, bool for_update);
+  void require_layer (unsigned int layout, unsigned int layer, bool for_update);
+  void restore_layers (unsigned int layout, bool for_update);
+  void clear_layer_sizes ();
+  bool spill_layer (unsigned int layout, unsigned int layer);
+  void restore_layer (unsigned int layout, unsigned int layer);
+  void update_spilled_layers ();
+
   typedef std::map<std::pair<db::RecursiveShapeIterator, db::ICplxTrans>, unsigned int, RecursiveShapeIteratorCompareForTargetHierarchy> layout_map_type;
 
   //  no copying
@@ -735,6 +882,11 @@ private:
   DeepShapeStoreState m_state;
   std::list<DeepShapeStoreState> m_state_stack;
   tl::Mutex m_lock;
+  size_t m_use_stamp;
+  size_t m_spilled_layers;
+  size_t m_spill_count;
+  size_t m_reload_count;
+  double m_reload_time;
 
   struct DeliveryMappingCacheKey
   {
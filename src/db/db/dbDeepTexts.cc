@@ -480,6 +480,11 @@ public:
     }
   }
 
+  virtual bool allows_clipped_intruders () const
+  {
+    return true;
+  }
+
   virtual std::string description () const
   {
     return tl::to_string (tr ("Select interacting texts"));
@@ -584,6 +589,7 @@ DeepTexts::selected_interacting_generic (const Region &other, bool inverse) cons
   db::local_processor<db::TextRef, db::PolygonRef, db::TextRef> proc (const_cast<db::Layout *> (&texts.layout ()), const_cast<db::Cell *> (&texts.initial_cell ()), &other_deep->deep_layer ().layout (), &other_deep->deep_layer ().initial_cell ());
   proc.set_base_verbosity (other.base_verbosity ());
   proc.set_threads (texts.store ()->threads ());
+  proc.set_thread_affinity (texts.store ()->thread_affinity ());
 
   proc.run (&op, texts.layer (), other_deep->deep_layer ().layer (), dl_out.layer ());
 
@@ -610,6 +616,7 @@ RegionDelegate *DeepTexts::pull_generic (const Region &other) const
   db::local_processor<db::TextRef, db::PolygonRef, db::PolygonRef> proc (const_cast<db::Layout *> (&texts.layout ()), const_cast<db::Cell *> (&texts.initial_cell ()), &other_polygons.layout (), &other_polygons.initial_cell ());
   proc.set_base_verbosity (other.base_verbosity ());
   proc.set_threads (texts.store ()->threads ());
+  proc.set_thread_affinity (texts.store ()->thread_affinity ());
 
   proc.run (&op, texts.layer (), other_polygons.layer (), dl_out.layer ());
 
@@ -254,6 +254,15 @@ public:
 
   virtual bool less (const db::Device &a, const db::Device &b) const = 0;
   virtual bool equal (const db::Device &a, const db::Device &b) const = 0;
+
+  /**
+   *  @brief Returns true, if "less" and "equal" can be called from multiple threads
+   *  This is the case unless the delegate is implemented in a script.
+   */
+  virtual bool is_thread_safe () const
+  {
+    return true;
+  }
 };
 
 /**
@@ -579,6 +588,14 @@ public:
     return mp_pc_delegate.get ();
   }
 
+  /**
+   *  @brief Gets the parameter compare delegate or null if no such delegate is registered (const version)
+   */
+  const db::DeviceParameterCompareDelegate *parameter_compare_delegate () const
+  {
+    return mp_pc_delegate.get ();
+  }
+
 private:
   friend class Netlist;
 
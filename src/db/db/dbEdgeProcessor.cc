@@ -27,11 +27,13 @@
 #include "dbLayout.h"
 #include "tlTimer.h"
 #include "tlProgress.h"
+#include "tlThreadedWorkers.h"
 #include "gsi.h"
 
 #include <vector>
 #include <deque>
 #include <memory>
+#include <limits>
 
 #if 0
 #define DEBUG_MERGEOP
@@ -972,348 +974,678 @@ BooleanOp2::compare_ns () const
 }
 
 // -------------------------------------------------------------------------------
-//  EdgeProcessor implementation
+//  Scan line evaluation
 
-EdgeProcessor::EdgeProcessor (bool report_progress, const std::string &progress_desc)
-  : m_report_progress (report_progress), m_progress_desc (progress_desc), m_base_verbosity (30)
+/**
+ *  @brief Computes the output edges for a set of intersection-free edges
+ *
+ *  The edges need to be sorted by their lower y coordinate. The scan line starts
+ *  at "y" - edges starting below "y" are taken if they extend to "y" at least.
+ *  The scan line stops before "y_end" unless "y_end" is the maximum coordinate value.
+ *  "progress" is optional and will receive values from "todo_from" to "todo_to".
+ */
+static void
+produce_scanlines (std::vector <WorkEdge> &work_edges, db::Coord y, db::Coord y_end, db::EdgeSink &es, db::EdgeEvaluatorBase &op, tl::AbsoluteProgress *progress, size_t todo_from, size_t todo_to)
 {
-  mp_work_edges = new std::vector <WorkEdge> ();
-  mp_cpvector = new std::vector <CutPoints> ();
-}
+  bool prefer_touch = op.prefer_touch (); 
+  bool selects_edges = op.selects_edges (); 
 
-EdgeProcessor::~EdgeProcessor ()
-{
-  if (mp_work_edges) {
-    delete mp_work_edges;
-    mp_work_edges = 0;
-  }
-  if (mp_cpvector) {
-    delete mp_cpvector;
-    mp_cpvector = 0;
-  }
-}
+  size_t skip_unit = 1;
 
-void 
-EdgeProcessor::disable_progress ()
-{
-  m_report_progress = false;
-}
+  std::vector <WorkEdge>::iterator future = work_edges.begin ();
 
-void 
-EdgeProcessor::enable_progress (const std::string &progress_desc)
-{
-  m_report_progress = true;
-  m_progress_desc = progress_desc;
-}
+  //  Edges starting below "y" need to be brought into the order they would have when
+  //  the scan line comes from below. Otherwise ties between edges ending and edges
+  //  advancing at "y" are not resolved the same way as in a scan over all edges.
+  while (future != work_edges.end () && edge_ymin (*future) < y) {
+    ++future;
+  }
+  if (future != work_edges.begin ()) {
+    std::sort (work_edges.begin (), future, EdgeXAtYCompare2 (y - 1));
+  }
 
-void
-EdgeProcessor::set_base_verbosity (int bv)
-{
-  m_base_verbosity = bv;
-}
+  for (std::vector <WorkEdge>::iterator current = work_edges.begin (); current != work_edges.end () && (y < y_end || y_end == std::numeric_limits <db::Coord>::max ()); ) {
 
-void 
-EdgeProcessor::reserve (size_t n)
-{
-  mp_work_edges->reserve (n);
-}
+    if (progress) {
+      double p = double (std::distance (work_edges.begin (), current)) / double (work_edges.size ());
+      progress->set (size_t (double (todo_to - todo_from) * p) + todo_from);
+    }
 
-void 
-EdgeProcessor::insert (const db::Edge &e, EdgeProcessor::property_type p)
-{
-  if (e.p1 () != e.p2 ()) {
-    mp_work_edges->push_back (WorkEdge (e, p));
-  }
-}
+    std::vector <WorkEdge>::iterator f0 = future;
+    while (future != work_edges.end () && edge_ymin (*future) <= y) {
+      tl_assert (future->data == 0); // HINT: for development
+      ++future;
+    }
+    std::sort (f0, future, EdgeXAtYCompare2 (y));
 
-void 
-EdgeProcessor::insert (const db::Polygon &q, EdgeProcessor::property_type p)
-{
-  for (db::Polygon::polygon_edge_iterator e = q.begin_edge (); ! e.at_end (); ++e) {
-    insert (*e, p);
-  }
-}
+    db::Coord yy = std::numeric_limits <db::Coord>::max ();
+    if (future != work_edges.end ()) {
+      yy = edge_ymin (*future);
+    }
+    for (std::vector <WorkEdge>::const_iterator c = current; c != future; ++c) {
+      if (edge_ymax (*c) > y) {
+        yy = std::min (yy, edge_ymax (*c));
+      }
+    }
 
-void 
-EdgeProcessor::clear ()
-{
-  mp_work_edges->clear ();
-  mp_cpvector->clear ();
-}
+    db::Coord ysl = y;
+    es.begin_scanline (y);
 
-static void
-add_hparallel_cutpoints (WorkEdge &e1, WorkEdge &e2, std::vector <CutPoints> &cutpoints)
-{
-  db::Coord e1_xmin = std::min (e1.x1 (), e1.x2 ());
-  db::Coord e1_xmax = std::max (e1.x1 (), e1.x2 ());
-  if (e2.x1 () > e1_xmin && e2.x1 () < e1_xmax) {
-    e1.make_cutpoints (cutpoints)->add (e2.p1 (), &cutpoints, false);
-  }
-  if (e2.x2 () > e1_xmin && e2.x2 () < e1_xmax) {
-    e1.make_cutpoints (cutpoints)->add (e2.p2 (), &cutpoints, false);
-  }
-}
+    tl_assert (op.is_reset ()); // HINT: for development
 
-static void
-get_intersections_per_band_90 (std::vector <CutPoints> &cutpoints, std::vector <WorkEdge>::iterator current, std::vector <WorkEdge>::iterator future, db::Coord y, db::Coord yy, bool with_h)
-{
-  std::sort (current, future, edge_xmin_compare<db::Coord> ());
+    if (current != future) {
 
+      std::inplace_merge (current, f0, future, EdgeXAtYCompare2 (y));
 #ifdef DEBUG_EDGE_PROCESSOR
-  printf ("y=%d..%d (90 degree)\n", y, yy);
-  printf ("edges:"); 
-  for (std::vector <WorkEdge>::iterator c1 = current; c1 != future; ++c1) { 
-    printf (" %s", c1->to_string().c_str ()); 
-  } 
-  printf ("\n");
+      printf ("y=%d ", y);
+      for (std::vector <WorkEdge>::iterator c = current; c != future; ++c) { 
+        printf ("%ld-", long (c->data)); 
+      } 
+      printf ("\n");
 #endif
-  db::Coord x = edge_xmin (*current);
 
-  std::vector <WorkEdge>::iterator f = current;
-  for (std::vector <WorkEdge>::iterator c = current; c != future; ) {
+      db::Coord hx = 0;
+      int ho = 0;
 
-    while (f != future && edge_xmin (*f) <= x) {
-      ++f;
-    }
+      size_t new_skip_unit = std::distance (current, future);
 
-    db::Coord xx = std::numeric_limits <db::Coord>::max ();
-    if (f != future) {
-      xx = edge_xmin (*f);
-    }
+      for (std::vector <WorkEdge>::iterator c = current; c != future; ) {
 
+        size_t skip = c->data % skip_unit;
+        size_t skip_res = c->data / skip_unit;
 #ifdef DEBUG_EDGE_PROCESSOR
-    printf ("edges %d..%d:", x, xx); 
-    for (std::vector <WorkEdge>::iterator c1 = c; c1 != f; ++c1) { 
-      printf (" %s", c1->to_string().c_str ()); 
-    } 
-    printf ("\n");
+        printf ("X %ld->%d,%d\n", long (c->data), int (skip), int (skip_res));
 #endif
 
-    if (std::distance (c, f) > 1) {
+        if (skip != 0 && (c + skip >= future || (c + skip)->data != 0)) {
 
-      db::Box cell (x, y, xx, yy);
+          tl_assert (c + skip <= future);
 
-      for (std::vector <WorkEdge>::iterator c1 = c; c1 != f; ++c1) {
+          es.skip_n (skip_res);
 
-        bool c1p1_in_cell = cell.contains (c1->p1 ());
-        bool c1p2_in_cell = cell.contains (c1->p2 ());
+          c->data = skip + new_skip_unit * skip_res;
 
-        for (std::vector <WorkEdge>::iterator c2 = c; c2 != f; ++c2) {
+          //  skip this interval - has not changed
+          c += skip;
 
-          if (c1 == c2) {
-            continue;
-          }
+        } else {
 
-          if (c2->dy () == 0) {
+          std::vector <WorkEdge>::iterator c0 = c;
+          size_t n_res = 0;
 
-            if ((with_h || c1->dy () != 0) && c1 < c2) {
+          do {
 
-              if (c1->dy () == 0) {
+            c->data = 0;
+            std::vector <WorkEdge>::iterator f = c + 1;
 
-                //  parallel horizontal edges: produce the end points of each other edge as cutpoints
-                if (c1->p1 ().y () == c2->p1 ().y ()) {
-                  add_hparallel_cutpoints (*c1, *c2, cutpoints);
-                  add_hparallel_cutpoints (*c2, *c1, cutpoints);
-                }
+            //  HINT: "volatile" forces x and xx into memory and disables FPU register optimisation.
+            //  That way, we can exactly compare doubles afterwards.
+            volatile double x = edge_xaty (*c, y);
 
-              } else if (c1->p1 () != c2->p1 () && c1->p2 () != c2->p1 () &&
-                         c1->p1 () != c2->p2 () && c1->p2 () != c2->p2 ()) {
+            while (f != future) {
+              volatile double xx = edge_xaty (*f, y);
+              if (xx != x) {
+                break;
+              }
+              f->data = 0;
+              ++f;
+            }
 
-                std::pair <bool, db::Point> cp = c1->intersect_point (*c2);
-                if (cp.first) {
+            //  compute edges that occure at this vertex
+            
+            bool vertex = false;
+            
+            //  treat all edges crossing the scanline in a certain point
+            for (std::vector <WorkEdge>::iterator cc = c; cc != f; ) {
 
-                  //  add a cut point to c1 and c2 (c2 only if necessary)
-                  c1->make_cutpoints (cutpoints)->add (cp.second, &cutpoints, true);
-                  if (with_h) {
-                    c2->make_cutpoints (cutpoints)->add (cp.second, &cutpoints, true);
-                  }
+              std::vector <WorkEdge>::iterator e = work_edges.end ();
 
-#ifdef DEBUG_EDGE_PROCESSOR
-                  printf ("intersection point %s between %s and %s (1).\n", cp.second.to_string ().c_str (), c1->to_string ().c_str (), c2->to_string ().c_str ());
-#endif
+              int pn = 0, ps = 0;
 
-                }
+              std::vector <WorkEdge>::iterator cc0 = cc;
+
+              std::vector <WorkEdge>::iterator fc = cc;
+              do {
+                ++fc;
+              } while (fc != f && EdgeXAtYCompare2 (y).equal (*fc, *cc));
 
+              //  sort the coincident edges by property ID - that will
+              //  simplify algorithms like "inside" and "outside".
+              if (fc - cc > 1) {
+                //  for prefer_touch we first deliver the opening edges in ascending
+                //  order, in the other case we the other way round so that the opening
+                //  edges are always delivered with ascending property ID order.
+                if (prefer_touch) {
+                  std::sort (cc, fc, EdgePropCompare ());
+                } else {
+                  std::sort (cc, fc, EdgePropCompareReverse ());
+                }
               }
 
-            } 
-          
-          } else if (c1->dy () == 0) {
-            
-            if (c1 < c2 && c1->p1 () != c2->p1 () && c1->p2 () != c2->p1 () &&
-                           c1->p1 () != c2->p2 () && c1->p2 () != c2->p2 ()) {
+              //  treat all coincident edges
+              do {
+
+                if (cc->dy () != 0) {
+
+                  if (e == work_edges.end () && edge_ymax (*cc) > y) {
+                    e = cc;
+                  }
+                  
+                  if ((cc->dy () > 0) == prefer_touch) {
+                    if (edge_ymax (*cc) > y) {
+                      pn += op.edge (true, prefer_touch, cc->prop);
+                    }
+                    if (edge_ymin (*cc) < y) {
+                      ps += op.edge (false, prefer_touch, cc->prop);
+                    }
+                  }
 
-              std::pair <bool, db::Point> cp = c1->intersect_point (*c2);
-              if (cp.first) {
-                
-                //  add a cut point to c1 and c2
-                c2->make_cutpoints (cutpoints)->add (cp.second, &cutpoints, true);
-                if (with_h) {
-                  c1->make_cutpoints (cutpoints)->add (cp.second, &cutpoints, true);
                 }
 
+                ++cc;
+
+              } while (cc != fc);
+
+              //  Give the edge selection operator a chance to select edges now
+              if (selects_edges) {
+
+                for (std::vector <WorkEdge>::iterator sc = cc0; sc != fc; ++sc) {
+                  if (edge_ymin (*sc) == y && op.select_edge (sc->dy () == 0, sc->prop)) {
+                    es.put (*sc);
 #ifdef DEBUG_EDGE_PROCESSOR
-                printf ("intersection point %s between %s and %s (2).\n", cp.second.to_string ().c_str (), c1->to_string ().c_str (), c2->to_string ().c_str ()); 
+                    printf ("put(%s)\n", sc->to_string().c_str());
 #endif
+                  }
+                }
 
               }
 
-            }
-
-          } else if (c1->p1 ().x () == c2->p1 ().x ()) {
+              //  report the closing or opening edges in the opposite order 
+              //  than the other ones (see previous loop). Hence we have some
+              //  symmetry of events which simplify implementatin of the 
+              //  InteractionDetector for example.
+              do {
+
+                --fc;
+
+                if (fc->dy () != 0 && (fc->dy () > 0) != prefer_touch) {
+                  if (edge_ymax (*fc) > y) {
+                    pn += op.edge (true, ! prefer_touch, fc->prop);
+                  }
+                  if (edge_ymin (*fc) < y) {
+                    ps += op.edge (false, ! prefer_touch, fc->prop);
+                  }
+                }
+
+              } while (fc != cc0);
+
+              if (! vertex && (ps != 0 || pn != 0)) {
+
+                if (ho != 0) {
+                  db::Edge he (db::Point (hx, y), db::Point (db::coord_traits<db::Coord>::rounded (x), y));
+                  if (ho > 0) {
+                    he.swap_points ();
+                  }
+                  es.put (he);
+#ifdef DEBUG_EDGE_PROCESSOR
+                  printf ("put(%s)\n", he.to_string().c_str());
+#endif
+                } 
+
+                vertex = true;
+
+              }
+
+              if (e != work_edges.end ()) {
+
+                db::Edge edge (*e);
+
+                if ((pn > 0 && edge.dy () < 0) || (pn < 0 && edge.dy () > 0)) {
+                  edge.swap_points ();
+                }
+
+                if (pn != 0) {
+                  ++n_res;
+                  if (edge_ymin (edge) == y) {
+                    es.put (edge);
+#ifdef DEBUG_EDGE_PROCESSOR
+                    printf ("put(%s)\n", edge.to_string().c_str());
+#endif
+                  } else {
+                    es.crossing_edge (edge);
+#ifdef DEBUG_EDGE_PROCESSOR
+                    printf ("xing(%s)\n", edge.to_string().c_str());
+#endif
+                  }
+                }
+
+              }
 
-            //  both edges are coincident - produce the ends of the edges involved as cut points
-            if (c1p1_in_cell && c1->p1 ().y () > db::edge_ymin (*c2) && c1->p1 ().y () < db::edge_ymax (*c2)) {
-              c2->make_cutpoints (cutpoints)->add (c1->p1 (), &cutpoints, true);
             }
-            if (c1p2_in_cell && c1->p2 ().y () > db::edge_ymin (*c2) && c1->p2 ().y () < db::edge_ymax (*c2)) {
-              c2->make_cutpoints (cutpoints)->add (c1->p2 (), &cutpoints, true);
+
+            if (vertex) {
+              hx = db::coord_traits<db::Coord>::rounded (x);
+              ho = op.compare_ns ();
             }
 
-          }
+            c = f;
+
+          } while (c != future && ! op.is_reset ());
+
+          //  TODO: assert that there is no overflow here:
+          c0->data = size_t (std::distance (c0, c) + new_skip_unit * n_res);
 
         }
 
       }
 
-    }
+      skip_unit = new_skip_unit;
 
-    x = xx;
-    for (std::vector <WorkEdge>::iterator cc = c; cc != f; ++cc) {
-      if (edge_xmax (*cc) < x) {
-        if (c != cc) {
-          std::swap (*cc, *c);
+      y = yy;
+
+#ifdef DEBUG_EDGE_PROCESSOR
+      for (std::vector <WorkEdge>::iterator c = current; c != future; ++c) { 
+        printf ("%ld-", long (c->data)); 
+      } 
+      printf ("\n");
+#endif
+      std::vector <WorkEdge>::iterator c0 = current;
+      std::vector <WorkEdge>::iterator last_interval = future;
+      current = future;
+
+      bool valid = true;
+
+      for (std::vector <WorkEdge>::iterator c = future; c != c0; ) {
+
+        --c;
+
+        bool start_interval = (c->data != 0);
+        size_t data = c->data;
+        c->data = 0;
+
+        db::Coord ymax = edge_ymax (*c);
+        if (ymax >= y) {
+          --current;
+          if (current != c) {
+            *current = *c;
+          }
         }
-        ++c;
+        if (ymax <= y) {
+          //  an edge ends now. The interval is not valid, i.e. cannot be skipped easily.
+          valid = false;
+        }
+
+        if (start_interval && current != future) {
+          current->data = valid ? data : 0;
+          last_interval = current;
+          valid = true;
+        }
+
       }
+#ifdef DEBUG_EDGE_PROCESSOR
+      for (std::vector <WorkEdge>::iterator c = current; c != future; ++c) { 
+        printf ("%ld-", long (c->data)); 
+      } 
+      printf ("\n");
+#endif
+    
     }
 
+    tl_assert (op.is_reset ()); // HINT: for development (second)
+
+    es.end_scanline (ysl);
+
   }
 }
 
 /**
- *  @brief Computes the x value of an edge at the given y value
- *
- *  HINT: for application in the scanline algorithm 
- *  it is important that this method delivers exactly (!) the same x for the same edge 
- *  (after normalization to dy()>0) and same y!
+ *  @brief An edge sink recording the scan line events for later delivery
  */
-template <class C>
-inline double edge_xaty_double (db::edge<C> e, double y)
+class EdgeSinkRecorder
+  : public db::EdgeSink
 {
-  if (e.p1 ().y () > e.p2 ().y ()) {
-    e.swap_points ();
+public:
+  EdgeSinkRecorder ()
+  {
+    //  .. nothing yet ..
   }
 
-  if (y <= e.p1 ().y ()) {
-    return e.p1 ().x ();
-  } else if (y >= e.p2 ().y ()) {
-    return e.p2 ().x ();
-  } else {
-    return double (e.p1 ().x ()) + double (e.dx ()) * (y - double (e.p1 ().y ())) / double (e.dy ());
+  virtual void put (const db::Edge &e)
+  {
+    m_events.push_back (Event (Put, e));
   }
-}
 
-/**
- *  @brief Computes the left bound of the edge geometry for a given band [y1..y2].
- */
-template <class C>
-inline C edge_xmin_at_yinterval_double (const db::edge<C> &e, double y1, double y2) 
-{
-  if (e.dx () == 0) {
-    return e.p1 ().x ();
-  } else if (e.dy () == 0) {
-    return std::min (e.p1 ().x (), e.p2 ().x ());
-  } else {
-    return C (floor (edge_xaty_double (e, ((e.dy () < 0) ^ (e.dx () < 0)) == 0 ? y1 : y2)));
+  virtual void crossing_edge (const db::Edge &e)
+  {
+    m_events.push_back (Event (CrossingEdge, e));
   }
-}
 
-/**
- *  @brief Computes the right bound of the edge geometry for a given band [y1..y2].
- */
-template <class C>
-inline C edge_xmax_at_yinterval_double (const db::edge<C> &e, double y1, double y2) 
-{
-  if (e.dx () == 0) {
-    return e.p1 ().x ();
-  } else if (e.dy () == 0) {
-    return std::max (e.p1 ().x (), e.p2 ().x ());
-  } else {
-    return C (ceil (edge_xaty_double (e, ((e.dy () < 0) ^ (e.dx () < 0)) != 0 ? y1 : y2)));
+  virtual void skip_n (size_t n)
+  {
+    m_events.push_back (Event (SkipN, db::Edge (), n));
   }
-}
 
-/**
- *  @brief Functor that compares two edges by their left bound for a given interval [y1..y2].
- *
- *  This function is intended for use in scanline scenarious to determine what edges are 
- *  interacting in a certain y interval.
- */
-template <class C>
-struct edge_xmin_at_yinterval_double_compare
-{
-  edge_xmin_at_yinterval_double_compare (double y1, double y2)
-    : m_y1 (y1), m_y2 (y2)
+  virtual void begin_scanline (db::Coord y)
   {
-    // .. nothing yet ..
+    m_events.push_back (Event (BeginScanline, db::Edge (), 0, y));
   }
 
-  bool operator() (const db::edge<C> &a, const db::edge<C> &b) const
+  virtual void end_scanline (db::Coord y)
   {
-    if (edge_xmax (a) < edge_xmin (b)) {
-      return true;
-    } else if (edge_xmin (a) >= edge_xmax (b)) {
-      return false;
-    } else {
-      C xa = edge_xmin_at_yinterval_double (a, m_y1, m_y2);
-      C xb = edge_xmin_at_yinterval_double (b, m_y1, m_y2);
-      if (xa != xb) {
-        return xa < xb;
-      } else {
-        return a < b;
+    m_events.push_back (Event (EndScanline, db::Edge (), 0, y));
+  }
+
+  /**
+   *  @brief Delivers the recorded events to the given edge sink
+   */
+  void replay (db::EdgeSink &es) const
+  {
+    for (std::vector<Event>::const_iterator e = m_events.begin (); e != m_events.end (); ++e) {
+      switch (e->type) {
+      case Put:
+        es.put (e->edge);
+        break;
+      case CrossingEdge:
+        es.crossing_edge (e->edge);
+        break;
+      case SkipN:
+        es.skip_n (e->n);
+        break;
+      case BeginScanline:
+        es.begin_scanline (e->y);
+        break;
+      case EndScanline:
+        es.end_scanline (e->y);
+        break;
       }
     }
   }
 
-public:
-  double m_y1, m_y2;
+private:
+  enum EventType { Put, CrossingEdge, SkipN, BeginScanline, EndScanline };
+
+  struct Event
+  {
+    Event (EventType t, const db::Edge &e, size_t _n = 0, db::Coord _y = 0)
+      : type (t), edge (e), n (_n), y (_y)
+    { }
+
+    EventType type;
+    db::Edge edge;
+    size_t n;
+    db::Coord y;
+  };
+
+  std::vector<Event> m_events;
 };
 
-static void 
-get_intersections_per_band_any (std::vector <CutPoints> &cutpoints, std::vector <WorkEdge>::iterator current, std::vector <WorkEdge>::iterator future, db::Coord y, db::Coord yy, bool with_h)
+/**
+ *  @brief A horizontal band of the scan line
+ *
+ *  The band covers the scan lines from "y" up to (but not including) "y_end".
+ */
+struct EdgeProcessorBand
 {
-  std::vector <WorkEdge *> p1_weak; // holds weak interactions of edge endpoints with other edges
-  std::vector <WorkEdge *> ip_weak;
-  double dy = y - 0.5;
-  double dyy = yy + 0.5;
-
-  std::sort (current, future, edge_xmin_at_yinterval_double_compare<db::Coord> (dy, dyy));
+  EdgeProcessorBand (db::Coord _y, db::Coord _y_end, db::EdgeEvaluatorBase *_op)
+    : y (_y), y_end (_y_end), op (_op)
+  { }
 
-#ifdef DEBUG_EDGE_PROCESSOR
-  printf ("y=%d..%d\n", y, yy);
-  printf ("edges:"); 
-  for (std::vector <WorkEdge>::iterator c1 = current; c1 != future; ++c1) { 
-    printf (" %s", c1->to_string().c_str ()); 
-  } 
-  printf ("\n");
-#endif
-  db::Coord x = edge_xmin_at_yinterval_double (*current, dy, dyy);
+  std::vector <WorkEdge> edges;
+  db::Coord y, y_end;
+  std::auto_ptr<db::EdgeEvaluatorBase> op;
+  EdgeSinkRecorder recorder;
+};
 
-  std::vector <WorkEdge>::iterator f = current;
-  for (std::vector <WorkEdge>::iterator c = current; c != future; ) {
+class EdgeProcessorBandTask
+  : public tl::Task
+{
+public:
+  EdgeProcessorBandTask (EdgeProcessorBand *band)
+    : mp_band (band)
+  {
+    //  .. nothing yet ..
+  }
 
-    while (f != future && edge_xmin_at_yinterval_double (*f, dy, dyy) <= x) {
-      ++f;
-    }
+  void perform ()
+  {
+    produce_scanlines (mp_band->edges, mp_band->y, mp_band->y_end, mp_band->recorder, *mp_band->op, 0, 0, 0);
+    //  release the memory early
+    std::vector <WorkEdge> ().swap (mp_band->edges);
+  }
 
-    db::Coord xx = std::numeric_limits <db::Coord>::max ();
-    if (f != future) {
-      xx = edge_xmin_at_yinterval_double (*f, dy, dyy);
-    }
+private:
+  EdgeProcessorBand *mp_band;
+};
 
-#ifdef DEBUG_EDGE_PROCESSOR
-    printf ("edges %d..%d:", x, xx); 
+class EdgeProcessorBandWorker
+  : public tl::Worker
+{
+public:
+  EdgeProcessorBandWorker ()
+    : tl::Worker ()
+  {
+    //  .. nothing yet ..
+  }
+
+  void perform_task (tl::Task *task)
+  {
+    static_cast<EdgeProcessorBandTask *> (task)->perform ();
+  }
+};
+
+/**
+ *  @brief Computes the output edges in multiple bands using multiple threads
+ *
+ *  The edges are distributed over horizontal bands whose limits are taken from the
+ *  lower edge coordinates. Hence the band limits are scan line positions of
+ *  the single-band scan as well. Edges crossing the band limits are copied into
+ *  each band they are present in. The bands are evaluated in parallel and the
+ *  output is delivered to "es" band by band. This renders the same events
+ *  as a single scan over all edges, except that "skip_n" may be replaced by
+ *  individual edges at the beginning of a band.
+ *
+ *  Returns false if the operation cannot or should not be split into bands.
+ */
+static bool
+produce_scanlines_in_bands (std::vector <WorkEdge> &work_edges, unsigned int threads, db::EdgeSink &es, db::EdgeEvaluatorBase &op)
+{
+  //  don't split too much: the overhead of copying the edges needs to pay off
+  const size_t min_edges_per_band = 10000;
+
+  size_t n_bands = std::min (size_t (threads) * 4, work_edges.size () / min_edges_per_band);
+  if (n_bands < 2) {
+    return false;
+  }
+
+  std::auto_ptr<db::EdgeEvaluatorBase> op_test (op.clone ());
+  if (! op_test.get ()) {
+    return false;
+  }
+
+  std::vector<db::Coord> band_y;
+  band_y.reserve (n_bands);
+  band_y.push_back (edge_ymin (work_edges.front ()));
+  for (size_t i = 1; i < n_bands; ++i) {
+    db::Coord y = edge_ymin (work_edges [work_edges.size () * i / n_bands]);
+    if (y > band_y.back ()) {
+      band_y.push_back (y);
+    }
+  }
+
+  if (band_y.size () < 2) {
+    return false;
+  }
+
+  std::vector<EdgeProcessorBand *> bands;
+
+  try {
+
+    for (size_t b = 0; b < band_y.size (); ++b) {
+      db::Coord y_end = b + 1 < band_y.size () ? band_y [b + 1] : std::numeric_limits <db::Coord>::max ();
+      bands.push_back (new EdgeProcessorBand (band_y [b], y_end, op.clone ()));
+    }
+
+    //  distribute the edges: an edge goes into the band it starts in and all
+    //  following bands it reaches into
+    size_t b0 = 0;
+    for (std::vector <WorkEdge>::const_iterator e = work_edges.begin (); e != work_edges.end (); ++e) {
+      db::Coord ymin = edge_ymin (*e), ymax = edge_ymax (*e);
+      while (b0 + 1 < band_y.size () && band_y [b0 + 1] <= ymin) {
+        ++b0;
+      }
+      for (size_t b = b0; b < band_y.size () && (b == b0 || band_y [b] <= ymax); ++b) {
+        bands [b]->edges.push_back (*e);
+      }
+    }
+
+    tl::Job<EdgeProcessorBandWorker> job ((int) threads);
+    for (std::vector<EdgeProcessorBand *>::const_iterator b = bands.begin (); b != bands.end (); ++b) {
+      job.schedule (new EdgeProcessorBandTask (*b));
+    }
+
+    job.start ();
+    job.wait ();
+
+    if (job.has_error ()) {
+      throw tl::Exception (job.error_messages ().front ());
+    }
+
+    for (std::vector<EdgeProcessorBand *>::const_iterator b = bands.begin (); b != bands.end (); ++b) {
+      (*b)->recorder.replay (es);
+    }
+
+  } catch (...) {
+    for (std::vector<EdgeProcessorBand *>::const_iterator b = bands.begin (); b != bands.end (); ++b) {
+      delete *b;
+    }
+    throw;
+  }
+
+  for (std::vector<EdgeProcessorBand *>::const_iterator b = bands.begin (); b != bands.end (); ++b) {
+    delete *b;
+  }
+
+  return true;
+}
+
+// -------------------------------------------------------------------------------
+//  EdgeProcessor implementation
+
+EdgeProcessor::EdgeProcessor (bool report_progress, const std::string &progress_desc)
+  : m_report_progress (report_progress), m_progress_desc (progress_desc), m_base_verbosity (30), m_threads (0)
+{
+  mp_work_edges = new std::vector <WorkEdge> ();
+  mp_cpvector = new std::vector <CutPoints> ();
+}
+
+EdgeProcessor::~EdgeProcessor ()
+{
+  if (mp_work_edges) {
+    delete mp_work_edges;
+    mp_work_edges = 0;
+  }
+  if (mp_cpvector) {
+    delete mp_cpvector;
+    mp_cpvector = 0;
+  }
+}
+
+void 
+EdgeProcessor::disable_progress ()
+{
+  m_report_progress = false;
+}
+
+void 
+EdgeProcessor::enable_progress (const std::string &progress_desc)
+{
+  m_report_progress = true;
+  m_progress_desc = progress_desc;
+}
+
+void
+EdgeProcessor::set_base_verbosity (int bv)
+{
+  m_base_verbosity = bv;
+}
+
+void
+EdgeProcessor::set_threads (unsigned int n)
+{
+  m_threads = n;
+}
+
+void 
+EdgeProcessor::reserve (size_t n)
+{
+  mp_work_edges->reserve (n);
+}
+
+void 
+EdgeProcessor::insert (const db::Edge &e, EdgeProcessor::property_type p)
+{
+  if (e.p1 () != e.p2 ()) {
+    mp_work_edges->push_back (WorkEdge (e, p));
+  }
+}
+
+void 
+EdgeProcessor::insert (const db::Polygon &q, EdgeProcessor::property_type p)
+{
+  for (db::Polygon::polygon_edge_iterator e = q.begin_edge (); ! e.at_end (); ++e) {
+    insert (*e, p);
+  }
+}
+
+void 
+EdgeProcessor::clear ()
+{
+  mp_work_edges->clear ();
+  mp_cpvector->clear ();
+}
+
+static void
+add_hparallel_cutpoints (WorkEdge &e1, WorkEdge &e2, std::vector <CutPoints> &cutpoints)
+{
+  db::Coord e1_xmin = std::min (e1.x1 (), e1.x2 ());
+  db::Coord e1_xmax = std::max (e1.x1 (), e1.x2 ());
+  if (e2.x1 () > e1_xmin && e2.x1 () < e1_xmax) {
+    e1.make_cutpoints (cutpoints)->add (e2.p1 (), &cutpoints, false);
+  }
+  if (e2.x2 () > e1_xmin && e2.x2 () < e1_xmax) {
+    e1.make_cutpoints (cutpoints)->add (e2.p2 (), &cutpoints, false);
+  }
+}
+
+static void
+get_intersections_per_band_90 (std::vector <CutPoints> &cutpoints, std::vector <WorkEdge>::iterator current, std::vector <WorkEdge>::iterator future, db::Coord y, db::Coord yy, bool with_h)
+{
+  std::sort (current, future, edge_xmin_compare<db::Coord> ());
+
+#ifdef DEBUG_EDGE_PROCESSOR
+  printf ("y=%d..%d (90 degree)\n", y, yy);
+  printf ("edges:"); 
+  for (std::vector <WorkEdge>::iterator c1 = current; c1 != future; ++c1) { 
+    printf (" %s", c1->to_string().c_str ()); 
+  } 
+  printf ("\n");
+#endif
+  db::Coord x = edge_xmin (*current);
+
+  std::vector <WorkEdge>::iterator f = current;
+  for (std::vector <WorkEdge>::iterator c = current; c != future; ) {
+
+    while (f != future && edge_xmin (*f) <= x) {
+      ++f;
+    }
+
+    db::Coord xx = std::numeric_limits <db::Coord>::max ();
+    if (f != future) {
+      xx = edge_xmin (*f);
+    }
+
+#ifdef DEBUG_EDGE_PROCESSOR
+    printf ("edges %d..%d:", x, xx); 
     for (std::vector <WorkEdge>::iterator c1 = c; c1 != f; ++c1) { 
       printf (" %s", c1->to_string().c_str ()); 
     } 
@@ -1326,8 +1658,6 @@ get_intersections_per_band_any (std::vector <CutPoints> &cutpoints, std::vector
 
       for (std::vector <WorkEdge>::iterator c1 = c; c1 != f; ++c1) {
 
-        p1_weak.clear (); 
-
         bool c1p1_in_cell = cell.contains (c1->p1 ());
         bool c1p2_in_cell = cell.contains (c1->p2 ());
 
@@ -1352,38 +1682,18 @@ get_intersections_per_band_any (std::vector <CutPoints> &cutpoints, std::vector
               } else if (c1->p1 () != c2->p1 () && c1->p2 () != c2->p1 () &&
                          c1->p1 () != c2->p2 () && c1->p2 () != c2->p2 ()) {
 
-                std::pair <bool, db::Point> cp = safe_intersect_point (*c1, *c2);
+                std::pair <bool, db::Point> cp = c1->intersect_point (*c2);
                 if (cp.first) {
 
-                  bool on_edge1 = is_point_on_exact (*c1, cp.second);
-
-                  //  add a cut point to c1 and c2 (points not on the edge give strong attractors)
-                  c1->make_cutpoints (cutpoints)->add (cp.second, &cutpoints, !on_edge1);
+                  //  add a cut point to c1 and c2 (c2 only if necessary)
+                  c1->make_cutpoints (cutpoints)->add (cp.second, &cutpoints, true);
                   if (with_h) {
-                    c2->make_cutpoints (cutpoints)->add (cp.second, &cutpoints, false);
-                  }
-
-#ifdef DEBUG_EDGE_PROCESSOR
-                  if (on_edge1) {
-                    printf ("weak intersection point %s between %s and %s.\n", cp.second.to_string ().c_str (), c1->to_string ().c_str (), c2->to_string ().c_str ());
-                  } else {
-                    printf ("intersection point %s between %s and %s.\n", cp.second.to_string ().c_str (), c1->to_string ().c_str (), c2->to_string ().c_str ());
+                    c2->make_cutpoints (cutpoints)->add (cp.second, &cutpoints, true);
                   }
-#endif
 
-                  //  The new cutpoint must be inserted into other edges as well.
-                  ip_weak.clear ();
-                  for (std::vector <WorkEdge>::iterator cc = c; cc != f; ++cc) {
-                    if ((with_h || cc->dy () != 0) && cc != c1 && cc != c2 && is_point_on_fuzzy (*cc, cp.second)) {
-                      ip_weak.push_back (&*cc);
-                    }
-                  }
-                  for (std::vector <WorkEdge *>::iterator icc = ip_weak.begin (); icc != ip_weak.end (); ++icc) {
-                    (*icc)->make_cutpoints (cutpoints)->add (cp.second, &cutpoints, true);
 #ifdef DEBUG_EDGE_PROCESSOR
-                    printf ("intersection point %s gives cutpoint in %s.\n", cp.second.to_string ().c_str (), (*icc)->to_string ().c_str ());
+                  printf ("intersection point %s between %s and %s (1).\n", cp.second.to_string ().c_str (), c1->to_string ().c_str (), c2->to_string ().c_str ());
 #endif
-                  }
 
                 }
 
@@ -1391,131 +1701,38 @@ get_intersections_per_band_any (std::vector <CutPoints> &cutpoints, std::vector
 
             } 
           
-          } else if (c1->parallel (*c2) && c1->side_of (c2->p1 ()) == 0) {
-
-#ifdef DEBUG_EDGE_PROCESSOR
-            printf ("%s and %s are parallel.\n", c1->to_string ().c_str (), c2->to_string ().c_str ()); 
-#endif
-
-            //  both edges are coincident - produce the ends of the edges involved as cut points
-            if (c1p1_in_cell && c2->contains (c1->p1 ()) && c2->p1 () != c1->p1 () && c2->p2 () != c1->p1 ()) {
-              c2->make_cutpoints (cutpoints)->add (c1->p1 (), &cutpoints, !is_point_on_exact(*c2, c1->p1 ()));
-#ifdef DEBUG_EDGE_PROCESSOR
-              if (! is_point_on_exact(*c2, c1->p1 ())) {
-                printf ("intersection point %s between %s and %s.\n", c1->p1 ().to_string ().c_str (), c1->to_string ().c_str (), c2->to_string ().c_str ()); 
-              } else {
-                printf ("weak intersection point %s between %s and %s.\n", c1->p1 ().to_string ().c_str (), c1->to_string ().c_str (), c2->to_string ().c_str ()); 
-              }
-#endif
-            }
-            if (c1p2_in_cell && c2->contains (c1->p2 ()) && c2->p1 () != c1->p2 () && c2->p2 () != c1->p2 ()) {
-              c2->make_cutpoints (cutpoints)->add (c1->p2 (), &cutpoints, !is_point_on_exact(*c2, c1->p2 ()));
-#ifdef DEBUG_EDGE_PROCESSOR
-              if (! is_point_on_exact(*c2, c1->p2 ())) {
-                printf ("intersection point %s between %s and %s.\n", c1->p2 ().to_string ().c_str (), c1->to_string ().c_str (), c2->to_string ().c_str ()); 
-              } else {
-                printf ("weak intersection point %s between %s and %s.\n", c1->p2 ().to_string ().c_str (), c1->to_string ().c_str (), c2->to_string ().c_str ()); 
-              }
-#endif
-            }
-
-          } else {
-
+          } else if (c1->dy () == 0) {
+            
             if (c1 < c2 && c1->p1 () != c2->p1 () && c1->p2 () != c2->p1 () &&
                            c1->p1 () != c2->p2 () && c1->p2 () != c2->p2 ()) {
 
-              std::pair <bool, db::Point> cp = safe_intersect_point (*c1, *c2);
+              std::pair <bool, db::Point> cp = c1->intersect_point (*c2);
               if (cp.first) {
                 
-                bool on_edge1 = true;
-                bool on_edge2 = is_point_on_exact (*c2, cp.second);
-
                 //  add a cut point to c1 and c2
-                if (with_h || c1->dy () != 0) {
-                  on_edge1 = is_point_on_exact (*c1, cp.second);
-                  c1->make_cutpoints (cutpoints)->add (cp.second, &cutpoints, !on_edge1);
+                c2->make_cutpoints (cutpoints)->add (cp.second, &cutpoints, true);
+                if (with_h) {
+                  c1->make_cutpoints (cutpoints)->add (cp.second, &cutpoints, true);
                 }
 
-                c2->make_cutpoints (cutpoints)->add (cp.second, &cutpoints, !on_edge2);
-
 #ifdef DEBUG_EDGE_PROCESSOR
-                if (!on_edge1 || !on_edge2) {
-                  printf ("intersection point %s between %s and %s.\n", cp.second.to_string ().c_str (), c1->to_string ().c_str (), c2->to_string ().c_str ()); 
-                } else {
-                  printf ("weak intersection point %s between %s and %s.\n", cp.second.to_string ().c_str (), c1->to_string ().c_str (), c2->to_string ().c_str ()); 
-                }
+                printf ("intersection point %s between %s and %s (2).\n", cp.second.to_string ().c_str (), c1->to_string ().c_str (), c2->to_string ().c_str ()); 
 #endif
 
-                //  The new cutpoint must be inserted into other edges as well.
-                ip_weak.clear ();
-                for (std::vector <WorkEdge>::iterator cc = c; cc != f; ++cc) {
-                  if ((with_h || cc->dy () != 0) && cc != c1 && cc != c2 && is_point_on_fuzzy (*cc, cp.second)) {
-                    ip_weak.push_back (&*cc);
-                  }
-                }
-                for (std::vector <WorkEdge *>::iterator icc = ip_weak.begin (); icc != ip_weak.end (); ++icc) {
-                  (*icc)->make_cutpoints (cutpoints)->add (cp.second, &cutpoints, true);
-#ifdef DEBUG_EDGE_PROCESSOR
-                  printf ("intersection point %s gives cutpoint in %s.\n", cp.second.to_string ().c_str (), (*icc)->to_string ().c_str ());
-#endif
-                }
-
               }
 
-            } 
-
-            //  The endpoints of the other edge must be inserted into the edge 
-            //  if they are within the modification range (but only then).
-            //  We first collect these endpoints because we have to decide whether that can be 
-            //  a weak attractor or, if it affects two or more edges in which case it will become a strong attractor. 
-            //  It's sufficient to do this for p1 only because we made sure we caught all edges
-            //  in the +-0.5DBU vicinity by choosing the cell large enough (.._double operators).
-            //  For end points exactly on the line we insert a cutpoint to ensure we use the
-            //  endpoints as cutpoints in any case.
-            if (c1p1_in_cell && is_point_on_fuzzy (*c2, c1->p1 ())) {
-              if (is_point_on_exact (*c2, c1->p1 ())) {
-#ifdef DEBUG_EDGE_PROCESSOR
-                printf ("end point %s gives intersection point between %s and %s.\n", c1->p1 ().to_string ().c_str (), c1->to_string ().c_str (), c2->to_string ().c_str ()); 
-#endif
-                c2->make_cutpoints (cutpoints)->add (c1->p1 (), &cutpoints, true);
-              } else {
-                p1_weak.push_back (&*c2);
-              }
             }
 
-          }
-
-        }
-
-        if (! p1_weak.empty ()) {
+          } else if (c1->p1 ().x () == c2->p1 ().x ()) {
 
-          bool strong = false;
-          for (std::vector<WorkEdge *>::const_iterator cp = p1_weak.begin (); cp != p1_weak.end () && ! strong; ++cp) {
-            if ((*cp)->data > 0 && cutpoints [(*cp)->data - 1].strong_cutpoints) {
-              strong = true;
+            //  both edges are coincident - produce the ends of the edges involved as cut points
+            if (c1p1_in_cell && c1->p1 ().y () > db::edge_ymin (*c2) && c1->p1 ().y () < db::edge_ymax (*c2)) {
+              c2->make_cutpoints (cutpoints)->add (c1->p1 (), &cutpoints, true);
             }
-          }
-
-          p1_weak.back ()->make_cutpoints (cutpoints);
-          size_t n = p1_weak.back ()->data - 1;
-          for (std::vector<WorkEdge *>::const_iterator cp = p1_weak.begin (); cp != p1_weak.end (); ++cp) {
-
-            (*cp)->make_cutpoints (cutpoints);
-            size_t nn = (*cp)->data - 1;
-            if (strong) {
-              cutpoints [nn].add (c1->p1 (), &cutpoints);
-#ifdef DEBUG_EDGE_PROCESSOR
-              printf ("Insert strong attractor %s in %s.\n", c1->p1 ().to_string ().c_str (), (*cp)->to_string ().c_str ()); 
-#endif
-            } else {
-              cutpoints [nn].add_attractor (c1->p1 (), n);
-#ifdef DEBUG_EDGE_PROCESSOR
-              printf ("Insert weak attractor %s in %s.\n", c1->p1 ().to_string ().c_str (), (*cp)->to_string ().c_str ()); 
-#endif
+            if (c1p2_in_cell && c1->p2 ().y () > db::edge_ymin (*c2) && c1->p2 ().y () < db::edge_ymax (*c2)) {
+              c2->make_cutpoints (cutpoints)->add (c1->p2 (), &cutpoints, true);
             }
 
-            n = nn;
-
           }
 
         }
@@ -1526,7 +1743,7 @@ get_intersections_per_band_any (std::vector <CutPoints> &cutpoints, std::vector
 
     x = xx;
     for (std::vector <WorkEdge>::iterator cc = c; cc != f; ++cc) {
-      if (edge_xmax (*cc) < x || edge_xmax_at_yinterval_double (*cc, dy, dyy) < x) {
+      if (edge_xmax (*cc) < x) {
         if (c != cc) {
           std::swap (*cc, *c);
         }
@@ -1537,530 +1754,582 @@ get_intersections_per_band_any (std::vector <CutPoints> &cutpoints, std::vector
   }
 }
 
-void 
-EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
+/**
+ *  @brief Computes the x value of an edge at the given y value
+ *
+ *  HINT: for application in the scanline algorithm 
+ *  it is important that this method delivers exactly (!) the same x for the same edge 
+ *  (after normalization to dy()>0) and same y!
+ */
+template <class C>
+inline double edge_xaty_double (db::edge<C> e, double y)
 {
-  tl::SelfTimer timer (tl::verbosity () >= m_base_verbosity, "EdgeProcessor: process");
-
-  bool prefer_touch = op.prefer_touch (); 
-  bool selects_edges = op.selects_edges (); 
-  
-  db::Coord y;
-  std::vector <WorkEdge>::iterator future;
-
-  //  step 1: preparation
+  if (e.p1 ().y () > e.p2 ().y ()) {
+    e.swap_points ();
+  }
 
-  if (mp_work_edges->empty ()) {
-    es.start ();
-    es.flush ();
-    return;
+  if (y <= e.p1 ().y ()) {
+    return e.p1 ().x ();
+  } else if (y >= e.p2 ().y ()) {
+    return e.p2 ().x ();
+  } else {
+    return double (e.p1 ().x ()) + double (e.dx ()) * (y - double (e.p1 ().y ())) / double (e.dy ());
   }
+}
 
-  mp_cpvector->clear ();
+/**
+ *  @brief Computes the left bound of the edge geometry for a given band [y1..y2].
+ */
+template <class C>
+inline C edge_xmin_at_yinterval_double (const db::edge<C> &e, double y1, double y2) 
+{
+  if (e.dx () == 0) {
+    return e.p1 ().x ();
+  } else if (e.dy () == 0) {
+    return std::min (e.p1 ().x (), e.p2 ().x ());
+  } else {
+    return C (floor (edge_xaty_double (e, ((e.dy () < 0) ^ (e.dx () < 0)) == 0 ? y1 : y2)));
+  }
+}
 
-  property_type n_props = 0;
-  for (std::vector <WorkEdge>::iterator e = mp_work_edges->begin (); e != mp_work_edges->end (); ++e) {
-    if (e->prop > n_props) {
-      n_props = e->prop;
-    }
+/**
+ *  @brief Computes the right bound of the edge geometry for a given band [y1..y2].
+ */
+template <class C>
+inline C edge_xmax_at_yinterval_double (const db::edge<C> &e, double y1, double y2) 
+{
+  if (e.dx () == 0) {
+    return e.p1 ().x ();
+  } else if (e.dy () == 0) {
+    return std::max (e.p1 ().x (), e.p2 ().x ());
+  } else {
+    return C (ceil (edge_xaty_double (e, ((e.dy () < 0) ^ (e.dx () < 0)) != 0 ? y1 : y2)));
   }
-  ++n_props;
+}
 
-  size_t todo_max = 1000000;
+/**
+ *  @brief Functor that compares two edges by their left bound for a given interval [y1..y2].
+ *
+ *  This function is intended for use in scanline scenarious to determine what edges are 
+ *  interacting in a certain y interval.
+ */
+template <class C>
+struct edge_xmin_at_yinterval_double_compare
+{
+  edge_xmin_at_yinterval_double_compare (double y1, double y2)
+    : m_y1 (y1), m_y2 (y2)
+  {
+    // .. nothing yet ..
+  }
 
-  std::auto_ptr<tl::AbsoluteProgress> progress (0);
-  if (m_report_progress) {
-    if (m_progress_desc.empty ()) {
-      progress.reset (new tl::AbsoluteProgress (tl::to_string (tr ("Processing")), 1000));
+  bool operator() (const db::edge<C> &a, const db::edge<C> &b) const
+  {
+    if (edge_xmax (a) < edge_xmin (b)) {
+      return true;
+    } else if (edge_xmin (a) >= edge_xmax (b)) {
+      return false;
     } else {
-      progress.reset (new tl::AbsoluteProgress (m_progress_desc, 1000));
+      C xa = edge_xmin_at_yinterval_double (a, m_y1, m_y2);
+      C xb = edge_xmin_at_yinterval_double (b, m_y1, m_y2);
+      if (xa != xb) {
+        return xa < xb;
+      } else {
+        return a < b;
+      }
     }
-    progress->set_format (tl::to_string (tr ("%.0f%%")));
-    progress->set_unit (todo_max / 100);
   }
 
-  size_t todo_next = 0;
-  size_t todo = todo_next;
-  todo_next += (todo_max - todo) / 5;
+public:
+  double m_y1, m_y2;
+};
 
+static void 
+get_intersections_per_band_any (std::vector <CutPoints> &cutpoints, std::vector <WorkEdge>::iterator current, std::vector <WorkEdge>::iterator future, db::Coord y, db::Coord yy, bool with_h)
+{
+  std::vector <WorkEdge *> p1_weak; // holds weak interactions of edge endpoints with other edges
+  std::vector <WorkEdge *> ip_weak;
+  double dy = y - 0.5;
+  double dyy = yy + 0.5;
 
-  //  step 2: find intersections
-  std::sort (mp_work_edges->begin (), mp_work_edges->end (), edge_ymin_compare<db::Coord> ());
+  std::sort (current, future, edge_xmin_at_yinterval_double_compare<db::Coord> (dy, dyy));
 
-  y = edge_ymin ((*mp_work_edges) [0]);
-  future = mp_work_edges->begin ();
+#ifdef DEBUG_EDGE_PROCESSOR
+  printf ("y=%d..%d\n", y, yy);
+  printf ("edges:"); 
+  for (std::vector <WorkEdge>::iterator c1 = current; c1 != future; ++c1) { 
+    printf (" %s", c1->to_string().c_str ()); 
+  } 
+  printf ("\n");
+#endif
+  db::Coord x = edge_xmin_at_yinterval_double (*current, dy, dyy);
 
-  for (std::vector <WorkEdge>::iterator current = mp_work_edges->begin (); current != mp_work_edges->end (); ) {
+  std::vector <WorkEdge>::iterator f = current;
+  for (std::vector <WorkEdge>::iterator c = current; c != future; ) {
 
-    if (m_report_progress) {
-      double p = double (std::distance (mp_work_edges->begin (), current)) / double (mp_work_edges->size ());
-      progress->set (size_t (double (todo_next - todo) * p) + todo);
+    while (f != future && edge_xmin_at_yinterval_double (*f, dy, dyy) <= x) {
+      ++f;
     }
 
-    size_t n = std::distance (current, future);
-    db::Coord yy = y;
+    db::Coord xx = std::numeric_limits <db::Coord>::max ();
+    if (f != future) {
+      xx = edge_xmin_at_yinterval_double (*f, dy, dyy);
+    }
 
-    //  Use as many scanlines as to fetch approx. 50% new edges into the scanline (this
-    //  is an empirically determined factor)
-    do {
+#ifdef DEBUG_EDGE_PROCESSOR
+    printf ("edges %d..%d:", x, xx); 
+    for (std::vector <WorkEdge>::iterator c1 = c; c1 != f; ++c1) { 
+      printf (" %s", c1->to_string().c_str ()); 
+    } 
+    printf ("\n");
+#endif
 
-      while (future != mp_work_edges->end () && edge_ymin (*future) <= yy) {
-        ++future;
-      }
+    if (std::distance (c, f) > 1) {
 
-      if (future != mp_work_edges->end ()) {
-        yy = edge_ymin (*future);
-      } else {
-        yy = std::numeric_limits <db::Coord>::max ();
-      }
+      db::Box cell (x, y, xx, yy);
 
-    } while (future != mp_work_edges->end () && std::distance (current, future) < long (n + n / 2));
+      for (std::vector <WorkEdge>::iterator c1 = c; c1 != f; ++c1) {
 
-    bool is90 = true;
+        p1_weak.clear (); 
 
-    if (current != future) {
+        bool c1p1_in_cell = cell.contains (c1->p1 ());
+        bool c1p2_in_cell = cell.contains (c1->p2 ());
 
-      for (std::vector <WorkEdge>::iterator c = current; c != future && is90; ++c) {
-        if (c->dx () != 0 && c->dy () != 0) {
-          is90 = false;
-        }
-      }
+        for (std::vector <WorkEdge>::iterator c2 = c; c2 != f; ++c2) {
 
-      if (is90) {
-        get_intersections_per_band_90 (*mp_cpvector, current, future, y, yy, selects_edges);
-      } else {
-        get_intersections_per_band_any (*mp_cpvector, current, future, y, yy, selects_edges);
-      }
+          if (c1 == c2) {
+            continue;
+          }
 
-    }
+          if (c2->dy () == 0) {
 
-    y = yy;
-    for (std::vector <WorkEdge>::iterator c = current; c != future; ++c) {
-      //  Hint: we have to keep the edges ending a y (the new lower band limit) in the all angle case because these edges
-      //  may receive cutpoints because the enter the -0.5DBU region below the band
-      if ((!is90 && edge_ymax (*c) < y) || (is90 && edge_ymax (*c) <= y)) {
-        if (current != c) {
-          std::swap (*current, *c);
-        }
-        ++current;
-      }
-    }
-    
-  }
+            if ((with_h || c1->dy () != 0) && c1 < c2) {
 
-  //  step 3: create new edges from the ones with cutpoints
-  //
-  //  Hint: when we create the edges from the cutpoints we use the projection to sort the cutpoints along the
-  //  edge. However, we have some freedom to connect the points which we use to avoid "z" configurations which could
-  //  create new intersections in a 1x1 pixel box.
-  
-  todo = todo_next;
-  todo_next += (todo_max - todo) / 5;
+              if (c1->dy () == 0) {
 
-  size_t n_work = mp_work_edges->size ();
-  size_t nw = 0;
-  for (size_t n = 0; n < n_work; ++n) {
+                //  parallel horizontal edges: produce the end points of each other edge as cutpoints
+                if (c1->p1 ().y () == c2->p1 ().y ()) {
+                  add_hparallel_cutpoints (*c1, *c2, cutpoints);
+                  add_hparallel_cutpoints (*c2, *c1, cutpoints);
+                }
 
-    if (m_report_progress) {
-      double p = double (n) / double (n_work);
-      progress->set (size_t (double (todo_next - todo) * p) + todo);
-    }
+              } else if (c1->p1 () != c2->p1 () && c1->p2 () != c2->p1 () &&
+                         c1->p1 () != c2->p2 () && c1->p2 () != c2->p2 ()) {
 
-    WorkEdge &ew = (*mp_work_edges) [n];
+                std::pair <bool, db::Point> cp = safe_intersect_point (*c1, *c2);
+                if (cp.first) {
 
-    CutPoints *cut_points = ew.data ? & ((*mp_cpvector) [ew.data - 1]) : 0;
-    ew.data = 0;
+                  bool on_edge1 = is_point_on_exact (*c1, cp.second);
 
-    if (ew.dy () == 0 && ! selects_edges) {
+                  //  add a cut point to c1 and c2 (points not on the edge give strong attractors)
+                  c1->make_cutpoints (cutpoints)->add (cp.second, &cutpoints, !on_edge1);
+                  if (with_h) {
+                    c2->make_cutpoints (cutpoints)->add (cp.second, &cutpoints, false);
+                  }
 
-      //  don't care about horizontal edges 
+#ifdef DEBUG_EDGE_PROCESSOR
+                  if (on_edge1) {
+                    printf ("weak intersection point %s between %s and %s.\n", cp.second.to_string ().c_str (), c1->to_string ().c_str (), c2->to_string ().c_str ());
+                  } else {
+                    printf ("intersection point %s between %s and %s.\n", cp.second.to_string ().c_str (), c1->to_string ().c_str (), c2->to_string ().c_str ());
+                  }
+#endif
 
-    } else if (cut_points) {
+                  //  The new cutpoint must be inserted into other edges as well.
+                  ip_weak.clear ();
+                  for (std::vector <WorkEdge>::iterator cc = c; cc != f; ++cc) {
+                    if ((with_h || cc->dy () != 0) && cc != c1 && cc != c2 && is_point_on_fuzzy (*cc, cp.second)) {
+                      ip_weak.push_back (&*cc);
+                    }
+                  }
+                  for (std::vector <WorkEdge *>::iterator icc = ip_weak.begin (); icc != ip_weak.end (); ++icc) {
+                    (*icc)->make_cutpoints (cutpoints)->add (cp.second, &cutpoints, true);
+#ifdef DEBUG_EDGE_PROCESSOR
+                    printf ("intersection point %s gives cutpoint in %s.\n", cp.second.to_string ().c_str (), (*icc)->to_string ().c_str ());
+#endif
+                  }
 
-      if (cut_points->has_cutpoints && ! cut_points->cut_points.empty ()) {
+                }
 
-        db::Edge e = ew;
-        property_type p = ew.prop;
-        std::sort (cut_points->cut_points.begin (), cut_points->cut_points.end (), ProjectionCompare (e));
+              }
 
-        db::Point pll = e.p1 ();
-        db::Point pl = e.p1 ();
+            } 
+          
+          } else if (c1->parallel (*c2) && c1->side_of (c2->p1 ()) == 0) {
 
-        for (std::vector <db::Point>::iterator cp = cut_points->cut_points.begin (); cp != cut_points->cut_points.end (); ++cp) {
-          if (*cp != pl) {
-            WorkEdge ne = WorkEdge (db::Edge (pl, *cp), p);
-            if (pl.y () == pll.y () && ne.p2 ().x () != pl.x () && ne.p2 ().x () == pll.x ()) {
-              ne = db::Edge (pll, ne.p2 ());
-            } else if (pl.x () == pll.x () && ne.p2 ().y () != pl.y () && ne.p2 ().y () == pll.y ()) {
-              ne = db::Edge (ne.p1 (), pll);
-            } else {
-              pll = pl;
-            }
-            pl = *cp;
-            if (selects_edges || ne.dy () != 0) {
-              if (nw <= n) {
-                (*mp_work_edges) [nw++] = ne;
+#ifdef DEBUG_EDGE_PROCESSOR
+            printf ("%s and %s are parallel.\n", c1->to_string ().c_str (), c2->to_string ().c_str ()); 
+#endif
+
+            //  both edges are coincident - produce the ends of the edges involved as cut points
+            if (c1p1_in_cell && c2->contains (c1->p1 ()) && c2->p1 () != c1->p1 () && c2->p2 () != c1->p1 ()) {
+              c2->make_cutpoints (cutpoints)->add (c1->p1 (), &cutpoints, !is_point_on_exact(*c2, c1->p1 ()));
+#ifdef DEBUG_EDGE_PROCESSOR
+              if (! is_point_on_exact(*c2, c1->p1 ())) {
+                printf ("intersection point %s between %s and %s.\n", c1->p1 ().to_string ().c_str (), c1->to_string ().c_str (), c2->to_string ().c_str ()); 
               } else {
-                mp_work_edges->push_back (ne);
+                printf ("weak intersection point %s between %s and %s.\n", c1->p1 ().to_string ().c_str (), c1->to_string ().c_str (), c2->to_string ().c_str ()); 
               }
+#endif
             }
-          }
-        }
-
-        if (cut_points->cut_points.back () != e.p2 ()) {
-          WorkEdge ne = WorkEdge (db::Edge (pl, e.p2 ()), p);
-          if (pl.y () == pll.y () && ne.p2 ().x () != pl.x () && ne.p2 ().x () == pll.x ()) {
-            ne = db::Edge (pll, ne.p2 ());
-          } else if (pl.x () == pll.x () && ne.p2 ().y () != pl.y () && ne.p2 ().y () == pll.y ()) {
-            ne = db::Edge (ne.p1 (), pll);
-          }
-          if (selects_edges || ne.dy () != 0) {
-            if (nw <= n) {
-              (*mp_work_edges) [nw++] = ne;
-            } else {
-              mp_work_edges->push_back (ne);
+            if (c1p2_in_cell && c2->contains (c1->p2 ()) && c2->p1 () != c1->p2 () && c2->p2 () != c1->p2 ()) {
+              c2->make_cutpoints (cutpoints)->add (c1->p2 (), &cutpoints, !is_point_on_exact(*c2, c1->p2 ()));
+#ifdef DEBUG_EDGE_PROCESSOR
+              if (! is_point_on_exact(*c2, c1->p2 ())) {
+                printf ("intersection point %s between %s and %s.\n", c1->p2 ().to_string ().c_str (), c1->to_string ().c_str (), c2->to_string ().c_str ()); 
+              } else {
+                printf ("weak intersection point %s between %s and %s.\n", c1->p2 ().to_string ().c_str (), c1->to_string ().c_str (), c2->to_string ().c_str ()); 
+              }
+#endif
             }
-          }
-        }
-
-      } else {
-
-        if (nw < n) {
-          (*mp_work_edges) [nw] = (*mp_work_edges) [n];
-        }
-        ++nw;
-
-      }
 
-    } else {
+          } else {
 
-      if (nw < n) {
-        (*mp_work_edges) [nw] = (*mp_work_edges) [n];
-      }
-      ++nw;
+            if (c1 < c2 && c1->p1 () != c2->p1 () && c1->p2 () != c2->p1 () &&
+                           c1->p1 () != c2->p2 () && c1->p2 () != c2->p2 ()) {
 
-    }
+              std::pair <bool, db::Point> cp = safe_intersect_point (*c1, *c2);
+              if (cp.first) {
+                
+                bool on_edge1 = true;
+                bool on_edge2 = is_point_on_exact (*c2, cp.second);
 
-  }
+                //  add a cut point to c1 and c2
+                if (with_h || c1->dy () != 0) {
+                  on_edge1 = is_point_on_exact (*c1, cp.second);
+                  c1->make_cutpoints (cutpoints)->add (cp.second, &cutpoints, !on_edge1);
+                }
 
-  if (nw != n_work) {
-    mp_work_edges->erase (mp_work_edges->begin () + nw, mp_work_edges->begin () + n_work);
-  }
+                c2->make_cutpoints (cutpoints)->add (cp.second, &cutpoints, !on_edge2);
 
 #ifdef DEBUG_EDGE_PROCESSOR
-  printf ("Output edges:\n");
-  for (std::vector <WorkEdge>::iterator c1 = mp_work_edges->begin (); c1 != mp_work_edges->end (); ++c1) { 
-    printf ("%s\n", c1->to_string().c_str ()); 
-  } 
+                if (!on_edge1 || !on_edge2) {
+                  printf ("intersection point %s between %s and %s.\n", cp.second.to_string ().c_str (), c1->to_string ().c_str (), c2->to_string ().c_str ()); 
+                } else {
+                  printf ("weak intersection point %s between %s and %s.\n", cp.second.to_string ().c_str (), c1->to_string ().c_str (), c2->to_string ().c_str ()); 
+                }
 #endif
 
+                //  The new cutpoint must be inserted into other edges as well.
+                ip_weak.clear ();
+                for (std::vector <WorkEdge>::iterator cc = c; cc != f; ++cc) {
+                  if ((with_h || cc->dy () != 0) && cc != c1 && cc != c2 && is_point_on_fuzzy (*cc, cp.second)) {
+                    ip_weak.push_back (&*cc);
+                  }
+                }
+                for (std::vector <WorkEdge *>::iterator icc = ip_weak.begin (); icc != ip_weak.end (); ++icc) {
+                  (*icc)->make_cutpoints (cutpoints)->add (cp.second, &cutpoints, true);
+#ifdef DEBUG_EDGE_PROCESSOR
+                  printf ("intersection point %s gives cutpoint in %s.\n", cp.second.to_string ().c_str (), (*icc)->to_string ().c_str ());
+#endif
+                }
 
-  tl::SelfTimer timer2 (tl::verbosity () >= m_base_verbosity + 10, "EdgeProcessor: production");
-
-  //  step 4: compute the result edges 
-  
-  es.start (); // call this as late as possible. This way, input containers can be identical with output containers ("clear" is done after the input is read)
-
-  op.reset ();
-  op.reserve (n_props);
-
-  std::sort (mp_work_edges->begin (), mp_work_edges->end (), edge_ymin_compare<db::Coord> ());
-
-  y = edge_ymin ((*mp_work_edges) [0]);
-  size_t skip_unit = 1;
+              }
 
-  future = mp_work_edges->begin ();
-  for (std::vector <WorkEdge>::iterator current = mp_work_edges->begin (); current != mp_work_edges->end (); ) {
+            } 
 
-    if (m_report_progress) {
-      double p = double (std::distance (mp_work_edges->begin (), current)) / double (mp_work_edges->size ());
-      progress->set (size_t (double (todo_max - todo_next) * p) + todo_next);
-    }
+            //  The endpoints of the other edge must be inserted into the edge 
+            //  if they are within the modification range (but only then).
+            //  We first collect these endpoints because we have to decide whether that can be 
+            //  a weak attractor or, if it affects two or more edges in which case it will become a strong attractor. 
+            //  It's sufficient to do this for p1 only because we made sure we caught all edges
+            //  in the +-0.5DBU vicinity by choosing the cell large enough (.._double operators).
+            //  For end points exactly on the line we insert a cutpoint to ensure we use the
+            //  endpoints as cutpoints in any case.
+            if (c1p1_in_cell && is_point_on_fuzzy (*c2, c1->p1 ())) {
+              if (is_point_on_exact (*c2, c1->p1 ())) {
+#ifdef DEBUG_EDGE_PROCESSOR
+                printf ("end point %s gives intersection point between %s and %s.\n", c1->p1 ().to_string ().c_str (), c1->to_string ().c_str (), c2->to_string ().c_str ()); 
+#endif
+                c2->make_cutpoints (cutpoints)->add (c1->p1 (), &cutpoints, true);
+              } else {
+                p1_weak.push_back (&*c2);
+              }
+            }
 
-    std::vector <WorkEdge>::iterator f0 = future;
-    while (future != mp_work_edges->end () && edge_ymin (*future) <= y) {
-      tl_assert (future->data == 0); // HINT: for development
-      ++future;
-    }
-    std::sort (f0, future, EdgeXAtYCompare2 (y));
+          }
 
-    db::Coord yy = std::numeric_limits <db::Coord>::max ();
-    if (future != mp_work_edges->end ()) {
-      yy = edge_ymin (*future);
-    }
-    for (std::vector <WorkEdge>::const_iterator c = current; c != future; ++c) {
-      if (edge_ymax (*c) > y) {
-        yy = std::min (yy, edge_ymax (*c));
-      }
-    }
+        }
 
-    db::Coord ysl = y;
-    es.begin_scanline (y);
+        if (! p1_weak.empty ()) {
 
-    tl_assert (op.is_reset ()); // HINT: for development
+          bool strong = false;
+          for (std::vector<WorkEdge *>::const_iterator cp = p1_weak.begin (); cp != p1_weak.end () && ! strong; ++cp) {
+            if ((*cp)->data > 0 && cutpoints [(*cp)->data - 1].strong_cutpoints) {
+              strong = true;
+            }
+          }
 
-    if (current != future) {
+          p1_weak.back ()->make_cutpoints (cutpoints);
+          size_t n = p1_weak.back ()->data - 1;
+          for (std::vector<WorkEdge *>::const_iterator cp = p1_weak.begin (); cp != p1_weak.end (); ++cp) {
 
-      std::inplace_merge (current, f0, future, EdgeXAtYCompare2 (y));
+            (*cp)->make_cutpoints (cutpoints);
+            size_t nn = (*cp)->data - 1;
+            if (strong) {
+              cutpoints [nn].add (c1->p1 (), &cutpoints);
 #ifdef DEBUG_EDGE_PROCESSOR
-      printf ("y=%d ", y);
-      for (std::vector <WorkEdge>::iterator c = current; c != future; ++c) { 
-        printf ("%ld-", long (c->data)); 
-      } 
-      printf ("\n");
+              printf ("Insert strong attractor %s in %s.\n", c1->p1 ().to_string ().c_str (), (*cp)->to_string ().c_str ()); 
+#endif
+            } else {
+              cutpoints [nn].add_attractor (c1->p1 (), n);
+#ifdef DEBUG_EDGE_PROCESSOR
+              printf ("Insert weak attractor %s in %s.\n", c1->p1 ().to_string ().c_str (), (*cp)->to_string ().c_str ()); 
 #endif
+            }
 
-      db::Coord hx = 0;
-      int ho = 0;
+            n = nn;
 
-      size_t new_skip_unit = std::distance (current, future);
+          }
 
-      for (std::vector <WorkEdge>::iterator c = current; c != future; ) {
+        }
 
-        size_t skip = c->data % skip_unit;
-        size_t skip_res = c->data / skip_unit;
-#ifdef DEBUG_EDGE_PROCESSOR
-        printf ("X %ld->%d,%d\n", long (c->data), int (skip), int (skip_res));
-#endif
+      }
 
-        if (skip != 0 && (c + skip >= future || (c + skip)->data != 0)) {
+    }
 
-          tl_assert (c + skip <= future);
+    x = xx;
+    for (std::vector <WorkEdge>::iterator cc = c; cc != f; ++cc) {
+      if (edge_xmax (*cc) < x || edge_xmax_at_yinterval_double (*cc, dy, dyy) < x) {
+        if (c != cc) {
+          std::swap (*cc, *c);
+        }
+        ++c;
+      }
+    }
 
-          es.skip_n (skip_res);
+  }
+}
 
-          c->data = skip + new_skip_unit * skip_res;
+void 
+EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
+{
+  tl::SelfTimer timer (tl::verbosity () >= m_base_verbosity, "EdgeProcessor: process");
 
-          //  skip this interval - has not changed
-          c += skip;
+  bool selects_edges = op.selects_edges (); 
+  
+  db::Coord y;
+  std::vector <WorkEdge>::iterator future;
 
-        } else {
+  //  step 1: preparation
 
-          std::vector <WorkEdge>::iterator c0 = c;
-          size_t n_res = 0;
+  if (mp_work_edges->empty ()) {
+    es.start ();
+    es.flush ();
+    return;
+  }
 
-          do {
+  mp_cpvector->clear ();
 
-            c->data = 0;
-            std::vector <WorkEdge>::iterator f = c + 1;
+  property_type n_props = 0;
+  for (std::vector <WorkEdge>::iterator e = mp_work_edges->begin (); e != mp_work_edges->end (); ++e) {
+    if (e->prop > n_props) {
+      n_props = e->prop;
+    }
+  }
+  ++n_props;
 
-            //  HINT: "volatile" forces x and xx into memory and disables FPU register optimisation.
-            //  That way, we can exactly compare doubles afterwards.
-            volatile double x = edge_xaty (*c, y);
+  size_t todo_max = 1000000;
 
-            while (f != future) {
-              volatile double xx = edge_xaty (*f, y);
-              if (xx != x) {
-                break;
-              }
-              f->data = 0;
-              ++f;
-            }
+  std::auto_ptr<tl::AbsoluteProgress> progress (0);
+  if (m_report_progress) {
+    if (m_progress_desc.empty ()) {
+      progress.reset (new tl::AbsoluteProgress (tl::to_string (tr ("Processing")), 1000));
+    } else {
+      progress.reset (new tl::AbsoluteProgress (m_progress_desc, 1000));
+    }
+    progress->set_format (tl::to_string (tr ("%.0f%%")));
+    progress->set_unit (todo_max / 100);
+  }
 
-            //  compute edges that occure at this vertex
-            
-            bool vertex = false;
-            
-            //  treat all edges crossing the scanline in a certain point
-            for (std::vector <WorkEdge>::iterator cc = c; cc != f; ) {
+  size_t todo_next = 0;
+  size_t todo = todo_next;
+  todo_next += (todo_max - todo) / 5;
 
-              std::vector <WorkEdge>::iterator e = mp_work_edges->end ();
 
-              int pn = 0, ps = 0;
+  //  step 2: find intersections
+  std::sort (mp_work_edges->begin (), mp_work_edges->end (), edge_ymin_compare<db::Coord> ());
 
-              std::vector <WorkEdge>::iterator cc0 = cc;
+  y = edge_ymin ((*mp_work_edges) [0]);
+  future = mp_work_edges->begin ();
 
-              std::vector <WorkEdge>::iterator fc = cc;
-              do {
-                ++fc;
-              } while (fc != f && EdgeXAtYCompare2 (y).equal (*fc, *cc));
+  for (std::vector <WorkEdge>::iterator current = mp_work_edges->begin (); current != mp_work_edges->end (); ) {
 
-              //  sort the coincident edges by property ID - that will
-              //  simplify algorithms like "inside" and "outside".
-              if (fc - cc > 1) {
-                //  for prefer_touch we first deliver the opening edges in ascending
-                //  order, in the other case we the other way round so that the opening
-                //  edges are always delivered with ascending property ID order.
-                if (prefer_touch) {
-                  std::sort (cc, fc, EdgePropCompare ());
-                } else {
-                  std::sort (cc, fc, EdgePropCompareReverse ());
-                }
-              }
+    if (m_report_progress) {
+      double p = double (std::distance (mp_work_edges->begin (), current)) / double (mp_work_edges->size ());
+      progress->set (size_t (double (todo_next - todo) * p) + todo);
+    }
 
-              //  treat all coincident edges
-              do {
+    size_t n = std::distance (current, future);
+    db::Coord yy = y;
 
-                if (cc->dy () != 0) {
+    //  Use as many scanlines as to fetch approx. 50% new edges into the scanline (this
+    //  is an empirically determined factor)
+    do {
 
-                  if (e == mp_work_edges->end () && edge_ymax (*cc) > y) {
-                    e = cc;
-                  }
-                  
-                  if ((cc->dy () > 0) == prefer_touch) {
-                    if (edge_ymax (*cc) > y) {
-                      pn += op.edge (true, prefer_touch, cc->prop);
-                    }
-                    if (edge_ymin (*cc) < y) {
-                      ps += op.edge (false, prefer_touch, cc->prop);
-                    }
-                  }
+      while (future != mp_work_edges->end () && edge_ymin (*future) <= yy) {
+        ++future;
+      }
 
-                }
+      if (future != mp_work_edges->end ()) {
+        yy = edge_ymin (*future);
+      } else {
+        yy = std::numeric_limits <db::Coord>::max ();
+      }
 
-                ++cc;
+    } while (future != mp_work_edges->end () && std::distance (current, future) < long (n + n / 2));
 
-              } while (cc != fc);
+    bool is90 = true;
 
-              //  Give the edge selection operator a chance to select edges now
-              if (selects_edges) {
+    if (current != future) {
 
-                for (std::vector <WorkEdge>::iterator sc = cc0; sc != fc; ++sc) {
-                  if (edge_ymin (*sc) == y && op.select_edge (sc->dy () == 0, sc->prop)) {
-                    es.put (*sc);
-#ifdef DEBUG_EDGE_PROCESSOR
-                    printf ("put(%s)\n", sc->to_string().c_str());
-#endif
-                  }
-                }
+      for (std::vector <WorkEdge>::iterator c = current; c != future && is90; ++c) {
+        if (c->dx () != 0 && c->dy () != 0) {
+          is90 = false;
+        }
+      }
 
-              }
+      if (is90) {
+        get_intersections_per_band_90 (*mp_cpvector, current, future, y, yy, selects_edges);
+      } else {
+        get_intersections_per_band_any (*mp_cpvector, current, future, y, yy, selects_edges);
+      }
 
-              //  report the closing or opening edges in the opposite order 
-              //  than the other ones (see previous loop). Hence we have some
-              //  symmetry of events which simplify implementatin of the 
-              //  InteractionDetector for example.
-              do {
+    }
 
-                --fc;
+    y = yy;
+    for (std::vector <WorkEdge>::iterator c = current; c != future; ++c) {
+      //  Hint: we have to keep the edges ending a y (the new lower band limit) in the all angle case because these edges
+      //  may receive cutpoints because the enter the -0.5DBU region below the band
+      if ((!is90 && edge_ymax (*c) < y) || (is90 && edge_ymax (*c) <= y)) {
+        if (current != c) {
+          std::swap (*current, *c);
+        }
+        ++current;
+      }
+    }
+    
+  }
 
-                if (fc->dy () != 0 && (fc->dy () > 0) != prefer_touch) {
-                  if (edge_ymax (*fc) > y) {
-                    pn += op.edge (true, ! prefer_touch, fc->prop);
-                  }
-                  if (edge_ymin (*fc) < y) {
-                    ps += op.edge (false, ! prefer_touch, fc->prop);
-                  }
-                }
+  //  step 3: create new edges from the ones with cutpoints
+  //
+  //  Hint: when we create the edges from the cutpoints we use the projection to sort the cutpoints along the
+  //  edge. However, we have some freedom to connect the points which we use to avoid "z" configurations which could
+  //  create new intersections in a 1x1 pixel box.
+  
+  todo = todo_next;
+  todo_next += (todo_max - todo) / 5;
 
-              } while (fc != cc0);
+  size_t n_work = mp_work_edges->size ();
+  size_t nw = 0;
+  for (size_t n = 0; n < n_work; ++n) {
 
-              if (! vertex && (ps != 0 || pn != 0)) {
+    if (m_report_progress) {
+      double p = double (n) / double (n_work);
+      progress->set (size_t (double (todo_next - todo) * p) + todo);
+    }
 
-                if (ho != 0) {
-                  db::Edge he (db::Point (hx, y), db::Point (db::coord_traits<db::Coord>::rounded (x), y));
-                  if (ho > 0) {
-                    he.swap_points ();
-                  }
-                  es.put (he);
-#ifdef DEBUG_EDGE_PROCESSOR
-                  printf ("put(%s)\n", he.to_string().c_str());
-#endif
-                } 
+    WorkEdge &ew = (*mp_work_edges) [n];
 
-                vertex = true;
+    CutPoints *cut_points = ew.data ? & ((*mp_cpvector) [ew.data - 1]) : 0;
+    ew.data = 0;
 
-              }
+    if (ew.dy () == 0 && ! selects_edges) {
 
-              if (e != mp_work_edges->end ()) {
+      //  don't care about horizontal edges 
 
-                db::Edge edge (*e);
+    } else if (cut_points) {
 
-                if ((pn > 0 && edge.dy () < 0) || (pn < 0 && edge.dy () > 0)) {
-                  edge.swap_points ();
-                }
+      if (cut_points->has_cutpoints && ! cut_points->cut_points.empty ()) {
 
-                if (pn != 0) {
-                  ++n_res;
-                  if (edge_ymin (edge) == y) {
-                    es.put (edge);
-#ifdef DEBUG_EDGE_PROCESSOR
-                    printf ("put(%s)\n", edge.to_string().c_str());
-#endif
-                  } else {
-                    es.crossing_edge (edge);
-#ifdef DEBUG_EDGE_PROCESSOR
-                    printf ("xing(%s)\n", edge.to_string().c_str());
-#endif
-                  }
-                }
+        db::Edge e = ew;
+        property_type p = ew.prop;
+        std::sort (cut_points->cut_points.begin (), cut_points->cut_points.end (), ProjectionCompare (e));
 
-              }
+        db::Point pll = e.p1 ();
+        db::Point pl = e.p1 ();
 
+        for (std::vector <db::Point>::iterator cp = cut_points->cut_points.begin (); cp != cut_points->cut_points.end (); ++cp) {
+          if (*cp != pl) {
+            WorkEdge ne = WorkEdge (db::Edge (pl, *cp), p);
+            if (pl.y () == pll.y () && ne.p2 ().x () != pl.x () && ne.p2 ().x () == pll.x ()) {
+              ne = db::Edge (pll, ne.p2 ());
+            } else if (pl.x () == pll.x () && ne.p2 ().y () != pl.y () && ne.p2 ().y () == pll.y ()) {
+              ne = db::Edge (ne.p1 (), pll);
+            } else {
+              pll = pl;
             }
-
-            if (vertex) {
-              hx = db::coord_traits<db::Coord>::rounded (x);
-              ho = op.compare_ns ();
+            pl = *cp;
+            if (selects_edges || ne.dy () != 0) {
+              if (nw <= n) {
+                (*mp_work_edges) [nw++] = ne;
+              } else {
+                mp_work_edges->push_back (ne);
+              }
             }
+          }
+        }
 
-            c = f;
-
-          } while (c != future && ! op.is_reset ());
+        if (cut_points->cut_points.back () != e.p2 ()) {
+          WorkEdge ne = WorkEdge (db::Edge (pl, e.p2 ()), p);
+          if (pl.y () == pll.y () && ne.p2 ().x () != pl.x () && ne.p2 ().x () == pll.x ()) {
+            ne = db::Edge (pll, ne.p2 ());
+          } else if (pl.x () == pll.x () && ne.p2 ().y () != pl.y () && ne.p2 ().y () == pll.y ()) {
+            ne = db::Edge (ne.p1 (), pll);
+          }
+          if (selects_edges || ne.dy () != 0) {
+            if (nw <= n) {
+              (*mp_work_edges) [nw++] = ne;
+            } else {
+              mp_work_edges->push_back (ne);
+            }
+          }
+        }
 
-          //  TODO: assert that there is no overflow here:
-          c0->data = size_t (std::distance (c0, c) + new_skip_unit * n_res);
+      } else {
 
+        if (nw < n) {
+          (*mp_work_edges) [nw] = (*mp_work_edges) [n];
         }
+        ++nw;
 
       }
 
-      skip_unit = new_skip_unit;
-
-      y = yy;
+    } else {
 
-#ifdef DEBUG_EDGE_PROCESSOR
-      for (std::vector <WorkEdge>::iterator c = current; c != future; ++c) { 
-        printf ("%ld-", long (c->data)); 
-      } 
-      printf ("\n");
-#endif
-      std::vector <WorkEdge>::iterator c0 = current;
-      std::vector <WorkEdge>::iterator last_interval = future;
-      current = future;
+      if (nw < n) {
+        (*mp_work_edges) [nw] = (*mp_work_edges) [n];
+      }
+      ++nw;
 
-      bool valid = true;
+    }
 
-      for (std::vector <WorkEdge>::iterator c = future; c != c0; ) {
+  }
 
-        --c;
+  if (nw != n_work) {
+    mp_work_edges->erase (mp_work_edges->begin () + nw, mp_work_edges->begin () + n_work);
+  }
 
-        bool start_interval = (c->data != 0);
-        size_t data = c->data;
-        c->data = 0;
+#ifdef DEBUG_EDGE_PROCESSOR
+  printf ("Output edges:\n");
+  for (std::vector <WorkEdge>::iterator c1 = mp_work_edges->begin (); c1 != mp_work_edges->end (); ++c1) { 
+    printf ("%s\n", c1->to_string().c_str ()); 
+  } 
+#endif
 
-        db::Coord ymax = edge_ymax (*c);
-        if (ymax >= y) {
-          --current;
-          if (current != c) {
-            *current = *c;
-          }
-        }
-        if (ymax <= y) {
-          //  an edge ends now. The interval is not valid, i.e. cannot be skipped easily.
-          valid = false;
-        }
 
-        if (start_interval && current != future) {
-          current->data = valid ? data : 0;
-          last_interval = current;
-          valid = true;
-        }
+  tl::SelfTimer timer2 (tl::verbosity () >= m_base_verbosity + 10, "EdgeProcessor: production");
 
-      }
-#ifdef DEBUG_EDGE_PROCESSOR
-      for (std::vector <WorkEdge>::iterator c = current; c != future; ++c) { 
-        printf ("%ld-", long (c->data)); 
-      } 
-      printf ("\n");
-#endif
-    
-    }
+  //  step 4: compute the result edges 
+  
+  es.start (); // call this as late as possible. This way, input containers can be identical with output containers ("clear" is done after the input is read)
 
-    tl_assert (op.is_reset ()); // HINT: for development (second)
+  op.reset ();
+  op.reserve (n_props);
 
-    es.end_scanline (ysl);
+  std::sort (mp_work_edges->begin (), mp_work_edges->end (), edge_ymin_compare<db::Coord> ());
 
+  if (m_threads <= 1 || ! produce_scanlines_in_bands (*mp_work_edges, m_threads, es, op)) {
+    produce_scanlines (*mp_work_edges, edge_ymin ((*mp_work_edges) [0]), std::numeric_limits <db::Coord>::max (), es, op, progress.get (), todo_next, todo_max);
   }
 
   es.flush ();
@@ -192,6 +192,10 @@ private:
  *  At the beginning of the scan line, the "reset" method is called to bring the
  *  evaluator into a defined state. Each edge has an integer property that can be
  *  used to distinguish edges from different polygons or layers.
+ *
+ *  Evaluators which do not keep state across scan lines can implement "clone".
+ *  This allows the edge processor to run the scan line on multiple bands
+ *  in parallel.
  */
 class DB_PUBLIC EdgeEvaluatorBase
 {
@@ -201,6 +205,14 @@ public:
   EdgeEvaluatorBase () { }
   virtual ~EdgeEvaluatorBase () { }
 
+  /**
+   *  @brief Creates a copy of this evaluator for use in a separate scan line band
+   *
+   *  The default implementation returns 0 which means that the evaluator
+   *  cannot be used in multiple bands.
+   */
+  virtual EdgeEvaluatorBase *clone () const { return 0; }
+
   virtual void reset () { }
   virtual void reserve (size_t /*n*/) { }
   virtual int edge (bool /*north*/, bool /*enter*/, property_type /*p*/) { return 0; }
@@ -330,6 +342,11 @@ public:
     : m_wc_n (0), m_wc_s (0), m_function (function)
   { }
 
+  virtual EdgeEvaluatorBase *clone () const
+  {
+    return new GenericMerge<F> (*this);
+  }
+
   virtual void reset ()
   {
     m_wc_n = m_wc_s = 0;
@@ -454,6 +471,7 @@ public:
    */
   BooleanOp (BoolOp mode);
 
+  virtual EdgeEvaluatorBase *clone () const { return new BooleanOp (*this); }
   virtual void reset ();
   virtual void reserve (size_t n);
   virtual int edge (bool north, bool enter, property_type p);
@@ -496,6 +514,7 @@ public:
    */
   EdgePolygonOp (bool outside = false, bool include_touching = true, int polygon_mode = -1);
 
+  virtual EdgeEvaluatorBase *clone () const { return new EdgePolygonOp (*this); }
   virtual void reset ();
   virtual bool select_edge (bool horizontal, property_type p);
   virtual int edge (bool north, bool enter, property_type p);
@@ -529,6 +548,7 @@ public:
    */
   BooleanOp2 (BoolOp mode, int wc_mode_a, int wc_mode_b);
 
+  virtual EdgeEvaluatorBase *clone () const { return new BooleanOp2 (*this); }
   virtual int edge (bool north, bool enter, property_type p);
   virtual int compare_ns () const;
 
@@ -556,6 +576,7 @@ public:
    */
   MergeOp (unsigned int min_overlap = 0);
 
+  virtual EdgeEvaluatorBase *clone () const { return new MergeOp (*this); }
   virtual void reset ();
   virtual void reserve (size_t n);
   virtual int edge (bool north, bool enter, property_type p);
@@ -614,6 +635,25 @@ public:
    */
   void set_base_verbosity (int bv);
 
+  /**
+   *  @brief Sets the number of threads to use for the scan line
+   *
+   *  With more than one thread, the edge set is split into horizontal bands which
+   *  are evaluated in parallel. The output is delivered to the edge sink in the
+   *  same order as for a single band, so the results are identical.
+   *  Multiple bands are only used if the evaluator supports "clone" and the
+   *  number of edges is large enough. The default is 0 (single-threaded).
+   */
+  void set_threads (unsigned int n);
+
+  /**
+   *  @brief Gets the number of threads to use for the scan line
+   */
+  unsigned int threads () const
+  {
+    return m_threads;
+  }
+
   /**
    *  @brief Reserve space for at least n edges
    */
@@ -952,6 +992,7 @@ private:
   bool m_report_progress;
   std::string m_progress_desc;
   int m_base_verbosity;
+  unsigned int m_threads;
 
   static size_t count_edges (const db::Polygon &q) 
   {
@@ -25,6 +25,7 @@
 #include "dbEmptyEdges.h"
 #include "dbEmptyEdgePairs.h"
 #include "dbRegion.h"
+#include "dbFlatRegion.h"
 
 namespace db
 {
@@ -156,6 +157,15 @@ EmptyRegion::angle_check (double, double, bool) const
   return new EmptyEdgePairs ();
 }
 
+RegionDelegate *
+EmptyRegion::density_check (db::Coord wx, db::Coord wy, db::Coord sx, db::Coord sy, double min_density, double max_density, bool inverse, const Region &boundary) const
+{
+  //  with a boundary, the windows of zero density need to be produced
+  FlatRegion empty;
+  empty.set_threads (threads ());
+  return empty.density_check (wx, wy, sx, sy, min_density, max_density, inverse, boundary);
+}
+
 EdgesDelegate *
 EmptyRegion::edges (const EdgeFilterBase *) const
 {
@@ -71,6 +71,7 @@ public:
   virtual EdgePairsDelegate *inside_check (const Region &, db::Coord, bool, metrics_type, double, distance_type, distance_type) const;
   virtual EdgePairsDelegate *grid_check (db::Coord, db::Coord) const;
   virtual EdgePairsDelegate *angle_check (double, double, bool) const;
+  virtual RegionDelegate *density_check (db::Coord wx, db::Coord wy, db::Coord sx, db::Coord sy, double min_density, double max_density, bool inverse, const Region &boundary) const;
 
   virtual RegionDelegate *snapped_in_place (db::Coord, db::Coord) { return this; }
   virtual RegionDelegate *snapped (db::Coord, db::Coord) { return new EmptyRegion (); }
@@ -115,6 +115,7 @@ FlatRegion::ensure_merged_polygons_valid () const
 
     db::EdgeProcessor ep (report_progress (), progress_desc ());
     ep.set_base_verbosity (base_verbosity ());
+    ep.set_threads (threads ());
 
     //  count edges and reserve memory
     size_t n = 0;
@@ -284,6 +285,7 @@ RegionDelegate *FlatRegion::merged_in_place (bool min_coherence, unsigned int mi
 
     db::EdgeProcessor ep (report_progress (), progress_desc ());
     ep.set_base_verbosity (base_verbosity ());
+    ep.set_threads (threads ());
 
     //  count edges and reserve memory
     size_t n = 0;
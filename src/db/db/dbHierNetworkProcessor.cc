@@ -33,6 +33,7 @@
 #include "tlProgress.h"
 #include "tlLog.h"
 #include "tlTimer.h"
+#include "tlThreadedWorkers.h"
 
 #include <vector>
 #include <map>
@@ -1273,7 +1274,7 @@ const db::cell_index_type hier_clusters<T>::top_cell_index = std::numeric_limits
 
 template <class T>
 hier_clusters<T>::hier_clusters ()
-  : m_base_verbosity (20)
+  : m_base_verbosity (20), m_threads (0)
 {
   //  .. nothing yet ..
 }
@@ -1284,6 +1285,12 @@ void hier_clusters<T>::set_base_verbosity (int bv)
   m_base_verbosity = bv;
 }
 
+template <class T>
+void hier_clusters<T>::set_threads (unsigned int n)
+{
+  m_threads = n;
+}
+
 template <class T>
 void hier_clusters<T>::clear ()
 {
@@ -2107,6 +2114,107 @@ hier_clusters<T>::propagate_cluster_inst (const db::Layout &layout, const db::Ce
   return id_new;
 }
 
+namespace
+{
+
+/**
+ *  @brief Computes the local clusters of a single cell
+ *
+ *  If "report_progress" is false, the box scanner will not report progress. This is
+ *  required when this function is called from a worker thread.
+ */
+template <class T>
+void build_local_clusters_for_cell (connected_clusters<T> &local, const db::Layout &layout, const db::Cell &cell, const db::Connectivity &conn, const tl::equivalence_clusters<size_t> *attr_equivalence, int base_verbosity, bool report_progress)
+{
+  std::string msg = tl::to_string (tr ("Computing local clusters for cell: ")) + std::string (layout.cell_name (cell.cell_index ()));
+  if (tl::verbosity () >= base_verbosity + 20) {
+    tl::log << msg;
+  }
+  tl::SelfTimer timer (tl::verbosity () > base_verbosity + 20, msg);
+
+  local.build_clusters (cell, conn, attr_equivalence, report_progress);
+}
+
+/**
+ *  @brief A counter for the cells finished by the local cluster computation tasks
+ */
+class local_cluster_computation_progress
+{
+public:
+  local_cluster_computation_progress ()
+    : m_count (0)
+  {
+    //  .. nothing yet ..
+  }
+
+  void next ()
+  {
+    tl::MutexLocker locker (&m_lock);
+    ++m_count;
+  }
+
+  size_t count ()
+  {
+    tl::MutexLocker locker (&m_lock);
+    return m_count;
+  }
+
+private:
+  tl::Mutex m_lock;
+  size_t m_count;
+};
+
+/**
+ *  @brief A task computing the local clusters of a single cell
+ */
+template <class T>
+class local_cluster_computation_task
+  : public tl::Task
+{
+public:
+  local_cluster_computation_task (connected_clusters<T> *local, const db::Layout *layout, const db::Cell *cell, const db::Connectivity *conn, const tl::equivalence_clusters<size_t> *attr_equivalence, int base_verbosity, local_cluster_computation_progress *progress)
+    : mp_local (local), mp_layout (layout), mp_cell (cell), mp_conn (conn), mp_attr_equivalence (attr_equivalence), m_base_verbosity (base_verbosity), mp_progress (progress)
+  {
+    //  .. nothing yet ..
+  }
+
+  void perform ()
+  {
+    //  NOTE: tl::Progress objects must not be created in the worker threads, so the
+    //  progress is reported through the counter and forwarded by the main thread.
+    build_local_clusters_for_cell (*mp_local, *mp_layout, *mp_cell, *mp_conn, mp_attr_equivalence, m_base_verbosity, false);
+    mp_progress->next ();
+  }
+
+private:
+  connected_clusters<T> *mp_local;
+  const db::Layout *mp_layout;
+  const db::Cell *mp_cell;
+  const db::Connectivity *mp_conn;
+  const tl::equivalence_clusters<size_t> *mp_attr_equivalence;
+  int m_base_verbosity;
+  local_cluster_computation_progress *mp_progress;
+};
+
+template <class T>
+class local_cluster_computation_worker
+  : public tl::Worker
+{
+public:
+  local_cluster_computation_worker ()
+    : tl::Worker ()
+  {
+    //  .. nothing yet ..
+  }
+
+  void perform_task (tl::Task *task)
+  {
+    static_cast<local_cluster_computation_task<T> *> (task)->perform ();
+  }
+};
+
+}
+
 template <class T>
 void
 hier_clusters<T>::do_build (cell_clusters_box_converter<T> &cbc, const db::Layout &layout, const db::Cell &cell, const db::Connectivity &conn, const std::map<db::cell_index_type, tl::equivalence_clusters<size_t> > *attr_equivalence, const std::set<db::cell_index_type> *breakout_cells)
@@ -2123,6 +2231,15 @@ hier_clusters<T>::do_build (cell_clusters_box_converter<T> &cbc, const db::Layou
     tl::SelfTimer timer (tl::verbosity () > m_base_verbosity + 10, tl::to_string (tr ("Computing local shape clusters")));
     tl::RelativeProgress progress (tl::to_string (tr ("Computing local clusters")), called.size (), 1);
 
+    //  The local clusters of the cells are independent from each other, so they can
+    //  be computed in parallel. The hierarchical stage below is kept serial as
+    //  the propagation of clusters writes into all parents of a child cell.
+    local_cluster_computation_progress job_progress;
+    std::auto_ptr<tl::Job<local_cluster_computation_worker<T> > > job;
+    if (m_threads > 0 && called.size () > 1) {
+      job.reset (new tl::Job<local_cluster_computation_worker<T> > (m_threads));
+    }
+
     for (std::set<db::cell_index_type>::const_iterator c = called.begin (); c != called.end (); ++c) {
 
       //  look for the net label joining spec - for the top cell the "top_cell_index" entry is looked for.
@@ -2144,9 +2261,33 @@ hier_clusters<T>::do_build (cell_clusters_box_converter<T> &cbc, const db::Layou
         }
       }
 
-      build_local_cluster (layout, layout.cell (*c), conn, ec);
+      if (job.get ()) {
+        //  NOTE: the map entry needs to be created here as the map must not be modified by the workers
+        job->schedule (new local_cluster_computation_task<T> (&m_per_cell_clusters [*c], &layout, &layout.cell (*c), &conn, ec, m_base_verbosity, &job_progress));
+      } else {
+        build_local_cluster (layout, layout.cell (*c), conn, ec);
+        ++progress;
+      }
 
-      ++progress;
+    }
+
+    if (job.get ()) {
+
+      try {
+        job->start ();
+        while (! job->wait (10)) {
+          progress.set (job_progress.count ());
+        }
+      } catch (...) {
+        job->terminate ();
+        throw;
+      }
+
+      if (job->has_error ()) {
+        throw tl::Exception (job->error_messages ().front ());
+      }
+
+      progress.set (job_progress.count ());
 
     }
   }
@@ -2193,14 +2334,7 @@ template <class T>
 void
 hier_clusters<T>::build_local_cluster (const db::Layout &layout, const db::Cell &cell, const db::Connectivity &conn, const tl::equivalence_clusters<size_t> *attr_equivalence)
 {
-  std::string msg = tl::to_string (tr ("Computing local clusters for cell: ")) + std::string (layout.cell_name (cell.cell_index ()));
-  if (tl::verbosity () >= m_base_verbosity + 20) {
-    tl::log << msg;
-  }
-  tl::SelfTimer timer (tl::verbosity () > m_base_verbosity + 20, msg);
-
-  connected_clusters<T> &local = m_per_cell_clusters [cell.cell_index ()];
-  local.build_clusters (cell, conn, attr_equivalence, true);
+  build_local_clusters_for_cell (m_per_cell_clusters [cell.cell_index ()], layout, cell, conn, attr_equivalence, m_base_verbosity, true);
 }
 
 template <class T>
@@ -1049,6 +1049,25 @@ public:
    */
   void set_base_verbosity (int bv);
 
+  /**
+   *  @brief Sets the number of threads to use
+   *
+   *  If this number is larger than 0, the local clusters of the cells are computed in
+   *  the given number of worker threads. The default is 0 which means the clusters are
+   *  computed in the main thread.
+   *  Only the local cluster stage is multi-threaded. The hierarchical connection stage
+   *  is always executed in the main thread.
+   */
+  void set_threads (unsigned int n);
+
+  /**
+   *  @brief Gets the number of threads to use
+   */
+  unsigned int threads () const
+  {
+    return m_threads;
+  }
+
   /**
    *  @brief A constant indicating the top cell for the equivalence cluster key
    */
@@ -1102,6 +1121,7 @@ private:
 
   std::map<db::cell_index_type, connected_clusters<T> > m_per_cell_clusters;
   int m_base_verbosity;
+  unsigned int m_threads;
 };
 
 /**
@@ -22,6 +22,7 @@
 
 
 #include "dbHierProcessor.h"
+#include "dbClip.h"
 #include "dbBoxScanner.h"
 #include "dbRecursiveShapeIterator.h"
 #include "dbBoxConvert.h"
@@ -32,6 +33,8 @@
 #include "tlTimer.h"
 #include "tlInternational.h"
 
+#include <limits>
+
 // ---------------------------------------------------------------------------------------------
 //  Cronology debugging support (TODO: experimental)
 
@@ -320,6 +323,38 @@ template class DB_PUBLIC local_processor_cell_context<db::Edge, db::Edge, db::Ed
 template class DB_PUBLIC local_processor_cell_context<db::Edge, db::Polygon, db::Edge>;
 template class DB_PUBLIC local_processor_cell_context<db::Edge, db::Edge, db::EdgePair>;
 
+// ---------------------------------------------------------------------------------------------
+//  Context clip traits implementation
+
+void
+context_clip_traits<db::PolygonRef>::clip (const db::PolygonRef &shape, const db::Box &box, std::vector<db::Polygon> &clipped)
+{
+  db::Polygon poly = shape.obj ().transformed (shape.trans ());
+  if (poly.box ().inside (box)) {
+    clipped.push_back (poly);
+  } else {
+    db::clip_poly (poly, box, clipped, false);
+  }
+}
+
+void
+context_clip_traits<db::Edge>::clip (const db::Edge &shape, const db::Box &box, std::vector<db::Edge> &clipped)
+{
+  std::pair<bool, db::Edge> ce = shape.clipped (box);
+  if (ce.first) {
+    clipped.push_back (ce.second);
+  }
+}
+
+void
+context_clip_traits<db::TextRef>::clip (const db::TextRef &shape, const db::Box &box, std::vector<db::Text> &clipped)
+{
+  db::Text text = shape.obj ().transformed (shape.trans ());
+  if (box.contains (text.box ().center ())) {
+    clipped.push_back (text);
+  }
+}
+
 // ---------------------------------------------------------------------------------------------
 //  LocalProcessorCellContexts implementation
 
@@ -337,6 +372,35 @@ local_processor_cell_contexts<TS, TI, TR>::local_processor_cell_contexts (const
   //  .. nothing yet ..
 }
 
+template <class TS, class TI, class TR>
+local_processor_cell_contexts<TS, TI, TR>::local_processor_cell_contexts (const local_processor_cell_contexts &other)
+  : mp_intruder_cell (0)
+{
+  operator= (other);
+}
+
+template <class TS, class TI, class TR>
+local_processor_cell_contexts<TS, TI, TR> &
+local_processor_cell_contexts<TS, TI, TR>::operator= (const local_processor_cell_contexts &other)
+{
+  if (this != &other) {
+
+    mp_intruder_cell = other.mp_intruder_cell;
+    m_contexts = other.m_contexts;
+
+    //  the signatures point to the contexts, so they need to be mapped to our copy
+    m_signatures.clear ();
+    for (typename std::unordered_map<context_signature_type, typename context_map_type::value_type *>::const_iterator s = other.m_signatures.begin (); s != other.m_signatures.end (); ++s) {
+      typename context_map_type::iterator c = m_contexts.find (s->second->first);
+      if (c != m_contexts.end ()) {
+        m_signatures.insert (std::make_pair (s->first, c.operator-> ()));
+      }
+    }
+
+  }
+  return *this;
+}
+
 template <class TS, class TI, class TR>
 db::local_processor_cell_context<TS, TI, TR> *
 local_processor_cell_contexts<TS, TI, TR>::find_context (const context_key_type &intruders)
@@ -352,6 +416,23 @@ local_processor_cell_contexts<TS, TI, TR>::create (const context_key_type &intru
   return &m_contexts[intruders];
 }
 
+template <class TS, class TI, class TR>
+db::local_processor_cell_context<TS, TI, TR> *
+local_processor_cell_contexts<TS, TI, TR>::find_context_by_signature (const context_signature_type &signature)
+{
+  typename std::unordered_map<context_signature_type, typename context_map_type::value_type *>::const_iterator s = m_signatures.find (signature);
+  return s != m_signatures.end () ? &s->second->second : 0;
+}
+
+template <class TS, class TI, class TR>
+db::local_processor_cell_context<TS, TI, TR> *
+local_processor_cell_contexts<TS, TI, TR>::create (const context_key_type &intruders, const context_signature_type &signature)
+{
+  typename context_map_type::iterator c = m_contexts.insert (std::make_pair (intruders, db::local_processor_cell_context<TS, TI, TR> ())).first;
+  m_signatures.insert (std::make_pair (signature, c.operator-> ()));
+  return &c->second;
+}
+
 template <class TS, class TI>
 static void
 subtract (std::unordered_set<db::PolygonRef> &res, const std::unordered_set<db::PolygonRef> &other, db::Layout *layout, const db::local_processor<TS, TI, db::PolygonRef> *proc)
@@ -533,6 +614,22 @@ local_processor_cell_contexts<TS, TI, TR>::compute_results (const local_processo
   proc->push_results (cell, output_layer, common);
 }
 
+template <class TS, class TI, class TR>
+size_t
+local_processor_cell_contexts<TS, TI, TR>::estimated_cost (const db::Cell *cell, unsigned int subject_layer) const
+{
+  size_t subjects = cell->shapes (subject_layer).size ();
+  size_t instances = cell->cell_instances ();
+
+  //  each context scans the subjects against the context's intruders and the child instances
+  size_t cost = 0;
+  for (typename std::unordered_map<context_key_type, db::local_processor_cell_context<TS, TI, TR> >::const_iterator c = m_contexts.begin (); c != m_contexts.end (); ++c) {
+    cost += subjects + instances + c->first.first.size () + c->first.second.size ();
+  }
+
+  return cost;
+}
+
 template class DB_PUBLIC local_processor_cell_contexts<db::PolygonRef, db::PolygonRef, db::PolygonRef>;
 template class DB_PUBLIC local_processor_cell_contexts<db::PolygonRef, db::Edge, db::PolygonRef>;
 template class DB_PUBLIC local_processor_cell_contexts<db::PolygonRef, db::PolygonRef, db::EdgePair>;
@@ -1056,6 +1153,202 @@ template class DB_PUBLIC local_processor_result_computation_task<db::Edge, db::E
 template class DB_PUBLIC local_processor_result_computation_task<db::Edge, db::PolygonRef, db::Edge>;
 template class DB_PUBLIC local_processor_result_computation_task<db::Edge, db::Edge, db::EdgePair>;
 
+// ---------------------------------------------------------------------------------------------
+//  Splitting of large local computations
+
+/**
+ *  @brief The number of subjects from which on the local computation of a cell is split
+ *
+ *  This applies to operations which allow computing the subjects separately only.
+ */
+static const size_t split_min_subjects = 10000;
+
+/**
+ *  @brief Converts a cost estimate into a task priority
+ *
+ *  The priority is logarithmic to keep the number of distinct priorities small.
+ */
+static int
+cost_to_priority (size_t cost)
+{
+  int p = 0;
+  while (cost > 0) {
+    ++p;
+    cost >>= 1;
+  }
+  return p;
+}
+
+/**
+ *  @brief The shared state of a split local computation
+ *
+ *  The chunks are taken by the thread which splits the computation and by helper tasks
+ *  scheduled into the running result computation job. As helper tasks may be executed
+ *  after the computation has finished, this object is reference counted.
+ */
+template <class TS, class TI, class TR>
+class local_computation_split
+{
+public:
+  local_computation_split (const local_operation<TS, TI, TR> *op, db::Layout *layout, size_t nchunks, size_t max_vertex_count, double area_ratio)
+    : mp_op (op), mp_layout (layout), m_chunks (nchunks), m_results (nchunks), m_max_vertex_count (max_vertex_count), m_area_ratio (area_ratio),
+      m_next_chunk (0), m_chunks_done (0), m_ref_count (1)
+  {
+    //  .. nothing yet ..
+  }
+
+  shape_interactions<TS, TI> &chunk (size_t n)
+  {
+    return m_chunks [n];
+  }
+
+  void add_ref ()
+  {
+    tl::MutexLocker locker (&m_lock);
+    ++m_ref_count;
+  }
+
+  void release ()
+  {
+    bool last = false;
+    {
+      tl::MutexLocker locker (&m_lock);
+      last = (--m_ref_count == 0);
+    }
+    if (last) {
+      delete this;
+    }
+  }
+
+  /**
+   *  @brief Computes chunks until no unclaimed chunk is left
+   */
+  void process ()
+  {
+    while (true) {
+
+      size_t n = 0;
+      {
+        tl::MutexLocker locker (&m_lock);
+        if (m_next_chunk >= m_chunks.size ()) {
+          return;
+        }
+        n = m_next_chunk++;
+      }
+
+      std::string error;
+      try {
+        mp_op->compute_local (mp_layout, m_chunks [n], m_results [n], m_max_vertex_count, m_area_ratio);
+      } catch (tl::Exception &ex) {
+        error = ex.msg ();
+      } catch (std::exception &ex) {
+        error = ex.what ();
+      } catch (...) {
+        error = tl::to_string (tr ("Unspecific error"));
+      }
+
+      tl::MutexLocker locker (&m_lock);
+      if (! error.empty () && m_error.empty ()) {
+        m_error = error;
+      }
+      if (++m_chunks_done == m_chunks.size ()) {
+        m_done_condition.wakeAll ();
+      }
+
+    }
+  }
+
+  /**
+   *  @brief Waits for the chunks claimed by other threads and collects the results
+   */
+  void collect (std::unordered_set<TR> &result)
+  {
+    {
+      tl::MutexLocker locker (&m_lock);
+      while (m_chunks_done < m_chunks.size ()) {
+        m_done_condition.wait (&m_lock);
+      }
+    }
+
+    if (! m_error.empty ()) {
+      throw tl::Exception (m_error);
+    }
+
+    for (typename std::vector<std::unordered_set<TR> >::const_iterator r = m_results.begin (); r != m_results.end (); ++r) {
+      result.insert (r->begin (), r->end ());
+    }
+  }
+
+private:
+  const local_operation<TS, TI, TR> *mp_op;
+  db::Layout *mp_layout;
+  std::vector<shape_interactions<TS, TI> > m_chunks;
+  std::vector<std::unordered_set<TR> > m_results;
+  size_t m_max_vertex_count;
+  double m_area_ratio;
+  tl::Mutex m_lock;
+  tl::WaitCondition m_done_condition;
+  size_t m_next_chunk, m_chunks_done;
+  int m_ref_count;
+  std::string m_error;
+};
+
+/**
+ *  @brief A task helping with a split local computation
+ *
+ *  These tasks are scheduled into the result computation job, so the chunks are
+ *  computed by the job's workers rather than by a separate set of threads.
+ */
+template <class TS, class TI, class TR>
+class local_computation_split_task
+  : public tl::Task
+{
+public:
+  local_computation_split_task (local_computation_split<TS, TI, TR> *split)
+    : mp_split (split)
+  {
+    mp_split->add_ref ();
+  }
+
+  ~local_computation_split_task ()
+  {
+    mp_split->release ();
+  }
+
+  void perform ()
+  {
+    mp_split->process ();
+  }
+
+private:
+  local_computation_split<TS, TI, TR> *mp_split;
+};
+
+template <class TS, class TI, class TR>
+void
+local_processor_result_computation_worker<TS, TI, TR>::perform_task (tl::Task *task)
+{
+  local_computation_split_task<TS, TI, TR> *split_task = dynamic_cast<local_computation_split_task<TS, TI, TR> *> (task);
+  if (split_task) {
+    split_task->perform ();
+  } else {
+    static_cast<local_processor_result_computation_task<TS, TI, TR> *> (task)->perform ();
+  }
+}
+
+template class DB_PUBLIC local_processor_result_computation_worker<db::PolygonRef, db::PolygonRef, db::PolygonRef>;
+template class DB_PUBLIC local_processor_result_computation_worker<db::PolygonRef, db::Edge, db::PolygonRef>;
+template class DB_PUBLIC local_processor_result_computation_worker<db::PolygonRef, db::Edge, db::Edge>;
+template class DB_PUBLIC local_processor_result_computation_worker<db::PolygonRef, db::TextRef, db::PolygonRef>;
+template class DB_PUBLIC local_processor_result_computation_worker<db::PolygonRef, db::TextRef, db::TextRef>;
+template class DB_PUBLIC local_processor_result_computation_worker<db::PolygonRef, db::PolygonRef, db::EdgePair>;
+template class DB_PUBLIC local_processor_result_computation_worker<db::Edge, db::Edge, db::Edge>;
+template class DB_PUBLIC local_processor_result_computation_worker<db::Edge, db::PolygonRef, db::Edge>;
+template class DB_PUBLIC local_processor_result_computation_worker<db::Edge, db::PolygonRef, db::PolygonRef>;
+template class DB_PUBLIC local_processor_result_computation_worker<db::Edge, db::Edge, db::EdgePair>;
+template class DB_PUBLIC local_processor_result_computation_worker<db::TextRef, db::PolygonRef, db::TextRef>;
+template class DB_PUBLIC local_processor_result_computation_worker<db::TextRef, db::PolygonRef, db::PolygonRef>;
+
 // ---------------------------------------------------------------------------------------------
 //  LocalProcessor implementation
 
@@ -1064,7 +1357,7 @@ local_processor<TS, TI, TR>::local_processor (db::Layout *layout, db::Cell *top,
   : mp_subject_layout (layout), mp_intruder_layout (layout),
     mp_subject_top (top), mp_intruder_top (top),
     mp_subject_breakout_cells (breakout_cells), mp_intruder_breakout_cells (breakout_cells),
-    m_nthreads (0), m_max_vertex_count (0), m_area_ratio (0.0), m_base_verbosity (30), m_progress (0), mp_progress (0)
+    m_nthreads (0), m_max_vertex_count (0), m_area_ratio (0.0), m_base_verbosity (30), m_progress (0), mp_progress (0), mp_rc_job (0)
 {
   //  .. nothing yet ..
 }
@@ -1074,7 +1367,7 @@ local_processor<TS, TI, TR>::local_processor (db::Layout *subject_layout, db::Ce
   : mp_subject_layout (subject_layout), mp_intruder_layout (intruder_layout),
     mp_subject_top (subject_top), mp_intruder_top (intruder_top),
     mp_subject_breakout_cells (subject_breakout_cells), mp_intruder_breakout_cells (intruder_breakout_cells),
-    m_nthreads (0), m_max_vertex_count (0), m_area_ratio (0.0), m_base_verbosity (30), m_progress (0), mp_progress (0)
+    m_nthreads (0), m_max_vertex_count (0), m_area_ratio (0.0), m_base_verbosity (30), m_progress (0), mp_progress (0), mp_rc_job (0)
 {
   //  .. nothing yet ..
 }
@@ -1142,6 +1435,7 @@ void local_processor<TS, TI, TR>::compute_contexts (local_processor_contexts<TS,
 
     if (m_nthreads > 0) {
       mp_cc_job.reset (new tl::Job<local_processor_context_computation_worker<TS, TI, TR> > (m_nthreads));
+      mp_cc_job->set_thread_affinity (m_thread_affinity);
     } else {
       mp_cc_job.reset (0);
     }
@@ -1149,6 +1443,7 @@ void local_processor<TS, TI, TR>::compute_contexts (local_processor_contexts<TS,
     contexts.clear ();
     contexts.set_intruder_layer (intruder_layer);
     contexts.set_subject_layer (subject_layer);
+    contexts.set_clip_intruders (op->allows_clipped_intruders ());
 
     typename local_processor_cell_contexts<TS, TI, TR>::context_key_type intruders;
     issue_compute_contexts (contexts, 0, 0, mp_subject_top, db::ICplxTrans (), mp_intruder_top, intruders, op->dist ());
@@ -1177,7 +1472,10 @@ void local_processor<TS, TI, TR>::issue_compute_contexts (local_processor_contex
   bool is_small_job = subject_cell->begin ().at_end ();
 
   if (! is_small_job && mp_cc_job.get ()) {
-    mp_cc_job->schedule (new local_processor_context_computation_task<TS, TI, TR> (this, contexts, parent_context, subject_parent, subject_cell, subject_cell_inst, intruder_cell, intruders, dist));
+    //  big cells go first so they don't end up as stragglers
+    local_processor_context_computation_task<TS, TI, TR> *task = new local_processor_context_computation_task<TS, TI, TR> (this, contexts, parent_context, subject_parent, subject_cell, subject_cell_inst, intruder_cell, intruders, dist);
+    task->set_priority (cost_to_priority (subject_cell->shapes (contexts.subject_layer ()).size () + subject_cell->cell_instances () + intruders.first.size () + intruders.second.size ()));
+    mp_cc_job->schedule (task);
   } else {
     compute_contexts (contexts, parent_context, subject_parent, subject_cell, subject_cell_inst, intruder_cell, intruders, dist);
   }
@@ -1237,8 +1535,46 @@ void local_processor<TS, TI, TR>::compute_contexts (local_processor_contexts<TS,
       return;
     }
 
-    cell_context = cell_contexts.create (intruders);
+    if (! contexts.clip_intruders ()) {
+      cell_context = cell_contexts.create (intruders);
+      cell_context->add (parent_context, subject_parent, subject_cell_inst);
+    }
+  }
+
+  if (! cell_context) {
+
+    //  cluster the contexts by the intruders inside the cell's interaction region: contexts which
+    //  look the same there will render the same results (e.g. in regular arrays covered by a big
+    //  intruder polygon). The signature is computed outside the lock as clipping is expensive.
+
+    typename local_processor_cell_contexts<TS, TI, TR>::context_signature_type signature;
+    signature.first = intruders.first;
+
+    db::Box region = subject_cell->bbox (contexts.subject_layer ()).enlarged (db::Vector (dist + 1, dist + 1));
+
+    std::vector<typename context_clip_traits<TI>::clipped_type> clipped;
+    for (typename std::set<TI>::const_iterator i = intruders.second.begin (); i != intruders.second.end (); ++i) {
+      context_clip_traits<TI>::clip (*i, region, clipped);
+    }
+    signature.second.insert (clipped.begin (), clipped.end ());
+
+    tl::MutexLocker locker (& contexts.lock ());
+
+    db::local_processor_cell_contexts<TS, TI, TR> &cell_contexts = contexts.contexts_per_cell (subject_cell, intruder_cell);
+
+    //  NOTE: the same context may have been created in the meantime
+    cell_context = cell_contexts.find_context (intruders);
+    if (! cell_context) {
+      cell_context = cell_contexts.find_context_by_signature (signature);
+    }
+    if (cell_context) {
+      cell_context->add (parent_context, subject_parent, subject_cell_inst);
+      return;
+    }
+
+    cell_context = cell_contexts.create (intruders, signature);
     cell_context->add (parent_context, subject_parent, subject_cell_inst);
+
   }
 
   //  perform the actual task ..
@@ -1475,71 +1811,86 @@ local_processor<TS, TI, TR>::compute_results (local_processor_contexts<TS, TI, T
   if (m_nthreads > 0) {
 
     std::auto_ptr<tl::Job<local_processor_result_computation_worker<TS, TI, TR> > > rc_job (new tl::Job<local_processor_result_computation_worker<TS, TI, TR> > (m_nthreads));
+    rc_job->set_thread_affinity (m_thread_affinity);
 
-    //  schedule computation jobs in "waves": we need to make sure they are executed
-    //  bottom-up. So we identify a new bunch of cells each time we pass through the cell set
-    //  and proceed until all cells are removed.
+    //  schedule the computation tasks with dependencies: we need to make sure they are executed
+    //  bottom-up. So the task of a cell is held back until the tasks of its child cells have
+    //  been processed.
 
-    std::vector<db::cell_index_type> cells_bu;
-    cells_bu.reserve (mp_subject_layout->cells ());
-    for (db::Layout::bottom_up_const_iterator bu = mp_subject_layout->begin_bottom_up (); bu != mp_subject_layout->end_bottom_up (); ++bu) {
-      cells_bu.push_back (*bu);
-    }
+    std::unordered_map<db::cell_index_type, local_processor_result_computation_task<TS, TI, TR> *> tasks;
+    std::vector<local_processor_result_computation_task<TS, TI, TR> *> tasks_bu;
+    std::unordered_map<db::cell_index_type, size_t> costs;
 
-    int iter = 0;
-    while (true) {
+    for (db::Layout::bottom_up_const_iterator bu = mp_subject_layout->begin_bottom_up (); bu != mp_subject_layout->end_bottom_up (); ++bu) {
 
-      ++iter;
-      tl::SelfTimer timer (tl::verbosity () > m_base_verbosity + 10, tl::sprintf (tl::to_string (tr ("Computing results iteration #%d")), iter));
+      typename local_processor_contexts<TS, TI, TR>::iterator cpc = contexts.context_map ().find (&mp_subject_layout->cell (*bu));
+      if (cpc != contexts.context_map ().end ()) {
 
-      bool any = false;
-      std::unordered_set<db::cell_index_type> later;
+        local_processor_result_computation_task<TS, TI, TR> *task = new local_processor_result_computation_task<TS, TI, TR> (this, contexts, cpc->first, &cpc->second, op, output_layer);
+        tasks.insert (std::make_pair (*bu, task));
+        tasks_bu.push_back (task);
+        costs.insert (std::make_pair (*bu, cpc->second.estimated_cost (cpc->first, contexts.subject_layer ())));
 
-      std::vector<db::cell_index_type> next_cells_bu;
-      next_cells_bu.reserve (cells_bu.size ());
+        //  as we go bottom-up, the child cells' tasks are there already
+        for (db::Cell::child_cell_iterator cc = cpc->first->begin_child_cells (); ! cc.at_end (); ++cc) {
+          typename std::unordered_map<db::cell_index_type, local_processor_result_computation_task<TS, TI, TR> *>::const_iterator t = tasks.find (*cc);
+          if (t != tasks.end ()) {
+            task->add_dependency (t->second);
+          }
+        }
 
-      for (std::vector<db::cell_index_type>::const_iterator bu = cells_bu.begin (); bu != cells_bu.end (); ++bu) {
+      }
 
-        typename local_processor_contexts<TS, TI, TR>::iterator cpc = contexts.context_map ().find (&mp_subject_layout->cell (*bu));
-        if (cpc != contexts.context_map ().end ()) {
+    }
 
-          if (later.find (*bu) == later.end ()) {
+    //  prioritize the tasks by the cost of the longest path to the top cell they are on: this
+    //  way, the tasks leading to the expensive parent cells are taken first.
 
-            rc_job->schedule (new local_processor_result_computation_task<TS, TI, TR> (this, contexts, cpc->first, &cpc->second, op, output_layer));
-            any = true;
+    std::unordered_map<db::cell_index_type, size_t> ranks;
 
-          } else {
-            next_cells_bu.push_back (*bu);
-          }
+    for (db::Layout::top_down_const_iterator td = mp_subject_layout->begin_top_down (); td != mp_subject_layout->end_top_down (); ++td) {
 
-          for (db::Cell::parent_cell_iterator pc = cpc->first->begin_parent_cells (); pc != cpc->first->end_parent_cells (); ++pc) {
-            later.insert (*pc);
-          }
+      typename std::unordered_map<db::cell_index_type, local_processor_result_computation_task<TS, TI, TR> *>::const_iterator t = tasks.find (*td);
+      if (t == tasks.end ()) {
+        continue;
+      }
 
+      size_t rank_above = 0;
+      const db::Cell &cell = mp_subject_layout->cell (*td);
+      for (db::Cell::parent_cell_iterator pc = cell.begin_parent_cells (); pc != cell.end_parent_cells (); ++pc) {
+        std::unordered_map<db::cell_index_type, size_t>::const_iterator r = ranks.find (*pc);
+        if (r != ranks.end ()) {
+          rank_above = std::max (rank_above, r->second);
         }
-
       }
 
-      cells_bu.swap (next_cells_bu);
+      size_t rank = costs [*td] + rank_above;
+      ranks.insert (std::make_pair (*td, rank));
+      t->second->set_priority (cost_to_priority (rank));
 
-      if (! any) {
-        break;
-      }
+    }
 
-      if (rc_job.get ()) {
+    if (! tasks_bu.empty ()) {
 
-        try {
+      for (typename std::vector<local_processor_result_computation_task<TS, TI, TR> *>::const_iterator t = tasks_bu.begin (); t != tasks_bu.end (); ++t) {
+        rc_job->schedule (*t);
+      }
 
-          rc_job->start ();
-          while (! rc_job->wait (10)) {
-            progress.set (get_progress ());
-          }
+      try {
 
-        } catch (...) {
-          rc_job->terminate ();
-          throw;
+        mp_rc_job = rc_job.get ();
+
+        rc_job->start ();
+        while (! rc_job->wait (10)) {
+          progress.set (get_progress ());
         }
 
+        mp_rc_job = 0;
+
+      } catch (...) {
+        rc_job->terminate ();
+        mp_rc_job = 0;
+        throw;
       }
 
     }
@@ -1749,9 +2100,80 @@ local_processor<TS, TI, TR>::compute_local_cell (const db::local_processor_conte
 
     }
 
+    if (m_nthreads > 1 && op->requests_single_subjects () && interactions.size () >= split_min_subjects) {
+      compute_local_split (op, interactions, result);
+    } else {
+      op->compute_local (mp_subject_layout, interactions, result, m_max_vertex_count, m_area_ratio);
+    }
+
+  }
+}
+
+template <class TS, class TI, class TR>
+void
+local_processor<TS, TI, TR>::compute_local_split (const local_operation<TS, TI, TR> *op, const shape_interactions<TS, TI> &interactions, std::unordered_set<TR> &result) const
+{
+  //  sort the subjects for a deterministic distribution over the chunks
+  std::vector<unsigned int> subjects;
+  subjects.reserve (interactions.size ());
+  for (typename shape_interactions<TS, TI>::iterator i = interactions.begin (); i != interactions.end (); ++i) {
+    subjects.push_back (i->first);
+  }
+  std::sort (subjects.begin (), subjects.end ());
+
+  size_t nchunks = std::min (size_t (m_nthreads) * 4, subjects.size () / (split_min_subjects / 4));
+  if (nchunks < 2) {
     op->compute_local (mp_subject_layout, interactions, result, m_max_vertex_count, m_area_ratio);
+    return;
+  }
+
+  size_t chunk_size = (subjects.size () + nchunks - 1) / nchunks;
+  nchunks = (subjects.size () + chunk_size - 1) / chunk_size;
+
+  local_computation_split<TS, TI, TR> *split = new local_computation_split<TS, TI, TR> (op, mp_subject_layout, nchunks, m_max_vertex_count, m_area_ratio);
 
+  std::vector<unsigned int>::const_iterator s = subjects.begin ();
+
+  for (size_t n = 0; n < nchunks; ++n) {
+
+    shape_interactions<TS, TI> &chunk = split->chunk (n);
+
+    for (size_t i = 0; i < chunk_size && s != subjects.end (); ++i, ++s) {
+
+      chunk.add_subject (*s, interactions.subject_shape (*s));
+
+      const std::vector<unsigned int> &intruders = interactions.intruders_for (*s);
+      for (std::vector<unsigned int>::const_iterator j = intruders.begin (); j != intruders.end (); ++j) {
+        if (! chunk.has_intruder_shape_id (*j)) {
+          chunk.add_intruder_shape (*j, interactions.intruder_shape (*j));
+        }
+        chunk.add_interaction (*s, *j);
+      }
+
+    }
+
+  }
+
+  //  let idle workers of the running result computation job help with the chunks - the
+  //  calling thread takes chunks too, so it never waits for chunks nobody has started
+
+  if (mp_rc_job) {
+    for (size_t n = 1; n < nchunks; ++n) {
+      local_computation_split_task<TS, TI, TR> *task = new local_computation_split_task<TS, TI, TR> (split);
+      task->set_priority (std::numeric_limits<int>::max ());
+      mp_rc_job->schedule (task);
+    }
   }
+
+  try {
+    split->process ();
+    split->collect (result);
+  } catch (...) {
+    split->release ();
+    throw;
+  }
+
+  split->release ();
 }
 
 template class DB_PUBLIC local_processor<db::PolygonRef, db::PolygonRef, db::PolygonRef>;
@@ -90,6 +90,11 @@ public:
     return m_intruder_shapes.end ();
   }
 
+  size_t size () const
+  {
+    return m_interactions.size ();
+  }
+
   bool has_intruder_shape_id (unsigned int id) const;
   bool has_subject_shape_id (unsigned int id) const;
   void add_intruder_shape (unsigned int id, const TI &shape);
@@ -179,21 +184,77 @@ private:
   tl::Mutex m_lock;
 };
 
+/**
+ *  @brief Provides the clipped representation of intruder shapes for the context signatures
+ *
+ *  The clipped representation is a plain shape (no reference). "clip" delivers the parts of
+ *  the shape inside the given box.
+ */
+template <class TI> struct context_clip_traits;
+
+template <>
+struct DB_PUBLIC context_clip_traits<db::PolygonRef>
+{
+  typedef db::Polygon clipped_type;
+  static void clip (const db::PolygonRef &shape, const db::Box &box, std::vector<clipped_type> &clipped);
+};
+
+template <>
+struct DB_PUBLIC context_clip_traits<db::Edge>
+{
+  typedef db::Edge clipped_type;
+  static void clip (const db::Edge &shape, const db::Box &box, std::vector<clipped_type> &clipped);
+};
+
+template <>
+struct DB_PUBLIC context_clip_traits<db::TextRef>
+{
+  typedef db::Text clipped_type;
+  static void clip (const db::TextRef &shape, const db::Box &box, std::vector<clipped_type> &clipped);
+};
+
 template <class TS, class TI, class TR>
 class DB_PUBLIC local_processor_cell_contexts
 {
 public:
   typedef std::pair<std::set<CellInstArray>, std::set<TI> > context_key_type;
+  typedef std::pair<std::set<CellInstArray>, std::set<typename context_clip_traits<TI>::clipped_type> > context_signature_type;
   typedef std::unordered_map<context_key_type, db::local_processor_cell_context<TS, TI, TR> > context_map_type;
   typedef typename context_map_type::const_iterator iterator;
 
   local_processor_cell_contexts ();
   local_processor_cell_contexts (const db::Cell *intruder_cell);
+  local_processor_cell_contexts (const local_processor_cell_contexts &other);
+
+  local_processor_cell_contexts &operator= (const local_processor_cell_contexts &other);
 
   db::local_processor_cell_context<TS, TI, TR> *find_context (const context_key_type &intruders);
   db::local_processor_cell_context<TS, TI, TR> *create (const context_key_type &intruders);
+
+  /**
+   *  @brief Finds a context by the signature of its intruders
+   *
+   *  The signature is the intruder geometry clipped to the cell's interaction region.
+   *  Contexts with the same signature render the same results if the operation only
+   *  looks at the intruders close to the subjects.
+   */
+  db::local_processor_cell_context<TS, TI, TR> *find_context_by_signature (const context_signature_type &signature);
+
+  /**
+   *  @brief Creates a context and registers it with the given signature
+   */
+  db::local_processor_cell_context<TS, TI, TR> *create (const context_key_type &intruders, const context_signature_type &signature);
   void compute_results (const local_processor_contexts<TS, TI, TR> &contexts, db::Cell *cell, const local_operation<TS, TI, TR> *op, unsigned int output_layer, const local_processor<TS, TI, TR> *proc);
 
+  /**
+   *  @brief Estimates the effort of computing the results for the given cell
+   *
+   *  The estimate is based on the number of subject shapes, the intruders of each
+   *  context and the number of child instances. It's a relative measure used for
+   *  scheduling.
+   */
+  size_t estimated_cost (const db::Cell *cell, unsigned int subject_layer) const;
+
   size_t size () const
   {
     return m_contexts.size ();
@@ -212,6 +273,7 @@ public:
 private:
   const db::Cell *mp_intruder_cell;
   std::unordered_map<context_key_type, db::local_processor_cell_context<TS, TI, TR> > m_contexts;
+  std::unordered_map<context_signature_type, typename context_map_type::value_type *> m_signatures;
 };
 
 template <class TS, class TI, class TR>
@@ -222,13 +284,13 @@ public:
   typedef typename contexts_per_cell_type::iterator iterator;
 
   local_processor_contexts ()
-    : m_subject_layer (0), m_intruder_layer (0)
+    : m_subject_layer (0), m_intruder_layer (0), m_clip_intruders (false)
   {
     //  .. nothing yet ..
   }
 
   local_processor_contexts (const local_processor_contexts &other)
-    : m_contexts_per_cell (other.m_contexts_per_cell), m_subject_layer (other.m_subject_layer), m_intruder_layer (other.m_intruder_layer)
+    : m_contexts_per_cell (other.m_contexts_per_cell), m_subject_layer (other.m_subject_layer), m_intruder_layer (other.m_intruder_layer), m_clip_intruders (other.m_clip_intruders)
   {
     //  .. nothing yet ..
   }
@@ -282,6 +344,23 @@ public:
     return m_intruder_layer;
   }
 
+  /**
+   *  @brief Enables clustering of contexts by their clipped intruders
+   *
+   *  If set, contexts whose intruders are identical within the subject cell's interaction
+   *  region are combined. This is only valid for operations which don't look at the
+   *  intruders beyond the subjects' neighborhood.
+   */
+  void set_clip_intruders (bool f)
+  {
+    m_clip_intruders = f;
+  }
+
+  bool clip_intruders () const
+  {
+    return m_clip_intruders;
+  }
+
   tl::Mutex &lock () const
   {
     return m_lock;
@@ -290,6 +369,7 @@ public:
 private:
   contexts_per_cell_type m_contexts_per_cell;
   unsigned int m_subject_layer, m_intruder_layer;
+  bool m_clip_intruders;
   mutable tl::Mutex m_lock;
 };
 
@@ -358,10 +438,7 @@ public:
     //  .. nothing yet ..
   }
 
-  void perform_task (tl::Task *task)
-  {
-    static_cast<local_processor_result_computation_task<TS, TI, TR> *> (task)->perform ();
-  }
+  void perform_task (tl::Task *task);
 };
 
 template <class TS, class TI, class TR>
@@ -399,6 +476,16 @@ public:
     return m_nthreads;
   }
 
+  void set_thread_affinity (const std::vector<int> &cpus)
+  {
+    m_thread_affinity = cpus;
+  }
+
+  const std::vector<int> &thread_affinity () const
+  {
+    return m_thread_affinity;
+  }
+
   void set_max_vertex_count (size_t max_vertex_count)
   {
     m_max_vertex_count = max_vertex_count;
@@ -431,12 +518,14 @@ private:
   const std::set<db::cell_index_type> *mp_intruder_breakout_cells;
   std::string m_description;
   unsigned int m_nthreads;
+  std::vector<int> m_thread_affinity;
   size_t m_max_vertex_count;
   double m_area_ratio;
   int m_base_verbosity;
   mutable std::auto_ptr<tl::Job<local_processor_context_computation_worker<TS, TI, TR> > > mp_cc_job;
   mutable size_t m_progress;
   mutable tl::Progress *mp_progress;
+  mutable tl::JobBase *mp_rc_job;
 
   std::string description (const local_operation<TS, TI, TR> *op) const;
   void next () const;
@@ -446,6 +535,7 @@ private:
   void issue_compute_contexts (db::local_processor_contexts<TS, TI, TR> &contexts, db::local_processor_cell_context<TS, TI, TR> *parent_context, db::Cell *subject_parent, db::Cell *subject_cell, const db::ICplxTrans &subject_cell_inst, const db::Cell *intruder_cell, typename local_processor_cell_contexts<TS, TI, TR>::context_key_type &intruders, db::Coord dist) const;
   void push_results (db::Cell *cell, unsigned int output_layer, const std::unordered_set<TR> &result) const;
   void compute_local_cell (const db::local_processor_contexts<TS, TI, TR> &contexts, db::Cell *subject_cell, const db::Cell *intruder_cell, const local_operation<TS, TI, TR> *op, const typename local_processor_cell_contexts<TS, TI, TR>::context_key_type &intruders, std::unordered_set<TR> &result) const;
+  void compute_local_split (const local_operation<TS, TI, TR> *op, const shape_interactions<TS, TI> &interactions, std::unordered_set<TR> &result) const;
   std::pair<bool, db::CellInstArray> effective_instance (local_processor_contexts<TS, TI, TR> &contexts, db::cell_index_type subject_cell_index, db::cell_index_type intruder_cell_index, const db::ICplxTrans &ti2s, db::Coord dist) const;
 
   bool subject_cell_is_breakout (db::cell_index_type ci) const
@@ -43,6 +43,7 @@
 #include "tlInternational.h"
 #include "tlProgress.h"
 #include "tlAssert.h"
+#include "tlThreadedWorkers.h"
 
 
 namespace db
@@ -1353,6 +1354,37 @@ Layout::end_top_cells () const
   return m_top_down_list.begin () + m_top_cells;
 }
 
+void
+Layout::start_concurrent_fill ()
+{
+  if (is_concurrent_fill ()) {
+    throw tl::Exception (tl::to_string (tr ("The layout is already in concurrent fill mode")));
+  }
+  if (manager () && manager ()->transacting ()) {
+    throw tl::Exception (tl::to_string (tr ("Concurrent fill mode cannot be entered while a transaction is open")));
+  }
+
+  start_changes ();
+  set_concurrent (true);
+
+  m_shape_repository.set_lock (&m_fill_lock);
+  m_array_repository.set_lock (&m_fill_lock);
+}
+
+void
+Layout::end_concurrent_fill ()
+{
+  if (! is_concurrent_fill ()) {
+    return;
+  }
+
+  m_shape_repository.set_lock (0);
+  m_array_repository.set_lock (0);
+
+  set_concurrent (false);
+  end_changes ();
+}
+
 void 
 Layout::force_update () 
 {
@@ -1399,6 +1431,96 @@ Layout::update () const
   }
 }
 
+namespace
+{
+
+/**
+ *  @brief A task sorting one shapes container
+ */
+class ShapesSortTask
+  : public tl::Task
+{
+public:
+  ShapesSortTask (db::Shapes *shapes)
+    : mp_shapes (shapes)
+  {
+    //  .. nothing yet ..
+  }
+
+  void perform ()
+  {
+    mp_shapes->sort ();
+  }
+
+private:
+  db::Shapes *mp_shapes;
+};
+
+/**
+ *  @brief The worker for the shapes sort tasks
+ */
+class ShapesSortWorker
+  : public tl::Worker
+{
+public:
+  ShapesSortWorker ()
+    : tl::Worker ()
+  {
+    //  .. nothing yet ..
+  }
+
+  void perform_task (tl::Task *task)
+  {
+    static_cast<ShapesSortTask *> (task)->perform ();
+  }
+};
+
+/**
+ *  @brief Sorts the shapes of all cells using the given number of threads
+ */
+static void
+sort_shapes_parallel (db::Layout &layout, tl::RelativeProgress &progress, unsigned int nthreads)
+{
+  std::vector<db::Shapes *> shapes;
+  for (db::Layout::bottom_up_iterator c = layout.begin_bottom_up (); c != layout.end_bottom_up (); ++c) {
+    layout.cell (*c).collect_shapes (shapes);
+  }
+
+  progress.set (0);
+
+  //  Small containers are sorted concurrently. Large ones are taken one by one -
+  //  their box trees are sorted by multiple threads themselves.
+  tl::Job<ShapesSortWorker> job ((int) nthreads);
+  size_t ntasks = 0;
+
+  for (std::vector<db::Shapes *>::const_iterator s = shapes.begin (); s != shapes.end (); ++s) {
+    if ((*s)->size () < db::box_tree_parallel_sort_min) {
+      job.schedule (new ShapesSortTask (*s));
+      ++ntasks;
+    }
+  }
+
+  if (ntasks > 0) {
+    job.start ();
+  }
+
+  for (std::vector<db::Shapes *>::const_iterator s = shapes.begin (); s != shapes.end (); ++s) {
+    if ((*s)->size () >= db::box_tree_parallel_sort_min) {
+      ++progress;
+      (*s)->sort ();
+    }
+  }
+
+  if (ntasks > 0) {
+    job.wait ();
+    if (job.has_error ()) {
+      throw tl::Exception (job.error_messages ().front ());
+    }
+  }
+}
+
+}
+
 void 
 Layout::do_update ()
 {
@@ -1465,10 +1587,15 @@ Layout::do_update ()
         tl::SelfTimer timer (tl::verbosity () > layout_base_verbosity + 10, "Sorting shapes");
         pr->set (0);
         pr->set_desc (tl::to_string (tr ("Sorting shapes")));
-        for (bottom_up_iterator c = begin_bottom_up (); c != end_bottom_up (); ++c) {
-          ++*pr;
-          cell_type &cp (cell (*c));
-          cp.sort_shapes ();
+        unsigned int nthreads = db::sort_threads ();
+        if (nthreads > 1) {
+          sort_shapes_parallel (*this, *pr, nthreads);
+        } else {
+          for (bottom_up_iterator c = begin_bottom_up (); c != end_bottom_up (); ++c) {
+            ++*pr;
+            cell_type &cp (cell (*c));
+            cp.sort_shapes ();
+          }
         }
       }
     }
@@ -1669,6 +1669,42 @@ public:
     return m_invalid > 0;
   }
 
+  /**
+   *  @brief Enters concurrent fill mode
+   *
+   *  In concurrent fill mode, distinct cells can be filled with shapes and
+   *  instances from different threads. Shape references and arrays may be
+   *  created using the layout's shape and array repositories from these
+   *  threads too. While in this mode, the hierarchy and bounding box
+   *  invalidation is suspended and the layout is "under construction".
+   *
+   *  The following rules apply:
+   *  - Cells, layers and property IDs need to be created before entering the mode
+   *  - Each cell must be modified by a single thread only
+   *  - Cells must not be deleted and the layout must not be read otherwise
+   *  - Undo is not available: concurrent fill mode cannot be entered
+   *    while a transaction is open and none must be opened while in this mode
+   *
+   *  The mode is left with "end_concurrent_fill" which updates the layout once.
+   */
+  void start_concurrent_fill ();
+
+  /**
+   *  @brief Leaves concurrent fill mode (see "start_concurrent_fill")
+   *
+   *  This method must be called after all threads filling cells have
+   *  finished. It will update the layout unless "start_changes" is in effect.
+   */
+  void end_concurrent_fill ();
+
+  /**
+   *  @brief Gets a flag indicating whether the layout is in concurrent fill mode
+   */
+  bool is_concurrent_fill () const
+  {
+    return concurrent ();
+  }
+
   /**
    *  @brief Register a library proxy
    *
@@ -1780,6 +1816,7 @@ private:
   bool m_editable;
   meta_info m_meta_info;
   tl::Mutex m_lock;
+  tl::Mutex m_fill_lock;
 
   /**
    *  @brief Sort the cells topologically
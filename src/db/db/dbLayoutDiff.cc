@@ -26,6 +26,7 @@
 #include "dbCellMapping.h"
 #include "dbFuzzyCellMapping.h"
 #include "dbLayoutUtils.h"
+#include "dbRegion.h"
 #include "tlLog.h"
 #include "tlExceptions.h"
 
@@ -1584,5 +1585,203 @@ compare_layouts (const db::Layout &a, db::cell_index_type top_a, const db::Layou
   return compare_layouts (a, top_a, b, top_b, flags, tolerance, r);
 }
 
+// -------------------------------------------------------------------------------
+//  Implementation of the difference region
+
+/**
+ *  @brief A difference receiver collecting the bounding boxes of the differences per cell of layout b
+ */
+class DifferenceRegionReceiver
+  : public DifferenceReceiver
+{
+public:
+  DifferenceRegionReceiver ()
+    : m_cell_b (0), m_dbu_differs (false)
+  {
+    //  .. nothing yet ..
+  }
+
+  bool dbu_differs () const
+  {
+    return m_dbu_differs;
+  }
+
+  std::map<db::cell_index_type, std::vector<db::Box> > &boxes ()
+  {
+    return m_boxes;
+  }
+
+  virtual void dbu_differs (double, double)
+  {
+    m_dbu_differs = true;
+  }
+
+  virtual void begin_cell (const std::string &, db::cell_index_type, db::cell_index_type cib)
+  {
+    m_cell_b = cib;
+  }
+
+  virtual void instances_in_a_only (const std::vector <db::CellInstArrayWithProperties> &anotb, const db::Layout &a)
+  {
+    add_instances (anotb, a);
+  }
+
+  virtual void instances_in_b_only (const std::vector <db::CellInstArrayWithProperties> &bnota, const db::Layout &b)
+  {
+    add_instances (bnota, b);
+  }
+
+  virtual void detailed_diff (const db::PropertiesRepository &, const std::vector <std::pair <db::Polygon, db::properties_id_type> > &a, const std::vector <std::pair <db::Polygon, db::properties_id_type> > &b)
+  {
+    add_shapes (a);
+    add_shapes (b);
+  }
+
+  virtual void detailed_diff (const db::PropertiesRepository &, const std::vector <std::pair <db::Path, db::properties_id_type> > &a, const std::vector <std::pair <db::Path, db::properties_id_type> > &b)
+  {
+    add_shapes (a);
+    add_shapes (b);
+  }
+
+  virtual void detailed_diff (const db::PropertiesRepository &, const std::vector <std::pair <db::Box, db::properties_id_type> > &a, const std::vector <std::pair <db::Box, db::properties_id_type> > &b)
+  {
+    add_shapes (a);
+    add_shapes (b);
+  }
+
+  virtual void detailed_diff (const db::PropertiesRepository &, const std::vector <std::pair <db::Edge, db::properties_id_type> > &a, const std::vector <std::pair <db::Edge, db::properties_id_type> > &b)
+  {
+    add_shapes (a);
+    add_shapes (b);
+  }
+
+  virtual void detailed_diff (const db::PropertiesRepository &, const std::vector <std::pair <db::Text, db::properties_id_type> > &a, const std::vector <std::pair <db::Text, db::properties_id_type> > &b)
+  {
+    add_shapes (a);
+    add_shapes (b);
+  }
+
+private:
+  db::cell_index_type m_cell_b;
+  bool m_dbu_differs;
+  std::map<db::cell_index_type, std::vector<db::Box> > m_boxes;
+
+  void add_instances (const std::vector <db::CellInstArrayWithProperties> &insts, const db::Layout &layout)
+  {
+    db::box_convert<db::CellInst> bc (layout);
+    std::vector<db::Box> &boxes = m_boxes [m_cell_b];
+    for (std::vector <db::CellInstArrayWithProperties>::const_iterator i = insts.begin (); i != insts.end (); ++i) {
+      db::Box box = i->bbox (bc);
+      if (! box.empty ()) {
+        boxes.push_back (box.enlarged (db::Vector (1, 1)));
+      }
+    }
+  }
+
+  template <class Sh>
+  void add_shapes (const std::vector <std::pair <Sh, db::properties_id_type> > &shapes)
+  {
+    db::box_convert<Sh> bc;
+    std::vector<db::Box> &boxes = m_boxes [m_cell_b];
+    for (typename std::vector <std::pair <Sh, db::properties_id_type> >::const_iterator s = shapes.begin (); s != shapes.end (); ++s) {
+      //  NOTE: enlarging makes texts and edges visible as areas
+      boxes.push_back (bc (s->first).enlarged (db::Vector (1, 1)));
+    }
+  }
+};
+
+/**
+ *  @brief A box converter delivering the same box for every cell instance
+ */
+struct fixed_box_convert
+{
+  fixed_box_convert (const db::Box &box)
+    : m_box (box)
+  {
+    //  .. nothing yet ..
+  }
+
+  db::Box operator() (const db::CellInst &) const
+  {
+    return m_box;
+  }
+
+private:
+  db::Box m_box;
+};
+
+/**
+ *  @brief Arrays with more members are represented by their bounding box in difference_region
+ */
+const size_t max_expanded_array_size = 16;
+
+db::Region
+difference_region (const db::Layout &a, db::cell_index_type top_a, const db::Layout &b, db::cell_index_type top_b, unsigned int flags, db::Coord tolerance)
+{
+  DifferenceRegionReceiver r;
+
+  //  we need the details, but want to see all differences. Layers present in one layout
+  //  only must not be summarized, so their shapes are reported as differences too.
+  flags |= layout_diff::f_verbose | layout_diff::f_dont_summarize_missing_layers;
+  flags &= ~layout_diff::f_silent;
+
+  if (compare_layouts (a, top_a, b, top_b, flags, tolerance, r)) {
+    return db::Region ();
+  }
+
+  if (r.dbu_differs ()) {
+    //  no geometrical comparison possible
+    return db::Region (b.cell (top_b).bbox ());
+  }
+
+  //  propagate the differences up to the top cell (bottom-up, so each cell is complete
+  //  before it is propagated into its parents)
+
+  std::map<db::cell_index_type, db::Region> regions;
+  for (std::map<db::cell_index_type, std::vector<db::Box> >::const_iterator c = r.boxes ().begin (); c != r.boxes ().end (); ++c) {
+    db::Region &region = regions [c->first];
+    for (std::vector<db::Box>::const_iterator bx = c->second.begin (); bx != c->second.end (); ++bx) {
+      region.insert (*bx);
+    }
+  }
+
+  std::set<db::cell_index_type> called;
+  b.cell (top_b).collect_called_cells (called);
+
+  for (db::Layout::bottom_up_const_iterator c = b.begin_bottom_up (); c != b.end_bottom_up (); ++c) {
+
+    if (*c == top_b || called.find (*c) == called.end ()) {
+      continue;
+    }
+
+    std::map<db::cell_index_type, db::Region>::iterator rc = regions.find (*c);
+    if (rc == regions.end ()) {
+      continue;
+    }
+
+    rc->second.merge ();
+
+    const db::Cell &cell = b.cell (*c);
+    for (db::Cell::parent_inst_iterator pi = cell.begin_parent_insts (); ! pi.at_end (); ++pi) {
+      db::Region &parent_region = regions [pi->parent_cell_index ()];
+      const db::CellInstArray &inst = pi->child_inst ().cell_inst ();
+      if (inst.size () > max_expanded_array_size) {
+        //  large arrays are not expanded: the array's bounding box is taken instead
+        parent_region.insert (inst.bbox (fixed_box_convert (rc->second.bbox ())));
+      } else {
+        for (db::CellInstArray::iterator i = inst.begin (); ! i.at_end (); ++i) {
+          parent_region += rc->second.transformed (inst.complex_trans (*i));
+        }
+      }
+    }
+
+    regions.erase (rc);
+
+  }
+
+  db::Region result = regions [top_b];
+  result.merge ();
+  return result;
 }
 
+}
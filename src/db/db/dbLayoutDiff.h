@@ -43,6 +43,7 @@ namespace db
 
 struct LayerProperties;
 class Layout;
+class Region;
 
 namespace layout_diff
 {
@@ -192,6 +193,19 @@ bool DB_PUBLIC compare_layouts (const db::Layout &a, const db::Layout &b, unsign
  */
 bool DB_PUBLIC compare_layouts (const db::Layout &a, db::cell_index_type top_a, const db::Layout &b, db::cell_index_type top_b, unsigned int flags, db::Coord tolerance, DifferenceReceiver &r);
 
+/**
+ *  @brief Computes the region where two layouts differ
+ *
+ *  The region is given in the coordinate system of top_b. It is made from the bounding boxes
+ *  of all shapes and instances which are present in only one of the layouts. These boxes are
+ *  propagated through the hierarchy of b, so every placement of a modified cell contributes.
+ *  Large arrays contribute their total bounding box. Shapes on layers present in only one
+ *  of the layouts count as differences. Cells are identified by name. If the database units differ, the whole bounding box of
+ *  top_b is returned. The region is empty if the layouts are identical.
+ *  The flags are the same as for compare_layouts.
+ */
+db::Region DB_PUBLIC difference_region (const db::Layout &a, db::cell_index_type top_a, const db::Layout &b, db::cell_index_type top_b, unsigned int flags, db::Coord tolerance);
+
 }
 
 #endif
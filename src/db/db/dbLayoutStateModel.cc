@@ -29,13 +29,13 @@ namespace db
 {
 
 LayoutStateModel::LayoutStateModel (bool busy)
-  : m_hier_dirty (false), m_all_bboxes_dirty (false), m_busy (busy)
+  : m_hier_dirty (false), m_all_bboxes_dirty (false), m_busy (busy), m_concurrent (false)
 {
   //  .. nothing yet ..
 }
 
 LayoutStateModel::LayoutStateModel (const LayoutStateModel &d)
-  : m_hier_dirty (d.m_hier_dirty), m_bboxes_dirty (d.m_bboxes_dirty), m_all_bboxes_dirty (d.m_all_bboxes_dirty), m_busy (d.m_busy)
+  : m_hier_dirty (d.m_hier_dirty), m_bboxes_dirty (d.m_bboxes_dirty), m_all_bboxes_dirty (d.m_all_bboxes_dirty), m_busy (d.m_busy), m_concurrent (false)
 {
   //  .. nothing yet ..
 }
@@ -71,6 +71,10 @@ LayoutStateModel::do_invalidate_bboxes (unsigned int index)
 void
 LayoutStateModel::invalidate_bboxes (unsigned int index)
 {
+  if (m_concurrent) {
+    return;
+  }
+
   if (index == std::numeric_limits<unsigned int>::max ()) {
     if (! m_all_bboxes_dirty || m_busy) {
       do_invalidate_bboxes (index);  //  must be called before the bboxes are invalidated (stopping of redraw thread requires this)
@@ -87,6 +91,16 @@ LayoutStateModel::invalidate_bboxes (unsigned int index)
   }
 }
 
+void
+LayoutStateModel::set_concurrent (bool c)
+{
+  if (c && ! m_concurrent) {
+    invalidate_hier ();
+    invalidate_bboxes (std::numeric_limits<unsigned int>::max ());
+  }
+  m_concurrent = c;
+}
+
 bool
 LayoutStateModel::bboxes_dirty () const
 {
@@ -85,6 +85,9 @@ public:
    */
   void invalidate_hier ()
   {
+    if (m_concurrent) {
+      return;
+    }
     if (! m_hier_dirty || m_busy) {
       do_invalidate_hier ();  //  must be called before the hierarchy is invalidated (stopping of redraw thread requires this)
       m_hier_dirty = true;
@@ -152,6 +155,24 @@ public:
     return m_busy;
   }
 
+  /**
+   *  @brief Sets or resets concurrent mode
+   *
+   *  When concurrent mode is entered, the hierarchy and all bounding boxes
+   *  are invalidated once. While in concurrent mode, "invalidate_hier" and
+   *  "invalidate_bboxes" do nothing and hence can be called from multiple
+   *  threads. No events are issued in this mode, even in busy mode.
+   */
+  void set_concurrent (bool c);
+
+  /**
+   *  @brief Gets a flag indicating concurrent mode
+   */
+  bool concurrent () const
+  {
+    return m_concurrent;
+  }
+
 protected:
   friend class PropertiesRepository;
 
@@ -198,6 +219,7 @@ private:
   std::vector<bool> m_bboxes_dirty;
   bool m_all_bboxes_dirty;
   bool m_busy;
+  bool m_concurrent;
 
   void do_invalidate_hier ();
   void do_invalidate_bboxes (unsigned int index);
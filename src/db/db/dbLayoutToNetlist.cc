@@ -40,7 +40,7 @@ namespace db
 //  the iterator provides the hierarchical selection (enabling/disabling cells etc.)
 
 LayoutToNetlist::LayoutToNetlist (const db::RecursiveShapeIterator &iter)
-  : m_iter (iter), m_layout_index (0), m_netlist_extracted (false), m_is_flat (false), m_device_scaling (1.0)
+  : m_iter (iter), m_layout_index (0), m_netlist_extracted (false), m_is_flat (false), m_shape_repository_locked (false), m_device_scaling (1.0)
 {
   //  check the iterator
   if (iter.has_complex_region () || iter.region () != db::Box::world ()) {
@@ -60,7 +60,7 @@ LayoutToNetlist::LayoutToNetlist (const db::RecursiveShapeIterator &iter)
 }
 
 LayoutToNetlist::LayoutToNetlist (db::DeepShapeStore *dss, unsigned int layout_index)
-  : mp_dss (dss), m_layout_index (layout_index), m_netlist_extracted (false), m_is_flat (false), m_device_scaling (1.0)
+  : mp_dss (dss), m_layout_index (layout_index), m_netlist_extracted (false), m_is_flat (false), m_shape_repository_locked (false), m_device_scaling (1.0)
 {
   if (dss->is_valid_layout_index (m_layout_index)) {
     m_iter = db::RecursiveShapeIterator (dss->layout (m_layout_index), dss->initial_cell (m_layout_index), std::set<unsigned int> ());
@@ -68,7 +68,7 @@ LayoutToNetlist::LayoutToNetlist (db::DeepShapeStore *dss, unsigned int layout_i
 }
 
 LayoutToNetlist::LayoutToNetlist (const std::string &topcell_name, double dbu)
-  : m_iter (), m_netlist_extracted (false), m_is_flat (true), m_device_scaling (1.0)
+  : m_iter (), m_netlist_extracted (false), m_is_flat (true), m_shape_repository_locked (false), m_device_scaling (1.0)
 {
   mp_internal_dss.reset (new db::DeepShapeStore (topcell_name, dbu));
   mp_dss.reset (mp_internal_dss.get ());
@@ -79,13 +79,17 @@ LayoutToNetlist::LayoutToNetlist (const std::string &topcell_name, double dbu)
 
 LayoutToNetlist::LayoutToNetlist ()
   : m_iter (), mp_internal_dss (new db::DeepShapeStore ()), mp_dss (mp_internal_dss.get ()), m_layout_index (0),
-    m_netlist_extracted (false), m_is_flat (false), m_device_scaling (1.0)
+    m_netlist_extracted (false), m_is_flat (false), m_shape_repository_locked (false), m_device_scaling (1.0)
 {
   init ();
 }
 
 LayoutToNetlist::~LayoutToNetlist ()
 {
+  if (m_shape_repository_locked && mp_dss.get ()) {
+    mp_dss->unlock_shape_repository (m_layout_index);
+  }
+
   //  NOTE: do this in this order because of unregistration of the layers
   m_named_regions.clear ();
   m_dlrefs.clear ();
@@ -102,6 +106,16 @@ void LayoutToNetlist::keep_dss ()
   }
 }
 
+void LayoutToNetlist::lock_shape_repository ()
+{
+  //  the net clusters keep references to the polygons and texts of the working layout,
+  //  so these must not be released when the store spills layers
+  if (! m_shape_repository_locked && mp_dss.get () && mp_dss->is_valid_layout_index (m_layout_index)) {
+    mp_dss->lock_shape_repository (m_layout_index);
+    m_shape_repository_locked = true;
+  }
+}
+
 void LayoutToNetlist::init ()
 {
   dss ().set_text_enlargement (1);
@@ -243,6 +257,7 @@ void LayoutToNetlist::extract_devices (db::NetlistDeviceExtractor &extractor, co
     throw tl::Exception (tl::to_string (tr ("The netlist has already been extracted")));
   }
   ensure_netlist ();
+  lock_shape_repository ();
   extractor.extract (dss (), m_layout_index, layers, *mp_netlist, m_net_clusters, m_device_scaling);
 }
 
@@ -341,6 +356,7 @@ void LayoutToNetlist::extract_netlist (const std::string &joined_net_names, cons
   }
 
   netex.set_include_floating_subcircuits (include_floating_subcircuits);
+  lock_shape_repository ();
   netex.extract_nets (dss (), m_layout_index, m_conn, *mp_netlist, m_net_clusters);
 
   m_netlist_extracted = true;
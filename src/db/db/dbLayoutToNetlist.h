@@ -188,6 +188,11 @@ public:
 
   /**
    *  @brief Sets the number of threads to use for operations which support multiple threads
+   *
+   *  Among others, this applies to the hierarchical boolean operations, the
+   *  thread-safe device extractors and the computation of the local shape
+   *  clusters in the net extraction. The hierarchical stage of the net
+   *  extraction is single-threaded.
    */
   void set_threads (int n);
 
@@ -573,6 +578,8 @@ public:
    */
   db::hier_clusters<db::NetShape> &net_clusters ()
   {
+    //  the clusters are going to refer to the shapes of the working layout
+    lock_shape_repository ();
     return m_net_clusters;
   }
 
@@ -827,6 +834,7 @@ private:
   std::map<unsigned int, std::string> m_name_of_layer;
   bool m_netlist_extracted;
   bool m_is_flat;
+  bool m_shape_repository_locked;
   double m_device_scaling;
   db::DeepLayer m_dummy_layer;
   std::string m_generator;
@@ -862,6 +870,7 @@ private:
 
   void init ();
   void ensure_netlist ();
+  void lock_shape_repository ();
   size_t search_net (const db::ICplxTrans &trans, const db::Cell *cell, const db::local_cluster<NetShape> &test_cluster, std::vector<db::InstElement> &rev_inst_path);
   void build_net_rec (const db::Net &net, db::Layout &target, cell_index_type circuit_cell, const db::CellMapping &cmap, const std::map<unsigned int, const db::Region *> &lmap, const char *net_cell_name_prefix, db::properties_id_type netname_propid, BuildNetHierarchyMode hier_mode, const char *cell_name_prefix, const char *device_cell_name_prefix, cell_reuse_table_type &reuse_table, const ICplxTrans &tr) const;
   void build_net_rec (const db::Net &net, db::Layout &target, db::Cell &target_cell, const std::map<unsigned int, const db::Region *> &lmap, const char *net_cell_name_prefix, db::properties_id_type netname_propid, BuildNetHierarchyMode hier_mode, const char *cell_name_prefix, const char *device_cell_name_prefix, cell_reuse_table_type &reuse_table, const ICplxTrans &tr) const;
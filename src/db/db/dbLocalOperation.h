@@ -97,6 +97,24 @@ public:
    */
   virtual on_empty_intruder_mode on_empty_intruder_hint () const { return Ignore; }
 
+  /**
+   *  @brief Indicates that the operation can be computed for each subject separately
+   *
+   *  If this method returns true, the processor may split the subjects of a cell into
+   *  several groups and compute them in parallel. The result needs to be the same as if all
+   *  subjects were computed together.
+   */
+  virtual bool requests_single_subjects () const { return false; }
+
+  /**
+   *  @brief Indicates that the result only depends on the intruders close to the subjects
+   *
+   *  If this method returns true, the processor may combine contexts whose intruders are
+   *  identical within the subject cell's bounding box (enlarged by the interaction distance).
+   *  This reduces the number of contexts on regular structures.
+   */
+  virtual bool allows_clipped_intruders () const { return false; }
+
   /**
    *  @brief Gets a description text for this operation
    */
@@ -120,6 +138,7 @@ public:
 
   virtual void compute_local (db::Layout *layout, const shape_interactions<db::PolygonRef, db::PolygonRef> &interactions, std::unordered_set<db::PolygonRef> &result, size_t max_vertex_count, double area_ratio) const;
   virtual on_empty_intruder_mode on_empty_intruder_hint () const;
+  virtual bool allows_clipped_intruders () const { return true; }
   virtual std::string description () const;
 
 private:
@@ -156,6 +175,7 @@ public:
 
   virtual void compute_local (db::Layout *layout, const shape_interactions<db::Edge, db::Edge> &interactions, std::unordered_set<db::Edge> &result, size_t max_vertex_count, double area_ratio) const;
   virtual on_empty_intruder_mode on_empty_intruder_hint () const;
+  virtual bool allows_clipped_intruders () const { return true; }
   virtual std::string description () const;
 
   //  edge interaction distance is 1 to force overlap between edges and edge/boxes
@@ -179,6 +199,7 @@ public:
 
   virtual void compute_local (db::Layout *layout, const shape_interactions<db::Edge, db::PolygonRef> &interactions, std::unordered_set<db::Edge> &result, size_t max_vertex_count, double area_ratio) const;
   virtual on_empty_intruder_mode on_empty_intruder_hint () const;
+  virtual bool allows_clipped_intruders () const { return true; }
   virtual std::string description () const;
 
   //  edge interaction distance is 1 to force overlap between edges and edge/boxes
@@ -29,6 +29,7 @@
 #include "tlLog.h"
 #include "tlEnv.h"
 #include "tlInternational.h"
+#include "tlThreadedWorkers.h"
 
 #include <cstring>
 
@@ -2797,6 +2798,230 @@ NetGraph::derive_node_identities_from_node_set (std::vector<std::pair<const NetG
 }
 
 
+// --------------------------------------------------------------------------------------------------------------------
+//  A logger buffering the compare events of one circuit
+
+/**
+ *  @brief A logger recording the compare events
+ *
+ *  In multi-threaded mode, each circuit pair is compared with a logger of this kind.
+ *  The events are replayed into the actual logger in the order of the single-threaded
+ *  compare later.
+ */
+class BufferedNetlistCompareLogger
+  : public NetlistCompareLogger
+{
+public:
+  BufferedNetlistCompareLogger ()
+    : NetlistCompareLogger ()
+  {
+    //  .. nothing yet ..
+  }
+
+  BufferedNetlistCompareLogger (const BufferedNetlistCompareLogger &other)
+    : NetlistCompareLogger (), m_events (other.m_events)
+  {
+    //  .. nothing yet ..
+  }
+
+  virtual void match_nets (const db::Net *a, const db::Net *b) { record (MatchNets, a, b); }
+  virtual void match_ambiguous_nets (const db::Net *a, const db::Net *b) { record (MatchAmbiguousNets, a, b); }
+  virtual void net_mismatch (const db::Net *a, const db::Net *b) { record (NetMismatch, a, b); }
+  virtual void match_devices (const db::Device *a, const db::Device *b) { record (MatchDevices, a, b); }
+  virtual void match_devices_with_different_parameters (const db::Device *a, const db::Device *b) { record (MatchDevicesWithDifferentParameters, a, b); }
+  virtual void match_devices_with_different_device_classes (const db::Device *a, const db::Device *b) { record (MatchDevicesWithDifferentDeviceClasses, a, b); }
+  virtual void device_mismatch (const db::Device *a, const db::Device *b) { record (DeviceMismatch, a, b); }
+  virtual void match_pins (const db::Pin *a, const db::Pin *b) { record (MatchPins, a, b); }
+  virtual void pin_mismatch (const db::Pin *a, const db::Pin *b) { record (PinMismatch, a, b); }
+  virtual void match_subcircuits (const db::SubCircuit *a, const db::SubCircuit *b) { record (MatchSubCircuits, a, b); }
+  virtual void subcircuit_mismatch (const db::SubCircuit *a, const db::SubCircuit *b) { record (SubCircuitMismatch, a, b); }
+
+  /**
+   *  @brief Sends the recorded events to the given logger
+   */
+  void replay (NetlistCompareLogger *logger) const
+  {
+    for (std::vector<Event>::const_iterator e = m_events.begin (); e != m_events.end (); ++e) {
+      switch (e->type) {
+      case MatchNets:
+        logger->match_nets ((const db::Net *) e->a, (const db::Net *) e->b);
+        break;
+      case MatchAmbiguousNets:
+        logger->match_ambiguous_nets ((const db::Net *) e->a, (const db::Net *) e->b);
+        break;
+      case NetMismatch:
+        logger->net_mismatch ((const db::Net *) e->a, (const db::Net *) e->b);
+        break;
+      case MatchDevices:
+        logger->match_devices ((const db::Device *) e->a, (const db::Device *) e->b);
+        break;
+      case MatchDevicesWithDifferentParameters:
+        logger->match_devices_with_different_parameters ((const db::Device *) e->a, (const db::Device *) e->b);
+        break;
+      case MatchDevicesWithDifferentDeviceClasses:
+        logger->match_devices_with_different_device_classes ((const db::Device *) e->a, (const db::Device *) e->b);
+        break;
+      case DeviceMismatch:
+        logger->device_mismatch ((const db::Device *) e->a, (const db::Device *) e->b);
+        break;
+      case MatchPins:
+        logger->match_pins ((const db::Pin *) e->a, (const db::Pin *) e->b);
+        break;
+      case PinMismatch:
+        logger->pin_mismatch ((const db::Pin *) e->a, (const db::Pin *) e->b);
+        break;
+      case MatchSubCircuits:
+        logger->match_subcircuits ((const db::SubCircuit *) e->a, (const db::SubCircuit *) e->b);
+        break;
+      case SubCircuitMismatch:
+        logger->subcircuit_mismatch ((const db::SubCircuit *) e->a, (const db::SubCircuit *) e->b);
+        break;
+      }
+    }
+  }
+
+private:
+  enum EventType {
+    MatchNets, MatchAmbiguousNets, NetMismatch,
+    MatchDevices, MatchDevicesWithDifferentParameters, MatchDevicesWithDifferentDeviceClasses, DeviceMismatch,
+    MatchPins, PinMismatch,
+    MatchSubCircuits, SubCircuitMismatch
+  };
+
+  struct Event
+  {
+    Event (EventType _type, const void *_a, const void *_b)
+      : type (_type), a (_a), b (_b)
+    { }
+
+    EventType type;
+    const void *a, *b;
+  };
+
+  std::vector<Event> m_events;
+
+  void record (EventType type, const void *a, const void *b)
+  {
+    m_events.push_back (Event (type, a, b));
+  }
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+//  Multi-threaded circuit compare
+
+/**
+ *  @brief Describes one circuit pair to compare
+ */
+struct CircuitCompareItem
+{
+  CircuitCompareItem (const db::Circuit *_ca, const db::Circuit *_cb, const std::vector<std::pair<const Net *, const Net *> > *_net_identity)
+    : ca (_ca), cb (_cb), net_identity (_net_identity), skipped (false), good (false), pin_mismatch (false)
+  {
+    //  .. nothing yet ..
+  }
+
+  const db::Circuit *ca, *cb;
+  const std::vector<std::pair<const Net *, const Net *> > *net_identity;
+  bool skipped;
+  bool good;
+  bool pin_mismatch;
+  BufferedNetlistCompareLogger logger;
+};
+
+/**
+ *  @brief The data shared by the circuit compare tasks
+ *
+ *  All categorizers are fully populated before the tasks are run, so the
+ *  tasks only read from them.
+ */
+struct CircuitCompareContext
+{
+  const NetlistComparer *comparer;
+  db::DeviceCategorizer *device_categorizer;
+  db::CircuitCategorizer *circuit_categorizer;
+  db::CircuitPinMapper *circuit_pin_mapper;
+  std::map<const db::Circuit *, CircuitMapper> *c12_pin_mapping, *c22_pin_mapping;
+  bool with_log;
+};
+
+/**
+ *  @brief A task comparing one circuit pair
+ */
+class CircuitCompareTask
+  : public tl::Task
+{
+public:
+  CircuitCompareTask (const CircuitCompareContext *context, CircuitCompareItem *item)
+    : mp_context (context), mp_item (item)
+  {
+    //  .. nothing yet ..
+  }
+
+  const CircuitCompareContext *context () const
+  {
+    return mp_context;
+  }
+
+  CircuitCompareItem *item () const
+  {
+    return mp_item;
+  }
+
+private:
+  const CircuitCompareContext *mp_context;
+  CircuitCompareItem *mp_item;
+};
+
+/**
+ *  @brief The worker for the circuit compare tasks
+ */
+class CircuitCompareWorker
+  : public tl::Worker
+{
+public:
+  CircuitCompareWorker ()
+    : tl::Worker ()
+  {
+    //  .. nothing yet ..
+  }
+
+  void perform_task (tl::Task *task)
+  {
+    const CircuitCompareContext *cx = static_cast<CircuitCompareTask *> (task)->context ();
+    CircuitCompareItem *item = static_cast<CircuitCompareTask *> (task)->item ();
+    item->good = cx->comparer->compare_circuits (item->ca, item->cb, *cx->device_categorizer, *cx->circuit_categorizer, *cx->circuit_pin_mapper, *item->net_identity, item->pin_mismatch, *cx->c12_pin_mapping, *cx->c22_pin_mapping, cx->with_log ? &item->logger : 0);
+  }
+};
+
+/**
+ *  @brief Returns true, if the circuit has one of the given circuits as a direct child
+ */
+static bool
+has_child_in (const db::Circuit *c, const std::set<const db::Circuit *> &circuits)
+{
+  for (db::Circuit::const_subcircuit_iterator sc = c->begin_subcircuits (); sc != c->end_subcircuits (); ++sc) {
+    if (sc->circuit_ref () && circuits.find (sc->circuit_ref ()) != circuits.end ()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ *  @brief Returns true, if the device compare delegates of the netlist can be used from multiple threads
+ */
+static bool
+device_compare_is_thread_safe (const db::Netlist *nl)
+{
+  for (db::Netlist::const_device_class_iterator dc = nl->begin_device_classes (); dc != nl->end_device_classes (); ++dc) {
+    const db::DeviceParameterCompareDelegate *pcd = dc->parameter_compare_delegate ();
+    if (pcd && ! pcd->is_thread_safe ()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 // --------------------------------------------------------------------------------------------------------------------
 //  NetlistComparer implementation
 
@@ -2815,6 +3040,8 @@ NetlistComparer::NetlistComparer (NetlistCompareLogger *logger)
   m_depth_first = true;
 
   m_dont_consider_net_names = false;
+
+  m_threads = 0;
 }
 
 NetlistComparer::~NetlistComparer ()
@@ -3024,7 +3251,9 @@ NetlistComparer::compare (const db::Netlist *a, const db::Netlist *b) const
 
   std::map<const db::Circuit *, CircuitMapper> c12_pin_mapping, c22_pin_mapping;
 
-  tl::RelativeProgress progress (tl::to_string (tr ("Comparing netlists")), a->circuit_count (), 1);
+  //  collect the circuit pairs to compare in bottom-up order
+
+  std::vector<CircuitCompareItem> items;
 
   for (db::Netlist::const_bottom_up_circuit_iterator c = a->begin_bottom_up (); c != a->end_bottom_up (); ++c) {
 
@@ -3046,50 +3275,142 @@ NetlistComparer::compare (const db::Netlist *a, const db::Netlist *b) const
     tl_assert (i->second.second.size () == size_t (1));
     const db::Circuit *cb = i->second.second.front ();
 
-    std::vector<std::pair<const Net *, const Net *> > empty;
+    static const std::vector<std::pair<const Net *, const Net *> > empty;
     const std::vector<std::pair<const Net *, const Net *> > *net_identity = &empty;
     std::map<std::pair<const db::Circuit *, const db::Circuit *>, std::vector<std::pair<const Net *, const Net *> > >::const_iterator sn = m_same_nets.find (std::make_pair (ca, cb));
     if (sn != m_same_nets.end ()) {
       net_identity = &sn->second;
     }
 
-    if (all_subcircuits_verified (ca, verified_circuits_a) && all_subcircuits_verified (cb, verified_circuits_b)) {
+    items.push_back (CircuitCompareItem (ca, cb, net_identity));
 
-      if (options ()->debug_netcompare) {
-        tl::info << "----------------------------------------------------------------------";
-        tl::info << "treating circuit: " << ca->name () << " vs. " << cb->name ();
+  }
+
+  //  In multi-threaded mode, the circuit pairs are compared in batches of consecutive pairs
+  //  which are independent: no circuit of a batch is a child of another circuit of the same
+  //  batch and a schematic circuit is not used twice. The results and log events are
+  //  taken in the original order afterwards, so the outcome is the same as in single-threaded
+  //  mode. Script-implemented parameter compare delegates cannot be used in threads.
+  bool multi_threaded = m_threads > 0 && ! options ()->debug_netcompare && device_compare_is_thread_safe (a) && device_compare_is_thread_safe (b);
+
+  tl::RelativeProgress progress (tl::to_string (tr ("Comparing netlists")), a->circuit_count (), 1);
+
+  for (std::vector<CircuitCompareItem>::iterator batch = items.begin (); batch != items.end (); ) {
+
+    std::vector<CircuitCompareItem>::iterator batch_end = batch + 1;
+
+    if (multi_threaded) {
+
+      std::set<const db::Circuit *> batch_a, batch_b;
+      batch_a.insert (batch->ca);
+      batch_b.insert (batch->cb);
+
+      while (batch_end != items.end () && batch_b.find (batch_end->cb) == batch_b.end () && ! has_child_in (batch_end->ca, batch_a) && ! has_child_in (batch_end->cb, batch_b)) {
+        batch_a.insert (batch_end->ca);
+        batch_b.insert (batch_end->cb);
+        ++batch_end;
       }
-      if (mp_logger) {
-        mp_logger->begin_circuit (ca, cb);
+
+    }
+
+    for (std::vector<CircuitCompareItem>::iterator i = batch; i != batch_end; ++i) {
+      i->skipped = ! all_subcircuits_verified (i->ca, verified_circuits_a) || ! all_subcircuits_verified (i->cb, verified_circuits_b);
+    }
+
+    bool in_threads = (batch_end - batch > 1);
+
+    if (in_threads) {
+
+      CircuitCompareContext cx;
+      cx.comparer = this;
+      cx.device_categorizer = &device_categorizer;
+      cx.circuit_categorizer = &circuit_categorizer;
+      cx.circuit_pin_mapper = &circuit_pin_mapper;
+      cx.c12_pin_mapping = &c12_pin_mapping;
+      cx.c22_pin_mapping = &c22_pin_mapping;
+      cx.with_log = (mp_logger != 0);
+
+      tl::Job<CircuitCompareWorker> job ((int) m_threads);
+
+      for (std::vector<CircuitCompareItem>::iterator i = batch; i != batch_end; ++i) {
+        if (! i->skipped) {
+          //  create the pin mapping entries here, so the workers don't modify the maps' structure
+          c12_pin_mapping [i->ca];
+          c22_pin_mapping [i->cb];
+          job.schedule (new CircuitCompareTask (&cx, i.operator-> ()));
+        }
       }
 
-      bool pin_mismatch = false;
-      bool g = compare_circuits (ca, cb, device_categorizer, circuit_categorizer, circuit_pin_mapper, *net_identity, pin_mismatch, c12_pin_mapping, c22_pin_mapping);
-      if (! g) {
-        good = false;
+      try {
+        job.start ();
+        job.wait ();
+      } catch (...) {
+        job.terminate ();
+        throw;
       }
 
-      if (! pin_mismatch) {
-        verified_circuits_a.insert (ca);
-        verified_circuits_b.insert (cb);
+      if (job.has_error ()) {
+        throw tl::Exception (job.error_messages ().front ());
       }
 
-      derive_pin_equivalence (ca, cb, &circuit_pin_mapper);
+    }
 
-      if (mp_logger) {
-        mp_logger->end_circuit (ca, cb, g);
-      }
+    for (std::vector<CircuitCompareItem>::iterator i = batch; i != batch_end; ++i) {
 
-    } else {
+      const db::Circuit *ca = i->ca;
+      const db::Circuit *cb = i->cb;
+
+      if (! i->skipped) {
+
+        if (options ()->debug_netcompare) {
+          tl::info << "----------------------------------------------------------------------";
+          tl::info << "treating circuit: " << ca->name () << " vs. " << cb->name ();
+        }
+        if (mp_logger) {
+          mp_logger->begin_circuit (ca, cb);
+        }
+
+        bool pin_mismatch = false;
+        bool g = false;
+        if (in_threads) {
+          if (mp_logger) {
+            i->logger.replay (mp_logger);
+          }
+          g = i->good;
+          pin_mismatch = i->pin_mismatch;
+        } else {
+          g = compare_circuits (ca, cb, device_categorizer, circuit_categorizer, circuit_pin_mapper, *i->net_identity, pin_mismatch, c12_pin_mapping, c22_pin_mapping, mp_logger);
+        }
+
+        if (! g) {
+          good = false;
+        }
+
+        if (! pin_mismatch) {
+          verified_circuits_a.insert (ca);
+          verified_circuits_b.insert (cb);
+        }
+
+        derive_pin_equivalence (ca, cb, &circuit_pin_mapper);
+
+        if (mp_logger) {
+          mp_logger->end_circuit (ca, cb, g);
+        }
+
+      } else {
+
+        if (mp_logger) {
+          mp_logger->circuit_skipped (ca, cb);
+          good = false;
+        }
 
-      if (mp_logger) {
-        mp_logger->circuit_skipped (ca, cb);
-        good = false;
       }
 
+      ++progress;
+
     }
 
-    ++progress;
+    batch = batch_end;
 
   }
 
@@ -3423,7 +3744,8 @@ NetlistComparer::compare_circuits (const db::Circuit *c1, const db::Circuit *c2,
                                    const std::vector<std::pair<const Net *, const Net *> > &net_identity,
                                    bool &pin_mismatch,
                                    std::map<const db::Circuit *, CircuitMapper> &c12_circuit_and_pin_mapping,
-                                   std::map<const db::Circuit *, CircuitMapper> &c22_circuit_and_pin_mapping) const
+                                   std::map<const db::Circuit *, CircuitMapper> &c22_circuit_and_pin_mapping,
+                                   db::NetlistCompareLogger *logger) const
 {
   db::DeviceFilter device_filter (m_cap_threshold, m_res_threshold);
   SubCircuitEquivalenceTracker subcircuit_equivalence;
@@ -3488,7 +3810,7 @@ NetlistComparer::compare_circuits (const db::Circuit *c1, const db::Circuit *c2,
           data.circuit_pin_mapper = &circuit_pin_mapper;
           data.subcircuit_equivalence = &subcircuit_equivalence;
           data.device_equivalence = &device_equivalence;
-          data.logger = mp_logger;
+          data.logger = logger;
           data.progress = &progress;
 
           size_t ni = g1.derive_node_identities (i1 - g1.begin (), 0, 1, 0 /*not tentative*/, &data);
@@ -3555,7 +3877,7 @@ NetlistComparer::compare_circuits (const db::Circuit *c1, const db::Circuit *c2,
       data.circuit_pin_mapper = &circuit_pin_mapper;
       data.subcircuit_equivalence = &subcircuit_equivalence;
       data.device_equivalence = &device_equivalence;
-      data.logger = mp_logger;
+      data.logger = logger;
       data.progress = &progress;
 
       size_t ni = g1.derive_node_identities_from_node_set (nodes, other_nodes, 0, 1, 0 /*not tentatively*/, &data);
@@ -3585,11 +3907,11 @@ NetlistComparer::compare_circuits (const db::Circuit *c1, const db::Circuit *c2,
       if (options ()->debug_netcompare) {
         tl::info << "Unresolved net from left: " << i->net ()->expanded_name () << " " << (good ? "(accepted)" : "(not accepted)");
       }
-      if (mp_logger) {
+      if (logger) {
         if (good) {
-          mp_logger->match_nets (i->net (), 0);
+          logger->match_nets (i->net (), 0);
         } else {
-          mp_logger->net_mismatch (i->net (), 0);
+          logger->net_mismatch (i->net (), 0);
         }
       }
       if (good) {
@@ -3604,11 +3926,11 @@ NetlistComparer::compare_circuits (const db::Circuit *c1, const db::Circuit *c2,
       if (options ()->debug_netcompare) {
         tl::info << "Unresolved net from right: " << i->net ()->expanded_name () << " " << (good ? "(accepted)" : "(not accepted)");
       }
-      if (mp_logger) {
+      if (logger) {
         if (good) {
-          mp_logger->match_nets (0, i->net ());
+          logger->match_nets (0, i->net ());
         } else {
-          mp_logger->net_mismatch (0, i->net ());
+          logger->net_mismatch (0, i->net ());
         }
       }
       if (good) {
@@ -3618,15 +3940,15 @@ NetlistComparer::compare_circuits (const db::Circuit *c1, const db::Circuit *c2,
     }
   }
 
-  do_pin_assignment (c1, g1, c2, g2, c12_circuit_and_pin_mapping, c22_circuit_and_pin_mapping, pin_mismatch, good);
-  do_device_assignment (c1, g1, c2, g2, device_filter, device_categorizer, device_equivalence, good);
-  do_subcircuit_assignment (c1, g1, c2, g2, circuit_categorizer, circuit_pin_mapper, c12_circuit_and_pin_mapping, c22_circuit_and_pin_mapping, subcircuit_equivalence, good);
+  do_pin_assignment (c1, g1, c2, g2, c12_circuit_and_pin_mapping, c22_circuit_and_pin_mapping, pin_mismatch, good, logger);
+  do_device_assignment (c1, g1, c2, g2, device_filter, device_categorizer, device_equivalence, good, logger);
+  do_subcircuit_assignment (c1, g1, c2, g2, circuit_categorizer, circuit_pin_mapper, c12_circuit_and_pin_mapping, c22_circuit_and_pin_mapping, subcircuit_equivalence, good, logger);
 
   return good;
 }
 
 bool
-NetlistComparer::handle_pin_mismatch (const db::NetGraph &g1, const db::Circuit *c1, const db::Pin *pin1, const db::NetGraph &g2, const db::Circuit *c2, const db::Pin *pin2) const
+NetlistComparer::handle_pin_mismatch (const db::NetGraph &g1, const db::Circuit *c1, const db::Pin *pin1, const db::NetGraph &g2, const db::Circuit *c2, const db::Pin *pin2, db::NetlistCompareLogger *logger) const
 {
   const db::Circuit *c = pin1 ? c1 : c2;
   const db::Pin *pin = pin1 ? pin1 : pin2;
@@ -3638,8 +3960,8 @@ NetlistComparer::handle_pin_mismatch (const db::NetGraph &g1, const db::Circuit
   if (net) {
     const db::NetGraphNode &n = graph->node (graph->node_index_for_net (net));
     if (n.has_other () && n.other_net_index () == 0) {
-      if (mp_logger) {
-        mp_logger->match_pins (pin1, pin2);
+      if (logger) {
+        logger->match_pins (pin1, pin2);
       }
       return true;
     }
@@ -3664,20 +3986,20 @@ NetlistComparer::handle_pin_mismatch (const db::NetGraph &g1, const db::Circuit
   }
 
   if (is_not_connected) {
-    if (mp_logger) {
-      mp_logger->match_pins (pin1, pin2);
+    if (logger) {
+      logger->match_pins (pin1, pin2);
     }
     return true;
   } else {
-    if (mp_logger) {
-      mp_logger->pin_mismatch (pin1, pin2);
+    if (logger) {
+      logger->pin_mismatch (pin1, pin2);
     }
     return false;
   }
 }
 
 void
-NetlistComparer::do_pin_assignment (const db::Circuit *c1, const db::NetGraph &g1, const db::Circuit *c2, const db::NetGraph &g2, std::map<const db::Circuit *, CircuitMapper> &c12_circuit_and_pin_mapping, std::map<const db::Circuit *, CircuitMapper> &c22_circuit_and_pin_mapping, bool &pin_mismatch, bool &good) const
+NetlistComparer::do_pin_assignment (const db::Circuit *c1, const db::NetGraph &g1, const db::Circuit *c2, const db::NetGraph &g2, std::map<const db::Circuit *, CircuitMapper> &c12_circuit_and_pin_mapping, std::map<const db::Circuit *, CircuitMapper> &c22_circuit_and_pin_mapping, bool &pin_mismatch, bool &good, db::NetlistCompareLogger *logger) const
 {
   //  Report pin assignment
   //  This step also does the pin identity mapping.
@@ -3743,8 +4065,8 @@ NetlistComparer::do_pin_assignment (const db::Circuit *c1, const db::NetGraph &g
 
         //  assign an abstract pin - this is a dummy assignment which is mitigated
         //  by declaring the pins equivalent in derive_pin_equivalence
-        if (mp_logger) {
-          mp_logger->match_pins (p.operator-> (), fp->second);
+        if (logger) {
+          logger->match_pins (p.operator-> (), fp->second);
         }
         c12_pin_mapping.map_pin (p->id (), fp->second->id ());
         c22_pin_mapping.map_pin (fp->second->id (), p->id ());
@@ -3753,8 +4075,8 @@ NetlistComparer::do_pin_assignment (const db::Circuit *c1, const db::NetGraph &g
 
         //  assign an abstract pin - this is a dummy assignment which is mitigated
         //  by declaring the pins equivalent in derive_pin_equivalence
-        if (mp_logger) {
-          mp_logger->match_pins (p.operator-> (), *next_abstract);
+        if (logger) {
+          logger->match_pins (p.operator-> (), *next_abstract);
         }
         c12_pin_mapping.map_pin (p->id (), (*next_abstract)->id ());
         c22_pin_mapping.map_pin ((*next_abstract)->id (), p->id ());
@@ -3764,7 +4086,7 @@ NetlistComparer::do_pin_assignment (const db::Circuit *c1, const db::NetGraph &g
       } else {
 
         //  otherwise this is an error for subcircuits or worth a report for top-level circuits
-        if (! handle_pin_mismatch (g1, c1, p.operator-> (), g2, c2, 0)) {
+        if (! handle_pin_mismatch (g1, c1, p.operator-> (), g2, c2, 0, logger)) {
           good = false;
           pin_mismatch = true;
         }
@@ -3788,8 +4110,8 @@ NetlistComparer::do_pin_assignment (const db::Circuit *c1, const db::NetGraph &g
 
       if (np != net2pin2.end () && np->first == n.other_net_index ()) {
 
-        if (mp_logger) {
-          mp_logger->match_pins (pi->pin (), np->second);
+        if (logger) {
+          logger->match_pins (pi->pin (), np->second);
         }
         c12_pin_mapping.map_pin (pi->pin ()->id (), np->second->id ());
         //  dummy mapping: we show this pin is used.
@@ -3811,14 +4133,14 @@ NetlistComparer::do_pin_assignment (const db::Circuit *c1, const db::NetGraph &g
   }
 
   for (std::multimap<size_t, const db::Pin *>::iterator np = net2pin1.begin (); np != net2pin1.end (); ++np) {
-    if (! handle_pin_mismatch (g1, c1, np->second, g2, c2, 0)) {
+    if (! handle_pin_mismatch (g1, c1, np->second, g2, c2, 0, logger)) {
       good = false;
       pin_mismatch = true;
     }
   }
 
   for (std::multimap<size_t, const db::Pin *>::iterator np = net2pin2.begin (); np != net2pin2.end (); ++np) {
-    if (! handle_pin_mismatch (g1, c1, 0, g2, c2, np->second)) {
+    if (! handle_pin_mismatch (g1, c1, 0, g2, c2, np->second, logger)) {
       good = false;
       pin_mismatch = true;
     }
@@ -3826,7 +4148,7 @@ NetlistComparer::do_pin_assignment (const db::Circuit *c1, const db::NetGraph &g
 
   //  abstract pins must match.
   while (next_abstract != abstract_pins2.end ()) {
-    if (! handle_pin_mismatch (g1, c1, 0, g2, c2, *next_abstract)) {
+    if (! handle_pin_mismatch (g1, c1, 0, g2, c2, *next_abstract, logger)) {
       good = false;
       pin_mismatch = true;
     }
@@ -3835,7 +4157,7 @@ NetlistComparer::do_pin_assignment (const db::Circuit *c1, const db::NetGraph &g
 }
 
 void
-NetlistComparer::do_device_assignment (const db::Circuit *c1, const db::NetGraph &g1, const db::Circuit *c2, const db::NetGraph &g2, const db::DeviceFilter &device_filter, db::DeviceCategorizer &device_categorizer, DeviceEquivalenceTracker &device_eq, bool &good) const
+NetlistComparer::do_device_assignment (const db::Circuit *c1, const db::NetGraph &g1, const db::Circuit *c2, const db::NetGraph &g2, const db::DeviceFilter &device_filter, db::DeviceCategorizer &device_categorizer, DeviceEquivalenceTracker &device_eq, bool &good, db::NetlistCompareLogger *logger) const
 {
   //  Report device assignment
 
@@ -3866,7 +4188,7 @@ NetlistComparer::do_device_assignment (const db::Circuit *c1, const db::NetGraph
     std::vector<std::pair<size_t, size_t> > k = compute_device_key_for_this (*d, g1, device_categorizer.is_strict_device_category (device_cat), mapped);
 
     if (! mapped) {
-      if (mp_logger) {
+      if (logger) {
         unmatched_a.push_back (std::make_pair (k, std::make_pair (d.operator-> (), device_cat)));
       }
       good = false;
@@ -3908,8 +4230,8 @@ NetlistComparer::do_device_assignment (const db::Circuit *c1, const db::NetGraph
       if (! mapped1 || ! mapped2 || k != k_this) {
 
         //  topological mismatch
-        if (mp_logger) {
-          mp_logger->device_mismatch (d_this, d.operator-> ());
+        if (logger) {
+          logger->device_mismatch (d_this, d.operator-> ());
         }
         good = false;
 
@@ -3929,7 +4251,7 @@ NetlistComparer::do_device_assignment (const db::Circuit *c1, const db::NetGraph
 
       if (! mapped || dm == device_map.end () || dm->first != k) {
 
-        if (mp_logger) {
+        if (logger) {
           unmatched_b.push_back (std::make_pair (k, std::make_pair (d.operator-> (), device_cat)));
         }
         good = false;
@@ -3951,19 +4273,19 @@ NetlistComparer::do_device_assignment (const db::Circuit *c1, const db::NetGraph
 
       if (! dc.equals (std::make_pair (c1_device, c1_device_cat), std::make_pair (d.operator-> (), device_cat))) {
         if (c1_device_cat != device_cat) {
-          if (mp_logger) {
-            mp_logger->match_devices_with_different_device_classes (c1_device, d.operator-> ());
+          if (logger) {
+            logger->match_devices_with_different_device_classes (c1_device, d.operator-> ());
           }
           good = false;
         } else {
-          if (mp_logger) {
-            mp_logger->match_devices_with_different_parameters (c1_device, d.operator-> ());
+          if (logger) {
+            logger->match_devices_with_different_parameters (c1_device, d.operator-> ());
           }
           good = false;
         }
       } else {
-        if (mp_logger) {
-          mp_logger->match_devices (c1_device, d.operator-> ());
+        if (logger) {
+          logger->match_devices (c1_device, d.operator-> ());
         }
       }
 
@@ -3972,7 +4294,7 @@ NetlistComparer::do_device_assignment (const db::Circuit *c1, const db::NetGraph
   }
 
   for (std::multimap<std::vector<std::pair<size_t, size_t> >, std::pair<const db::Device *, size_t> >::const_iterator dm = device_map.begin (); dm != device_map.end (); ++dm) {
-    if (mp_logger) {
+    if (logger) {
       unmatched_a.push_back (*dm);
     }
     good = false;
@@ -3981,17 +4303,17 @@ NetlistComparer::do_device_assignment (const db::Circuit *c1, const db::NetGraph
   //  try to do some better mapping of unmatched devices - they will still be reported as mismatching, but their pairing gives some hint
   //  what to fix.
 
-  if (mp_logger) {
+  if (logger) {
 
     size_t max_analysis_set = 1000;
     if (unmatched_a.size () + unmatched_b.size () > max_analysis_set) {
 
       //  don't try too much analysis - this may be a waste of time
       for (unmatched_list::const_iterator i = unmatched_a.begin (); i != unmatched_a.end (); ++i) {
-        mp_logger->device_mismatch (i->second.first, 0);
+        logger->device_mismatch (i->second.first, 0);
       }
       for (unmatched_list::const_iterator i = unmatched_b.begin (); i != unmatched_b.end (); ++i) {
-        mp_logger->device_mismatch (0, i->second.first);
+        logger->device_mismatch (0, i->second.first);
       }
 
     } else {
@@ -4004,12 +4326,12 @@ NetlistComparer::do_device_assignment (const db::Circuit *c1, const db::NetGraph
       for (unmatched_list::iterator i = unmatched_a.begin (), j = unmatched_b.begin (); i != unmatched_a.end () || j != unmatched_b.end (); ) {
 
         while (j != unmatched_b.end () && (i == unmatched_a.end () || !cmp.equals (*j, *i))) {
-          mp_logger->device_mismatch (0, j->second.first);
+          logger->device_mismatch (0, j->second.first);
           ++j;
         }
 
         while (i != unmatched_a.end () && (j == unmatched_b.end () || !cmp.equals (*i, *j))) {
-          mp_logger->device_mismatch (i->second.first, 0);
+          logger->device_mismatch (i->second.first, 0);
           ++i;
         }
 
@@ -4031,15 +4353,15 @@ NetlistComparer::do_device_assignment (const db::Circuit *c1, const db::NetGraph
         align (ii, i, jj, j, DeviceConnectionDistance ());
 
         for ( ; ii != i && jj != j; ++ii, ++jj) {
-          mp_logger->device_mismatch (ii->second.first, jj->second.first);
+          logger->device_mismatch (ii->second.first, jj->second.first);
         }
 
         for ( ; jj != j; ++jj) {
-          mp_logger->device_mismatch (0, jj->second.first);
+          logger->device_mismatch (0, jj->second.first);
         }
 
         for ( ; ii != i; ++ii) {
-          mp_logger->device_mismatch (ii->second.first, 0);
+          logger->device_mismatch (ii->second.first, 0);
         }
 
       }
@@ -4050,7 +4372,7 @@ NetlistComparer::do_device_assignment (const db::Circuit *c1, const db::NetGraph
 }
 
 void
-NetlistComparer::do_subcircuit_assignment (const db::Circuit *c1, const db::NetGraph &g1, const db::Circuit *c2, const db::NetGraph &g2, CircuitCategorizer &circuit_categorizer, const CircuitPinMapper &circuit_pin_mapper, std::map<const Circuit *, CircuitMapper> &c12_circuit_and_pin_mapping, std::map<const Circuit *, CircuitMapper> &c22_circuit_and_pin_mapping, SubCircuitEquivalenceTracker &subcircuit_eq, bool &good) const
+NetlistComparer::do_subcircuit_assignment (const db::Circuit *c1, const db::NetGraph &g1, const db::Circuit *c2, const db::NetGraph &g2, CircuitCategorizer &circuit_categorizer, const CircuitPinMapper &circuit_pin_mapper, std::map<const Circuit *, CircuitMapper> &c12_circuit_and_pin_mapping, std::map<const Circuit *, CircuitMapper> &c22_circuit_and_pin_mapping, SubCircuitEquivalenceTracker &subcircuit_eq, bool &good, db::NetlistCompareLogger *logger) const
 {
   //  Report subcircuit assignment
 
@@ -4072,8 +4394,8 @@ NetlistComparer::do_subcircuit_assignment (const db::Circuit *c1, const db::NetG
     std::vector<std::pair<size_t, size_t> > k = compute_subcircuit_key_for_this (*sc, g1, &c12_circuit_and_pin_mapping, &circuit_pin_mapper, mapped, valid);
 
     if (! mapped) {
-      if (mp_logger) {
-        mp_logger->subcircuit_mismatch (sc.operator-> (), 0);
+      if (logger) {
+        logger->subcircuit_mismatch (sc.operator-> (), 0);
       }
       good = false;
     } else if (valid) {
@@ -4109,13 +4431,13 @@ NetlistComparer::do_subcircuit_assignment (const db::Circuit *c1, const db::NetG
       std::vector<std::pair<size_t, size_t> > k = compute_subcircuit_key_for_other (*sc, g2, &c22_circuit_and_pin_mapping, &circuit_pin_mapper, mapped2, valid2);
 
       if (! valid1 || ! valid2 || ! mapped1 || ! mapped2 || k_this != k || sc_cat != sc_cat_this) {
-        if (mp_logger) {
-          mp_logger->subcircuit_mismatch (sc_this, sc.operator-> ());
+        if (logger) {
+          logger->subcircuit_mismatch (sc_this, sc.operator-> ());
         }
         good = false;
       } else {
-        if (mp_logger) {
-          mp_logger->match_subcircuits (sc_this, sc.operator-> ());
+        if (logger) {
+          logger->match_subcircuits (sc_this, sc.operator-> ());
         }
       }
 
@@ -4128,7 +4450,7 @@ NetlistComparer::do_subcircuit_assignment (const db::Circuit *c1, const db::NetG
 
       if (! mapped || scm == subcircuit_map.end () || scm->first != k) {
 
-        if (mp_logger) {
+        if (logger) {
           unmatched_b.push_back (std::make_pair (k, sc.operator-> ()));
         }
         good = false;
@@ -4153,8 +4475,8 @@ NetlistComparer::do_subcircuit_assignment (const db::Circuit *c1, const db::NetG
           if (nscm == 1) {
 
             //  unique match, but doesn't fit: report this one as paired, but mismatching:
-            if (mp_logger) {
-              mp_logger->subcircuit_mismatch (scm_start->second.first, sc.operator-> ());
+            if (logger) {
+              logger->subcircuit_mismatch (scm_start->second.first, sc.operator-> ());
             }
 
             //  no longer look for this one
@@ -4163,8 +4485,8 @@ NetlistComparer::do_subcircuit_assignment (const db::Circuit *c1, const db::NetG
           } else {
 
             //  no unqiue match
-            if (mp_logger) {
-              mp_logger->subcircuit_mismatch (0, sc.operator-> ());
+            if (logger) {
+              logger->subcircuit_mismatch (0, sc.operator-> ());
             }
 
           }
@@ -4173,8 +4495,8 @@ NetlistComparer::do_subcircuit_assignment (const db::Circuit *c1, const db::NetG
 
         } else {
 
-          if (mp_logger) {
-            mp_logger->match_subcircuits (scm->second.first, sc.operator-> ());
+          if (logger) {
+            logger->match_subcircuits (scm->second.first, sc.operator-> ());
           }
 
           //  no longer look for this one
@@ -4189,7 +4511,7 @@ NetlistComparer::do_subcircuit_assignment (const db::Circuit *c1, const db::NetG
   }
 
   for (std::multimap<std::vector<std::pair<size_t, size_t> >, std::pair<const db::SubCircuit *, size_t> >::const_iterator scm = subcircuit_map.begin (); scm != subcircuit_map.end (); ++scm) {
-    if (mp_logger) {
+    if (logger) {
       unmatched_a.push_back (std::make_pair (scm->first, scm->second.first));
     }
     good = false;
@@ -4198,17 +4520,17 @@ NetlistComparer::do_subcircuit_assignment (const db::Circuit *c1, const db::NetG
   //  try to do some pairing between the mismatching subcircuits - even though we will still report them as
   //  mismatches it will give some better hint about what needs to be fixed
 
-  if (mp_logger) {
+  if (logger) {
 
     size_t max_analysis_set = 1000;
     if (unmatched_a.size () + unmatched_b.size () > max_analysis_set) {
 
       //  don't try too much analysis - this may be a waste of time
       for (unmatched_list::const_iterator i = unmatched_a.begin (); i != unmatched_a.end (); ++i) {
-        mp_logger->subcircuit_mismatch (i->second, 0);
+        logger->subcircuit_mismatch (i->second, 0);
       }
       for (unmatched_list::const_iterator i = unmatched_b.begin (); i != unmatched_b.end (); ++i) {
-        mp_logger->subcircuit_mismatch (0, i->second);
+        logger->subcircuit_mismatch (0, i->second);
       }
 
     } else {
@@ -4219,12 +4541,12 @@ NetlistComparer::do_subcircuit_assignment (const db::Circuit *c1, const db::NetG
       for (unmatched_list::iterator i = unmatched_a.begin (), j = unmatched_b.begin (); i != unmatched_a.end () || j != unmatched_b.end (); ) {
 
         while (j != unmatched_b.end () && (i == unmatched_a.end () || j->first.size () < i->first.size ())) {
-          mp_logger->subcircuit_mismatch (0, j->second);
+          logger->subcircuit_mismatch (0, j->second);
           ++j;
         }
 
         while (i != unmatched_a.end () && (j == unmatched_b.end () || i->first.size () < j->first.size ())) {
-          mp_logger->subcircuit_mismatch (i->second, 0);
+          logger->subcircuit_mismatch (i->second, 0);
           ++i;
         }
 
@@ -4248,15 +4570,15 @@ NetlistComparer::do_subcircuit_assignment (const db::Circuit *c1, const db::NetG
         align (ii, i, jj, j, KeyDistance ());
 
         for ( ; ii != i && jj != j; ++ii, ++jj) {
-          mp_logger->subcircuit_mismatch (ii->second, jj->second);
+          logger->subcircuit_mismatch (ii->second, jj->second);
         }
 
         for ( ; jj != j; ++jj) {
-          mp_logger->subcircuit_mismatch (0, jj->second);
+          logger->subcircuit_mismatch (0, jj->second);
         }
 
         for ( ; ii != i; ++ii) {
-          mp_logger->subcircuit_mismatch (ii->second, 0);
+          logger->subcircuit_mismatch (ii->second, 0);
         }
 
       }
@@ -28,6 +28,8 @@
 #include "tlProgress.h"
 #include "tlTimer.h"
 #include "tlInternational.h"
+#include "tlThreadedWorkers.h"
+#include "tlThreads.h"
 
 namespace db
 {
@@ -71,11 +73,65 @@ std::string NetlistDeviceExtractorError::to_string () const
   return res;
 }
 
+// ----------------------------------------------------------------------------------------
+//  NetlistDeviceExtractionBuffer definition
+
+/**
+ *  @brief Collects the devices, terminals and errors of one cluster extracted in a worker thread
+ *
+ *  The devices are not attached to a circuit yet. They are committed by the
+ *  extractor later in the order of the single-threaded extraction.
+ */
+struct NetlistDeviceExtractionBuffer
+{
+  typedef std::map<unsigned int, std::vector<db::Polygon> > polygons_per_layer_type;
+  typedef std::map<size_t, polygons_per_layer_type> polygons_per_terminal_type;
+
+  NetlistDeviceExtractionBuffer ()
+    : cell_index (0)
+  {
+    //  .. nothing yet ..
+  }
+
+  ~NetlistDeviceExtractionBuffer ()
+  {
+    for (std::vector<db::Device *>::const_iterator d = devices.begin (); d != devices.end (); ++d) {
+      delete *d;
+    }
+  }
+
+  db::cell_index_type cell_index;
+  std::vector<db::Device *> devices;
+  std::map<const db::Device *, polygons_per_terminal_type> terminals;
+  std::vector<db::NetlistDeviceExtractorError> errors;
+};
+
+//  Hint: like tl::Progress, we store a pointer to a pointer so the thread storage
+//  does not take ownership over the buffer
+static tl::ThreadStorage<NetlistDeviceExtractionBuffer **> s_extraction_buffer;
+
+static NetlistDeviceExtractionBuffer *current_extraction_buffer ()
+{
+  if (! s_extraction_buffer.hasLocalData ()) {
+    return 0;
+  } else {
+    return *s_extraction_buffer.localData ();
+  }
+}
+
+static void set_current_extraction_buffer (NetlistDeviceExtractionBuffer *buffer)
+{
+  if (! s_extraction_buffer.hasLocalData ()) {
+    s_extraction_buffer.setLocalData (new (NetlistDeviceExtractionBuffer *) (0));
+  }
+  *s_extraction_buffer.localData () = buffer;
+}
+
 // ----------------------------------------------------------------------------------------
 //  NetlistDeviceExtractor implementation
 
 NetlistDeviceExtractor::NetlistDeviceExtractor (const std::string &name)
-  : mp_layout (0), m_cell_index (0), mp_breakout_cells (0), m_device_scaling (1.0), mp_circuit (0)
+  : mp_layout (0), m_cell_index (0), mp_breakout_cells (0), m_device_scaling (1.0), mp_circuit (0), m_threads (0)
 {
   m_name = name;
   m_terminal_id_propname_id = 0;
@@ -187,6 +243,8 @@ void NetlistDeviceExtractor::extract (db::DeepShapeStore &dss, unsigned int layo
 
   }
 
+  m_threads = (unsigned int) std::max (0, dss.threads ());
+
   extract_without_initialize (dss.layout (layout_index), dss.initial_cell (layout_index), clusters, layers, device_scaling, dss.breakout_cells (layout_index));
 }
 
@@ -204,6 +262,153 @@ struct ExtractorCacheValueType {
   tl::vector<db::Device *> devices;
 };
 
+struct LayerGeometryPtrCompare
+{
+  bool operator() (const std::vector<db::Region> *a, const std::vector<db::Region> *b) const
+  {
+    return *a < *b;
+  }
+};
+
+/**
+ *  @brief A root cluster to extract devices from
+ */
+struct DeviceExtractionItem
+{
+  DeviceExtractionItem (db::cell_index_type _cell_index, size_t _cluster_id)
+    : cell_index (_cell_index), cluster_id (_cluster_id), extract (false)
+  {
+    //  .. nothing yet ..
+  }
+
+  db::cell_index_type cell_index;
+  size_t cluster_id;
+  std::vector<db::Region> layer_geometry;
+  db::Vector disp;
+  bool extract;
+  db::NetlistDeviceExtractionBuffer buffer;
+};
+
+/**
+ *  @brief Builds the normalized layer geometry for a cluster
+ */
+static void
+build_layer_geometry (const db::hier_clusters<db::NetShape> &device_clusters, const std::vector<unsigned int> &layers, db::cell_index_type ci, size_t cluster_id, std::vector<db::Region> &layer_geometry, db::Vector &disp)
+{
+  layer_geometry.resize (layers.size ());
+
+  for (std::vector<unsigned int>::const_iterator l = layers.begin (); l != layers.end (); ++l) {
+    db::Region &r = layer_geometry [l - layers.begin ()];
+    for (db::recursive_cluster_shape_iterator<db::NetShape> si (device_clusters, *l, ci, cluster_id); ! si.at_end(); ++si) {
+      insert_into_region (*si, si.trans (), r);
+    }
+    r.set_base_verbosity (50);
+  }
+
+  db::Box box;
+  for (std::vector<db::Region>::const_iterator g = layer_geometry.begin (); g != layer_geometry.end (); ++g) {
+    box += g->bbox ();
+  }
+
+  disp = box.p1 () - db::Point ();
+  for (std::vector<db::Region>::iterator g = layer_geometry.begin (); g != layer_geometry.end (); ++g) {
+    g->transform (db::Disp (-disp));
+  }
+}
+
+/**
+ *  @brief A task computing the geometry of a range of items or extracting the devices from them
+ */
+class DeviceExtractionTask
+  : public tl::Task
+{
+public:
+  DeviceExtractionTask (db::NetlistDeviceExtractor *extractor, const db::hier_clusters<db::NetShape> *device_clusters, const std::vector<unsigned int> *layers, std::vector<DeviceExtractionItem>::iterator from, std::vector<DeviceExtractionItem>::iterator to, bool extract)
+    : mp_extractor (extractor), mp_device_clusters (device_clusters), mp_layers (layers), m_from (from), m_to (to), m_extract (extract)
+  {
+    //  .. nothing yet ..
+  }
+
+  void perform ()
+  {
+    for (std::vector<DeviceExtractionItem>::iterator i = m_from; i != m_to; ++i) {
+
+      if (! m_extract) {
+
+        build_layer_geometry (*mp_device_clusters, *mp_layers, i->cell_index, i->cluster_id, i->layer_geometry, i->disp);
+
+      } else if (i->extract) {
+
+        i->buffer.cell_index = i->cell_index;
+
+        set_current_extraction_buffer (&i->buffer);
+        try {
+          mp_extractor->extract_devices (i->layer_geometry);
+        } catch (...) {
+          set_current_extraction_buffer (0);
+          throw;
+        }
+        set_current_extraction_buffer (0);
+
+      }
+
+    }
+  }
+
+private:
+  db::NetlistDeviceExtractor *mp_extractor;
+  const db::hier_clusters<db::NetShape> *mp_device_clusters;
+  const std::vector<unsigned int> *mp_layers;
+  std::vector<DeviceExtractionItem>::iterator m_from, m_to;
+  bool m_extract;
+};
+
+class DeviceExtractionWorker
+  : public tl::Worker
+{
+public:
+  DeviceExtractionWorker ()
+    : tl::Worker ()
+  {
+    //  .. nothing yet ..
+  }
+
+  void perform_task (tl::Task *task)
+  {
+    static_cast<DeviceExtractionTask *> (task)->perform ();
+  }
+};
+
+//  the number of items processed in one batch in multi-threaded mode
+const size_t items_per_batch = 10000;
+
+//  the number of items per task in multi-threaded mode
+const size_t items_per_task = 10;
+
+static void
+run_device_extraction_tasks (unsigned int threads, db::NetlistDeviceExtractor *extractor, const db::hier_clusters<db::NetShape> &device_clusters, const std::vector<unsigned int> &layers, std::vector<DeviceExtractionItem>::iterator from, std::vector<DeviceExtractionItem>::iterator to, bool extract)
+{
+  tl::Job<DeviceExtractionWorker> job ((int) threads);
+
+  while (from != to) {
+    std::vector<DeviceExtractionItem>::iterator next = from + std::min (items_per_task, size_t (to - from));
+    job.schedule (new DeviceExtractionTask (extractor, &device_clusters, &layers, from, next, extract));
+    from = next;
+  }
+
+  try {
+    job.start ();
+    job.wait ();
+  } catch (...) {
+    job.terminate ();
+    throw;
+  }
+
+  if (job.has_error ()) {
+    throw tl::Exception (job.error_messages ().front ());
+  }
+}
+
 }
 
 void NetlistDeviceExtractor::extract_without_initialize (db::Layout &layout, db::Cell &cell, hier_clusters_type &clusters, const std::vector<unsigned int> &layers, double device_scaling, const std::set<db::cell_index_type> *breakout_cells)
@@ -253,87 +458,89 @@ void NetlistDeviceExtractor::extract_without_initialize (db::Layout &layout, db:
 
   tl::SelfTimer timer (tl::verbosity () >= 21, tl::to_string (tr ("Extracting devices")));
 
-  //  count effort and make a progress reporter
+  //  make sure there is a circuit for each cell and collect the clusters to investigate:
+  //  take only root clusters - others have upward connections and are not "whole"
+
+  std::vector<DeviceExtractionItem> items;
 
-  size_t n = 0;
   for (std::set<db::cell_index_type>::const_iterator ci = called_cells.begin (); ci != called_cells.end (); ++ci) {
+
+    if (circuits_by_cell.find (*ci) == circuits_by_cell.end ()) {
+
+      //  create a new circuit for this cell
+      db::Circuit *circuit = new db::Circuit (layout, *ci);
+      m_netlist->add_circuit (circuit);
+      circuits_by_cell.insert (std::make_pair (*ci, circuit));
+
+    }
+
     db::connected_clusters<shape_type> cc = device_clusters.clusters_per_cell (*ci);
     for (db::connected_clusters<shape_type>::all_iterator c = cc.begin_all (); !c.at_end(); ++c) {
       if (cc.is_root (*c)) {
-        ++n;
+        items.push_back (DeviceExtractionItem (*ci, *c));
       }
     }
+
   }
 
-  tl::RelativeProgress progress (tl::to_string (tr ("Extracting devices")), n, 1);
+  tl::RelativeProgress progress (tl::to_string (tr ("Extracting devices")), items.size (), 1);
 
   typedef std::map<std::vector<db::Region>, ExtractorCacheValueType> extractor_cache_type;
   extractor_cache_type extractor_cache;
 
-  //  for each cell investigate the clusters
-  for (std::set<db::cell_index_type>::const_iterator ci = called_cells.begin (); ci != called_cells.end (); ++ci) {
+  //  In multi-threaded mode, the items are processed in batches: first the geometry is
+  //  computed for the whole batch, then the devices are extracted in parallel for the first
+  //  occurrence of each geometry. Eventually, the devices are committed in the order of the
+  //  single-threaded extraction, so the device numbering does not depend on the threads.
+  bool multi_threaded = (m_threads > 0 && is_thread_safe ());
+  size_t batch_size = multi_threaded ? items_per_batch : items.size ();
 
-    m_cell_index = *ci;
+  for (std::vector<DeviceExtractionItem>::iterator batch = items.begin (); batch != items.end (); ) {
 
-    std::map<db::cell_index_type, db::Circuit *>::const_iterator c2c = circuits_by_cell.find (*ci);
-    if (c2c != circuits_by_cell.end ()) {
+    std::vector<DeviceExtractionItem>::iterator batch_end = batch + std::min (batch_size, size_t (items.end () - batch));
 
-      //  reuse existing circuit
-      mp_circuit = c2c->second;
+    if (multi_threaded) {
 
-    } else {
+      run_device_extraction_tasks (m_threads, this, device_clusters, layers, batch, batch_end, false);
 
-      //  create a new circuit for this cell
-      mp_circuit = new db::Circuit (layout, *ci);
-      m_netlist->add_circuit (mp_circuit);
+      std::set<const std::vector<db::Region> *, LayerGeometryPtrCompare> seen;
+      for (std::vector<DeviceExtractionItem>::iterator i = batch; i != batch_end; ++i) {
+        i->extract = (extractor_cache.find (i->layer_geometry) == extractor_cache.end () && seen.insert (&i->layer_geometry).second);
+      }
 
-    }
+      run_device_extraction_tasks (m_threads, this, device_clusters, layers, batch, batch_end, true);
 
-    //  investigate each cluster
-    db::connected_clusters<shape_type> cc = device_clusters.clusters_per_cell (*ci);
-    for (db::connected_clusters<shape_type>::all_iterator c = cc.begin_all (); !c.at_end(); ++c) {
+    }
 
-      //  take only root clusters - others have upward connections and are not "whole"
-      if (! cc.is_root (*c)) {
-        continue;
-      }
+    for (std::vector<DeviceExtractionItem>::iterator i = batch; i != batch_end; ++i) {
 
       ++progress;
 
-      //  build layer geometry from the cluster found
-
-      std::vector<db::Region> layer_geometry;
-      layer_geometry.resize (layers.size ());
-
-      for (std::vector<unsigned int>::const_iterator l = layers.begin (); l != layers.end (); ++l) {
-        db::Region &r = layer_geometry [l - layers.begin ()];
-        for (db::recursive_cluster_shape_iterator<shape_type> si (device_clusters, *l, *ci, *c); ! si.at_end(); ++si) {
-          insert_into_region (*si, si.trans (), r);
-        }
-        r.set_base_verbosity (50);
-      }
+      m_cell_index = i->cell_index;
+      mp_circuit = circuits_by_cell [i->cell_index];
 
-      db::Box box;
-      for (std::vector<db::Region>::const_iterator g = layer_geometry.begin (); g != layer_geometry.end (); ++g) {
-        box += g->bbox ();
-      }
+      //  build layer geometry from the cluster found
 
-      db::Vector disp = box.p1 () - db::Point ();
-      for (std::vector<db::Region>::iterator g = layer_geometry.begin (); g != layer_geometry.end (); ++g) {
-        g->transform (db::Disp (-disp));
+      if (! multi_threaded) {
+        build_layer_geometry (device_clusters, layers, i->cell_index, i->cluster_id, i->layer_geometry, i->disp);
       }
 
-      extractor_cache_type::const_iterator ec = extractor_cache.find (layer_geometry);
+      extractor_cache_type::const_iterator ec = extractor_cache.find (i->layer_geometry);
       if (ec == extractor_cache.end ()) {
 
-        //  do the actual device extraction
-        extract_devices (layer_geometry);
+        if (multi_threaded) {
+          //  take the devices extracted in the worker thread
+          commit_buffered_devices (i->buffer);
+        } else {
+          //  do the actual device extraction
+          extract_devices (i->layer_geometry);
+        }
 
         //  push the new devices to the layout
-        push_new_devices (disp);
+        push_new_devices (i->disp);
 
-        ExtractorCacheValueType &ecv = extractor_cache [layer_geometry];
-        ecv.disp = disp;
+        ExtractorCacheValueType &ecv = extractor_cache [i->layer_geometry];
+        ecv.disp = i->disp;
 
         for (std::map<size_t, std::pair<db::Device *, geometry_per_terminal_type> >::const_iterator d = m_new_devices.begin (); d != m_new_devices.end (); ++d) {
           ecv.devices.push_back (d->second.first);
@@ -343,13 +550,61 @@ void NetlistDeviceExtractor::extract_without_initialize (db::Layout &layout, db:
 
       } else {
 
-        push_cached_devices (ec->second.devices, ec->second.disp, disp);
+        push_cached_devices (ec->second.devices, ec->second.disp, i->disp);
 
       }
 
+      //  release the geometry as we go
+      i->layer_geometry.clear ();
+
+    }
+
+    batch = batch_end;
+
+  }
+}
+
+void NetlistDeviceExtractor::commit_buffered_devices (NetlistDeviceExtractionBuffer &buffer)
+{
+  for (std::vector<db::NetlistDeviceExtractorError>::const_iterator e = buffer.errors.begin (); e != buffer.errors.end (); ++e) {
+    m_errors.push_back (*e);
+    if (tl::verbosity () >= 20) {
+      tl::error << m_errors.back ().to_string ();
+    }
+  }
+
+  buffer.errors.clear ();
+
+  //  the devices are added in the order of creation, hence they receive the same IDs as
+  //  they would have received in single-threaded mode
+  for (std::vector<db::Device *>::iterator d = buffer.devices.begin (); d != buffer.devices.end (); ++d) {
+
+    db::Device *device = *d;
+    *d = 0;
+
+    mp_circuit->add_device (device);
+
+    std::map<const db::Device *, NetlistDeviceExtractionBuffer::polygons_per_terminal_type>::const_iterator dt = buffer.terminals.find (device);
+    if (dt == buffer.terminals.end ()) {
+      continue;
+    }
+
+    std::pair<db::Device *, geometry_per_terminal_type> &dd = m_new_devices[device->id ()];
+    dd.first = device;
+
+    for (NetlistDeviceExtractionBuffer::polygons_per_terminal_type::const_iterator t = dt->second.begin (); t != dt->second.end (); ++t) {
+      for (NetlistDeviceExtractionBuffer::polygons_per_layer_type::const_iterator l = t->second.begin (); l != t->second.end (); ++l) {
+        std::vector<db::NetShape> &geo = dd.second[t->first][l->first];
+        for (std::vector<db::Polygon>::const_iterator p = l->second.begin (); p != l->second.end (); ++p) {
+          geo.push_back (db::NetShape (*p, mp_layout->shape_repository ()));
+        }
+      }
     }
 
   }
+
+  buffer.devices.clear ();
+  buffer.terminals.clear ();
 }
 
 void NetlistDeviceExtractor::push_new_devices (const db::Vector &disp_cache)
@@ -481,6 +736,11 @@ void NetlistDeviceExtractor::extract_devices (const std::vector<db::Region> & /*
   //  .. the default implementation does nothing ..
 }
 
+bool NetlistDeviceExtractor::is_thread_safe () const
+{
+  return false;
+}
+
 void NetlistDeviceExtractor::register_device_class (DeviceClass *device_class)
 {
   std::auto_ptr<DeviceClass> holder (device_class);
@@ -530,6 +790,14 @@ Device *NetlistDeviceExtractor::create_device ()
     throw tl::Exception (tl::to_string (tr ("No device class registered")));
   }
 
+  NetlistDeviceExtractionBuffer *buffer = current_extraction_buffer ();
+  if (buffer) {
+    //  in a worker thread, the device is added to the circuit later
+    Device *device = new Device (mp_device_class);
+    buffer->devices.push_back (device);
+    return device;
+  }
+
   tl_assert (mp_circuit != 0);
   Device *device = new Device (mp_device_class);
   mp_circuit->add_device (device);
@@ -542,6 +810,15 @@ void NetlistDeviceExtractor::define_terminal (Device *device, size_t terminal_id
   tl_assert (geometry_index < m_layers.size ());
   unsigned int layer_index = m_layers [geometry_index];
 
+  NetlistDeviceExtractionBuffer *buffer = current_extraction_buffer ();
+  if (buffer) {
+    std::vector<db::Polygon> &geo = buffer->terminals[device][terminal_id][layer_index];
+    for (db::Region::const_iterator p = region.begin_merged (); !p.at_end (); ++p) {
+      geo.push_back (*p);
+    }
+    return;
+  }
+
   std::pair<db::Device *, geometry_per_terminal_type> &dd = m_new_devices[device->id ()];
   dd.first = device;
   std::vector<db::NetShape> &geo = dd.second[terminal_id][layer_index];
@@ -557,6 +834,12 @@ void NetlistDeviceExtractor::define_terminal (Device *device, size_t terminal_id
   tl_assert (geometry_index < m_layers.size ());
   unsigned int layer_index = m_layers [geometry_index];
 
+  NetlistDeviceExtractionBuffer *buffer = current_extraction_buffer ();
+  if (buffer) {
+    buffer->terminals[device][terminal_id][layer_index].push_back (polygon);
+    return;
+  }
+
   db::NetShape pr (polygon, mp_layout->shape_repository ());
   std::pair<db::Device *, geometry_per_terminal_type> &dd = m_new_devices[device->id ()];
   dd.first = device;
@@ -575,6 +858,12 @@ void NetlistDeviceExtractor::define_terminal (Device *device, size_t terminal_id
   define_terminal (device, terminal_id, layer_index, db::Polygon (db::Box (point - dv, point + dv)));
 }
 
+db::cell_index_type NetlistDeviceExtractor::cell_index () const
+{
+  NetlistDeviceExtractionBuffer *buffer = current_extraction_buffer ();
+  return buffer ? buffer->cell_index : m_cell_index;
+}
+
 std::string NetlistDeviceExtractor::cell_name () const
 {
   if (layout ()) {
@@ -584,46 +873,49 @@ std::string NetlistDeviceExtractor::cell_name () const
   }
 }
 
-void NetlistDeviceExtractor::error (const std::string &msg)
+void NetlistDeviceExtractor::add_error (const db::NetlistDeviceExtractorError &error)
 {
-  m_errors.push_back (db::NetlistDeviceExtractorError (cell_name (), msg));
+  NetlistDeviceExtractionBuffer *buffer = current_extraction_buffer ();
+  if (buffer) {
+    //  in a worker thread, the error is reported when the devices are committed
+    buffer->errors.push_back (error);
+    return;
+  }
+
+  m_errors.push_back (error);
 
   if (tl::verbosity () >= 20) {
     tl::error << m_errors.back ().to_string ();
   }
 }
 
-void NetlistDeviceExtractor::error (const std::string &msg, const db::DPolygon &poly)
+void NetlistDeviceExtractor::error (const std::string &msg)
 {
-  m_errors.push_back (db::NetlistDeviceExtractorError (cell_name (), msg));
-  m_errors.back ().set_geometry (poly);
+  add_error (db::NetlistDeviceExtractorError (cell_name (), msg));
+}
 
-  if (tl::verbosity () >= 20) {
-    tl::error << m_errors.back ().to_string ();
-  }
+void NetlistDeviceExtractor::error (const std::string &msg, const db::DPolygon &poly)
+{
+  db::NetlistDeviceExtractorError err (cell_name (), msg);
+  err.set_geometry (poly);
+  add_error (err);
 }
 
 void NetlistDeviceExtractor::error (const std::string &category_name, const std::string &category_description, const std::string &msg)
 {
-  m_errors.push_back (db::NetlistDeviceExtractorError (cell_name (), msg));
-  m_errors.back ().set_category_name (category_name);
-  m_errors.back ().set_category_description (category_description);
-
-  if (tl::verbosity () >= 20) {
-    tl::error << m_errors.back ().to_string ();
-  }
+  db::NetlistDeviceExtractorError err (cell_name (), msg);
+  err.set_category_name (category_name);
+  err.set_category_description (category_description);
+  add_error (err);
 }
 
 void NetlistDeviceExtractor::error (const std::string &category_name, const std::string &category_description, const std::string &msg, const db::DPolygon &poly)
 {
-  m_errors.push_back (db::NetlistDeviceExtractorError (cell_name (), msg));
-  m_errors.back ().set_category_name (category_name);
-  m_errors.back ().set_category_description (category_description);
-  m_errors.back ().set_geometry (poly);
-
-  if (tl::verbosity () >= 20) {
-    tl::error << m_errors.back ().to_string ();
-  }
+  db::NetlistDeviceExtractorError err (cell_name (), msg);
+  err.set_category_name (category_name);
+  err.set_category_description (category_description);
+  err.set_geometry (poly);
+  add_error (err);
 }
 
 }
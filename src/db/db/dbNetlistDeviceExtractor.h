@@ -191,6 +191,8 @@ public:
   size_t fallback_index;
 };
 
+struct NetlistDeviceExtractionBuffer;
+
 /**
  *  @brief Implements the device extraction for a specific setup
  *
@@ -313,6 +315,32 @@ public:
     return m_layer_definitions.end ();
   }
 
+  /**
+   *  @brief Sets the number of threads to use for the device extraction
+   *
+   *  With a thread count of 0 (the default), the devices are extracted in the
+   *  calling thread. Otherwise, "extract_devices" is called from the given number
+   *  of worker threads, provided the extractor is thread-safe (see "is_thread_safe").
+   *  Devices and terminals are collected per cluster and committed in the
+   *  order of the single-threaded extraction, so the resulting netlist and the
+   *  device numbering do not depend on the number of threads.
+   *
+   *  When extracting from a DeepShapeStore, the thread count is taken from the
+   *  store.
+   */
+  void set_threads (unsigned int n)
+  {
+    m_threads = n;
+  }
+
+  /**
+   *  @brief Gets the number of threads to use for the device extraction
+   */
+  unsigned int threads () const
+  {
+    return m_threads;
+  }
+
   /**
    *  @brief Sets the name of the device class and the device extractor
    */
@@ -354,6 +382,17 @@ public:
    */
   virtual void extract_devices (const std::vector<db::Region> &layer_geometry);
 
+  /**
+   *  @brief Returns true, if "extract_devices" can be called from worker threads
+   *
+   *  An implementation may return true if "extract_devices" does not modify
+   *  the extractor's state and only uses "create_device", "define_terminal",
+   *  "error" and const methods. The default implementation returns false, so
+   *  the devices are extracted in the calling thread. Classes derived from a
+   *  thread-safe extractor need to maintain this property.
+   */
+  virtual bool is_thread_safe () const;
+
   /**
    *  @brief Registers a device class
    *  The device class object will become owned by the netlist and must not be deleted by
@@ -447,10 +486,7 @@ public:
    *  @brief Gets the cell index of the current cell
    *  NOTE: this method is provided for testing purposes mainly.
    */
-  db::cell_index_type cell_index () const
-  {
-    return m_cell_index;
-  }
+  db::cell_index_type cell_index () const;
 
   /**
    *  @brief Issues an error with the given message
@@ -542,6 +578,7 @@ private:
   error_list m_errors;
   std::map<size_t, std::pair<db::Device *, geometry_per_terminal_type> > m_new_devices;
   std::map<DeviceCellKey, std::pair<db::cell_index_type, db::DeviceAbstract *> > m_device_cells;
+  unsigned int m_threads;
 
   //  no copying
   NetlistDeviceExtractor (const NetlistDeviceExtractor &);
@@ -556,6 +593,8 @@ private:
   void extract_without_initialize (db::Layout &layout, db::Cell &cell, hier_clusters_type &clusters, const std::vector<unsigned int> &layers, double device_scaling, const std::set<cell_index_type> *breakout_cells);
   void push_new_devices (const Vector &disp_cache);
   void push_cached_devices (const tl::vector<Device *> &cached_devices, const db::Vector &disp_cache, const db::Vector &new_disp);
+  void commit_buffered_devices (NetlistDeviceExtractionBuffer &buffer);
+  void add_error (const db::NetlistDeviceExtractorError &error);
 };
 
 }
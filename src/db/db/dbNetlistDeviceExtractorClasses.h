@@ -53,6 +53,7 @@ public:
   virtual void setup ();
   virtual db::Connectivity get_connectivity (const db::Layout &layout, const std::vector<unsigned int> &layers) const;
   virtual void extract_devices (const std::vector<db::Region> &layer_geometry);
+  virtual bool is_thread_safe () const;
 
   bool is_strict () const
   {
@@ -129,6 +130,7 @@ public:
   virtual void setup ();
   virtual db::Connectivity get_connectivity (const db::Layout &layout, const std::vector<unsigned int> &layers) const;
   virtual void extract_devices (const std::vector<db::Region> &layer_geometry);
+  virtual bool is_thread_safe () const;
 
 protected:
   /**
@@ -194,6 +196,7 @@ public:
   virtual void setup ();
   virtual db::Connectivity get_connectivity (const db::Layout &layout, const std::vector<unsigned int> &layers) const;
   virtual void extract_devices (const std::vector<db::Region> &layer_geometry);
+  virtual bool is_thread_safe () const;
 
 protected:
   /**
@@ -264,6 +267,7 @@ public:
   virtual void setup ();
   virtual db::Connectivity get_connectivity (const db::Layout &layout, const std::vector<unsigned int> &layers) const;
   virtual void extract_devices (const std::vector<db::Region> &layer_geometry);
+  virtual bool is_thread_safe () const;
 
 protected:
   /**
@@ -329,6 +333,7 @@ public:
   virtual void setup ();
   virtual db::Connectivity get_connectivity (const db::Layout &layout, const std::vector<unsigned int> &layers) const;
   virtual void extract_devices (const std::vector<db::Region> &layer_geometry);
+  virtual bool is_thread_safe () const;
 
 protected:
   /**
@@ -281,6 +281,7 @@ OriginalLayerRegion::ensure_merged_polygons_valid () const
 
     db::EdgeProcessor ep (report_progress (), progress_desc ());
     ep.set_base_verbosity (base_verbosity ());
+    ep.set_threads (threads ());
 
     //  count edges and reserve memory
     size_t n = 0;
@@ -0,0 +1,549 @@
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2020 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#ifndef HDR_dbPackedBoxTree
+#define HDR_dbPackedBoxTree
+
+#include "tlVector.h"
+#include "tlAssert.h"
+#include "dbBox.h"
+#include "dbMemStatistics.h"
+
+#include <vector>
+#include <algorithm>
+
+namespace db
+{
+
+/**
+ *  @brief The "touching" selector for the packed box tree
+ *
+ *  The test is written without branches, so the compiler is able to vectorize
+ *  the scan over the child boxes of a node.
+ */
+template <class Box>
+struct packed_box_tree_sel_touch
+{
+  typedef typename Box::coord_type coord_type;
+
+  static bool test (coord_type l, coord_type b, coord_type r, coord_type t, coord_type ql, coord_type qb, coord_type qr, coord_type qt)
+  {
+    return (l <= qr) & (r >= ql) & (b <= qt) & (t >= qb);
+  }
+};
+
+/**
+ *  @brief The "overlapping" selector for the packed box tree
+ */
+template <class Box>
+struct packed_box_tree_sel_overlap
+{
+  typedef typename Box::coord_type coord_type;
+
+  static bool test (coord_type l, coord_type b, coord_type r, coord_type t, coord_type ql, coord_type qb, coord_type qr, coord_type qt)
+  {
+    return (l < qr) & (r > ql) & (b < qt) & (t > qb);
+  }
+};
+
+/**
+ *  @brief The region query iterator for the packed box tree
+ *
+ *  The iterator performs a depth-first traversal of the tree. For each level
+ *  it keeps the index of the first child and a bit mask of the children
+ *  which match the search box.
+ */
+template <class Tree, class Sel>
+class packed_box_tree_it
+{
+public:
+  typedef typename Tree::object_type object_type;
+  typedef typename Tree::box_type box_type;
+
+  /**
+   *  @brief Default constructor: creates an iterator at end
+   */
+  packed_box_tree_it ()
+    : mp_tree (0), m_level (0), m_index (0)
+  {
+    //  .. nothing yet ..
+  }
+
+  /**
+   *  @brief Creates an iterator delivering the objects selected by the given search box
+   */
+  packed_box_tree_it (const Tree &tree, const box_type &box)
+    : mp_tree (&tree), m_box (box), m_level (0), m_index (0)
+  {
+    if (box.empty () || tree.levels () == 0) {
+      mp_tree = 0;
+    } else {
+      m_level = tree.levels () - 1;
+      m_base [m_level] = 0;
+      m_mask [m_level] = tree.template scan<Sel> (m_level, 0, m_box);
+      next ();
+    }
+  }
+
+  packed_box_tree_it &operator++ ()
+  {
+    next ();
+    return *this;
+  }
+
+  const object_type &operator* () const
+  {
+    return mp_tree->object (m_index);
+  }
+
+  const object_type *operator-> () const
+  {
+    return &mp_tree->object (m_index);
+  }
+
+  /**
+   *  @brief Gets the index of the current object inside the tree's object vector
+   */
+  size_t index () const
+  {
+    return m_index;
+  }
+
+  bool at_end () const
+  {
+    return mp_tree == 0;
+  }
+
+private:
+  //  node_size is at least 8, so 24 levels are sufficient for any size_t count
+  enum { max_levels = 24 };
+
+  const Tree *mp_tree;
+  box_type m_box;
+  unsigned int m_level;
+  size_t m_index;
+  size_t m_base [max_levels];
+  unsigned int m_mask [max_levels];
+
+  void next ()
+  {
+    unsigned int levels = mp_tree->levels ();
+
+    while (true) {
+
+      unsigned int &mask = m_mask [m_level];
+
+      if (mask == 0) {
+
+        //  all children done: continue with the parent level
+        if (++m_level == levels) {
+          mp_tree = 0;
+          return;
+        }
+
+      } else {
+
+        unsigned int k = 0;
+        while ((mask & (1u << k)) == 0) {
+          ++k;
+        }
+        mask &= mask - 1;
+
+        size_t i = m_base [m_level] + k;
+        if (m_level == 0) {
+          m_index = i;
+          return;
+        }
+
+        --m_level;
+        m_base [m_level] = i * Tree::node_size;
+        m_mask [m_level] = mp_tree->template scan<Sel> (m_level, m_base [m_level], m_box);
+
+      }
+
+    }
+  }
+};
+
+/**
+ *  @brief A packed, static R-tree for region queries on read-only box collections
+ *
+ *  Unlike box_tree and unstable_box_tree, this tree does not employ linked nodes.
+ *  When the tree is sorted, the objects are brought into the order of the Hilbert
+ *  curve index of their box centers. The objects are then grouped into nodes of
+ *  "node_size" consecutive entries, these nodes are grouped again and so forth until
+ *  a single root node remains. The bounding boxes of all levels are stored in flat
+ *  coordinate arrays (left, bottom, right and top separately), so a query scans the
+ *  children of a node with a single tight loop over consecutive memory.
+ *
+ *  Objects with empty boxes are moved to the end and are never delivered by the
+ *  region queries.
+ *
+ *  The tree is not intended for modification: inserting objects invalidates the
+ *  index and "sort" needs to be called before queries can be done again.
+ *
+ *  "node_size" must be between 8 and 32.
+ */
+template <class Box, class Obj, class BoxConv, unsigned int NodeSize = 16>
+class packed_box_tree
+{
+public:
+  typedef Box box_type;
+  typedef BoxConv box_conv_type;
+  typedef Obj object_type;
+  typedef typename box_type::coord_type coord_type;
+  typedef db::point<coord_type> point_type;
+  typedef tl::vector<object_type> obj_vector_type;
+  typedef size_t size_type;
+  typedef typename obj_vector_type::const_iterator const_iterator;
+  typedef packed_box_tree<box_type, object_type, box_conv_type, NodeSize> box_tree_type;
+  typedef packed_box_tree_it<box_tree_type, packed_box_tree_sel_touch<box_type> > touching_iterator;
+  typedef packed_box_tree_it<box_tree_type, packed_box_tree_sel_overlap<box_type> > overlapping_iterator;
+
+  enum { node_size = NodeSize };
+
+  /**
+   *  @brief Creates an empty tree
+   */
+  packed_box_tree ()
+  {
+    //  .. nothing yet ..
+  }
+
+  /**
+   *  @brief Inserts an object
+   *
+   *  This operation invalidates the index.
+   */
+  void insert (const Obj &o)
+  {
+    invalidate ();
+    m_objects.push_back (o);
+  }
+
+  /**
+   *  @brief Inserts a range of objects
+   *
+   *  This operation invalidates the index.
+   */
+  template <class I>
+  void insert (I from, I to)
+  {
+    invalidate ();
+    m_objects.insert (m_objects.end (), from, to);
+  }
+
+  /**
+   *  @brief Reserves space for the given number of objects
+   */
+  void reserve (size_t n)
+  {
+    m_objects.reserve (n);
+  }
+
+  /**
+   *  @brief Gets the number of objects
+   */
+  size_type size () const
+  {
+    return m_objects.size ();
+  }
+
+  /**
+   *  @brief Returns true, if the tree is empty
+   */
+  bool empty () const
+  {
+    return m_objects.empty ();
+  }
+
+  /**
+   *  @brief Clears the tree
+   */
+  void clear ()
+  {
+    m_objects.clear ();
+    invalidate ();
+  }
+
+  /**
+   *  @brief Swaps the tree with another one
+   */
+  void swap (packed_box_tree &other)
+  {
+    m_objects.swap (other.m_objects);
+    m_left.swap (other.m_left);
+    m_bottom.swap (other.m_bottom);
+    m_right.swap (other.m_right);
+    m_top.swap (other.m_top);
+    m_level_start.swap (other.m_level_start);
+  }
+
+  /**
+   *  @brief Begin iterator for all objects
+   *
+   *  After "sort", the objects are delivered in the order of the tree.
+   */
+  const_iterator begin () const
+  {
+    return m_objects.begin ();
+  }
+
+  /**
+   *  @brief End iterator for all objects
+   */
+  const_iterator end () const
+  {
+    return m_objects.end ();
+  }
+
+  /**
+   *  @brief Gets the object with the given index
+   */
+  const object_type &object (size_t index) const
+  {
+    return m_objects [index];
+  }
+
+  /**
+   *  @brief Builds the index
+   *
+   *  This method needs to be called before queries can be done. It reorders the objects.
+   *  Complexity is O(N*log(N)).
+   */
+  void sort (const BoxConv &conv)
+  {
+    tl_assert (node_size >= 8 && node_size <= 32);
+
+    invalidate ();
+    if (m_objects.empty ()) {
+      return;
+    }
+
+    std::vector<box_type> boxes;
+    boxes.reserve (m_objects.size ());
+    box_type bbox;
+    for (const_iterator o = m_objects.begin (); o != m_objects.end (); ++o) {
+      boxes.push_back (conv (*o));
+      bbox += boxes.back ();
+    }
+
+    //  order the objects along the Hilbert curve of their box centers
+    //  (mapped to a 65536x65536 grid). Empty boxes are put at the end.
+    std::vector<std::pair<unsigned int, size_t> > keys;
+    keys.reserve (boxes.size ());
+
+    double sx = bbox.width () > 0 ? 65535.0 / double (bbox.width ()) : 0.0;
+    double sy = bbox.height () > 0 ? 65535.0 / double (bbox.height ()) : 0.0;
+
+    for (size_t i = 0; i < boxes.size (); ++i) {
+      const box_type &b = boxes [i];
+      if (! b.empty ()) {
+        double cx = 0.5 * (double (b.left ()) + double (b.right ())) - double (bbox.left ());
+        double cy = 0.5 * (double (b.bottom ()) + double (b.top ())) - double (bbox.bottom ());
+        keys.push_back (std::make_pair (hilbert_index ((unsigned int) (cx * sx + 0.5), (unsigned int) (cy * sy + 0.5)), i));
+      }
+    }
+
+    std::sort (keys.begin (), keys.end ());
+
+    size_t nindexed = keys.size ();
+
+    obj_vector_type objects;
+    objects.reserve (m_objects.size ());
+
+    m_left.reserve (nindexed + nindexed / (node_size - 1) + 1);
+    m_bottom.reserve (m_left.capacity ());
+    m_right.reserve (m_left.capacity ());
+    m_top.reserve (m_left.capacity ());
+
+    for (std::vector<std::pair<unsigned int, size_t> >::const_iterator k = keys.begin (); k != keys.end (); ++k) {
+      objects.push_back (m_objects [k->second]);
+      add_box (boxes [k->second]);
+    }
+
+    for (size_t i = 0; i < boxes.size (); ++i) {
+      if (boxes [i].empty ()) {
+        objects.push_back (m_objects [i]);
+      }
+    }
+
+    m_objects.swap (objects);
+
+    if (nindexed == 0) {
+      return;
+    }
+
+    //  build the node levels bottom-up until a single root node is left
+    m_level_start.push_back (0);
+    m_level_start.push_back (nindexed);
+
+    size_t from = 0;
+    size_t n = nindexed;
+
+    while (n > 1) {
+
+      size_t nn = (n + node_size - 1) / node_size;
+
+      for (size_t i = 0; i < nn; ++i) {
+        size_t c = from + i * node_size;
+        size_t cend = std::min (from + n, c + node_size);
+        box_type b;
+        for ( ; c != cend; ++c) {
+          b += box_type (m_left [c], m_bottom [c], m_right [c], m_top [c]);
+        }
+        add_box (b);
+      }
+
+      from += n;
+      n = nn;
+      m_level_start.push_back (from + n);
+
+    }
+  }
+
+  /**
+   *  @brief Begins a region query delivering all objects touching the given box
+   */
+  touching_iterator begin_touching (const box_type &b, const BoxConv & /*conv*/) const
+  {
+    return touching_iterator (*this, b);
+  }
+
+  /**
+   *  @brief Begins a region query delivering all objects overlapping the given box
+   */
+  overlapping_iterator begin_overlapping (const box_type &b, const BoxConv & /*conv*/) const
+  {
+    return overlapping_iterator (*this, b);
+  }
+
+  /**
+   *  @brief Gets the number of levels of the tree
+   *
+   *  Level 0 are the objects, the highest level is the root node.
+   *  The number of levels is 0 if the tree is not sorted.
+   */
+  unsigned int levels () const
+  {
+    return m_level_start.empty () ? 0 : (unsigned int) (m_level_start.size () - 1);
+  }
+
+  /**
+   *  @brief Scans up to node_size entries of the given level starting with "from"
+   *
+   *  Returns a bit mask of the entries selected by Sel for the given box.
+   *  This method is used by the iterators.
+   */
+  template <class Sel>
+  unsigned int scan (unsigned int level, size_t from, const box_type &box) const
+  {
+    size_t offset = m_level_start [level] + from;
+    size_t n = std::min (size_t (node_size), m_level_start [level + 1] - offset);
+
+    const coord_type *l = &m_left [offset];
+    const coord_type *b = &m_bottom [offset];
+    const coord_type *r = &m_right [offset];
+    const coord_type *t = &m_top [offset];
+
+    coord_type ql = box.left (), qb = box.bottom (), qr = box.right (), qt = box.top ();
+
+    unsigned int mask = 0;
+    for (size_t i = 0; i < n; ++i) {
+      mask |= (unsigned int) Sel::test (l [i], b [i], r [i], t [i], ql, qb, qr, qt) << i;
+    }
+
+    return mask;
+  }
+
+  /**
+   *  @brief Collects memory statistics
+   */
+  void mem_stat (MemStatistics *stat, MemStatistics::purpose_t purpose, int cat, bool no_self = false, void *parent = 0) const
+  {
+    if (! no_self) {
+      stat->add (typeid (*this), (void *) this, sizeof (*this), sizeof (*this), parent, purpose, cat);
+    }
+    db::mem_stat (stat, purpose, cat, m_objects, true, (void *) this);
+    db::mem_stat (stat, purpose, cat, m_left, true, (void *) this);
+    db::mem_stat (stat, purpose, cat, m_bottom, true, (void *) this);
+    db::mem_stat (stat, purpose, cat, m_right, true, (void *) this);
+    db::mem_stat (stat, purpose, cat, m_top, true, (void *) this);
+    db::mem_stat (stat, purpose, cat, m_level_start, true, (void *) this);
+  }
+
+private:
+  obj_vector_type m_objects;
+  std::vector<coord_type> m_left, m_bottom, m_right, m_top;
+  std::vector<size_t> m_level_start;
+
+  void invalidate ()
+  {
+    m_left.clear ();
+    m_bottom.clear ();
+    m_right.clear ();
+    m_top.clear ();
+    m_level_start.clear ();
+  }
+
+  void add_box (const box_type &b)
+  {
+    m_left.push_back (b.left ());
+    m_bottom.push_back (b.bottom ());
+    m_right.push_back (b.right ());
+    m_top.push_back (b.top ());
+  }
+
+  static unsigned int hilbert_index (unsigned int x, unsigned int y)
+  {
+    const unsigned int n = 65536;
+
+    unsigned int d = 0;
+    for (unsigned int s = n / 2; s > 0; s /= 2) {
+      unsigned int rx = (x & s) > 0 ? 1 : 0;
+      unsigned int ry = (y & s) > 0 ? 1 : 0;
+      d += s * s * ((3 * rx) ^ ry);
+      if (ry == 0) {
+        if (rx == 1) {
+          x = n - 1 - x;
+          y = n - 1 - y;
+        }
+        std::swap (x, y);
+      }
+    }
+
+    return d;
+  }
+};
+
+/**
+ *  @brief Collects memory statistics
+ */
+template <class Box, class Obj, class BoxConv, unsigned int NodeSize>
+inline void mem_stat (MemStatistics *stat, MemStatistics::purpose_t purpose, int cat, const packed_box_tree<Box, Obj, BoxConv, NodeSize> &x, bool no_self = false, void *parent = 0)
+{
+  x.mem_stat (stat, purpose, cat, no_self, parent);
+}
+
+}
+
+#endif
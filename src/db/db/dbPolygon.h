@@ -35,12 +35,16 @@
 #include "dbBox.h"
 #include "dbObjectTag.h"
 #include "dbShapeRepository.h"
+#include "dbContourAllocator.h"
 #include "tlTypeTraits.h"
 #include "tlVector.h"
 #include "tlAlgorithm.h"
 #include "tlAssert.h"
 
 #include <cstddef>
+#include <cstring>
+#include <new>
+#include <limits>
 #include <string>
 #include <vector>
 #include <iterator>
@@ -74,6 +78,22 @@ inline bool default_compression<db::DCoord> ()
   return false;
 }
 
+// define whether contours may use the compact representation:
+// points are stored as short offsets to a reference point if possible.
+// This is only available for integer coordinates.
+
+template<class X> 
+inline bool allows_compact_contours () 
+{
+  return false;
+}
+
+template<> 
+inline bool allows_compact_contours<db::Coord> () 
+{
+  return true;
+}
+
 /**
  *  @brief A "closed" contour type 
  *
@@ -104,6 +124,15 @@ public:
   typedef tl::vector<point_type> container_type;
   typedef typename container_type::const_iterator const_iterator;
   typedef polygon_contour_iterator<polygon_contour, db::unit_trans<C> > simple_iterator;
+  typedef typename coord_traits::short_coord_type short_coord_type;
+
+  /**
+   *  @brief The point offset type of the compact representation
+   */
+  struct compact_offset
+  {
+    short_coord_type dx, dy;
+  };
 
 private:
   /**
@@ -140,10 +169,11 @@ public:
     if (d.mp_points == 0) {
       mp_points = 0;
     } else {
-      point_type *p = new point_type [m_size];
-      point_type *pp = (point_type *) ((size_t) d.mp_points & ~3);
+      size_type n = d.allocated_points ();
+      point_type *p = new_points (n);
+      point_type *pp = d.raw_points ();
       mp_points = (point_type *)((size_t) p | ((size_t) d.mp_points & 3));
-      for (unsigned int i = 0; i < m_size; ++i) {
+      for (size_type i = 0; i < n; ++i) {
         p[i] = pp[i];
       }
     }
@@ -350,7 +380,7 @@ public:
       point_type *pts;
 
       m_size = n;
-      pts = new point_type [m_size];
+      pts = new_points (m_size);
 
       //  copy distinct points now
       p = min;
@@ -382,8 +412,7 @@ public:
       }
 
       //  and store the pointer along with the hole flag
-      tl_assert (((size_t) pts & 3) == 0);
-      mp_points = (point_type *) ((size_t) pts | (hole ? 2 : 0)); 
+      store_points (pts, hole, false);
 
     } else {
 
@@ -497,7 +526,7 @@ public:
         tl_assert ((n % 2) == 0);
 
         m_size = n / 2;
-        pts = new point_type [m_size];
+        pts = new_points (m_size);
 
         //  determine orientation:
         //  it is that simple since we know that the segments attached to 
@@ -535,7 +564,7 @@ public:
       } else {
 
         m_size = n;
-        pts = new point_type [m_size];
+        pts = new_points (m_size);
 
         //  copy distinct points now
         n = 0;
@@ -587,8 +616,7 @@ public:
       }
 
       //  and store the pointer along with two flags: ortho mode and hole flag
-      tl_assert (((size_t) pts & 3) == 0);
-      mp_points = (point_type *) ((size_t) pts | (hole ? 2 : 0) | (ortho ? 1 : 0)); 
+      store_points (pts, hole, ortho);
 
     }
   }
@@ -606,9 +634,14 @@ public:
    */
   polygon_contour<C> &move (const vector_type &d)
   {
-    point_type *p = (point_type *) ((size_t) mp_points & ~3);
-    for (size_type i = 0; i < m_size; ++i, ++p) {
+    point_type *p = raw_points ();
+    if (is_compact ()) {
+      //  only the reference point needs to be moved
       *p += d;
+    } else {
+      for (size_type i = 0; i < m_size; ++i, ++p) {
+        *p += d;
+      }
     }
     return *this;
   }
@@ -729,12 +762,13 @@ public:
     if (((size_t) mp_points & 1) != 0) {
       return true;
     }
-    if (m_size < 2) {
+    size_type n = stored_size ();
+    if (n < 2) {
       return false;
     }
-    point_type pl = mp_points [m_size - 1];
-    for (size_t i = 0; i < m_size; ++i) {
-      point_type p = mp_points [i];
+    point_type pl = stored_point (n - 1);
+    for (size_type i = 0; i < n; ++i) {
+      point_type p = stored_point (i);
       if (! coord_traits::equals (p.x (), pl.x ()) && ! coord_traits::equals (p.y (), pl.y ())) {
         return false;
       }
@@ -813,19 +847,18 @@ public:
   point_type operator[] (size_type index) const
   {
     size_t f = (size_t) mp_points;
-    point_type *pts = (point_type *) (f & ~3);
     if ((f & 1) != 0) {
       if ((index & 1) != 0) {
         if ((f & 2) != 0) {
-          return point_type (pts [((index + 1) / 2) % m_size].x (), pts [(index - 1) / 2].y ());
+          return point_type (stored_point (((index + 1) / 2) % stored_size ()).x (), stored_point ((index - 1) / 2).y ());
         } else {
-          return point_type (pts [(index - 1) / 2].x (), pts [((index + 1) / 2) % m_size].y ());
+          return point_type (stored_point ((index - 1) / 2).x (), stored_point (((index + 1) / 2) % stored_size ()).y ());
         }
       } else {
-        return pts [index / 2];
+        return stored_point (index / 2);
       }
     } else {
-      return pts [index];
+      return stored_point (index);
     }
   }
 
@@ -854,12 +887,25 @@ public:
   size_type size () const 
   {
     if ((size_t) mp_points & 1) {
-      return m_size * 2;
+      return stored_size () * 2;
     } else {
-      return m_size;
+      return stored_size ();
     }
   }
 
+  /**
+   *  @brief Returns true, if the contour uses the compact representation
+   *
+   *  In the compact representation, the points are stored as short offsets
+   *  to a reference point. This representation is chosen automatically for
+   *  integer contours with more than two stored points if the offsets fit
+   *  into the short coordinate type.
+   */
+  bool is_compact () const
+  {
+    return (m_size & compact_flag) != 0;
+  }
+
   /**
    *  @brief Compute the bounding box
    *
@@ -871,9 +917,9 @@ public:
   box_type bbox () const
   {
     box_type box;
-    point_type *p = (point_type *) ((size_t) mp_points & ~3);
-    for (size_type i = 0; i < m_size; ++i, ++p) {
-      box += *p;
+    size_type n = stored_size ();
+    for (size_type i = 0; i < n; ++i) {
+      box += stored_point (i);
     }
     return box;
   }
@@ -1003,22 +1049,146 @@ public:
     if (! no_self) {
       stat->add (typeid (*this), (void *) this, sizeof (*this), sizeof (*this), parent, purpose, cat);
     }
-    stat->add (typeid (point_type []), (void *) mp_points, sizeof (point_type) * m_size, sizeof (point_type) * m_size, (void *) this, purpose, cat);
+    if (is_compact ()) {
+      //  report compact contours separately, so their share becomes visible
+      size_t used = sizeof (point_type) + sizeof (compact_offset) * stored_size ();
+      stat->add (typeid (compact_offset []), (void *) raw_points (), sizeof (point_type) * allocated_points (), used, (void *) this, purpose, cat);
+    } else {
+      stat->add (typeid (point_type []), (void *) raw_points (), sizeof (point_type) * m_size, sizeof (point_type) * m_size, (void *) this, purpose, cat);
+    }
   }
 
 private:
   point_type *mp_points;
   size_type m_size;
 
+  //  the most significant bit of m_size indicates the compact representation
+  static const size_type compact_flag = size_type (1) << (sizeof (size_type) * 8 - 1);
+
   void release ()
   {
-    point_type *p = (point_type *) ((size_t) mp_points & ~3);
+    point_type *p = raw_points ();
     if (p) {
-      delete [] p;
+      delete_points (p, allocated_points ());
     }
     mp_points = 0;
     m_size = 0;
   }
+
+  /**
+   *  @brief Allocates the point array
+   *
+   *  Point arrays are allocated through the contour allocator which pools small blocks
+   *  per thread. The points are not initialized.
+   */
+  static point_type *new_points (size_type n)
+  {
+    point_type *p = (point_type *) allocate_contour_points (n * sizeof (point_type));
+    for (size_type i = 0; i < n; ++i) {
+      new (p + i) point_type ();
+    }
+    return p;
+  }
+
+  static void delete_points (point_type *p, size_type n)
+  {
+    for (size_type i = 0; i < n; ++i) {
+      p [i].~point_type ();
+    }
+    release_contour_points ((void *) p, n * sizeof (point_type));
+  }
+
+  point_type *raw_points () const
+  {
+    return (point_type *) ((size_t) mp_points & ~3);
+  }
+
+  size_type stored_size () const
+  {
+    return m_size & ~compact_flag;
+  }
+
+  /**
+   *  @brief Gets the number of point_type slots allocated for the stored points
+   *
+   *  A compact contour uses one slot for the reference point followed by the offsets.
+   */
+  size_type allocated_points () const
+  {
+    if (is_compact ()) {
+      return compact_slots (stored_size ());
+    } else {
+      return m_size;
+    }
+  }
+
+  static size_type compact_slots (size_type n)
+  {
+    return 1 + (n * sizeof (compact_offset) + sizeof (point_type) - 1) / sizeof (point_type);
+  }
+
+  /**
+   *  @brief Gets the stored point with the given index
+   */
+  point_type stored_point (size_type i) const
+  {
+    const point_type *p = raw_points ();
+    if (is_compact ()) {
+      compact_offset o;
+      memcpy ((void *) &o, (const void *) ((const char *) (p + 1) + i * sizeof (compact_offset)), sizeof (compact_offset));
+      return point_type (p->x () + o.dx, p->y () + o.dy);
+    } else {
+      return p [i];
+    }
+  }
+
+  /**
+   *  @brief Takes over the points and sets the flags
+   *
+   *  "pts" needs to be allocated with new_points and hold m_size points.
+   *  If possible, the points are converted into the compact representation.
+   */
+  void store_points (point_type *pts, bool hole, bool ortho)
+  {
+    //  NOTE: with up to three points, the compact representation does not save memory
+    if (m_size > 3 && allows_compact_contours<C> ()) {
+
+      box_type bx;
+      for (size_type i = 0; i < m_size; ++i) {
+        bx += pts [i];
+      }
+
+      //  use the box center as the reference point, so the offsets span the full range of the short type
+      point_type ref (coord_type (((area_type) bx.left () + (area_type) bx.right ()) / 2), coord_type (((area_type) bx.bottom () + (area_type) bx.top ()) / 2));
+
+      const area_type smin = (area_type) std::numeric_limits<short_coord_type>::min ();
+      const area_type smax = (area_type) std::numeric_limits<short_coord_type>::max ();
+
+      if ((area_type) bx.left () - (area_type) ref.x () >= smin && (area_type) bx.right () - (area_type) ref.x () <= smax &&
+          (area_type) bx.bottom () - (area_type) ref.y () >= smin && (area_type) bx.top () - (area_type) ref.y () <= smax) {
+
+        point_type *cpts = new_points (compact_slots (m_size));
+        cpts [0] = ref;
+
+        char *d = (char *) (cpts + 1);
+        for (size_type i = 0; i < m_size; ++i, d += sizeof (compact_offset)) {
+          compact_offset o;
+          o.dx = short_coord_type (pts [i].x () - ref.x ());
+          o.dy = short_coord_type (pts [i].y () - ref.y ());
+          memcpy ((void *) d, (const void *) &o, sizeof (compact_offset));
+        }
+
+        delete_points (pts, m_size);
+        pts = cpts;
+        m_size |= compact_flag;
+
+      }
+
+    }
+
+    tl_assert (((size_t) pts & 3) == 0);
+    mp_points = (point_type *) ((size_t) pts | (hole ? 2 : 0) | (ortho ? 1 : 0));
+  }
 };
 
 }
@@ -386,6 +386,25 @@ public:
     return mp_delegate->base_verbosity ();
   }
 
+  /**
+   *  @brief Sets the number of threads to use for flat merge, size and boolean operations
+   *
+   *  With 0 or 1 threads (the default), the edge processor runs single-threaded.
+   *  In binary operations, the setting of the first argument is considered.
+   */
+  void set_threads (unsigned int n)
+  {
+    mp_delegate->set_threads (n);
+  }
+
+  /**
+   *  @brief Gets the number of threads to use for flat operations
+   */
+  unsigned int threads () const
+  {
+    return mp_delegate->threads ();
+  }
+
   /**
    *  @brief Enable progress reporting
    *
@@ -897,6 +916,29 @@ public:
     return EdgePairs (mp_delegate->angle_check (min, max, inverse));
   }
 
+  /**
+   *  @brief Performs a density check
+   *
+   *  The density is computed within windows of size wx x wy which are placed
+   *  in steps of sx and sy, starting at the lower left corner of the boundary's
+   *  bounding box. If the boundary is empty, the bounding box of the region is
+   *  used. Windows extending beyond that box are clipped. With a non-rectangular
+   *  boundary, only the windows overlapping the boundary are considered.
+   *
+   *  The density is the covered area divided by the area of the window.
+   *  The method returns the window boxes with a density between min_density and
+   *  max_density (both inclusive) or, if inverse is true, the ones outside this
+   *  range.
+   *
+   *  Merged semantics applies. On deep regions the computation is done
+   *  hierarchically and with the threads of the deep shape store, on flat
+   *  regions with the threads set with "set_threads".
+   */
+  Region density_check (db::Coord wx, db::Coord wy, db::Coord sx, db::Coord sy, double min_density, double max_density, bool inverse, const Region &boundary) const
+  {
+    return Region (mp_delegate->density_check (wx, wy, sx, sy, min_density, max_density, inverse, boundary));
+  }
+
   /**
    *  @brief Grid-snaps the region
    *
@@ -31,6 +31,7 @@ namespace db
 RegionDelegate::RegionDelegate ()
 {
   m_base_verbosity = 30;
+  m_threads = 0;
   m_report_progress = false;
   m_merged_semantics = true;
   m_strict_handling = false;
@@ -48,6 +49,7 @@ RegionDelegate::operator= (const RegionDelegate &other)
 {
   if (this != &other) {
     m_base_verbosity = other.m_base_verbosity;
+    m_threads = other.m_threads;
     m_report_progress = other.m_report_progress;
     m_merged_semantics = other.m_merged_semantics;
     m_strict_handling = other.m_strict_handling;
@@ -77,6 +79,11 @@ void RegionDelegate::set_base_verbosity (int vb)
   m_base_verbosity = vb;
 }
 
+void RegionDelegate::set_threads (unsigned int n)
+{
+  m_threads = n;
+}
+
 void RegionDelegate::set_min_coherence (bool f)
 {
   if (f != m_merge_min_coherence) {
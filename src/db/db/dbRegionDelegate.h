@@ -187,6 +187,12 @@ public:
     return m_base_verbosity;
   }
 
+  void set_threads (unsigned int n);
+  unsigned int threads () const
+  {
+    return m_threads;
+  }
+
   void enable_progress (const std::string &progress_desc);
   void disable_progress ();
 
@@ -235,6 +241,7 @@ public:
   virtual EdgePairsDelegate *inside_check (const Region &other, db::Coord d, bool whole_edges, metrics_type metrics, double ignore_angle, distance_type min_projection, distance_type max_projection) const = 0;
   virtual EdgePairsDelegate *grid_check (db::Coord gx, db::Coord gy) const = 0;
   virtual EdgePairsDelegate *angle_check (double min, double max, bool inverse) const = 0;
+  virtual RegionDelegate *density_check (db::Coord wx, db::Coord wy, db::Coord sx, db::Coord sy, double min_density, double max_density, bool inverse, const Region &boundary) const = 0;
 
   virtual RegionDelegate *snapped_in_place (db::Coord gx, db::Coord gy) = 0;
   virtual RegionDelegate *snapped (db::Coord gx, db::Coord gy) = 0;
@@ -315,6 +322,7 @@ private:
   bool m_report_progress;
   std::string m_progress_desc;
   int m_base_verbosity;
+  unsigned int m_threads;
 };
 
 }
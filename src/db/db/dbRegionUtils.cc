@@ -22,7 +22,11 @@
 
 
 #include "dbRegionUtils.h"
+#include "dbPolygonTools.h"
+#include "dbClip.h"
 #include "tlSelect.h"
+#include "tlMath.h"
+#include "tlThreadedWorkers.h"
 
 namespace db
 {
@@ -494,4 +498,195 @@ scaled_and_snapped_vector (const db::Vector &v, db::Coord gx, db::Coord mx, db::
   return db::Vector (db::Coord (x), db::Coord (y));
 }
 
+// -------------------------------------------------------------------------------------
+//  Density check
+
+namespace
+{
+
+/**
+ *  @brief A task rasterizing one stripe of the density map
+ */
+class DensityRasterTask
+  : public tl::Task
+{
+public:
+  typedef db::AreaMap::area_type area_type;
+
+  DensityRasterTask (const std::pair<db::RecursiveShapeIterator, db::ICplxTrans> *source, const db::Box *extent, const db::Point &p0, const db::Vector &d, size_t nx, size_t ny, area_type *target)
+    : mp_source (source), mp_extent (extent), m_p0 (p0), m_d (d), m_nx (nx), m_ny (ny), mp_target (target)
+  {
+    //  .. nothing yet ..
+  }
+
+  void perform ()
+  {
+    db::AreaMap am (m_p0, m_d, m_nx, m_ny);
+    db::Box stripe = am.bbox ();
+
+    db::RecursiveShapeIterator iter (mp_source->first);
+    iter.confine_region (stripe.transformed (mp_source->second.inverted ()));
+
+    db::Polygon poly;
+    std::vector<db::Polygon> clipped;
+
+    for ( ; ! iter.at_end (); ++iter) {
+
+      if (! (iter.shape ().is_polygon () || iter.shape ().is_path () || iter.shape ().is_box ())) {
+        continue;
+      }
+
+      iter.shape ().polygon (poly);
+      poly.transform (mp_source->second * iter.trans (), false);
+
+      //  rasterize only clips at the stripe, so clip at the extent here if required
+      if (poly.box ().inside (*mp_extent)) {
+        db::rasterize (poly, am);
+      } else {
+        clipped.clear ();
+        db::clip_poly (poly, *mp_extent, clipped, false);
+        for (std::vector<db::Polygon>::const_iterator p = clipped.begin (); p != clipped.end (); ++p) {
+          db::rasterize (*p, am);
+        }
+      }
+
+    }
+
+    area_type *t = mp_target;
+    for (size_t y = 0; y < m_ny; ++y) {
+      for (size_t x = 0; x < m_nx; ++x) {
+        *t++ = am.get (x, y);
+      }
+    }
+  }
+
+private:
+  const std::pair<db::RecursiveShapeIterator, db::ICplxTrans> *mp_source;
+  const db::Box *mp_extent;
+  db::Point m_p0;
+  db::Vector m_d;
+  size_t m_nx, m_ny;
+  area_type *mp_target;
+};
+
+class DensityRasterWorker
+  : public tl::Worker
+{
+public:
+  DensityRasterWorker ()
+    : tl::Worker ()
+  {
+    //  .. nothing yet ..
+  }
+
+  void perform_task (tl::Task *task)
+  {
+    static_cast<DensityRasterTask *> (task)->perform ();
+  }
+};
+
+}
+
+void
+compute_density_windows (const std::pair<db::RecursiveShapeIterator, db::ICplxTrans> &source, const db::Box &extent, db::Coord wx, db::Coord wy, db::Coord sx, db::Coord sy, double min_density, double max_density, bool inverse, unsigned int threads, std::vector<db::Box> &windows)
+{
+  typedef db::AreaMap::area_type area_type;
+
+  if (wx <= 0 || wy <= 0 || sx <= 0 || sy <= 0) {
+    throw tl::Exception (tl::to_string (tr ("Window size and step must be positive values for the density check")));
+  }
+
+  if (extent.empty () || extent.area () == 0) {
+    return;
+  }
+
+  //  The pixel size is chosen such that each window is made from full pixels
+  db::Coord px = tl::gcd (wx, sx);
+  db::Coord py = tl::gcd (wy, sy);
+
+  db::Coord w = extent.width (), h = extent.height ();
+  size_t npx = size_t ((w + px - 1) / px);
+  size_t npy = size_t ((h + py - 1) / py);
+
+  std::vector<area_type> pixels (npx * npy, area_type (0));
+
+  //  initializes the iterator's layout or shape container before the workers use them
+  source.first.at_end ();
+
+  size_t rows_per_stripe = npy;
+  if (threads > 0) {
+    rows_per_stripe = std::max (size_t (1), (npy + threads * 4 - 1) / (threads * 4));
+  }
+
+  if (rows_per_stripe >= npy) {
+
+    DensityRasterTask task (&source, &extent, extent.p1 (), db::Vector (px, py), npx, npy, &pixels.front ());
+    task.perform ();
+
+  } else {
+
+    tl::Job<DensityRasterWorker> job ((int) threads);
+
+    for (size_t r = 0; r < npy; r += rows_per_stripe) {
+      size_t nr = std::min (rows_per_stripe, npy - r);
+      db::Point p0 = extent.p1 () + db::Vector (0, db::Coord (r) * py);
+      job.schedule (new DensityRasterTask (&source, &extent, p0, db::Vector (px, py), npx, nr, &pixels.front () + r * npx));
+    }
+
+    try {
+      job.start ();
+      job.wait ();
+    } catch (...) {
+      job.terminate ();
+      throw;
+    }
+
+    if (job.has_error ()) {
+      throw tl::Exception (job.error_messages ().front ());
+    }
+
+  }
+
+  //  Turn the pixels into a summed-area table so the window sums are O(1)
+  std::vector<area_type> sums ((npx + 1) * (npy + 1), area_type (0));
+  for (size_t y = 0; y < npy; ++y) {
+    area_type row = 0;
+    for (size_t x = 0; x < npx; ++x) {
+      row += pixels [y * npx + x];
+      sums [(y + 1) * (npx + 1) + x + 1] = sums [y * (npx + 1) + x + 1] + row;
+    }
+  }
+
+  size_t nwx = w <= wx ? 1 : size_t ((w - wx + sx - 1) / sx) + 1;
+  size_t nwy = h <= wy ? 1 : size_t ((h - wy + sy - 1) / sy) + 1;
+
+  for (size_t j = 0; j < nwy; ++j) {
+
+    db::Coord y = db::Coord (j) * sy;
+    size_t r0 = size_t (y / py);
+    size_t r1 = std::min (npy, size_t ((y + wy) / py));
+
+    for (size_t i = 0; i < nwx; ++i) {
+
+      db::Coord x = db::Coord (i) * sx;
+      size_t c0 = size_t (x / px);
+      size_t c1 = std::min (npx, size_t ((x + wx) / px));
+
+      db::Box window = db::Box (extent.p1 () + db::Vector (x, y), extent.p1 () + db::Vector (x + wx, y + wy)) & extent;
+      if (window.empty () || window.area () == 0) {
+        continue;
+      }
+
+      area_type covered = sums [r1 * (npx + 1) + c1] - sums [r0 * (npx + 1) + c1] - sums [r1 * (npx + 1) + c0] + sums [r0 * (npx + 1) + c0];
+      double density = std::min (1.0, double (covered) / double (window.area ()));
+
+      if ((density >= min_density && density <= max_density) != inverse) {
+        windows.push_back (window);
+      }
+
+    }
+
+  }
+}
+
 }
@@ -601,6 +601,27 @@ DB_PUBLIC db::Polygon scaled_and_snapped_polygon (const db::Polygon &poly, db::C
  */
 DB_PUBLIC db::Vector scaled_and_snapped_vector (const db::Vector &v, db::Coord gx, db::Coord mx, db::Coord dx, db::Coord ox, db::Coord gy, db::Coord my, db::Coord dy, db::Coord oy);
 
+/**
+ *  @brief Computes the density check windows for a polygon source
+ *
+ *  The polygons are delivered by the recursive shape iterator and the transformation
+ *  given by "source". The windows have a size of wx x wy and are placed in steps of
+ *  sx, sy starting at the lower left corner of "extent". Windows extending beyond
+ *  the extent are clipped at the extent.
+ *
+ *  The density of a window is the area covered by the polygons inside the window
+ *  divided by the window's area. The polygons should be merged, otherwise overlapping
+ *  areas are counted multiple times (the density is limited to 1.0 however).
+ *
+ *  Windows with a density of min_density <= density <= max_density are delivered in
+ *  "windows" (or the ones outside this range if "inverse" is true).
+ *
+ *  The polygons are rasterized with db::rasterize into pixels of gcd(wx, sx) x gcd(wy, sy).
+ *  If "threads" is non-zero, the rasterization is done in horizontal stripes using the given
+ *  number of worker threads.
+ */
+DB_PUBLIC void compute_density_windows (const std::pair<db::RecursiveShapeIterator, db::ICplxTrans> &source, const db::Box &extent, db::Coord wx, db::Coord wy, db::Coord sx, db::Coord sy, double min_density, double max_density, bool inverse, unsigned int threads, std::vector<db::Box> &windows);
+
 } // namespace db
 
 #endif
@@ -30,8 +30,11 @@
 #include "dbTrans.h"
 #include "dbBox.h"
 #include "dbMemStatistics.h"
+#include "tlThreads.h"
 
 #include <set>
+#include <vector>
+#include <algorithm>
 
 namespace db {
 
@@ -62,11 +65,46 @@ public:
    *  @brief The standard constructor
    */
   repository ()
-    : m_set ()
+    : m_set (), mp_lock (0)
   {
     //  .. nothing yet ..
   }
 
+  /**
+   *  @brief The copy constructor
+   *
+   *  The lock (see set_lock) is not copied.
+   */
+  repository (const repository &d)
+    : m_set (d.m_set), mp_lock (0)
+  {
+    //  .. nothing yet ..
+  }
+
+  /**
+   *  @brief Assignment
+   *
+   *  The lock (see set_lock) is not copied.
+   */
+  repository &operator= (const repository &d)
+  {
+    if (this != &d) {
+      m_set = d.m_set;
+    }
+    return *this;
+  }
+
+  /**
+   *  @brief Sets the lock used for guarding insert
+   *
+   *  If a lock is set, "insert" can be called from multiple threads.
+   *  Pass 0 to disable locking.
+   */
+  void set_lock (tl::Mutex *lock)
+  {
+    mp_lock = lock;
+  }
+
   /**
    *  @brief Insert a shape into the repository
    *
@@ -76,8 +114,30 @@ public:
    */
   const Sh *insert (const Sh &shape)
   {
-    typename std::set<Sh>::iterator f = m_set.insert (shape).first;
-    return &(*f);
+    if (mp_lock) {
+      tl::MutexLocker locker (mp_lock);
+      return &(*m_set.insert (shape).first);
+    } else {
+      return &(*m_set.insert (shape).first);
+    }
+  }
+
+  /**
+   *  @brief Removes the shapes not listed in "used"
+   *
+   *  "used" needs to be sorted. Pointers to the remaining shapes stay valid.
+   *  The caller is responsible for making sure that no reference to a removed
+   *  shape is left.
+   */
+  void erase_unused (const std::vector<const Sh *> &used)
+  {
+    for (typename set_type::iterator i = m_set.begin (); i != m_set.end (); ) {
+      typename set_type::iterator ii = i;
+      ++i;
+      if (! std::binary_search (used.begin (), used.end (), &*ii)) {
+        m_set.erase (ii);
+      }
+    }
   }
 
   /**
@@ -111,6 +171,7 @@ public:
 
 private:
   set_type m_set;
+  tl::Mutex *mp_lock;
 };
 
 /**
@@ -176,6 +237,19 @@ public:
     return const_cast<generic_repository<C> *> (this)->repository (tag);
   }
 
+  /**
+   *  @brief Sets the lock used for guarding insert for all repositories
+   *
+   *  See repository::set_lock for details.
+   */
+  void set_lock (tl::Mutex *lock)
+  {
+    m_polygon_repository.set_lock (lock);
+    m_simple_polygon_repository.set_lock (lock);
+    m_path_repository.set_lock (lock);
+    m_text_repository.set_lock (lock);
+  }
+
   void mem_stat (MemStatistics *stat, MemStatistics::purpose_t purpose, int cat, bool no_self, void *parent) const
   {
     db::mem_stat (stat, purpose, cat, m_polygon_repository, no_self, parent);
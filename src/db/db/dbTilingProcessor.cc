@@ -22,6 +22,7 @@
 
 
 #include "dbTilingProcessor.h"
+#include "dbWriter.h"
 
 #include "tlExpression.h"
 #include "tlProgress.h"
@@ -30,6 +31,19 @@
 #include "gsiDecl.h"
 
 #include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <iostream>
+
+#if !defined(_WIN32)
+#  include <unistd.h>
+#  include <errno.h>
+#  include <signal.h>
+#  include <poll.h>
+#  include <sys/types.h>
+#  include <sys/socket.h>
+#  include <sys/wait.h>
+#endif
 
 namespace db
 {
@@ -319,6 +333,183 @@ private:
   db::Texts *mp_texts;
 };
 
+// ----------------------------------------------------------------------------------
+//  TileOutputStreamWriter implementation
+
+TileOutputStreamWriter::TileOutputStreamWriter (tl::OutputStream &stream, const db::SaveLayoutOptions &options, double dbu, const std::string &top_cell_name, size_t max_shapes)
+  : mp_stream (&stream), m_options (options), m_top_cell_name (top_cell_name), m_max_shapes (max_shapes), m_buffered_shapes (0), m_finished (false)
+{
+  if (m_options.format () != "GDS2") {
+    throw tl::Exception (tl::to_string (tr ("Streaming tile output is only supported for GDS2 format, not for ")) + m_options.format ());
+  }
+
+  //  we write all cells and layers of the buffer and the chunk cells are referenced by
+  //  the top cell through empty ghost cells
+  m_options.select_all_cells ();
+  m_options.select_all_layers ();
+  m_options.set_dont_write_empty_cells (false);
+  m_options.set_write_context_info (false);
+
+  m_buffer.dbu (dbu);
+  m_chunk_cell = m_buffer.add_cell (m_top_cell_name.c_str ());
+}
+
+void
+TileOutputStreamWriter::set_dbu (double dbu)
+{
+  tl_assert (m_chunks.empty ());
+  m_buffer.dbu (dbu);
+}
+
+unsigned int
+TileOutputStreamWriter::add_layer (const db::LayerProperties &lp)
+{
+  unsigned int layer = m_buffer.insert_layer (lp);
+  if (m_shape_counts.size () <= size_t (layer)) {
+    m_shape_counts.resize (layer + 1, 0);
+  }
+  return layer;
+}
+
+void
+TileOutputStreamWriter::commit (unsigned int layer, size_t n)
+{
+  m_shape_counts [layer] += n;
+  m_buffered_shapes += n;
+  if (m_buffered_shapes >= m_max_shapes) {
+    flush ();
+  }
+}
+
+size_t
+TileOutputStreamWriter::shape_count (unsigned int layer) const
+{
+  return layer < m_shape_counts.size () ? m_shape_counts [layer] : 0;
+}
+
+void
+TileOutputStreamWriter::flush ()
+{
+  if (m_buffered_shapes == 0) {
+    return;
+  }
+
+  std::string name = m_top_cell_name + "$" + tl::to_string (m_chunks.size () + 1);
+  m_buffer.rename_cell (m_chunk_cell, name.c_str ());
+
+  write (m_chunks.empty (), false);
+  m_chunks.push_back (name);
+
+  //  start over with a fresh buffer cell
+  m_buffer.delete_cell (m_chunk_cell);
+  m_chunk_cell = m_buffer.add_cell (m_top_cell_name.c_str ());
+  m_buffered_shapes = 0;
+}
+
+void
+TileOutputStreamWriter::finish ()
+{
+  if (m_finished) {
+    return;
+  }
+
+  m_finished = true;
+
+  if (m_chunks.empty ()) {
+    //  everything fits into the buffer: write it as a single layout
+    write (true, true);
+    return;
+  }
+
+  flush ();
+
+  //  write the top cell with references to the chunk cells written before
+  m_buffer.delete_cell (m_chunk_cell);
+  m_chunk_cell = m_buffer.add_cell (m_top_cell_name.c_str ());
+
+  for (std::vector<std::string>::const_iterator c = m_chunks.begin (); c != m_chunks.end (); ++c) {
+    db::cell_index_type ci = m_buffer.add_cell (c->c_str ());
+    m_buffer.cell (ci).set_ghost_cell (true);
+    m_buffer.cell (m_chunk_cell).insert (db::CellInstArray (db::CellInst (ci), db::Trans ()));
+  }
+
+  write (false, true);
+}
+
+void
+TileOutputStreamWriter::write (bool with_header, bool with_trailer)
+{
+  tl::OutputMemoryStream mem;
+
+  {
+    tl::OutputStream os (mem);
+    db::Writer writer (m_options);
+    writer.write (m_buffer, os);
+    os.flush ();
+  }
+
+  //  GDS2 files are a sequence of records: header records, the structures (starting with BGNSTR)
+  //  and ENDLIB. We take the header from the first piece and the ENDLIB from the last one.
+
+  const unsigned char *d = (const unsigned char *) mem.data ();
+  size_t n = mem.size ();
+
+  size_t body_begin = n, body_end = n;
+  size_t pos = 0;
+  while (pos + 4 <= n) {
+
+    size_t len = (size_t (d [pos]) << 8) | size_t (d [pos + 1]);
+    if (len < 4) {
+      //  padding
+      break;
+    }
+
+    unsigned char rec = d [pos + 2];
+    if (rec == 0x05 /*BGNSTR*/ && body_begin == n) {
+      body_begin = pos;
+    } else if (rec == 0x04 /*ENDLIB*/) {
+      body_end = pos;
+      break;
+    }
+
+    pos += len;
+
+  }
+
+  if (body_begin > body_end) {
+    body_begin = body_end;
+  }
+
+  size_t from = with_header ? 0 : body_begin;
+  size_t to = with_trailer ? n : body_end;
+
+  mp_stream->put ((const char *) d + from, to - from);
+}
+
+// ----------------------------------------------------------------------------------
+//  TileStreamOutputReceiver implementation
+
+TileStreamOutputReceiver::TileStreamOutputReceiver (TileOutputStreamWriter *writer, unsigned int layer, db::Coord ep_ext)
+  : mp_writer (writer), m_layer (layer), m_ep_sizing (ep_ext)
+{
+  //  .. nothing yet ..
+}
+
+void
+TileStreamOutputReceiver::put (size_t /*ix*/, size_t /*iy*/, const db::Box &tile, size_t /*id*/, const tl::Variant &obj, double dbu, const db::ICplxTrans &trans, bool clip)
+{
+  db::ICplxTrans t (db::ICplxTrans (dbu / mp_writer->dbu ()) * trans);
+  db::Shapes &shapes = mp_writer->shapes (m_layer);
+  size_t n = shapes.size ();
+
+  ShapesInserter inserter (&shapes, t, m_ep_sizing);
+  insert_var (inserter, obj, tile, clip);
+
+  mp_writer->commit (m_layer, shapes.size () - n);
+}
+
+// ----------------------------------------------------------------------------------
+
 class TilingProcessorJob
   : public tl::JobBase
 {
@@ -601,6 +792,953 @@ TilingProcessorJob::create_worker ()
   return new TilingProcessorWorker (this);
 }
 
+#if !defined(_WIN32)
+
+// ----------------------------------------------------------------------------------
+//  Serialization of tile results for the worker processes
+
+/**
+ *  @brief Type tags of the serialized variants
+ */
+enum TilingProcessorVariantTag
+{
+  TPV_Nil = 0,
+  TPV_Bool,
+  TPV_Int,
+  TPV_UInt,
+  TPV_Double,
+  TPV_String,
+  TPV_List,
+  TPV_Array,
+  TPV_Region,
+  TPV_Edges,
+  TPV_EdgePairs,
+  TPV_Texts,
+  TPV_Polygon,
+  TPV_SimplePolygon,
+  TPV_Box,
+  TPV_Edge,
+  TPV_EdgePair,
+  TPV_Text,
+  TPV_Path
+};
+
+/**
+ *  @brief The message types sent from the worker processes to the parent
+ */
+enum TilingProcessorMessageType
+{
+  TPM_Put = 1,
+  TPM_Done,
+  TPM_Error
+};
+
+/**
+ *  @brief A writer for the binary representation of the tile results
+ *
+ *  The data is only exchanged between processes forked from the same executable,
+ *  hence the values are written in native byte order.
+ */
+class TilingProcessorRecordWriter
+{
+public:
+  TilingProcessorRecordWriter ()
+  {
+    //  .. nothing yet ..
+  }
+
+  const std::string &data () const
+  {
+    return m_data;
+  }
+
+  void write_byte (unsigned char b)
+  {
+    m_data.push_back (char (b));
+  }
+
+  template <class T>
+  void write_raw (const T &t)
+  {
+    m_data.append ((const char *) &t, sizeof (T));
+  }
+
+  void write_size (size_t n)
+  {
+    write_raw (uint64_t (n));
+  }
+
+  void write_coord (db::Coord c)
+  {
+    write_raw (c);
+  }
+
+  size_t begin_count ()
+  {
+    size_t pos = m_data.size ();
+    write_size (0);
+    return pos;
+  }
+
+  void end_count (size_t pos, size_t n)
+  {
+    uint64_t nn = uint64_t (n);
+    m_data.replace (pos, sizeof (nn), (const char *) &nn, sizeof (nn));
+  }
+
+  void write_string (const std::string &s)
+  {
+    write_size (s.size ());
+    m_data += s;
+  }
+
+  void write_point (const db::Point &p)
+  {
+    write_coord (p.x ());
+    write_coord (p.y ());
+  }
+
+  void write_box (const db::Box &b)
+  {
+    write_byte (b.empty () ? 1 : 0);
+    if (! b.empty ()) {
+      write_point (b.p1 ());
+      write_point (b.p2 ());
+    }
+  }
+
+  void write_edge (const db::Edge &e)
+  {
+    write_point (e.p1 ());
+    write_point (e.p2 ());
+  }
+
+  template <class C>
+  void write_contour (const C &c)
+  {
+    write_size (c.size ());
+    for (size_t i = 0; i < c.size (); ++i) {
+      write_point (c [i]);
+    }
+  }
+
+  void write_polygon (const db::Polygon &p)
+  {
+    write_contour (p.hull ());
+    write_size (p.holes ());
+    for (unsigned int h = 0; h < p.holes (); ++h) {
+      write_contour (p.hole (h));
+    }
+  }
+
+  void write_text (const db::Text &t)
+  {
+    write_string (t.string ());
+    write_raw (int32_t (t.trans ().rot ()));
+    write_point (db::Point () + t.trans ().disp ());
+    write_coord (t.size ());
+    write_raw (int32_t (t.font ()));
+    write_raw (int32_t (t.halign ()));
+    write_raw (int32_t (t.valign ()));
+  }
+
+  void write_path (const db::Path &p)
+  {
+    write_coord (p.width ());
+    write_coord (p.bgn_ext ());
+    write_coord (p.end_ext ());
+    write_byte (p.round () ? 1 : 0);
+    write_size (p.points ());
+    for (db::Path::iterator pt = p.begin (); pt != p.end (); ++pt) {
+      write_point (*pt);
+    }
+  }
+
+  void write_variant (const tl::Variant &v)
+  {
+    switch (v.type_code ()) {
+    case tl::Variant::t_nil:
+      write_byte (TPV_Nil);
+      break;
+    case tl::Variant::t_bool:
+      write_byte (TPV_Bool);
+      write_byte (v.to_bool () ? 1 : 0);
+      break;
+    case tl::Variant::t_char:
+    case tl::Variant::t_schar:
+    case tl::Variant::t_short:
+    case tl::Variant::t_int:
+    case tl::Variant::t_long:
+    case tl::Variant::t_longlong:
+      write_byte (TPV_Int);
+      write_raw ((long long) v.to_longlong ());
+      break;
+    case tl::Variant::t_uchar:
+    case tl::Variant::t_ushort:
+    case tl::Variant::t_uint:
+    case tl::Variant::t_ulong:
+    case tl::Variant::t_ulonglong:
+      write_byte (TPV_UInt);
+      write_raw ((unsigned long long) v.to_ulonglong ());
+      break;
+    case tl::Variant::t_float:
+    case tl::Variant::t_double:
+      write_byte (TPV_Double);
+      write_raw (v.to_double ());
+      break;
+    case tl::Variant::t_list:
+      write_byte (TPV_List);
+      write_size (v.get_list ().size ());
+      for (tl::Variant::const_iterator i = v.begin (); i != v.end (); ++i) {
+        write_variant (*i);
+      }
+      break;
+    case tl::Variant::t_array:
+      write_byte (TPV_Array);
+      write_size (v.get_array ().size ());
+      for (tl::Variant::const_array_iterator i = v.begin_array (); i != v.end_array (); ++i) {
+        write_variant (i->first);
+        write_variant (i->second);
+      }
+      break;
+    case tl::Variant::t_user:
+    case tl::Variant::t_user_ref:
+      write_user_object (v);
+      break;
+    default:
+      if (v.is_a_string ()) {
+        write_byte (TPV_String);
+        write_string (v.to_stdstring ());
+      } else {
+        throw tl::Exception (tl::to_string (tr ("Unsupported object type for _output in a worker process: %s")), v.to_parsable_string ());
+      }
+      break;
+    }
+  }
+
+private:
+  std::string m_data;
+
+  void write_user_object (const tl::Variant &v)
+  {
+    if (v.is_user<db::Region> ()) {
+
+      const db::Region &r = v.to_user<db::Region> ();
+      write_byte (TPV_Region);
+      write_byte (r.merged_semantics () ? 1 : 0);
+      size_t pos = begin_count (), n = 0;
+      for (db::Region::const_iterator p = r.begin (); ! p.at_end (); ++p, ++n) {
+        write_polygon (*p);
+      }
+      end_count (pos, n);
+
+    } else if (v.is_user<db::Edges> ()) {
+
+      const db::Edges &e = v.to_user<db::Edges> ();
+      write_byte (TPV_Edges);
+      write_byte (e.merged_semantics () ? 1 : 0);
+      size_t pos = begin_count (), n = 0;
+      for (db::Edges::const_iterator i = e.begin (); ! i.at_end (); ++i, ++n) {
+        write_edge (*i);
+      }
+      end_count (pos, n);
+
+    } else if (v.is_user<db::EdgePairs> ()) {
+
+      const db::EdgePairs &ep = v.to_user<db::EdgePairs> ();
+      write_byte (TPV_EdgePairs);
+      size_t pos = begin_count (), n = 0;
+      for (db::EdgePairs::const_iterator i = ep.begin (); ! i.at_end (); ++i, ++n) {
+        write_edge (i->first ());
+        write_edge (i->second ());
+      }
+      end_count (pos, n);
+
+    } else if (v.is_user<db::Texts> ()) {
+
+      const db::Texts &t = v.to_user<db::Texts> ();
+      write_byte (TPV_Texts);
+      size_t pos = begin_count (), n = 0;
+      for (db::Texts::const_iterator i = t.begin (); ! i.at_end (); ++i, ++n) {
+        write_text (*i);
+      }
+      end_count (pos, n);
+
+    } else if (v.is_user<db::Polygon> ()) {
+      write_byte (TPV_Polygon);
+      write_polygon (v.to_user<db::Polygon> ());
+    } else if (v.is_user<db::SimplePolygon> ()) {
+      write_byte (TPV_SimplePolygon);
+      write_contour (v.to_user<db::SimplePolygon> ().hull ());
+    } else if (v.is_user<db::Box> ()) {
+      write_byte (TPV_Box);
+      write_box (v.to_user<db::Box> ());
+    } else if (v.is_user<db::Edge> ()) {
+      write_byte (TPV_Edge);
+      write_edge (v.to_user<db::Edge> ());
+    } else if (v.is_user<db::EdgePair> ()) {
+      write_byte (TPV_EdgePair);
+      write_edge (v.to_user<db::EdgePair> ().first ());
+      write_edge (v.to_user<db::EdgePair> ().second ());
+    } else if (v.is_user<db::Text> ()) {
+      write_byte (TPV_Text);
+      write_text (v.to_user<db::Text> ());
+    } else if (v.is_user<db::Path> ()) {
+      write_byte (TPV_Path);
+      write_path (v.to_user<db::Path> ());
+    } else {
+      throw tl::Exception (tl::to_string (tr ("Unsupported object type for _output in a worker process: %s")), v.to_parsable_string ());
+    }
+  }
+};
+
+/**
+ *  @brief A reader for the data produced by TilingProcessorRecordWriter
+ */
+class TilingProcessorRecordReader
+{
+public:
+  TilingProcessorRecordReader (const std::string &data)
+    : m_data (data), m_pos (0)
+  {
+    //  .. nothing yet ..
+  }
+
+  unsigned char read_byte ()
+  {
+    check (1);
+    return (unsigned char) m_data [m_pos++];
+  }
+
+  template <class T>
+  T read_raw ()
+  {
+    T t;
+    check (sizeof (T));
+    memcpy ((void *) &t, m_data.c_str () + m_pos, sizeof (T));
+    m_pos += sizeof (T);
+    return t;
+  }
+
+  size_t read_size ()
+  {
+    return size_t (read_raw<uint64_t> ());
+  }
+
+  db::Coord read_coord ()
+  {
+    return read_raw<db::Coord> ();
+  }
+
+  std::string read_string ()
+  {
+    size_t n = read_size ();
+    check (n);
+    std::string s (m_data, m_pos, n);
+    m_pos += n;
+    return s;
+  }
+
+  db::Point read_point ()
+  {
+    db::Coord x = read_coord ();
+    db::Coord y = read_coord ();
+    return db::Point (x, y);
+  }
+
+  db::Box read_box ()
+  {
+    if (read_byte ()) {
+      return db::Box ();
+    } else {
+      db::Point p1 = read_point ();
+      db::Point p2 = read_point ();
+      return db::Box (p1, p2);
+    }
+  }
+
+  db::Edge read_edge ()
+  {
+    db::Point p1 = read_point ();
+    db::Point p2 = read_point ();
+    return db::Edge (p1, p2);
+  }
+
+  void read_contour (std::vector<db::Point> &pts)
+  {
+    pts.clear ();
+    size_t n = read_size ();
+    pts.reserve (n);
+    for (size_t i = 0; i < n; ++i) {
+      pts.push_back (read_point ());
+    }
+  }
+
+  db::Polygon read_polygon ()
+  {
+    db::Polygon poly;
+    std::vector<db::Point> pts;
+    read_contour (pts);
+    poly.assign_hull (pts.begin (), pts.end (), false /*don't compress*/);
+    size_t nholes = read_size ();
+    for (size_t h = 0; h < nholes; ++h) {
+      read_contour (pts);
+      poly.insert_hole (pts.begin (), pts.end (), false /*don't compress*/);
+    }
+    return poly;
+  }
+
+  db::Text read_text ()
+  {
+    std::string s = read_string ();
+    int rot = int (read_raw<int32_t> ());
+    db::Point d = read_point ();
+    db::Coord size = read_coord ();
+    db::Font font = db::Font (read_raw<int32_t> ());
+    db::HAlign halign = db::HAlign (read_raw<int32_t> ());
+    db::VAlign valign = db::VAlign (read_raw<int32_t> ());
+    return db::Text (s, db::Trans (rot, d - db::Point ()), size, font, halign, valign);
+  }
+
+  db::Path read_path ()
+  {
+    db::Coord w = read_coord ();
+    db::Coord bx = read_coord ();
+    db::Coord ex = read_coord ();
+    bool round = (read_byte () != 0);
+    std::vector<db::Point> pts;
+    read_contour (pts);
+    return db::Path (pts.begin (), pts.end (), w, bx, ex, round);
+  }
+
+  tl::Variant read_variant ()
+  {
+    unsigned char tag = read_byte ();
+
+    switch (tag) {
+    case TPV_Nil:
+      return tl::Variant ();
+    case TPV_Bool:
+      return tl::Variant (read_byte () != 0);
+    case TPV_Int:
+      return tl::Variant (read_raw<long long> ());
+    case TPV_UInt:
+      return tl::Variant (read_raw<unsigned long long> ());
+    case TPV_Double:
+      return tl::Variant (read_raw<double> ());
+    case TPV_String:
+      return tl::Variant (read_string ());
+    case TPV_List:
+      {
+        tl::Variant v = tl::Variant::empty_list ();
+        size_t n = read_size ();
+        for (size_t i = 0; i < n; ++i) {
+          v.push (read_variant ());
+        }
+        return v;
+      }
+    case TPV_Array:
+      {
+        tl::Variant v = tl::Variant::empty_array ();
+        size_t n = read_size ();
+        for (size_t i = 0; i < n; ++i) {
+          tl::Variant k = read_variant ();
+          v.insert (k, read_variant ());
+        }
+        return v;
+      }
+    case TPV_Region:
+      {
+        db::Region r;
+        r.set_merged_semantics (read_byte () != 0);
+        size_t n = read_size ();
+        for (size_t i = 0; i < n; ++i) {
+          r.insert (read_polygon ());
+        }
+        return tl::Variant (r);
+      }
+    case TPV_Edges:
+      {
+        db::Edges e;
+        e.set_merged_semantics (read_byte () != 0);
+        size_t n = read_size ();
+        for (size_t i = 0; i < n; ++i) {
+          e.insert (read_edge ());
+        }
+        return tl::Variant (e);
+      }
+    case TPV_EdgePairs:
+      {
+        db::EdgePairs ep;
+        size_t n = read_size ();
+        for (size_t i = 0; i < n; ++i) {
+          db::Edge e1 = read_edge ();
+          db::Edge e2 = read_edge ();
+          ep.insert (e1, e2);
+        }
+        return tl::Variant (ep);
+      }
+    case TPV_Texts:
+      {
+        db::Texts t;
+        size_t n = read_size ();
+        for (size_t i = 0; i < n; ++i) {
+          t.insert (read_text ());
+        }
+        return tl::Variant (t);
+      }
+    case TPV_Polygon:
+      return tl::Variant (read_polygon ());
+    case TPV_SimplePolygon:
+      {
+        std::vector<db::Point> pts;
+        read_contour (pts);
+        db::SimplePolygon sp;
+        sp.assign_hull (pts.begin (), pts.end (), false /*don't compress*/);
+        return tl::Variant (sp);
+      }
+    case TPV_Box:
+      return tl::Variant (read_box ());
+    case TPV_Edge:
+      return tl::Variant (read_edge ());
+    case TPV_EdgePair:
+      {
+        db::Edge e1 = read_edge ();
+        db::Edge e2 = read_edge ();
+        return tl::Variant (db::EdgePair (e1, e2));
+      }
+    case TPV_Text:
+      return tl::Variant (read_text ());
+    case TPV_Path:
+      return tl::Variant (read_path ());
+    default:
+      throw tl::Exception (tl::to_string (tr ("Invalid object type received from worker process")));
+    }
+  }
+
+private:
+  const std::string &m_data;
+  size_t m_pos;
+
+  void check (size_t n) const
+  {
+    if (m_pos + n > m_data.size ()) {
+      throw tl::Exception (tl::to_string (tr ("Truncated message received from worker process")));
+    }
+  }
+};
+
+// ----------------------------------------------------------------------------------
+//  Worker processes
+
+static void
+write_to_channel (int fd, const char *data, size_t n)
+{
+  while (n > 0) {
+#if defined(MSG_NOSIGNAL)
+    ssize_t ret = send (fd, data, n, MSG_NOSIGNAL);
+#else
+    ssize_t ret = send (fd, data, n, 0);
+#endif
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw tl::Exception (tl::to_string (tr ("Unable to write to worker process channel: %s")), strerror (errno));
+    }
+    data += ret;
+    n -= size_t (ret);
+  }
+}
+
+/**
+ *  @brief Reads n bytes from the channel
+ *  Returns false if the channel was closed before any data was read.
+ */
+static bool
+read_from_channel (int fd, char *data, size_t n)
+{
+  bool any = false;
+  while (n > 0) {
+    ssize_t ret = read (fd, data, n);
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw tl::Exception (tl::to_string (tr ("Unable to read from worker process channel: %s")), strerror (errno));
+    } else if (ret == 0) {
+      if (any) {
+        throw tl::Exception (tl::to_string (tr ("Worker process channel closed unexpectedly")));
+      }
+      return false;
+    }
+    any = true;
+    data += ret;
+    n -= size_t (ret);
+  }
+  return true;
+}
+
+static void
+send_message (int fd, unsigned char type, const std::string &payload)
+{
+  std::string msg;
+  uint64_t n = uint64_t (payload.size () + 1);
+  msg.append ((const char *) &n, sizeof (n));
+  msg.push_back (char (type));
+  msg += payload;
+  write_to_channel (fd, msg.c_str (), msg.size ());
+}
+
+static bool
+receive_message (int fd, unsigned char &type, std::string &payload)
+{
+  uint64_t n = 0;
+  if (! read_from_channel (fd, (char *) &n, sizeof (n))) {
+    return false;
+  }
+  if (n == 0) {
+    throw tl::Exception (tl::to_string (tr ("Invalid message received from worker process")));
+  }
+
+  std::string msg;
+  msg.resize (size_t (n));
+  read_from_channel (fd, &msg [0], size_t (n));
+
+  type = (unsigned char) msg [0];
+  payload = std::string (msg, 1);
+  return true;
+}
+
+/**
+ *  @brief Executes the tiling processor tasks in worker processes
+ *
+ *  The worker processes are forked from the current process. Each one receives
+ *  the indexes of the tasks to execute through a socket and sends back the
+ *  objects delivered by "_output" as well as the completion state. New tasks
+ *  are handed out when a worker becomes idle, so the load is balanced dynamically.
+ */
+class TilingProcessorWorkerProcesses
+{
+public:
+  TilingProcessorWorkerProcesses (TilingProcessor *proc, bool has_tiles)
+    : mp_proc (proc), m_has_tiles (has_tiles)
+  {
+    //  .. nothing yet ..
+  }
+
+  ~TilingProcessorWorkerProcesses ()
+  {
+    shutdown (true);
+  }
+
+  static bool available (const TilingProcessor *proc, size_t ntasks)
+  {
+    if (proc->processes () <= 1 || ntasks <= 1) {
+      return false;
+    }
+
+    //  the receiver objects delivered by _rec live in the parent process
+    for (std::vector<std::string>::const_iterator s = proc->m_scripts.begin (); s != proc->m_scripts.end (); ++s) {
+      if (s->find ("_rec") != std::string::npos) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  void run (const std::vector<TilingProcessorTask *> &tasks, tl::RelativeProgress &progress)
+  {
+    size_t nworkers = std::min (mp_proc->processes (), tasks.size ());
+
+    //  flush the output buffers, so the workers won't emit the buffered output again
+    std::cout.flush ();
+    std::cerr.flush ();
+    fflush (stdout);
+    fflush (stderr);
+
+    for (size_t i = 0; i < nworkers; ++i) {
+      start_worker (tasks);
+    }
+
+    size_t next = 0, done = 0;
+    for (std::vector<WorkerSpec>::iterator w = m_workers.begin (); w != m_workers.end () && next < tasks.size (); ++w) {
+      send_task (*w, next++);
+    }
+
+    std::vector<pollfd> fds;
+    std::vector<size_t> fd_workers;
+
+    while (done < tasks.size ()) {
+
+      fds.clear ();
+      fd_workers.clear ();
+      for (size_t i = 0; i < m_workers.size (); ++i) {
+        if (m_workers [i].busy) {
+          pollfd pfd;
+          pfd.fd = m_workers [i].fd;
+          pfd.events = POLLIN;
+          pfd.revents = 0;
+          fds.push_back (pfd);
+          fd_workers.push_back (i);
+        }
+      }
+
+      if (fds.empty ()) {
+        //  all workers are gone
+        m_error_messages.push_back (tl::to_string (tr ("No worker process left to execute the remaining tasks")));
+        break;
+      }
+
+      int n = poll (&fds.front (), nfds_t (fds.size ()), 100);
+      if (n < 0 && errno != EINTR) {
+        throw tl::Exception (tl::to_string (tr ("Unable to wait for worker processes: %s")), strerror (errno));
+      }
+
+      for (size_t i = 0; i < fds.size () && n > 0; ++i) {
+
+        if ((fds [i].revents & (POLLIN | POLLHUP | POLLERR)) == 0) {
+          continue;
+        }
+
+        WorkerSpec &w = m_workers [fd_workers [i]];
+        unsigned char type = 0;
+        std::string payload;
+
+        if (! receive_message (w.fd, type, payload)) {
+
+          if (w.busy) {
+            m_error_messages.push_back (tl::sprintf (tl::to_string (tr ("Worker process terminated unexpectedly while computing tile %s")), tasks [w.task]->tile_desc ()));
+          } else {
+            m_error_messages.push_back (tl::to_string (tr ("Worker process terminated unexpectedly")));
+          }
+          close (w.fd);
+          w.fd = -1;
+          w.busy = false;
+          ++done;
+
+        } else if (type == TPM_Put) {
+
+          deliver (payload);
+
+        } else if (type == TPM_Done || type == TPM_Error) {
+
+          if (type == TPM_Error) {
+            m_error_messages.push_back (payload);
+          }
+
+          w.busy = false;
+          ++done;
+          if (next < tasks.size ()) {
+            send_task (w, next++);
+          }
+
+        } else {
+          throw tl::Exception (tl::to_string (tr ("Invalid message received from worker process")));
+        }
+
+      }
+
+      //  This may throw an exception, if the cancel button has been pressed.
+      progress.set (done, true /*force yield*/);
+
+    }
+
+    shutdown (false);
+  }
+
+  bool has_error () const
+  {
+    return ! m_error_messages.empty ();
+  }
+
+  const std::vector<std::string> &error_messages () const
+  {
+    return m_error_messages;
+  }
+
+private:
+  struct WorkerSpec
+  {
+    WorkerSpec () : pid (0), fd (-1), busy (false), task (0) { }
+    pid_t pid;
+    int fd;
+    bool busy;
+    size_t task;
+  };
+
+  TilingProcessor *mp_proc;
+  bool m_has_tiles;
+  std::vector<WorkerSpec> m_workers;
+  std::vector<std::string> m_error_messages;
+
+  void start_worker (const std::vector<TilingProcessorTask *> &tasks)
+  {
+    int sv [2];
+    if (socketpair (AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+      throw tl::Exception (tl::to_string (tr ("Unable to create worker process channel: %s")), strerror (errno));
+    }
+
+    pid_t pid = fork ();
+    if (pid < 0) {
+      close (sv [0]);
+      close (sv [1]);
+      throw tl::Exception (tl::to_string (tr ("Unable to create worker process: %s")), strerror (errno));
+    }
+
+    if (pid == 0) {
+
+      //  the worker must not hold the channels of the other workers, otherwise these
+      //  won't see the end of their channel when the parent closes it
+      for (std::vector<WorkerSpec>::const_iterator w = m_workers.begin (); w != m_workers.end (); ++w) {
+        if (w->fd >= 0) {
+          close (w->fd);
+        }
+      }
+      close (sv [0]);
+
+      worker_main (sv [1], tasks);
+
+    }
+
+    close (sv [1]);
+
+    m_workers.push_back (WorkerSpec ());
+    m_workers.back ().pid = pid;
+    m_workers.back ().fd = sv [0];
+  }
+
+  void worker_main (int fd, const std::vector<TilingProcessorTask *> &tasks)
+  {
+    int status = 0;
+
+    try {
+
+      mp_proc->m_worker_channel = fd;
+
+      uint64_t index = 0;
+      while (read_from_channel (fd, (char *) &index, sizeof (index))) {
+
+        const TilingProcessorTask *t = tasks [size_t (index)];
+
+        std::string error;
+
+        try {
+
+          //  execute the task synchronously through a job without worker threads
+          TilingProcessorJob job (mp_proc, 0, m_has_tiles);
+          job.schedule (new TilingProcessorTask (t->tile_desc (), t->ix (), t->iy (), t->clip_box (), t->region (), t->script (), t->script_index ()));
+          job.start ();
+
+          if (job.has_error ()) {
+            error = job.error_messages ().front ();
+          }
+
+        } catch (tl::Exception &ex) {
+          error = ex.msg ();
+        } catch (std::exception &ex) {
+          error = ex.what ();
+        }
+
+        if (! error.empty ()) {
+          send_message (fd, TPM_Error, error);
+        } else {
+          send_message (fd, TPM_Done, std::string ());
+        }
+
+      }
+
+    } catch (tl::Exception &ex) {
+      //  the channel is broken - there is nobody left to report the error to
+      std::cerr << ex.msg () << std::endl;
+      status = 1;
+    } catch (...) {
+      status = 1;
+    }
+
+    std::cout.flush ();
+    std::cerr.flush ();
+    fflush (stdout);
+    fflush (stderr);
+
+    //  leave without running the destructors and exit handlers of the parent's objects
+    _exit (status);
+  }
+
+  void send_task (WorkerSpec &w, size_t index)
+  {
+    uint64_t i = uint64_t (index);
+    write_to_channel (w.fd, (const char *) &i, sizeof (i));
+    w.busy = true;
+    w.task = index;
+  }
+
+  void deliver (const std::string &payload)
+  {
+    TilingProcessorRecordReader reader (payload);
+
+    size_t index = reader.read_size ();
+    size_t ix = reader.read_size ();
+    size_t iy = reader.read_size ();
+    db::Box tile = reader.read_box ();
+    bool clip = (reader.read_byte () != 0);
+    tl::Variant obj = reader.read_variant ();
+
+    if (index >= mp_proc->m_outputs.size ()) {
+      throw tl::Exception (tl::to_string (tr ("Invalid output handle received from worker process")));
+    }
+
+    TilingProcessor::OutputSpec &os = mp_proc->m_outputs [index];
+    os.receiver->put (ix, iy, tile, os.id, obj, mp_proc->dbu (), os.trans, clip);
+  }
+
+  void shutdown (bool kill_workers)
+  {
+    for (std::vector<WorkerSpec>::iterator w = m_workers.begin (); w != m_workers.end (); ++w) {
+      if (kill_workers) {
+        kill (w->pid, SIGKILL);
+      }
+      //  closing the channel tells an idle worker to terminate
+      if (w->fd >= 0) {
+        close (w->fd);
+        w->fd = -1;
+      }
+    }
+
+    for (std::vector<WorkerSpec>::iterator w = m_workers.begin (); w != m_workers.end (); ++w) {
+      int status = 0;
+      while (waitpid (w->pid, &status, 0) < 0 && errno == EINTR) {
+        ;
+      }
+    }
+
+    m_workers.clear ();
+  }
+};
+
+#endif
+
+/**
+ *  @brief A container for the tasks which deletes the tasks it still holds
+ */
+class TilingProcessorTaskList
+  : public std::vector<TilingProcessorTask *>
+{
+public:
+  TilingProcessorTaskList ()
+  {
+    //  .. nothing yet ..
+  }
+
+  ~TilingProcessorTaskList ()
+  {
+    for (iterator t = begin (); t != end (); ++t) {
+      delete *t;
+    }
+  }
+};
+
 // ----------------------------------------------------------------------------------
 //  The tiling processor implementation
 
@@ -611,7 +1749,7 @@ TilingProcessor::TilingProcessor ()
     m_tile_origin_x (0.0), m_tile_origin_y (0.0),
     m_tile_origin_given (false),
     m_tile_bx (0.0), m_tile_by (0.0),
-    m_threads (0), m_dbu (0.001), m_dbu_specific (0.001), m_dbu_specific_set (false),
+    m_threads (0), m_processes (0), m_worker_channel (-1), m_dbu (0.001), m_dbu_specific (0.001), m_dbu_specific_set (false),
     m_scale_to_dbu (true)
 {
   //  .. nothing yet ..
@@ -679,6 +1817,12 @@ TilingProcessor::set_threads (size_t n)
   m_threads = n;
 }
 
+void
+TilingProcessor::set_processes (size_t n)
+{
+  m_processes = n;
+}
+
 void  
 TilingProcessor::queue (const std::string &script)
 {
@@ -816,7 +1960,23 @@ TilingProcessor::put (size_t ix, size_t iy, const db::Box &tile, const std::vect
     throw tl::Exception (tl::to_string (tr ("Invalid handle (first argument) in _output function call")));
   }
 
-  m_outputs[index].receiver->put (ix, iy, tile, m_outputs[index].id, args[1], dbu (), m_outputs[index].trans, clip);
+  if (m_worker_channel >= 0) {
+
+#if !defined(_WIN32)
+    //  inside a worker process: send the object to the parent process which delivers it to the receiver
+    TilingProcessorRecordWriter writer;
+    writer.write_size (index);
+    writer.write_size (ix);
+    writer.write_size (iy);
+    writer.write_box (tile);
+    writer.write_byte (clip ? 1 : 0);
+    writer.write_variant (args[1]);
+    send_message (m_worker_channel, TPM_Put, writer.data ());
+#endif
+
+  } else {
+    m_outputs[index].receiver->put (ix, iy, tile, m_outputs[index].id, args[1], dbu (), m_outputs[index].trans, clip);
+  }
 }
 
 void  
@@ -884,6 +2044,7 @@ TilingProcessor::execute (const std::string &desc)
   bool has_tiles = (ntiles_w > 1 || ntiles_h > 1 || ! m_frame.empty ());
 
   TilingProcessorJob job (this, int (m_threads), has_tiles);
+  TilingProcessorTaskList tasks;
 
   double l = 0.0, b = 0.0;
 
@@ -912,7 +2073,7 @@ TilingProcessor::execute (const std::string &desc)
 
         size_t si = 0;
         for (std::vector <std::string>::const_iterator s = m_scripts.begin (); s != m_scripts.end (); ++s, ++si) {
-          job.schedule (new TilingProcessorTask (tile_desc, ix, iy, clip_box, region, *s, si));
+          tasks.push_back (new TilingProcessorTask (tile_desc, ix, iy, clip_box, region, *s, si));
         }
 
       }
@@ -925,16 +2086,36 @@ TilingProcessor::execute (const std::string &desc)
 
     size_t si = 0;
     for (std::vector <std::string>::const_iterator s = m_scripts.begin (); s != m_scripts.end (); ++s, ++si) {
-      job.schedule (new TilingProcessorTask ("all", 0, 0, db::DBox (), db::DBox (), *s, si));
+      tasks.push_back (new TilingProcessorTask ("all", 0, 0, db::DBox (), db::DBox (), *s, si));
     }
 
   }
 
+#if !defined(_WIN32)
+  std::auto_ptr<TilingProcessorWorkerProcesses> processes;
+  if (TilingProcessorWorkerProcesses::available (this, tasks.size ())) {
+    processes.reset (new TilingProcessorWorkerProcesses (this, has_tiles));
+  }
+  bool use_processes = (processes.get () != 0);
+#else
+  bool use_processes = false;
+#endif
+
+  if (! use_processes) {
+    //  the job takes over the tasks
+    for (std::vector<TilingProcessorTask *>::const_iterator t = tasks.begin (); t != tasks.end (); ++t) {
+      job.schedule (*t);
+    }
+    tasks.clear ();
+  }
+
   //  TODO: there should be a general scheme of how thread-specific progress is merged
   //  into a global one ..
   size_t todo_count = ntiles_w * ntiles_h * m_scripts.size ();
   tl::RelativeProgress progress (desc, todo_count, 1);
 
+  std::vector<std::string> error_messages;
+
   try {
 
     try {
@@ -946,16 +2127,29 @@ TilingProcessor::execute (const std::string &desc)
         }
       }
 
-      job.start ();
-      while (job.is_running ()) {
-        //  This may throw an exception, if the cancel button has been pressed.
-        job.update_progress (progress);
-        job.wait (100);
+      if (use_processes) {
+
+#if !defined(_WIN32)
+        processes->run (tasks, progress);
+        error_messages = processes->error_messages ();
+#endif
+
+      } else {
+
+        job.start ();
+        while (job.is_running ()) {
+          //  This may throw an exception, if the cancel button has been pressed.
+          job.update_progress (progress);
+          job.wait (100);
+        }
+
+        error_messages = job.error_messages ();
+
       }
 
       for (std::vector<OutputSpec>::iterator o = m_outputs.begin (); o != m_outputs.end (); ++o) {
         if (o->receiver) {
-          o->receiver->finish (!job.has_error ());
+          o->receiver->finish (error_messages.empty ());
           o->receiver->set_processor (0);
         }
       }
@@ -978,8 +2172,8 @@ TilingProcessor::execute (const std::string &desc)
     throw ex;
   }
 
-  if (job.has_error ()) {
-    throw tl::Exception (tl::to_string (tr ("Errors occurred during processing. First error message says:\n")) + job.error_messages ().front ());
+  if (! error_messages.empty ()) {
+    throw tl::Exception (tl::to_string (tr ("Errors occurred during processing. First error message says:\n")) + error_messages.front ());
   }
 }
 
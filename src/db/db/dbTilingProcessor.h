@@ -31,10 +31,12 @@
 #include "dbLayoutUtils.h"
 #include "dbPolygonTools.h"
 #include "dbClip.h"
+#include "dbSaveLayoutOptions.h"
 
 #include "gsiObject.h"
 
 #include "tlExpression.h"
+#include "tlStream.h"
 #include "tlTypeTraits.h"
 #include "tlThreads.h"
 
@@ -410,6 +412,131 @@ bool insert_var (X &inserter, const tl::Variant &obj, const db::Box &tile, bool
   }
 }
 
+/**
+ *  @brief A writer streaming the tiling processor output into a layout file
+ *
+ *  The tile results are collected in a buffer layout. When the buffer exceeds the
+ *  given number of shapes, it is written to the stream as a separate cell and cleared.
+ *  When the writer is finished, a top cell is written which instantiates all these
+ *  cells. Hence the memory required is bounded by the buffer size, not by the
+ *  total size of the output.
+ *
+ *  If the output fits into the buffer, the shapes are written directly into the top cell.
+ *
+ *  The writer needs a stream format which can be concatenated, i.e. GDS2.
+ *  Use TileStreamOutputReceiver to connect the writer with a tiling processor output.
+ */
+class DB_PUBLIC TileOutputStreamWriter
+{
+public:
+  /**
+   *  @brief Constructor
+   *
+   *  @param stream The stream to write the output to
+   *  @param options The save options (the format needs to be GDS2)
+   *  @param dbu The database unit of the output
+   *  @param top_cell_name The name of the top cell
+   *  @param max_shapes The number of shapes buffered before they are written
+   */
+  TileOutputStreamWriter (tl::OutputStream &stream, const db::SaveLayoutOptions &options, double dbu, const std::string &top_cell_name, size_t max_shapes = 1000000);
+
+  /**
+   *  @brief Sets the database unit
+   *
+   *  The database unit can only be changed before anything has been written.
+   */
+  void set_dbu (double dbu);
+
+  /**
+   *  @brief Gets the database unit
+   */
+  double dbu () const
+  {
+    return m_buffer.dbu ();
+  }
+
+  /**
+   *  @brief Adds an output layer and returns the layer index
+   */
+  unsigned int add_layer (const db::LayerProperties &lp);
+
+  /**
+   *  @brief Gets the layer properties for the given layer index
+   */
+  const db::LayerProperties &layer_properties (unsigned int layer) const
+  {
+    return m_buffer.get_properties (layer);
+  }
+
+  /**
+   *  @brief Gets the buffer's shape container for the given layer
+   *
+   *  After shapes have been inserted, "commit" needs to be called.
+   */
+  db::Shapes &shapes (unsigned int layer)
+  {
+    return m_buffer.cell (m_chunk_cell).shapes (layer);
+  }
+
+  /**
+   *  @brief Registers the given number of shapes which have been inserted into the given layer
+   *
+   *  This method will write the buffer if it exceeds the maximum number of shapes.
+   */
+  void commit (unsigned int layer, size_t n);
+
+  /**
+   *  @brief Gets the number of shapes written for the given layer so far
+   */
+  size_t shape_count (unsigned int layer) const;
+
+  /**
+   *  @brief Writes the remaining shapes and the top cell
+   *
+   *  This method needs to be called after the tiling processor has finished.
+   */
+  void finish ();
+
+private:
+  tl::OutputStream *mp_stream;
+  db::SaveLayoutOptions m_options;
+  std::string m_top_cell_name;
+  size_t m_max_shapes;
+  db::Layout m_buffer;
+  db::cell_index_type m_chunk_cell;
+  size_t m_buffered_shapes;
+  std::vector<std::string> m_chunks;
+  std::vector<size_t> m_shape_counts;
+  bool m_finished;
+
+  void flush ();
+  void write (bool with_header, bool with_trailer);
+};
+
+/**
+ *  @brief A tile output receiver which sends the shapes to a TileOutputStreamWriter
+ */
+class DB_PUBLIC TileStreamOutputReceiver
+  : public TileOutputReceiver
+{
+public:
+  /**
+   *  @brief Constructor
+   *
+   *  @param writer The writer to send the shapes to
+   *  @param layer The layer index as delivered by TileOutputStreamWriter::add_layer
+   *  @param ep_ext The enlargement applied when converting edge pairs to polygons
+   */
+  TileStreamOutputReceiver (TileOutputStreamWriter *writer, unsigned int layer, db::Coord ep_ext = 1);
+
+  virtual void put (size_t ix, size_t iy, const db::Box &tile, size_t id, const tl::Variant &obj, double dbu, const db::ICplxTrans &trans, bool clip);
+
+private:
+  TileOutputStreamWriter *mp_writer;
+  unsigned int m_layer;
+  db::Coord m_ep_sizing;
+};
+
 /**
  *  @brief A processor for executing scripts on tiles of a layout
  *
@@ -629,6 +756,30 @@ public:
     return m_threads;
   }
 
+  /**
+   *  @brief Specifies the number of worker processes to use
+   *
+   *  With a value larger than 1, the tasks are not executed in threads but
+   *  distributed over the given number of processes forked from the current one.
+   *  The worker processes see the inputs as they are when "execute" is called
+   *  and send the objects delivered by "_output" back to the output receivers
+   *  of this processor. This avoids the contention of threads inside the
+   *  expression interpreter.
+   *
+   *  Worker processes are not available on Windows and for scripts using "_rec".
+   *  In that case, the tasks are executed in the number of threads specified
+   *  with "set_threads".
+   */
+  void set_processes (size_t n);
+
+  /**
+   *  @brief Gets the number of worker processes used
+   */
+  size_t processes () const
+  {
+    return m_processes;
+  }
+
   /**
    *  @brief Queue a script for execution with "execute"
    *
@@ -648,6 +799,7 @@ private:
   friend class TilingProcessorWorker;
   friend class TilingProcessorOutputFunction;
   friend class TilingProcessorReceiverFunction;
+  friend class TilingProcessorWorkerProcesses;
 
   struct InputSpec
   {
@@ -685,6 +837,8 @@ private:
   bool m_tile_origin_given;
   double m_tile_bx, m_tile_by;
   size_t m_threads;
+  size_t m_processes;
+  int m_worker_channel;
   double m_dbu, m_dbu_specific;
   bool m_dbu_specific_set;
   bool m_scale_to_dbu;
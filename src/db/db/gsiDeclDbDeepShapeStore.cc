@@ -22,7 +22,14 @@
 
 #include "gsiDecl.h"
 #include "dbDeepShapeStore.h"
+#include "dbRegion.h"
+#include "dbEdges.h"
+#include "dbEdgePairs.h"
+#include "dbDeepRegion.h"
+#include "dbDeepEdges.h"
+#include "dbDeepEdgePairs.h"
 #include "tlGlobPattern.h"
+#include "tlThreadedWorkers.h"
 
 namespace gsi
 {
@@ -94,6 +101,52 @@ static void add_breakout_cells3 (db::DeepShapeStore *dss, const std::string &pat
   set_or_add_breakout_cells (dss, pattern, true);
 }
 
+static const db::DeepLayer &deep_layer_of (const db::ShapeCollection &coll)
+{
+  db::DeepShapeCollectionDelegateBase *deep = coll.get_delegate ()->deep ();
+  if (! deep) {
+    throw tl::Exception (tl::to_string (tr ("The collection is not a deep (hierarchical) collection")));
+  }
+  return deep->deep_layer ();
+}
+
+static size_t layer_hash (const db::ShapeCollection &coll)
+{
+  return db::DeepShapeStore::layer_hash (deep_layer_of (coll));
+}
+
+static void save_layer (const db::ShapeCollection &coll, const std::string &key, const std::string &path)
+{
+  db::DeepShapeStore::save_layer (deep_layer_of (coll), key, path);
+}
+
+static db::Region *load_region (const std::string &key, const std::string &path, const db::ShapeCollection &like)
+{
+  db::DeepLayer dl = deep_layer_of (like).derived ();
+  if (! db::DeepShapeStore::load_layer (dl, key, path)) {
+    return 0;
+  }
+  return new db::Region (new db::DeepRegion (dl));
+}
+
+static db::Edges *load_edges (const std::string &key, const std::string &path, const db::ShapeCollection &like)
+{
+  db::DeepLayer dl = deep_layer_of (like).derived ();
+  if (! db::DeepShapeStore::load_layer (dl, key, path)) {
+    return 0;
+  }
+  return new db::Edges (new db::DeepEdges (dl));
+}
+
+static db::EdgePairs *load_edge_pairs (const std::string &key, const std::string &path, const db::ShapeCollection &like)
+{
+  db::DeepLayer dl = deep_layer_of (like).derived ();
+  if (! db::DeepShapeStore::load_layer (dl, key, path)) {
+    return 0;
+  }
+  return new db::EdgePairs (new db::DeepEdgePairs (dl));
+}
+
 Class<db::DeepShapeStore> decl_dbDeepShapeStore ("db", "DeepShapeStore",
   gsi::method ("instance_count", &db::DeepShapeStore::instance_count,
     "@hide\n"
@@ -111,6 +164,30 @@ Class<db::DeepShapeStore> decl_dbDeepShapeStore ("db", "DeepShapeStore",
   gsi::method ("threads", &db::DeepShapeStore::threads,
     "@brief Gets the number of threads.\n"
   ) +
+  gsi::method ("thread_affinity=", &db::DeepShapeStore::set_thread_affinity, gsi::arg ("cpus"),
+    "@brief Sets the CPUs the threads of the hierarchical processor are pinned to\n"
+    "Thread n is pinned to the CPU given by the n-th element of the list (the list is repeated if there are more threads). "
+    "An empty list disables pinning. Pinning threads keeps the data they produce on their NUMA node. "
+    "Use \\thread_affinity_layout to compute a NUMA-aware assignment. On platforms not supporting thread affinity, "
+    "this setting is ignored.\n"
+    "\n"
+    "This method has been added in version 0.27.\n"
+  ) +
+  gsi::method ("thread_affinity", &db::DeepShapeStore::thread_affinity,
+    "@brief Gets the CPUs the threads are pinned to\n"
+    "See \\thread_affinity= for details.\n"
+    "\n"
+    "This method has been added in version 0.27.\n"
+  ) +
+  gsi::method ("thread_affinity_layout", &tl::thread_affinity_layout, gsi::arg ("threads"), gsi::arg ("spread", false),
+    "@brief Computes a NUMA-aware assignment of threads to CPUs\n"
+    "If 'spread' is false, the threads fill the NUMA nodes one after another. This keeps neighboring threads on the same "
+    "node which is beneficial as threads take over work from their neighbors first. If 'spread' is true, the threads are "
+    "distributed round-robin over the nodes which gives more memory bandwidth. The result can be used for \\thread_affinity=. "
+    "An empty list is returned if the CPUs of the system cannot be determined.\n"
+    "\n"
+    "This method has been added in version 0.27.\n"
+  ) +
   gsi::method ("max_vertex_count=", &db::DeepShapeStore::set_max_vertex_count, gsi::arg ("count"),
     "@brief Sets the maximum vertex count default value\n"
     "\n"
@@ -153,6 +230,88 @@ Class<db::DeepShapeStore> decl_dbDeepShapeStore ("db", "DeepShapeStore",
   gsi::method ("text_enlargement", &db::DeepShapeStore::text_enlargement,
     "@brief Gets the text enlargement value.\n"
   ) +
+  gsi::method ("memory_limit=", &db::DeepShapeStore::set_memory_limit, gsi::arg ("bytes"),
+    "@brief Sets the memory budget for the shape containers in bytes\n"
+    "\n"
+    "If a memory limit is set, \\spill will write the shapes of the least recently used layers "
+    "to temporary files until the remaining layers fit into this budget. Spilled layers are read back "
+    "automatically when they are used again. The temporary files are created in the directory given by "
+    "the TMPDIR environment variable (TEMP on Windows). "
+    "The budget applies to the shape containers only - polygon and text "
+    "objects shared through the layout's shape repository stay in memory.\n"
+    "A value of 0 (the default) disables spilling.\n"
+    "\n"
+    "This method has been added in version 0.27.\n"
+  ) +
+  gsi::method ("memory_limit", &db::DeepShapeStore::memory_limit,
+    "@brief Gets the memory budget for the shape containers in bytes\n"
+    "See \\memory_limit= for details.\n"
+    "\n"
+    "This method has been added in version 0.27.\n"
+  ) +
+  gsi::method ("spill", &db::DeepShapeStore::spill,
+    "@brief Spills layers to disk if the memory budget is exceeded\n"
+    "Returns the number of layers spilled. This method must not be called while an operation "
+    "is using the store. See \\memory_limit= for details.\n"
+    "\n"
+    "This method has been added in version 0.27.\n"
+  ) +
+  gsi::method ("memory_used", &db::DeepShapeStore::memory_used,
+    "@brief Gets the memory in bytes used by the shape containers of the layers held in memory\n"
+    "This is the figure \\spill compares against the memory budget. See \\memory_limit= for details.\n"
+    "\n"
+    "This method has been added in version 0.27.\n"
+  ) +
+  gsi::method ("layer_hash", &layer_hash, gsi::arg ("collection"),
+    "@brief Computes a content hash value for a deep collection\n"
+    "The hash value covers the shapes and the cell tree of the collection's layer. Cells are identified by "
+    "name, so the value can be compared against values obtained in other runs of the same program. "
+    "The collection needs to be a deep region, edge or edge pair collection.\n"
+    "\n"
+    "This method has been added in version 0.27.\n"
+  ) +
+  gsi::method ("save_layer", &save_layer, gsi::arg ("collection"), gsi::arg ("key"), gsi::arg ("path"),
+    "@brief Writes the shapes of a deep collection to a file\n"
+    "The key is stored in the file and needs to be given again when the file is loaded. "
+    "Use \\load_region, \\load_edges or \\load_edge_pairs to read the file.\n"
+    "\n"
+    "This method has been added in version 0.27.\n"
+  ) +
+  gsi::factory ("load_region", &load_region, gsi::arg ("key"), gsi::arg ("path"), gsi::arg ("like"),
+    "@brief Reads a deep region from a file written by \\save_layer\n"
+    "The new region is created in the hierarchy of the 'like' collection. Cells are identified by name. "
+    "If the key does not match the key stored in the file or the file refers to cells not present in that "
+    "hierarchy, nil is returned.\n"
+    "\n"
+    "This method has been added in version 0.27.\n"
+  ) +
+  gsi::factory ("load_edges", &load_edges, gsi::arg ("key"), gsi::arg ("path"), gsi::arg ("like"),
+    "@brief Reads a deep edge collection from a file written by \\save_layer\n"
+    "See \\load_region for details.\n"
+    "\n"
+    "This method has been added in version 0.27.\n"
+  ) +
+  gsi::factory ("load_edge_pairs", &load_edge_pairs, gsi::arg ("key"), gsi::arg ("path"), gsi::arg ("like"),
+    "@brief Reads a deep edge pair collection from a file written by \\save_layer\n"
+    "See \\load_region for details.\n"
+    "\n"
+    "This method has been added in version 0.27.\n"
+  ) +
+  gsi::method ("spill_count", &db::DeepShapeStore::spill_count,
+    "@brief Gets the total number of layers spilled to disk so far\n"
+    "\n"
+    "This method has been added in version 0.27.\n"
+  ) +
+  gsi::method ("reload_count", &db::DeepShapeStore::reload_count,
+    "@brief Gets the total number of layers read back from disk so far\n"
+    "\n"
+    "This method has been added in version 0.27.\n"
+  ) +
+  gsi::method ("reload_time", &db::DeepShapeStore::reload_time,
+    "@brief Gets the total time in seconds spent for reading back layers from disk\n"
+    "\n"
+    "This method has been added in version 0.27.\n"
+  ) +
   gsi::method ("clear_breakout_cells", &db::DeepShapeStore::clear_breakout_cells, gsi::arg ("layout_index"),
     "@brief Clears the breakout cells\n"
     "Breakout cells are a feature by which hierarchy handling can be disabled for specific cells. "
@@ -39,6 +39,7 @@
 #include "dbLayoutUtils.h"
 #include "dbLayerMapping.h"
 #include "dbCellMapping.h"
+#include "dbBoxTree.h"
 #include "tlStream.h"
 
 namespace gsi
@@ -1333,6 +1334,20 @@ Class<db::Layout> decl_Layout ("db", "Layout",
     "This method is provided to ensure this explicitly. This can be useful while using \\start_changes and \\end_changes to wrap a performance-critical operation. "
     "See \\start_changes for more details."
   ) +
+  gsi::method ("sort_threads=", &db::set_sort_threads, gsi::arg ("n"),
+    "@brief Sets the number of threads used for sorting the shapes\n"
+    "When the layout is updated, the shapes of the cells are sorted for fast region queries. With a thread count larger "
+    "than 1, the shape containers of different cells and layers are sorted in parallel. Large shape containers "
+    "are sorted by multiple threads themselves. This setting is global and applies to all layouts. The default is 1.\n"
+    "\n"
+    "This method has been added in version 0.27."
+  ) +
+  gsi::method ("sort_threads", &db::sort_threads,
+    "@brief Gets the number of threads used for sorting the shapes\n"
+    "See \\sort_threads= for details.\n"
+    "\n"
+    "This method has been added in version 0.27."
+  ) +
   gsi::method ("cleanup", &db::Layout::cleanup,
     "@brief Cleans up the layout\n"
     "This method will remove proxy objects that are no longer in use. After changing PCell parameters such "
@@ -26,6 +26,7 @@
 
 #include "dbLayoutDiff.h"
 #include "dbLayout.h"
+#include "dbRegion.h"
 
 #include "tlEvents.h"
 
@@ -387,6 +388,13 @@ struct type_traits<LayoutDiff>
 namespace gsi
 {
 
+static db::Region difference_region (const db::Cell *a, const db::Cell *b, unsigned int flags, db::Coord tolerance)
+{
+  tl_assert (a != 0 && b != 0);
+  tl_assert (a->layout () != 0 && b->layout () != 0);
+  return db::difference_region (*a->layout (), a->cell_index (), *b->layout (), b->cell_index (), flags, tolerance);
+}
+
 static unsigned int f_silent () {
   return db::layout_diff::f_silent;
 }
@@ -537,6 +545,27 @@ gsi::Class<LayoutDiff> decl_LayoutDiff ("db", "LayoutDiff",
     "\n"
     "@return True, if the cells are identical\n"
   ) +
+  gsi::method ("difference_region", &difference_region,
+    gsi::arg("a"),
+    gsi::arg("b"),
+    gsi::arg<int> ("flags", 0),
+    gsi::arg<int> ("tolerance", 0),
+    "@brief Computes the region where two cell hierarchies differ\n"
+    "\n"
+    "Compares the hierarchies below the given cells like \\compare and returns the region covered by the "
+    "differences in the coordinate system of cell 'b'. The region is made from the bounding boxes of all shapes and instances "
+    "present in only one of the hierarchies. Differences inside a child cell appear at every placement "
+    "of that cell - large arrays contribute their total bounding box. Shapes on layers present in only one "
+    "of the layouts count as differences. If the database units differ, the bounding box of 'b' is returned. "
+    "If the hierarchies are identical, the region is empty.\n"
+    "\n"
+    "@param a The first top cell\n"
+    "@param b The second top cell\n"
+    "@param flags Flags to use for the comparison\n"
+    "@param tolerance A coordinate tolerance to apply (0: exact match, 1: one DBU tolerance is allowed ...)\n"
+    "\n"
+    "This method has been added in version 0.27.\n"
+  ) +
   gsi::method ("layout_a", &LayoutDiff::layout_a,
     "@brief Gets the first layout the difference detector runs on"
   ) +
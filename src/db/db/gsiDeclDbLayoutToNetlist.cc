@@ -194,6 +194,10 @@ Class<db::LayoutToNetlist> decl_dbLayoutToNetlist ("db", "LayoutToNetlist",
   ) +
   gsi::method ("threads=", &db::LayoutToNetlist::set_threads, gsi::arg ("n"),
     "@brief Sets the number of threads to use for operations which support multiple threads\n"
+    "Among others, this applies to the hierarchical boolean operations, the built-in device extractors and the computation of the "
+    "local shape clusters in the net extraction. Device and net extraction have been made multi-threaded in version 0.27. "
+    "Device extractors implemented in scripts (see \\GenericDeviceExtractor) always run single-threaded. "
+    "The hierarchical stage of the net extraction, which connects the clusters across the cells, is single-threaded too.\n"
   ) +
   gsi::method ("threads", &db::LayoutToNetlist::threads,
     "@brief Gets the number of threads to use for operations which support multiple threads\n"
@@ -852,6 +852,12 @@ public:
     }
   }
 
+  virtual bool is_thread_safe () const
+  {
+    //  script callbacks must not be called from worker threads
+    return ! cb_less.can_issue () && ! cb_equal.can_issue ();
+  }
+
   gsi::Callback cb_less, cb_equal;
 };
 
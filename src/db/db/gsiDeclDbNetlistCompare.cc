@@ -550,6 +550,19 @@ Class<db::NetlistComparer> decl_dbNetlistComparer ("db", "NetlistComparer",
     "@brief Gets a value indicating whether net names shall not be considered\n"
     "See \\dont_consider_net_names= for details."
   ) +
+  gsi::method ("threads=", &db::NetlistComparer::set_threads, gsi::arg ("n"),
+    "@brief Sets the number of threads to use for the compare\n"
+    "With a value of 0 (the default), the circuits are compared one after another. "
+    "Otherwise, circuits whose subcircuits have been compared already are compared in parallel using "
+    "the given number of threads. The log events and the result are the same as in single-threaded mode.\n"
+    "Compare delegates implemented in scripts (see \\GenericDeviceParameterCompare) will make the compare run single-threaded.\n"
+    "\n"
+    "This property has been introduced in version 0.27.\n"
+  ) +
+  gsi::method ("threads", &db::NetlistComparer::threads,
+    "@brief Gets the number of threads to use for the compare\n"
+    "See \\threads= for details."
+  ) +
   gsi::method_ext ("unmatched_circuits_a", &unmatched_circuits_a, gsi::arg ("a"), gsi::arg ("b"),
     "@brief Returns a list of circuits in A for which there is not corresponding circuit in B\n"
     "This list can be used to flatten these circuits so they do not participate in the compare process.\n"
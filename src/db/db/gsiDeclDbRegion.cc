@@ -1003,6 +1003,33 @@ Class<db::Region> decl_Region (decl_dbShapeCollection, "db", "Region",
     "\n"
     "Merged semantics applies for this method (see \\merged_semantics= of merged semantics)\n"
   ) +
+  method ("density_check", &db::Region::density_check, gsi::arg ("wx"), gsi::arg ("wy"), gsi::arg ("sx"), gsi::arg ("sy"), gsi::arg ("min_density"), gsi::arg ("max_density"), gsi::arg ("inverse"), gsi::arg ("boundary", db::Region (), "Region()"),
+    "@brief Returns the windows whose density is inside (or outside) the given range\n"
+    "@param wx The width of the windows\n"
+    "@param wy The height of the windows\n"
+    "@param sx The horizontal step of the windows\n"
+    "@param sy The vertical step of the windows\n"
+    "@param min_density The minimum density (0.0 to 1.0)\n"
+    "@param max_density The maximum density (0.0 to 1.0)\n"
+    "@param inverse If true, the windows outside the density range are returned\n"
+    "@param boundary The region defining the extent of the window grid\n"
+    "\n"
+    "The density is computed inside windows of wx x wy size. The windows are placed at steps of sx and sy, "
+    "starting at the lower left corner of the boundary's bounding box. If the boundary is empty, the bounding box "
+    "of this region is used. Windows extending beyond this box are clipped. If the boundary is not a simple box, "
+    "only windows overlapping the boundary are considered.\n"
+    "\n"
+    "The density is the area covered by the polygons inside the window divided by the window's area. "
+    "The method returns the window boxes whose density is larger or equal to min_density and less or equal to max_density. "
+    "If 'inverse' is true, the windows outside this range are returned.\n"
+    "\n"
+    "Flat regions use the number of threads given by \\threads= for the computation. For deep regions, the "
+    "threads of the deep shape store apply and the result will be a deep region too.\n"
+    "\n"
+    "Merged semantics applies for this method (see \\merged_semantics= of merged semantics)\n"
+    "\n"
+    "This method has been introduced in version 0.27.\n"
+  ) +
   method ("insert", (void (db::Region::*)(const db::Box &)) &db::Region::insert, gsi::arg ("box"),
     "@brief Inserts a box\n"
     "\n"
@@ -2359,6 +2386,22 @@ Class<db::Region> decl_Region (decl_dbShapeCollection, "db", "Region",
     "\n"
     "This method has been introduced in version 0.26.\n"
   ) +
+  method ("threads=", &db::Region::set_threads, gsi::arg ("n"),
+    "@brief Sets the number of threads to use for flat merge, sizing and boolean operations\n"
+    "With more than one thread, the scanline of the edge processor is split into horizontal bands "
+    "which are computed in parallel. The results are identical to the single-threaded ones. "
+    "Small inputs are processed single-threaded always. "
+    "This setting does not apply to deep (hierarchical) regions.\n"
+    "In binary operations, the setting of the first argument is considered.\n"
+    "\n"
+    "This method has been introduced in version 0.27.\n"
+  ) +
+  method ("threads", &db::Region::threads,
+    "@brief Gets the number of threads to use for flat operations\n"
+    "See \\threads= for details.\n"
+    "\n"
+    "This method has been introduced in version 0.27.\n"
+  ) +
   method ("Euclidian", &euclidian_metrics,
     "@brief Specifies Euclidian metrics for the check functions\n"
     "This value can be used for the metrics parameter in the check functions, i.e. \\width_check. "
@@ -687,6 +687,24 @@ Class<db::TilingProcessor> decl_TilingProcessor ("db", "TilingProcessor",
   method ("threads", &db::TilingProcessor::threads,
     "@brief Gets the number of threads to use\n"
   ) + 
+  method ("processes=", &db::TilingProcessor::set_processes, gsi::arg ("n"),
+    "@brief Specifies the number of worker processes to use\n"
+    "\n"
+    "If a value larger than 1 is given, the tiles are not computed in threads but in the given number "
+    "of worker processes forked from the current one. The objects delivered with \"_output\" are sent back "
+    "to this process and passed to the receivers here. Worker processes are not subject to the "
+    "serialization of threads inside the script interpreter and hence scale better.\n"
+    "\n"
+    "Worker processes are not available on Windows and for scripts using \"_rec\". In that case, "
+    "the number of threads specified with \\threads= is used instead.\n"
+    "\n"
+    "This method has been introduced in version 0.27.\n"
+  ) + 
+  method ("processes", &db::TilingProcessor::processes,
+    "@brief Gets the number of worker processes to use\n"
+    "\n"
+    "This method has been introduced in version 0.27.\n"
+  ) + 
   method ("queue", &db::TilingProcessor::queue, gsi::arg ("script"),
     "@brief Queues a script for parallel execution\n"
     "\n"
@@ -363,6 +363,21 @@ TEST(0)
   EXPECT_EQ (bitset, (unsigned int) 0);
 }
 
+template <class Tree>
+static std::string touching_sequence (const Tree &t, const db::Box &b)
+{
+  //  the objects delivered in the order of the tree traversal reflect the tree structure
+  Box2Box conv;
+  std::string r;
+  for (typename Tree::touching_iterator i = t.begin_touching (b, conv); ! i.at_end (); ++i) {
+    if (! r.empty ()) {
+      r += ";";
+    }
+    r += (*i).to_string ();
+  }
+  return r;
+}
+
 TEST(1)
 {
   Box2Box conv;
@@ -1120,3 +1135,77 @@ TEST(7U)
     EXPECT_EQ (n, t.size () * 10);
   }
 }
+
+TEST(8)
+{
+  Box2Box conv;
+  TestTreeL t1, t4;
+
+  int n = 300000;
+
+  for (int i = 0; i < n; ++i) {
+    db::Box b = rbox ();
+    t1.insert (b);
+    t4.insert (b);
+  }
+
+  t1.sort (conv);
+
+  db::set_sort_threads (4);
+  try {
+    tl::SelfTimer timer ("test 8 sort with 4 threads");
+    t4.sort (conv);
+    db::set_sort_threads (1);
+  } catch (...) {
+    db::set_sort_threads (1);
+    throw;
+  }
+
+  //  the parallel sort must deliver the same tree: region queries visit the objects in the same order
+  EXPECT_EQ (t1.size (), t4.size ());
+  EXPECT_EQ (touching_sequence (t4, db::Box::world ()) == touching_sequence (t1, db::Box::world ()), true);
+
+  for (int i = 0; i < 20; ++i) {
+    db::Box b (rbox ().enlarged (db::Vector (1000, 1000)));
+    EXPECT_EQ (touching_sequence (t4, b), touching_sequence (t1, b));
+    test_tree_overlap (_this, t4, b, conv);
+    test_tree_touching (_this, t4, b, conv);
+  }
+}
+
+TEST(8U)
+{
+  Box2Box conv;
+  UnstableTestTreeL t1, t4;
+
+  int n = 300000;
+
+  for (int i = 0; i < n; ++i) {
+    db::Box b = rbox ();
+    t1.insert (b);
+    t4.insert (b);
+  }
+
+  t1.sort (conv);
+
+  db::set_sort_threads (4);
+  try {
+    tl::SelfTimer timer ("test 8U sort with 4 threads");
+    t4.sort (conv);
+    db::set_sort_threads (1);
+  } catch (...) {
+    db::set_sort_threads (1);
+    throw;
+  }
+
+  //  the parallel sort must deliver the same tree: region queries visit the objects in the same order
+  EXPECT_EQ (t1.size (), t4.size ());
+  EXPECT_EQ (touching_sequence (t4, db::Box::world ()) == touching_sequence (t1, db::Box::world ()), true);
+
+  for (int i = 0; i < 20; ++i) {
+    db::Box b (rbox ().enlarged (db::Vector (1000, 1000)));
+    EXPECT_EQ (touching_sequence (t4, b), touching_sequence (t1, b));
+    test_tree_overlap (_this, t4, b, conv);
+    test_tree_touching (_this, t4, b, conv);
+  }
+}
@@ -0,0 +1,194 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2020 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "dbContourAllocator.h"
+#include "dbPolygon.h"
+#include "tlUnitTest.h"
+#include "tlThreads.h"
+
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+
+namespace
+{
+
+class PolygonCreatorThread
+  : public tl::Thread
+{
+public:
+  PolygonCreatorThread (std::vector<db::Polygon> *polygons, int seed)
+    : mp_polygons (polygons), m_seed (seed)
+  {
+    //  .. nothing yet ..
+  }
+
+protected:
+  virtual void run ()
+  {
+    for (int i = 0; i < 10000; ++i) {
+      std::vector<db::Point> pts;
+      int x0 = (i * 37 + m_seed * 1000) % 100000;
+      int n = 3 + i % 20;
+      for (int k = 0; k < n; ++k) {
+        pts.push_back (db::Point (x0 + (k * k * 7) % (k % 2 ? 100 : 100000), (k * 13) % 1000));
+      }
+      db::Polygon p;
+      p.assign_hull (pts.begin (), pts.end ());
+      mp_polygons->push_back (p);
+      if (i % 3 == 0) {
+        mp_polygons->pop_back ();
+      }
+    }
+  }
+
+private:
+  std::vector<db::Polygon> *mp_polygons;
+  int m_seed;
+};
+
+class BlockAllocatorThread
+  : public tl::Thread
+{
+public:
+  BlockAllocatorThread (std::vector<void *> *blocks)
+    : mp_blocks (blocks)
+  {
+    //  .. nothing yet ..
+  }
+
+protected:
+  virtual void run ()
+  {
+    for (int i = 0; i < 10; ++i) {
+      mp_blocks->push_back (db::allocate_contour_points (24));
+    }
+  }
+
+private:
+  std::vector<void *> *mp_blocks;
+};
+
+}
+
+TEST(1)
+{
+  //  blocks are reused for the same size
+  void *p1 = db::allocate_contour_points (24);
+  memset (p1, 0xff, 24);
+  db::release_contour_points (p1, 24);
+  void *p2 = db::allocate_contour_points (20);
+  EXPECT_EQ (p1 == p2, true);
+
+  void *p3 = db::allocate_contour_points (24);
+  EXPECT_EQ (p2 != p3, true);
+  EXPECT_EQ (((size_t) p3 & 7), size_t (0));
+
+  db::release_contour_points (p2, 20);
+  db::release_contour_points (p3, 24);
+
+  //  large blocks
+  void *p4 = db::allocate_contour_points (10000);
+  memset (p4, 0xff, 10000);
+  db::release_contour_points (p4, 10000);
+
+  //  null is ignored
+  db::release_contour_points (0, 16);
+}
+
+TEST(2)
+{
+  //  polygons created in different threads and released in the main thread
+  std::vector<std::vector<db::Polygon> > polygons (4);
+  std::vector<db::Polygon> reference;
+
+  PolygonCreatorThread ref_creator (&reference, 0);
+  ref_creator.start ();
+  ref_creator.wait ();
+
+  for (int round = 0; round < 3; ++round) {
+
+    std::vector<PolygonCreatorThread *> threads;
+    for (size_t i = 0; i < polygons.size (); ++i) {
+      threads.push_back (new PolygonCreatorThread (&polygons [i], int (i)));
+      threads.back ()->start ();
+    }
+
+    for (std::vector<PolygonCreatorThread *>::const_iterator t = threads.begin (); t != threads.end (); ++t) {
+      (*t)->wait ();
+      delete *t;
+    }
+
+    EXPECT_EQ (polygons [0].size (), reference.size ());
+    EXPECT_EQ (polygons [0] == reference, true);
+
+    for (size_t i = 0; i < polygons.size (); ++i) {
+      EXPECT_EQ (polygons [i].size (), size_t (6666));
+      polygons [i].clear ();
+    }
+
+  }
+}
+
+TEST(3)
+{
+  //  chunks whose blocks are all released go back to the system
+  db::release_unused_contour_points ();
+  size_t size0 = db::contour_point_pool_size ();
+
+  std::vector<void *> blocks;
+  for (int i = 0; i < 200000; ++i) {
+    blocks.push_back (db::allocate_contour_points (24));
+  }
+  EXPECT_EQ (db::contour_point_pool_size () > size0 + 100000 * 24, true);
+
+  for (std::vector<void *>::const_iterator b = blocks.begin (); b != blocks.end (); ++b) {
+    db::release_contour_points (*b, 24);
+  }
+
+  db::release_unused_contour_points ();
+  //  NOTE: the chunk the current thread takes blocks from is kept
+  EXPECT_EQ (db::contour_point_pool_size () <= size0 + 64 * 1024, true);
+}
+
+TEST(4)
+{
+  //  the partially used chunk of a terminated thread is taken by the next one,
+  //  so a sequence of short-lived threads does not allocate a chunk each
+  std::vector<void *> blocks;
+
+  size_t size0 = db::contour_point_pool_size ();
+
+  for (int i = 0; i < 50; ++i) {
+    BlockAllocatorThread t (&blocks);
+    t.start ();
+    t.wait ();
+  }
+
+  EXPECT_EQ (blocks.size (), size_t (500));
+  EXPECT_EQ (db::contour_point_pool_size () < size0 + 10 * 64 * 1024, true);
+
+  for (std::vector<void *>::const_iterator b = blocks.begin (); b != blocks.end (); ++b) {
+    db::release_contour_points (*b, 24);
+  }
+}
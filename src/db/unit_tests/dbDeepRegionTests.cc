@@ -31,6 +31,9 @@
 #include "dbEdgesUtils.h"
 #include "dbDeepShapeStore.h"
 #include "dbOriginalLayerRegion.h"
+#include "dbDeepRegion.h"
+#include "dbHierProcessor.h"
+#include "dbLocalOperation.h"
 #include "tlUnitTest.h"
 #include "tlStream.h"
 
@@ -1774,6 +1777,35 @@ TEST(101_DeepFlatCollaboration)
   db::compare_layouts (_this, target, tl::testsrc () + "/testdata/algo/deep_region_au101.gds");
 }
 
+TEST(102_DensityCheck)
+{
+  db::Layout ly;
+  db::cell_index_type top_cell_index = ly.add_cell ("TOP");
+  db::cell_index_type child_cell_index = ly.add_cell ("CHILD");
+  db::Cell &top_cell = ly.cell (top_cell_index);
+  unsigned int l1 = ly.insert_layer ();
+
+  ly.cell (child_cell_index).shapes (l1).insert (db::Box (0, 0, 500, 1000));
+  top_cell.insert (db::CellInstArray (db::CellInst (child_cell_index), db::Trans (db::Vector (0, 0))));
+  top_cell.insert (db::CellInstArray (db::CellInst (child_cell_index), db::Trans (db::Vector (250, 0))));
+  top_cell.insert (db::CellInstArray (db::CellInst (child_cell_index), db::Trans (db::Vector (2000, 0))));
+  top_cell.shapes (l1).insert (db::Box (3000, 0, 4000, 1000));
+
+  db::Region r_flat (db::RecursiveShapeIterator (ly, top_cell, l1));
+
+  db::DeepShapeStore dss;
+  dss.set_threads (4);
+  db::Region r (db::RecursiveShapeIterator (ly, top_cell, l1), dss);
+
+  //  the child instances at 0 and 250 overlap - the density is taken from the merged layer
+  EXPECT_EQ (r.density_check (1000, 1000, 1000, 1000, 0.6, 0.8, false, db::Region ()).to_string (), "(0,0;0,1000;1000,1000;1000,0)");
+  EXPECT_EQ (r.density_check (1000, 1000, 1000, 1000, 0.4, 0.6, false, db::Region ()).to_string (), "(2000,0;2000,1000;3000,1000;3000,0)");
+
+  db::Region res = r.density_check (500, 500, 250, 250, 0.3, 0.9, true, db::Region ());
+  EXPECT_EQ (dynamic_cast<db::DeepRegion *> (res.delegate ()) != 0, true);
+  EXPECT_EQ (res.to_string (1000), r_flat.density_check (500, 500, 250, 250, 0.3, 0.9, true, db::Region ()).to_string (1000));
+}
+
 TEST(issue_277)
 {
   db::Layout ly;
@@ -1904,3 +1936,152 @@ TEST(issue_400_with_region)
   CHECKPOINT();
   db::compare_layouts (_this, ly, tl::testsrc () + "/testdata/algo/deep_region_au400c.gds");
 }
+
+TEST(SplitLocalComputation)
+{
+  //  many subjects in a single cell: with multiple threads, the interaction check is split
+  //  into chunks computed in parallel. The result must not depend on that.
+
+  db::Layout ly;
+  db::cell_index_type top_cell_index = ly.add_cell ("TOP");
+  db::Cell &top_cell = ly.cell (top_cell_index);
+
+  unsigned int l1 = ly.insert_layer ();
+  unsigned int l2 = ly.insert_layer ();
+
+  for (int i = 0; i < 150; ++i) {
+    for (int j = 0; j < 150; ++j) {
+      top_cell.shapes (l1).insert (db::Box (i * 100, j * 100, i * 100 + 50, j * 100 + 50));
+      if ((i + j) % 3 == 0) {
+        top_cell.shapes (l2).insert (db::Box (i * 100 + 40, j * 100 + 40, i * 100 + 60, j * 100 + 60));
+      }
+    }
+  }
+
+  db::Region flat1 (db::RecursiveShapeIterator (ly, top_cell, l1));
+  db::Region flat2 (db::RecursiveShapeIterator (ly, top_cell, l2));
+  db::Region ref = flat1.selected_interacting (flat2);
+  EXPECT_EQ (ref.size (), size_t (7500));
+
+  for (unsigned int nthreads = 0; nthreads <= 4; nthreads += 4) {
+
+    db::DeepShapeStore dss;
+    dss.set_threads (nthreads);
+
+    db::Region r1 (db::RecursiveShapeIterator (ly, top_cell, l1), dss);
+    db::Region r2 (db::RecursiveShapeIterator (ly, top_cell, l2), dss);
+
+    db::Region res = r1.selected_interacting (r2);
+    EXPECT_EQ (res.size (), size_t (7500));
+    EXPECT_EQ ((res ^ ref).empty (), true);
+
+    res = r1.selected_not_interacting (r2);
+    EXPECT_EQ (res.size (), size_t (15000));
+    EXPECT_EQ ((res & ref).empty (), true);
+
+  }
+}
+
+namespace
+{
+
+/**
+ *  @brief A boolean operation which does not allow combining contexts by their clipped intruders
+ */
+class UnclippedBoolAndOrNotLocalOperation
+  : public db::BoolAndOrNotLocalOperation
+{
+public:
+  UnclippedBoolAndOrNotLocalOperation (bool is_and)
+    : db::BoolAndOrNotLocalOperation (is_and)
+  {
+    //  .. nothing yet ..
+  }
+
+  virtual bool allows_clipped_intruders () const
+  {
+    return false;
+  }
+};
+
+}
+
+static size_t
+count_contexts (db::Layout &ly, db::Cell &top_cell, db::cell_index_type ci, const db::local_operation<db::PolygonRef, db::PolygonRef, db::PolygonRef> *op, unsigned int l1, unsigned int l2, unsigned int lout)
+{
+  db::local_processor<db::PolygonRef, db::PolygonRef, db::PolygonRef> proc (&ly, &top_cell);
+  db::local_processor_contexts<db::PolygonRef, db::PolygonRef, db::PolygonRef> contexts;
+  proc.compute_contexts (contexts, op, l1, l2);
+
+  size_t n = 0;
+  db::local_processor_contexts<db::PolygonRef, db::PolygonRef, db::PolygonRef>::iterator cc = contexts.context_map ().find (&ly.cell (ci));
+  if (cc != contexts.context_map ().end ()) {
+    n = cc->second.size ();
+  }
+
+  proc.compute_results (contexts, op, lout);
+
+  return n;
+}
+
+TEST(ClippedIntruderContexts)
+{
+  //  an array covered partially by a big intruder polygon: the array members inside the
+  //  polygon share the same context as the intruder looks the same inside the cells
+
+  db::Layout ly;
+  db::cell_index_type top_cell_index = ly.add_cell ("TOP");
+  db::cell_index_type child_cell_index = ly.add_cell ("CHILD");
+  db::Cell &top_cell = ly.cell (top_cell_index);
+  db::Cell &child_cell = ly.cell (child_cell_index);
+
+  unsigned int l1 = ly.insert_layer ();
+  unsigned int l2 = ly.insert_layer ();
+
+  child_cell.shapes (l1).insert (db::PolygonRef (db::Polygon (db::Box (0, 0, 100, 100)), ly.shape_repository ()));
+  child_cell.shapes (l1).insert (db::PolygonRef (db::Polygon (db::Box (150, 0, 200, 100)), ly.shape_repository ()));
+  top_cell.insert (db::CellInstArray (db::CellInst (child_cell_index), db::Trans (), db::Vector (300, 0), db::Vector (0, 300), 20, 20));
+
+  db::Point pts[] = {
+    db::Point (-50, -50), db::Point (-50, 4550), db::Point (3050, 4550), db::Point (3050, 3050), db::Point (5000, 3050), db::Point (5000, -50)
+  };
+  db::Polygon poly;
+  poly.assign_hull (pts + 0, pts + sizeof (pts) / sizeof (pts [0]));
+  top_cell.shapes (l2).insert (db::PolygonRef (poly, ly.shape_repository ()));
+  top_cell.shapes (l2).insert (db::PolygonRef (db::Polygon (db::Box (1020, 5000, 1170, 5500)), ly.shape_repository ()));
+
+  //  the number of contexts computed for CHILD with and without clipping
+
+  for (int is_and = 0; is_and < 2; ++is_and) {
+
+    db::BoolAndOrNotLocalOperation clipped_op (is_and != 0);
+    UnclippedBoolAndOrNotLocalOperation unclipped_op (is_and != 0);
+
+    unsigned int lout_clipped = ly.insert_layer ();
+    unsigned int lout_unclipped = ly.insert_layer ();
+
+    //  without clipping, every member touched by the big polygon sees it at a different place
+    EXPECT_EQ (count_contexts (ly, top_cell, child_cell_index, &clipped_op, l1, l2, lout_clipped), size_t (10));
+    EXPECT_EQ (count_contexts (ly, top_cell, child_cell_index, &unclipped_op, l1, l2, lout_unclipped), size_t (275));
+
+    db::Region res_clipped (db::RecursiveShapeIterator (ly, top_cell, lout_clipped));
+    db::Region res_unclipped (db::RecursiveShapeIterator (ly, top_cell, lout_unclipped));
+    EXPECT_EQ ((res_clipped ^ res_unclipped).empty (), true);
+
+  }
+
+  db::Region flat1 (db::RecursiveShapeIterator (ly, top_cell, l1));
+  db::Region flat2 (db::RecursiveShapeIterator (ly, top_cell, l2));
+
+  db::DeepShapeStore dss;
+  dss.set_threads (0);
+
+  db::Region r1 (db::RecursiveShapeIterator (ly, top_cell, l1), dss);
+  db::Region r2 (db::RecursiveShapeIterator (ly, top_cell, l2), dss);
+
+  EXPECT_EQ (((r1 & r2) ^ (flat1 & flat2)).empty (), true);
+  EXPECT_EQ (((r1 - r2) ^ (flat1 - flat2)).empty (), true);
+  EXPECT_EQ ((r1.selected_interacting (r2) ^ flat1.selected_interacting (flat2)).empty (), true);
+  EXPECT_EQ ((r1.selected_inside (r2) ^ flat1.selected_inside (flat2)).empty (), true);
+  EXPECT_EQ ((r1.selected_outside (r2) ^ flat1.selected_outside (flat2)).empty (), true);
+}
@@ -24,8 +24,12 @@
 #include "dbDeepShapeStore.h"
 #include "dbRegion.h"
 #include "dbDeepRegion.h"
+#include "dbEdges.h"
+#include "dbReader.h"
 #include "tlUnitTest.h"
 #include "tlStream.h"
+#include "tlThreadedWorkers.h"
+#include "dbContourAllocator.h"
 
 TEST(1)
 {
@@ -265,3 +269,211 @@ TEST(5_State)
   EXPECT_EQ (store.breakout_cells (0)->find (5) != store.breakout_cells (0)->end (), true);
   EXPECT_EQ (store.breakout_cells (0)->find (3) != store.breakout_cells (0)->end (), true);
 }
+
+TEST(6_Spill)
+{
+  db::Layout ly;
+  {
+    std::string fn (tl::testsrc ());
+    fn += "/testdata/algo/deep_region_l1.gds";
+    tl::InputStream stream (fn);
+    db::Reader reader (stream);
+    reader.read (ly);
+  }
+
+  db::cell_index_type top_cell_index = *ly.begin_top_down ();
+  unsigned int l2 = ly.get_layer (db::LayerProperties (2, 0));
+  unsigned int l3 = ly.get_layer (db::LayerProperties (3, 0));
+
+  db::DeepShapeStore dss;
+  EXPECT_EQ (dss.memory_limit (), size_t (0));
+
+  db::Region r2 (db::RecursiveShapeIterator (ly, ly.cell (top_cell_index), l2), dss);
+  db::Region r3 (db::RecursiveShapeIterator (ly, ly.cell (top_cell_index), l3), dss);
+  db::Edges e3 = r3.edges ();
+
+  std::string r2_ref = r2.to_string (1000);
+  std::string e3_ref = e3.to_string (1000);
+  std::string and_ref = (r2 & r3).to_string (1000);
+  size_t hc_ref = r3.size ();
+
+  //  no limit -> no spilling
+  EXPECT_EQ (dss.spill (), size_t (0));
+  EXPECT_EQ (dss.spilled_layers (), size_t (0));
+
+  dss.set_memory_limit (1);
+  EXPECT_EQ (dss.memory_limit (), size_t (1));
+  EXPECT_EQ (dss.memory_used () > 0, true);
+
+  //  r2, r3, e3 and the merged polygons of r3 which have been computed for the edges
+  EXPECT_EQ (dss.spill (), size_t (4));
+  EXPECT_EQ (dss.spilled_layers (), size_t (4));
+  EXPECT_EQ (dss.memory_used (), size_t (0));
+  EXPECT_EQ (dss.spill_count (), size_t (4));
+
+  //  using a layer brings back this layer only
+  EXPECT_EQ (r2.to_string (1000), r2_ref);
+  EXPECT_EQ (dss.spilled_layers (), size_t (3));
+  EXPECT_EQ (dss.reload_count (), size_t (1));
+
+  //  the operations on r3 use its merged polygons, so the original layer of r3 stays spilled
+  EXPECT_EQ ((r2 & r3).to_string (1000), and_ref);
+  EXPECT_EQ (r3.size (), hc_ref);
+  EXPECT_EQ (e3.to_string (1000), e3_ref);
+  EXPECT_EQ (dss.spilled_layers (), size_t (1));
+  EXPECT_EQ (dss.reload_count (), size_t (3));
+
+  //  dropping a spilled layer is safe
+  EXPECT_EQ (dss.spill () > 0, true);
+  e3.clear ();
+  EXPECT_EQ ((r2 & r3).to_string (1000), and_ref);
+
+  //  the non-layer specific access brings back all layers
+  dss.spill ();
+  EXPECT_EQ (dss.spilled_layers () > 0, true);
+  dss.layout (0);
+  EXPECT_EQ (dss.spilled_layers (), size_t (0));
+  EXPECT_EQ (r3.size (), hc_ref);
+}
+
+TEST(7_SaveAndLoadLayer)
+{
+  db::Layout ly;
+  {
+    std::string fn (tl::testsrc ());
+    fn += "/testdata/algo/deep_region_l1.gds";
+    tl::InputStream stream (fn);
+    db::Reader reader (stream);
+    reader.read (ly);
+  }
+
+  db::cell_index_type top_cell_index = *ly.begin_top_down ();
+  unsigned int l2 = ly.get_layer (db::LayerProperties (2, 0));
+  unsigned int l3 = ly.get_layer (db::LayerProperties (3, 0));
+
+  db::DeepShapeStore dss1;
+  db::Region r2 (db::RecursiveShapeIterator (ly, ly.cell (top_cell_index), l2), dss1);
+  db::Region r3 (db::RecursiveShapeIterator (ly, ly.cell (top_cell_index), l3), dss1);
+  db::Region r23 = r2 & r3;
+
+  db::DeepShapeStore dss2;
+  db::Region r2b (db::RecursiveShapeIterator (ly, ly.cell (top_cell_index), l2), dss2);
+
+  //  the hash value does not depend on the store
+  EXPECT_EQ (db::DeepShapeStore::layer_hash (db::DeepLayer (r2)) == db::DeepShapeStore::layer_hash (db::DeepLayer (r2b)), true);
+  EXPECT_EQ (db::DeepShapeStore::layer_hash (db::DeepLayer (r2)) == db::DeepShapeStore::layer_hash (db::DeepLayer (r3)), false);
+
+  std::string fn = this->tmp_file ("layer.bin");
+  db::DeepShapeStore::save_layer (db::DeepLayer (r23), "key", fn);
+
+  db::DeepLayer dl = db::DeepLayer (r2b).derived ();
+  EXPECT_EQ (db::DeepShapeStore::load_layer (dl, "other", fn), false);
+  EXPECT_EQ (db::DeepShapeStore::load_layer (dl, "key", fn), true);
+
+  db::Region r23b (new db::DeepRegion (dl));
+  EXPECT_EQ (r23b.to_string (1000), r23.to_string (1000));
+  EXPECT_EQ (db::DeepShapeStore::layer_hash (dl) == db::DeepShapeStore::layer_hash (db::DeepLayer (r23)), true);
+}
+
+TEST(8_ThreadAffinity)
+{
+  db::Layout ly;
+  {
+    std::string fn (tl::testsrc ());
+    fn += "/testdata/algo/deep_region_l1.gds";
+    tl::InputStream stream (fn);
+    db::Reader reader (stream);
+    reader.read (ly);
+  }
+
+  db::cell_index_type top_cell_index = *ly.begin_top_down ();
+  unsigned int l2 = ly.get_layer (db::LayerProperties (2, 0));
+  unsigned int l3 = ly.get_layer (db::LayerProperties (3, 0));
+
+  db::DeepShapeStore dss;
+  EXPECT_EQ (dss.thread_affinity ().empty (), true);
+
+  db::Region r2 (db::RecursiveShapeIterator (ly, ly.cell (top_cell_index), l2), dss);
+  db::Region r3 (db::RecursiveShapeIterator (ly, ly.cell (top_cell_index), l3), dss);
+
+  dss.set_threads (0);
+  db::Region::area_type and_ref = (r2 & r3).area ();
+  db::Region::area_type sized_ref = r3.sized (100).area ();
+
+  std::vector<int> cpus = tl::thread_affinity_layout (2, false);
+
+  dss.set_threads (2);
+  dss.set_thread_affinity (cpus);
+  EXPECT_EQ (dss.thread_affinity () == cpus, true);
+
+  EXPECT_EQ ((r2 & r3).area (), and_ref);
+  EXPECT_EQ (r3.sized (100).area (), sized_ref);
+}
+
+//  Spilling releases the polygons of the spilled layers
+TEST(9_SpillReleasesShapes)
+{
+  db::Layout ly;
+  db::cell_index_type top = ly.add_cell ("TOP");
+  unsigned int l1 = ly.insert_layer (db::LayerProperties (1, 0));
+  unsigned int l2 = ly.insert_layer (db::LayerProperties (2, 0));
+
+  //  distinct polygons, so they are not shared in the shape repository
+  for (int i = 0; i < 20000; ++i) {
+
+    db::Coord a = i % 1000, b = i / 1000;
+    db::Point pts[] = {
+      db::Point (0, 0), db::Point (0, 3000), db::Point (1000 + b, 3000), db::Point (1000 + b, 2000),
+      db::Point (2000, 2000), db::Point (2000, 1000), db::Point (3000 + a, 1000), db::Point (3000 + a, 0)
+    };
+
+    db::Polygon poly;
+    poly.assign_hull (pts, pts + sizeof (pts) / sizeof (pts [0]));
+    ly.cell (top).shapes (l1).insert (poly.moved (db::Vector ((i % 100) * 5000, (i / 100) * 5000)));
+
+  }
+
+  for (int i = 0; i < 10; ++i) {
+    ly.cell (top).shapes (l2).insert (db::Box (i * 1000, 0, i * 1000 + 500 + i, 500));
+  }
+
+  db::DeepShapeStore dss;
+  db::Region r1 (db::RecursiveShapeIterator (ly, ly.cell (top), l1), dss);
+  db::Region r2 (db::RecursiveShapeIterator (ly, ly.cell (top), l2), dss);
+
+  db::DeepLayer dl1 (r1), dl2 (r2);
+  size_t hash_ref = db::DeepShapeStore::layer_hash (dl1);
+
+  const db::Layout &dss_layout = dl2.layout ();
+  EXPECT_EQ (dss_layout.shape_repository ().repository (db::Polygon::tag ()).size (), size_t (20010));
+
+  size_t mem = dss.memory_used ();
+  dss.set_memory_limit (mem / 2);
+
+  //  makes r1 the least recently used layer
+  dl2.layout ();
+
+  size_t pool_size = db::contour_point_pool_size ();
+
+  EXPECT_EQ (dss.spill (), size_t (1));
+  EXPECT_EQ (dss.spilled_layers (), size_t (1));
+  EXPECT_EQ (dss.memory_used () < mem / 10, true);
+
+  //  the polygons of r1 are gone and their memory is given back
+  EXPECT_EQ (dss_layout.shape_repository ().repository (db::Polygon::tag ()).size (), size_t (10));
+  EXPECT_EQ (db::contour_point_pool_size () < pool_size, true);
+
+  //  using the layer brings back the polygons
+  EXPECT_EQ (db::DeepShapeStore::layer_hash (dl1), hash_ref);
+  EXPECT_EQ (dss.spilled_layers (), size_t (0));
+  EXPECT_EQ (dss_layout.shape_repository ().repository (db::Polygon::tag ()).size (), size_t (20010));
+
+  //  a locked repository keeps the polygons
+  dss.lock_shape_repository (dl1.layout_index ());
+  dl2.layout ();
+  EXPECT_EQ (dss.spill (), size_t (1));
+  EXPECT_EQ (dss_layout.shape_repository ().repository (db::Polygon::tag ()).size (), size_t (20010));
+  dss.unlock_shape_repository (dl1.layout_index ());
+
+  EXPECT_EQ (db::DeepShapeStore::layer_hash (dl1), hash_ref);
+}
@@ -2483,3 +2483,104 @@ TEST(135b)
   EXPECT_EQ (run_test135b (_this, db::Trans (db::Trans::m90)), "(-78,25;-33,34;-36,33;-37,33)");
   EXPECT_EQ (run_test135b (_this, db::Trans (db::Trans::m135)), "(-26,-78;-35,-33;-33,-36;-33,-37)");
 }
+
+static void make_random_polygons (std::vector<db::Polygon> &polygons, size_t n, unsigned int seed)
+{
+  //  a simple LCG to be independent from the platform's random number generator
+  unsigned int r = seed;
+  for (size_t i = 0; i < n; ++i) {
+
+    db::Point pts[3];
+    db::Coord x0 = 0, y0 = 0;
+    for (unsigned int j = 0; j < 3; ++j) {
+      r = r * 1103515245 + 12345;
+      db::Coord dx = db::Coord ((r >> 8) % 1000);
+      r = r * 1103515245 + 12345;
+      db::Coord dy = db::Coord ((r >> 8) % 1000);
+      if (j == 0) {
+        r = r * 1103515245 + 12345;
+        x0 = db::Coord ((r >> 8) % 100000);
+        r = r * 1103515245 + 12345;
+        y0 = db::Coord ((r >> 8) % 100000);
+      }
+      //  produce some Manhattan shapes too
+      pts [j] = db::Point (x0 + dx, y0 + ((i % 3) == 0 ? dx : dy));
+    }
+
+    db::Polygon p;
+    if ((i % 3) == 0) {
+      p = db::Polygon (db::Box (pts [0], pts [1]));
+    } else {
+      p.assign_hull (&pts[0], &pts[sizeof(pts) / sizeof(pts[0])]);
+    }
+    polygons.push_back (p);
+
+  }
+}
+
+TEST(200_MultiThreaded)
+{
+  std::vector<db::Polygon> a, b;
+  make_random_polygons (a, 20000, 1);
+  make_random_polygons (b, 20000, 2);
+
+  std::vector<db::Polygon> out_st, out_mt;
+  std::vector<db::Edge> edges_st, edges_mt;
+
+  db::EdgeProcessor ep_st;
+  db::EdgeProcessor ep_mt;
+  ep_mt.set_threads (4);
+  EXPECT_EQ (ep_mt.threads (), (unsigned int) 4);
+
+  out_st.clear ();
+  out_mt.clear ();
+  ep_st.merge (a, out_st, 0, true, true);
+  ep_mt.merge (a, out_mt, 0, true, true);
+  EXPECT_EQ (out_st.size () > 10, true);
+  EXPECT_EQ (out_st == out_mt, true);
+
+  out_st.clear ();
+  out_mt.clear ();
+  ep_st.merge (a, out_st, 1, false, false);
+  ep_mt.merge (a, out_mt, 1, false, false);
+  EXPECT_EQ (out_st == out_mt, true);
+
+  edges_st.clear ();
+  edges_mt.clear ();
+  ep_st.merge (a, edges_st, 0);
+  ep_mt.merge (a, edges_mt, 0);
+  EXPECT_EQ (edges_st.size () > 10, true);
+  EXPECT_EQ (edges_st == edges_mt, true);
+
+  out_st.clear ();
+  out_mt.clear ();
+  ep_st.boolean (a, b, out_st, db::BooleanOp::And, false, true);
+  ep_mt.boolean (a, b, out_mt, db::BooleanOp::And, false, true);
+  EXPECT_EQ (out_st.size () > 10, true);
+  EXPECT_EQ (out_st == out_mt, true);
+
+  out_st.clear ();
+  out_mt.clear ();
+  ep_st.boolean (a, b, out_st, db::BooleanOp::ANotB, true, false);
+  ep_mt.boolean (a, b, out_mt, db::BooleanOp::ANotB, true, false);
+  EXPECT_EQ (out_st == out_mt, true);
+
+  out_st.clear ();
+  out_mt.clear ();
+  ep_st.boolean (a, b, out_st, db::BooleanOp::Xor, false, false);
+  ep_mt.boolean (a, b, out_mt, db::BooleanOp::Xor, false, false);
+  EXPECT_EQ (out_st == out_mt, true);
+
+  out_st.clear ();
+  out_mt.clear ();
+  ep_st.size (a, 50, 30, out_st, 2, true, true);
+  ep_mt.size (a, 50, 30, out_mt, 2, true, true);
+  EXPECT_EQ (out_st.size () > 10, true);
+  EXPECT_EQ (out_st == out_mt, true);
+
+  out_st.clear ();
+  out_mt.clear ();
+  ep_st.size (a, -20, -20, out_st, 2, false, false);
+  ep_mt.size (a, -20, -20, out_mt, 2, false, false);
+  EXPECT_EQ (out_st == out_mt, true);
+}
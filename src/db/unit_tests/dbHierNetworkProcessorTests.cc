@@ -944,7 +944,7 @@ static void copy_cluster_shapes (const std::string *&attrs, db::Shapes &out, db:
   }
 }
 
-static void run_hc_test (tl::TestBase *_this, const std::string &file, const std::string &au_file)
+static void run_hc_test (tl::TestBase *_this, const std::string &file, const std::string &au_file, unsigned int threads = 0)
 {
   db::Layout ly;
   unsigned int l1 = 0, l2 = 0, l3 = 0, l4 = 0, l5 = 0, l6 = 0;
@@ -1020,6 +1020,7 @@ static void run_hc_test (tl::TestBase *_this, const std::string &file, const std
   conn.connect_global (l6, "BULK2");
 
   db::hier_clusters<db::PolygonRef> hc;
+  hc.set_threads (threads);
   hc.build (ly, ly.cell (*ly.begin_top_down ()), conn);
 
   std::vector<std::pair<db::Polygon::area_type, unsigned int> > net_layers;
@@ -1288,6 +1289,15 @@ TEST(120_HierClustersCombArrays)
   run_hc_test_with_backannotation (_this, "comb2.gds", "comb2_au2.gds");
 }
 
+TEST(121_HierClustersMultiThreaded)
+{
+  //  the results need to be the same as for the single-threaded case
+  run_hc_test (_this, "hc_test_l1.gds", "hc_test_au1.gds", 4);
+  run_hc_test (_this, "hc_test_l5.gds", "hc_test_au5.gds", 4);
+  run_hc_test (_this, "hc_test_l10.gds", "hc_test_au10.gds", 4);
+  run_hc_test (_this, "hc_test_l14.gds", "hc_test_au14.gds", 4);
+}
+
 static size_t root_nets (const db::connected_clusters<db::PolygonRef> &cc)
 {
   size_t n = 0;
@@ -25,6 +25,7 @@
 #include "dbLayoutDiff.h"
 #include "dbLayerProperties.h"
 #include "dbLayout.h"
+#include "dbRegion.h"
 
 #include <sstream>
 
@@ -1477,3 +1478,60 @@ TEST(7)
 }
 
 
+
+TEST(8_DifferenceRegion)
+{
+  db::Layout a;
+  unsigned int l1 = a.insert_layer (db::LayerProperties (1, 0));
+
+  db::cell_index_type top = a.add_cell ("TOP");
+  db::cell_index_type ca = a.add_cell ("A");
+  a.cell (ca).shapes (l1).insert (db::Box (0, 0, 100, 100));
+  a.cell (top).insert (db::CellInstArray (db::CellInst (ca), db::Trans ()));
+  a.cell (top).insert (db::CellInstArray (db::CellInst (ca), db::Trans (db::Vector (1000, 0))));
+
+  db::Layout b = a;
+
+  EXPECT_EQ (db::difference_region (a, top, b, top, 0, 0).empty (), true);
+
+  //  a change inside A shows up in both placements
+  b.cell (ca).shapes (l1).insert (db::Box (10, 10, 20, 20));
+
+  db::Region r = db::difference_region (a, top, b, top, 0, 0);
+  EXPECT_EQ (r.bbox ().to_string (), "(9,9;1021,21)");
+  EXPECT_EQ (r.area (), 288);
+
+  //  a new instance
+  b.cell (top).insert (db::CellInstArray (db::CellInst (ca), db::Trans (db::Vector (0, 1000))));
+
+  r = db::difference_region (a, top, b, top, 0, 0);
+  EXPECT_EQ (r.bbox ().to_string (), "(-1,9;1021,1101)");
+  EXPECT_EQ (r.area (), 288 + 102 * 102);
+
+  //  a layer present in b only
+  db::Layout c = a;
+  unsigned int l2 = c.insert_layer (db::LayerProperties (2, 0));
+  c.cell (ca).shapes (l2).insert (db::Box (50, 50, 60, 60));
+
+  r = db::difference_region (a, top, c, top, 0, 0);
+  EXPECT_EQ (r.bbox ().to_string (), "(49,49;1061,61)");
+  EXPECT_EQ (r.area (), 2 * 12 * 12);
+
+  //  a layer present in a only
+  r = db::difference_region (c, top, a, top, 0, 0);
+  EXPECT_EQ (r.bbox ().to_string (), "(49,49;1061,61)");
+  EXPECT_EQ (r.area (), 2 * 12 * 12);
+
+  //  large arrays contribute their bounding box
+  db::Layout d = a;
+  db::cell_index_type cb = d.add_cell ("B");
+  d.cell (cb).insert (db::CellInstArray (db::CellInst (ca), db::Trans (db::Vector (0, 2000)), db::Vector (200, 0), db::Vector (0, 200), 10, 10));
+  d.cell (top).insert (db::CellInstArray (db::CellInst (cb), db::Trans ()));
+
+  db::Layout e = d;
+  e.cell (ca).shapes (l1).insert (db::Box (10, 10, 20, 20));
+
+  r = db::difference_region (d, top, e, top, 0, 0);
+  EXPECT_EQ (r.bbox ().to_string (), "(9,9;1821,3821)");
+  EXPECT_EQ (r.area (), 288 + 1812 * 1812);
+}
@@ -25,6 +25,7 @@
 #include "dbLayout.h"
 #include "tlString.h"
 #include "tlUnitTest.h"
+#include "tlThreads.h"
 
 std::string set2string (const std::set<db::cell_index_type> &set)
 {
@@ -39,6 +40,80 @@ std::string set2string (const std::set<db::cell_index_type> &set)
 }
 
 
+namespace
+{
+
+class CellFillThread
+  : public tl::Thread
+{
+public:
+  CellFillThread (db::Layout *layout, db::cell_index_type ci, db::cell_index_type leaf, unsigned int layer)
+    : mp_layout (layout), m_ci (ci), m_leaf (leaf), m_layer (layer)
+  {
+    //  .. nothing yet ..
+  }
+
+protected:
+  virtual void run ()
+  {
+    db::Cell &cell = mp_layout->cell (m_ci);
+    db::Shapes &shapes = cell.shapes (m_layer);
+
+    for (int i = 0; i < 1000; ++i) {
+      shapes.insert (db::Box (i * 10, 0, i * 10 + 5, 100));
+      db::Polygon poly (db::Box (0, 0, 100 + (i % 10) * 10, 200));
+      shapes.insert (db::PolygonRef (poly.moved (db::Vector (i * 10, 1000)), mp_layout->shape_repository ()));
+    }
+
+    for (int i = 0; i < 100; ++i) {
+      db::CellInstArray inst (db::CellInst (m_leaf), db::ICplxTrans (2.0, 0.0, false, db::Vector (0, i * 1000)), mp_layout->array_repository (), db::Vector (100, 0), db::Vector (0, 100), 2 + (i % 5), 2);
+      cell.insert (inst);
+    }
+  }
+
+private:
+  db::Layout *mp_layout;
+  db::cell_index_type m_ci, m_leaf;
+  unsigned int m_layer;
+};
+
+}
+
+static void
+fill_for_sort (db::Layout &g, unsigned int l1)
+{
+  db::cell_index_type top = g.add_cell ("TOP");
+
+  //  many small containers which are sorted concurrently
+  for (int c = 0; c < 50; ++c) {
+    db::cell_index_type ci = g.add_cell (("C" + tl::to_string (c)).c_str ());
+    for (int i = 0; i < 200; ++i) {
+      int x = (i * 7919) % 10000, y = (i * 104729) % 10000;
+      g.cell (ci).shapes (l1).insert (db::Box (x, y, x + 10 + i % 50, y + 10 + i % 30));
+    }
+    g.cell (top).insert (db::CellInstArray (db::CellInst (ci), db::Trans (db::Vector (0, c * 20000))));
+  }
+
+  //  one container large enough for the box tree being sorted by multiple threads
+  for (int i = 0; i < int (db::box_tree_parallel_sort_min) + 50000; ++i) {
+    db::Coord x = db::Coord ((size_t (i) * 7919) % 1000000), y = db::Coord ((size_t (i) * 104729) % 1000000);
+    g.cell (top).shapes (l1).insert (db::Box (x, y, x + 10 + i % 500, y + 10 + i % 300));
+  }
+}
+
+static std::string
+touching_sequence (const db::Shapes &shapes, const db::Box &box)
+{
+  std::string r;
+  for (db::ShapeIterator s = shapes.begin_touching (box, db::ShapeIterator::All); ! s.at_end (); ++s) {
+    if (! r.empty ()) {
+      r += ";";
+    }
+    r += s->to_string ();
+  }
+  return r;
+}
+
 TEST(1) 
 {
   db::Layout g;
@@ -464,3 +539,103 @@ TEST(4)
   prop_id = g.properties_repository ().properties_id (ps);
   EXPECT_EQ (el.property_ids_dirty, true);
 }
+
+TEST(5)
+{
+  //  concurrent fill mode
+
+  db::Layout g (false);
+  unsigned int l1 = g.insert_layer (db::LayerProperties (1, 0));
+
+  db::cell_index_type top = g.add_cell ("TOP");
+  db::cell_index_type leaf = g.add_cell ("LEAF");
+  g.cell (leaf).shapes (l1).insert (db::Box (0, 0, 10, 10));
+
+  std::vector<db::cell_index_type> cells;
+  for (unsigned int i = 0; i < 4; ++i) {
+    cells.push_back (g.add_cell (("C" + tl::to_string (i)).c_str ()));
+    g.cell (top).insert (db::CellInstArray (db::CellInst (cells.back ()), db::Trans (db::Vector (0, i * 200000))));
+  }
+  g.update ();
+
+  EventListener el;
+  g.hier_changed_event.add (&el, &EventListener::hier_changed);
+  g.bboxes_changed_event.add (&el, &EventListener::bboxes_changed);
+
+  EXPECT_EQ (g.is_concurrent_fill (), false);
+  g.start_concurrent_fill ();
+  EXPECT_EQ (g.is_concurrent_fill (), true);
+  EXPECT_EQ (g.under_construction (), true);
+  EXPECT_EQ (el.hier_dirty, true);
+  EXPECT_EQ (el.bboxes_all_dirty, true);
+
+  std::vector<CellFillThread *> threads;
+  for (std::vector<db::cell_index_type>::const_iterator c = cells.begin (); c != cells.end (); ++c) {
+    threads.push_back (new CellFillThread (&g, *c, leaf, l1));
+    threads.back ()->start ();
+  }
+
+  for (std::vector<CellFillThread *>::const_iterator t = threads.begin (); t != threads.end (); ++t) {
+    (*t)->wait ();
+    delete *t;
+  }
+
+  g.end_concurrent_fill ();
+  EXPECT_EQ (g.is_concurrent_fill (), false);
+  EXPECT_EQ (g.under_construction (), false);
+  EXPECT_EQ (g.hier_dirty (), false);
+  EXPECT_EQ (g.bboxes_dirty (), false);
+
+  //  identical shapes and arrays are shared between the cells
+  EXPECT_EQ (g.shape_repository ().repository (db::Polygon::tag ()).size (), size_t (10));
+
+  for (std::vector<db::cell_index_type>::const_iterator c = cells.begin (); c != cells.end (); ++c) {
+    EXPECT_EQ (g.cell (*c).shapes (l1).size (), size_t (2000));
+    EXPECT_EQ (g.cell (*c).cell_instances (), size_t (100));
+    EXPECT_EQ (g.cell (*c).bbox ().to_string (), "(0,0;10180,99120)");
+  }
+
+  EXPECT_EQ (g.cell (top).bbox ().to_string (), "(0,0;10180,699120)");
+  EXPECT_EQ (g.cell (leaf).parent_cells (), size_t (4));
+}
+
+TEST(6)
+{
+  //  parallel sorting of the shapes on update
+
+  db::Layout g1 (false), g4 (false);
+  unsigned int l1 = g1.insert_layer (db::LayerProperties (1, 0));
+  unsigned int l4 = g4.insert_layer (db::LayerProperties (1, 0));
+
+  fill_for_sort (g1, l1);
+  fill_for_sort (g4, l4);
+
+  g1.update ();
+
+  db::set_sort_threads (4);
+  try {
+    g4.update ();
+    db::set_sort_threads (1);
+  } catch (...) {
+    db::set_sort_threads (1);
+    throw;
+  }
+
+  EXPECT_EQ (g4.bboxes_dirty (), false);
+  EXPECT_EQ (g4.cell_by_name ("TOP").second, g1.cell_by_name ("TOP").second);
+
+  //  region queries must visit the shapes in the same order as with the sequential sort
+  for (db::Layout::const_iterator c = g1.begin (); c != g1.end (); ++c) {
+
+    const db::Shapes &s1 = c->shapes (l1);
+    const db::Shapes &s4 = g4.cell (c->cell_index ()).shapes (l4);
+    EXPECT_EQ (s4.size (), s1.size ());
+    EXPECT_EQ (touching_sequence (s4, db::Box::world ()) == touching_sequence (s1, db::Box::world ()), true);
+
+    for (int i = 0; i < 10; ++i) {
+      db::Box b (db::Point (i * 97000, i * 51000), db::Point (i * 97000 + 5000, i * 51000 + 8000));
+      EXPECT_EQ (touching_sequence (s4, b), touching_sequence (s1, b));
+    }
+
+  }
+}
@@ -4536,3 +4536,92 @@ TEST(28_JoinSymmetricNets)
   )
 }
 
+
+TEST(29_MultiThreaded)
+{
+  const char *nls1 =
+    "circuit INV ($1=IN,$2=OUT,$3=VDD,$4=VSS);\n"
+    "  device PMOS $1 (S=VDD,G=IN,D=OUT) (L=0.25,W=0.95);\n"
+    "  device NMOS $2 (S=VSS,G=IN,D=OUT) (L=0.25,W=0.95);\n"
+    "end;\n"
+    "circuit NAND ($0=A,$1=B,$2=OUT,$3=VDD,$4=VSS);\n"
+    "  device PMOS $1 (S=VDD,G=A,D=OUT) (L=0.25,W=0.95);\n"
+    "  device PMOS $2 (S=VDD,G=B,D=OUT) (L=0.25,W=0.95);\n"
+    "  device NMOS $3 (S=VSS,G=A,D=INT) (L=0.25,W=0.95);\n"
+    "  device NMOS $4 (S=INT,G=B,D=OUT) (L=0.25,W=0.95);\n"
+    "end;\n"
+    "circuit NOR ($0=A,$1=B,$2=OUT,$3=VDD,$4=VSS);\n"
+    "  device PMOS $1 (S=VDD,G=A,D=INT) (L=0.25,W=0.95);\n"
+    "  device PMOS $2 (S=INT,G=B,D=OUT) (L=0.25,W=0.95);\n"
+    "  device NMOS $3 (S=VSS,G=A,D=OUT) (L=0.25,W=0.95);\n"
+    "  device NMOS $4 (S=VSS,G=B,D=OUT) (L=0.25,W=0.95);\n"
+    "end;\n"
+    "circuit AND ($0=A,$1=B,$2=OUT,$3=VDD,$4=VSS);\n"
+    "  subcircuit NAND $1 ($0=A,$1=B,$2=INT,$3=VDD,$4=VSS);\n"
+    "  subcircuit INV $2 ($1=INT,$2=OUT,$3=VDD,$4=VSS);\n"
+    "end;\n"
+    "circuit OR ($0=A,$1=B,$2=OUT,$3=VDD,$4=VSS);\n"
+    "  subcircuit NOR $1 ($0=A,$1=B,$2=INT,$3=VDD,$4=VSS);\n"
+    "  subcircuit INV $2 ($1=INT,$2=OUT,$3=VDD,$4=VSS);\n"
+    "end;\n"
+    "circuit TOP ($0=IN1,$1=IN2,$2=OUT,$3=VDD,$4=VSS);\n"
+    "  subcircuit AND $1 ($0=IN1,$1=IN2,$2=INT1,$3=VDD,$4=VSS);\n"
+    "  subcircuit OR $2 ($0=IN1,$1=IN2,$2=INT2,$3=VDD,$4=VSS);\n"
+    "  subcircuit NAND $3 ($0=INT1,$1=INT2,$2=OUT,$3=VDD,$4=VSS);\n"
+    "end;\n";
+
+  //  same, but NOR has a different device width
+  const char *nls2 =
+    "circuit INV ($1=IN,$2=OUT,$3=VDD,$4=VSS);\n"
+    "  device NMOS $1 (S=VSS,G=IN,D=OUT) (L=0.25,W=0.95);\n"
+    "  device PMOS $2 (S=VDD,G=IN,D=OUT) (L=0.25,W=0.95);\n"
+    "end;\n"
+    "circuit NOR ($0=A,$1=B,$2=OUT,$3=VDD,$4=VSS);\n"
+    "  device PMOS $1 (S=VDD,G=A,D=INT) (L=0.25,W=0.95);\n"
+    "  device PMOS $2 (S=INT,G=B,D=OUT) (L=0.25,W=0.95);\n"
+    "  device NMOS $3 (S=VSS,G=A,D=OUT) (L=0.25,W=0.95);\n"
+    "  device NMOS $4 (S=VSS,G=B,D=OUT) (L=0.25,W=1.5);\n"
+    "end;\n"
+    "circuit NAND ($0=A,$1=B,$2=OUT,$3=VDD,$4=VSS);\n"
+    "  device PMOS $1 (S=VDD,G=B,D=OUT) (L=0.25,W=0.95);\n"
+    "  device PMOS $2 (S=VDD,G=A,D=OUT) (L=0.25,W=0.95);\n"
+    "  device NMOS $3 (S=VSS,G=A,D=INT) (L=0.25,W=0.95);\n"
+    "  device NMOS $4 (S=INT,G=B,D=OUT) (L=0.25,W=0.95);\n"
+    "end;\n"
+    "circuit OR ($0=A,$1=B,$2=OUT,$3=VDD,$4=VSS);\n"
+    "  subcircuit INV $1 ($1=INT,$2=OUT,$3=VDD,$4=VSS);\n"
+    "  subcircuit NOR $2 ($0=A,$1=B,$2=INT,$3=VDD,$4=VSS);\n"
+    "end;\n"
+    "circuit AND ($0=A,$1=B,$2=OUT,$3=VDD,$4=VSS);\n"
+    "  subcircuit NAND $1 ($0=A,$1=B,$2=INT,$3=VDD,$4=VSS);\n"
+    "  subcircuit INV $2 ($1=INT,$2=OUT,$3=VDD,$4=VSS);\n"
+    "end;\n"
+    "circuit TOP ($0=IN1,$1=IN2,$2=OUT,$3=VDD,$4=VSS);\n"
+    "  subcircuit NAND $1 ($0=INT1,$1=INT2,$2=OUT,$3=VDD,$4=VSS);\n"
+    "  subcircuit OR $2 ($0=IN1,$1=IN2,$2=INT2,$3=VDD,$4=VSS);\n"
+    "  subcircuit AND $3 ($0=IN1,$1=IN2,$2=INT1,$3=VDD,$4=VSS);\n"
+    "end;\n";
+
+  db::Netlist nl1, nl2;
+  prep_nl (nl1, nls1);
+  prep_nl (nl2, nls2);
+
+  NetlistCompareTestLogger logger_st;
+  db::NetlistComparer comp_st (&logger_st);
+  bool good_st = comp_st.compare (&nl1, &nl2);
+
+  NetlistCompareTestLogger logger_mt;
+  db::NetlistComparer comp_mt (&logger_mt);
+  comp_mt.set_threads (4);
+  EXPECT_EQ (comp_mt.threads (), (unsigned int) 4);
+  bool good_mt = comp_mt.compare (&nl1, &nl2);
+
+  //  the multi-threaded compare must deliver the same log in the same order
+  EXPECT_EQ (logger_mt.text (), logger_st.text ());
+  EXPECT_EQ (good_mt, good_st);
+  EXPECT_EQ (good_mt, false);
+
+  EXPECT_EQ (logger_st.text ().find ("begin_circuit INV INV\n") < logger_st.text ().find ("begin_circuit AND AND\n"), true);
+  EXPECT_EQ (logger_st.text ().find ("end_circuit NOR NOR NOMATCH") != std::string::npos, true);
+  EXPECT_EQ (logger_st.text ().find ("end_circuit NAND NAND MATCH") != std::string::npos, true);
+}
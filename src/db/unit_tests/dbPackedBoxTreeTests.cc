@@ -0,0 +1,219 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2020 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "dbPackedBoxTree.h"
+#include "dbBoxTree.h"
+#include "dbBoxConvert.h"
+#include "tlUnitTest.h"
+#include "tlTimer.h"
+
+#include <set>
+#include <stdlib.h>
+
+namespace
+{
+
+struct Box2Box {
+  typedef db::simple_bbox_tag complexity;
+  const db::Box &operator() (const db::Box &b) const { return b; }
+};
+
+typedef db::packed_box_tree<db::Box, db::Box, Box2Box> TestTree;
+typedef db::packed_box_tree<db::Box, db::Box, Box2Box, 8> TestTree8;
+
+inline int rvalue ()
+{
+  return (rand () % 10000) - 5000;
+}
+
+inline db::Box rbox ()
+{
+  int x = rvalue ();
+  int y = rvalue ();
+  return db::Box (x, y, x + rand () % 200, y + rand () % 200);
+}
+
+template <class Tree>
+static void test_query (tl::TestBase *_this, const Tree &t, const db::Box &b)
+{
+  Box2Box conv;
+
+  std::multiset<db::Box> touching_good, overlapping_good;
+  for (typename Tree::const_iterator e = t.begin (); e != t.end (); ++e) {
+    if (b.touches (*e)) {
+      touching_good.insert (*e);
+    }
+    if (b.overlaps (*e)) {
+      overlapping_good.insert (*e);
+    }
+  }
+
+  std::multiset<db::Box> touching, overlapping;
+  for (typename Tree::touching_iterator i = t.begin_touching (b, conv); ! i.at_end (); ++i) {
+    touching.insert (*i);
+  }
+  for (typename Tree::overlapping_iterator i = t.begin_overlapping (b, conv); ! i.at_end (); ++i) {
+    overlapping.insert (*i);
+  }
+
+  EXPECT_EQ (touching.size (), touching_good.size ());
+  EXPECT_EQ (touching == touching_good, true);
+  EXPECT_EQ (overlapping.size (), overlapping_good.size ());
+  EXPECT_EQ (overlapping == overlapping_good, true);
+}
+
+}
+
+TEST(1)
+{
+  Box2Box conv;
+  TestTree t;
+
+  t.sort (conv);
+  EXPECT_EQ (t.levels (), (unsigned int) 0);
+  EXPECT_EQ (t.begin_touching (db::Box (0, 0, 100, 100), conv).at_end (), true);
+
+  t.insert (db::Box (0, 0, 10, 10));
+  t.sort (conv);
+  EXPECT_EQ (t.levels (), (unsigned int) 1);
+
+  TestTree::touching_iterator i = t.begin_touching (db::Box (10, 10, 20, 20), conv);
+  EXPECT_EQ (i.at_end (), false);
+  EXPECT_EQ (i->to_string (), "(0,0;10,10)");
+  ++i;
+  EXPECT_EQ (i.at_end (), true);
+
+  EXPECT_EQ (t.begin_overlapping (db::Box (10, 10, 20, 20), conv).at_end (), true);
+  EXPECT_EQ (t.begin_touching (db::Box (), conv).at_end (), true);
+
+  //  inserting invalidates the index
+  t.insert (db::Box (100, 100, 110, 110));
+  EXPECT_EQ (t.levels (), (unsigned int) 0);
+  EXPECT_EQ (t.begin_touching (db::Box (0, 0, 200, 200), conv).at_end (), true);
+}
+
+TEST(2)
+{
+  TestTree t;
+  TestTree8 t8;
+
+  for (int i = 0; i < 1000; ++i) {
+    //  insert some empty boxes ..
+    db::Box b;
+    if (rand () % 10 != 0) {
+      b = rbox ();
+    }
+    t.insert (b);
+    t8.insert (b);
+  }
+
+  Box2Box conv;
+  t.sort (conv);
+  t8.sort (conv);
+
+  EXPECT_EQ (t.size (), size_t (1000));
+  EXPECT_EQ (t.levels (), (unsigned int) 4);
+
+  for (int i = 0; i < 200; ++i) {
+    db::Box b = rbox ().enlarged (db::Vector (rand () % 2000, rand () % 2000));
+    test_query (_this, t, b);
+    test_query (_this, t8, b);
+  }
+
+  test_query (_this, t, db::Box::world ());
+  test_query (_this, t8, db::Box::world ());
+}
+
+TEST(3)
+{
+  //  degenerated boxes and identical centers
+  TestTree t;
+  for (int i = 0; i < 500; ++i) {
+    t.insert (db::Box (0, 0, i % 7, 0));
+    t.insert (db::Box (-i, -i, i, i));
+  }
+
+  Box2Box conv;
+  t.sort (conv);
+
+  test_query (_this, t, db::Box (0, 0, 0, 0));
+  test_query (_this, t, db::Box (3, 0, 3, 0));
+  test_query (_this, t, db::Box (100, 100, 200, 200));
+  test_query (_this, t, db::Box (-1000, -1000, -499, -499));
+}
+
+//  Benchmark: region queries on the packed tree vs. the box tree
+TEST(4)
+{
+  typedef db::box_tree<db::Box, db::Box, Box2Box> RefTree;
+
+  Box2Box conv;
+  TestTree t;
+  RefTree rt;
+
+  int n = 1000000;
+  for (int i = 0; i < n; ++i) {
+    int x = rand () % 1000000, y = rand () % 1000000;
+    db::Box b (x, y, x + rand () % 500, y + rand () % 500);
+    t.insert (b);
+    rt.insert (b);
+  }
+
+  {
+    tl::SelfTimer timer ("test 4 packed tree sort");
+    t.sort (conv);
+  }
+
+  {
+    tl::SelfTimer timer ("test 4 box tree sort");
+    rt.sort (conv);
+  }
+
+  std::vector<db::Box> queries;
+  for (int i = 0; i < 100000; ++i) {
+    int x = rand () % 1000000, y = rand () % 1000000;
+    queries.push_back (db::Box (x, y, x + rand () % 5000, y + rand () % 5000));
+  }
+
+  size_t n1 = 0, n2 = 0;
+
+  {
+    tl::SelfTimer timer ("test 4 packed tree queries");
+    for (std::vector<db::Box>::const_iterator q = queries.begin (); q != queries.end (); ++q) {
+      for (TestTree::touching_iterator i = t.begin_touching (*q, conv); ! i.at_end (); ++i) {
+        ++n1;
+      }
+    }
+  }
+
+  {
+    tl::SelfTimer timer ("test 4 box tree queries");
+    for (std::vector<db::Box>::const_iterator q = queries.begin (); q != queries.end (); ++q) {
+      for (RefTree::touching_iterator i = rt.begin_touching (*q, conv); ! i.at_end (); ++i) {
+        ++n2;
+      }
+    }
+  }
+
+  EXPECT_EQ (n1, n2);
+}
@@ -322,7 +322,7 @@ TEST(4)
     EXPECT_EQ (contour.is_hole (), false);
     ms.clear ();
     contour.mem_stat (&ms, db::MemStatistics::None, 0);
-    EXPECT_EQ (ms.used, 5 * sizeof(db::Point) + sizeof(Ctr));
+    EXPECT_EQ (ms.used, sizeof(db::Point) + 5 * sizeof(Ctr::compact_offset) + sizeof(Ctr));
     EXPECT_EQ (contour[0], db::Point (100,100));
     EXPECT_EQ (contour[1], db::Point (100,200));
     EXPECT_EQ (contour[2], db::Point (0,300));
@@ -335,7 +335,7 @@ TEST(4)
     EXPECT_EQ (contour.is_hole (), true);
     ms.clear ();
     contour.mem_stat (&ms, db::MemStatistics::None, 0);
-    EXPECT_EQ (ms.used, 5 * sizeof(db::Point) + sizeof(Ctr));
+    EXPECT_EQ (ms.used, sizeof(db::Point) + 5 * sizeof(Ctr::compact_offset) + sizeof(Ctr));
     EXPECT_EQ (contour[0], db::Point (100,100));
     EXPECT_EQ (contour[1], db::Point (300,100));
     EXPECT_EQ (contour[2], db::Point (300,300));
@@ -356,7 +356,7 @@ TEST(4)
     EXPECT_EQ (contour2.is_hole (), true);
     ms.clear ();
     contour.mem_stat (&ms, db::MemStatistics::None, 0);
-    EXPECT_EQ (ms.used, 5 * sizeof(db::Point) + sizeof(Ctr));
+    EXPECT_EQ (ms.used, sizeof(db::Point) + 5 * sizeof(Ctr::compact_offset) + sizeof(Ctr));
     EXPECT_EQ (contour2[0], db::Point (100,100));
     EXPECT_EQ (contour2[1], db::Point (300,100));
     EXPECT_EQ (contour2[2], db::Point (300,300));
@@ -610,7 +610,7 @@ TEST(7)
     EXPECT_EQ (contour.is_hole (), false);
     ms.clear ();
     contour.mem_stat (&ms, db::MemStatistics::None, 0);
-    EXPECT_EQ (ms.used, 6 * sizeof(db::Point) + sizeof(Ctr));
+    EXPECT_EQ (ms.used, sizeof(db::Point) + 6 * sizeof(Ctr::compact_offset) + sizeof(Ctr));
     EXPECT_EQ (contour[0], db::Point (0,0));
     EXPECT_EQ (contour[1], db::Point (0,4));
     EXPECT_EQ (contour[2], db::Point (4,4));
@@ -624,7 +624,7 @@ TEST(7)
     EXPECT_EQ (contour.is_hole (), true);
     ms.clear ();
     contour.mem_stat (&ms, db::MemStatistics::None, 0);
-    EXPECT_EQ (ms.used, 6 * sizeof(db::Point) + sizeof(Ctr));
+    EXPECT_EQ (ms.used, sizeof(db::Point) + 6 * sizeof(Ctr::compact_offset) + sizeof(Ctr));
     EXPECT_EQ (contour[0], db::Point (0,0));
     EXPECT_EQ (contour[1], db::Point (0,4));
     EXPECT_EQ (contour[2], db::Point (4,4));
@@ -645,7 +645,7 @@ TEST(7)
     EXPECT_EQ (contour2.is_hole (), true);
     ms.clear ();
     contour.mem_stat (&ms, db::MemStatistics::None, 0);
-    EXPECT_EQ (ms.used, 6 * sizeof(db::Point) + sizeof(Ctr));
+    EXPECT_EQ (ms.used, sizeof(db::Point) + 6 * sizeof(Ctr::compact_offset) + sizeof(Ctr));
     EXPECT_EQ (contour2[0], db::Point (0,0));
     EXPECT_EQ (contour2[1], db::Point (0,4));
     EXPECT_EQ (contour2[2], db::Point (4,4));
@@ -1216,7 +1216,7 @@ TEST(21)
 #if !defined(_MSC_VER)
     ms.clear ();
     poly.mem_stat (&ms, db::MemStatistics::None, 0);
-    EXPECT_EQ (ms.reqd, (sizeof(void *)-4)*5+68);
+    EXPECT_EQ (ms.reqd, (sizeof(void *)-4)*5+60);
 #endif
   }
 
@@ -1349,3 +1349,115 @@ TEST(28)
   db::Polygon b (db::Box (-1000000000, -1000000000, 1000000000, 1000000000));
   EXPECT_EQ (b.perimeter (), 8000000000.0);
 }
+
+TEST(29)
+{
+  //  compact contour representation
+  typedef db::polygon_contour<db::Coord> Ctr;
+  TestMemStatistics ms;
+
+  db::Point pts [] = {
+    db::Point (100000, 100000),
+    db::Point (100000, 100200),
+    db::Point (100100, 100300),
+    db::Point (100400, 100300),
+    db::Point (100400, 100000)
+  };
+
+  Ctr contour;
+  contour.assign (pts, pts + sizeof (pts) / sizeof (pts [0]), false);
+  EXPECT_EQ (contour.is_compact (), true);
+  EXPECT_EQ (contour.size (), size_t (5));
+  EXPECT_EQ (contour[0], db::Point (100000, 100000));
+  EXPECT_EQ (contour[1], db::Point (100000, 100200));
+  EXPECT_EQ (contour[2], db::Point (100100, 100300));
+  EXPECT_EQ (contour[3], db::Point (100400, 100300));
+  EXPECT_EQ (contour[4], db::Point (100400, 100000));
+  EXPECT_EQ (contour.bbox ().to_string (), "(100000,100000;100400,100300)");
+
+  ms.clear ();
+  contour.mem_stat (&ms, db::MemStatistics::None, 0);
+  EXPECT_EQ (ms.used, sizeof(db::Point) + 5 * sizeof(Ctr::compact_offset) + sizeof(Ctr));
+
+  //  copy and move
+  Ctr contour2 (contour);
+  EXPECT_EQ (contour2.is_compact (), true);
+  EXPECT_EQ (contour2 == contour, true);
+  contour2.move (db::Vector (-100000, 10));
+  EXPECT_EQ (contour2.is_compact (), true);
+  EXPECT_EQ (contour2[0], db::Point (0, 100010));
+  EXPECT_EQ (contour2[2], db::Point (100, 100310));
+  EXPECT_EQ (contour2[4], db::Point (400, 100010));
+
+  //  offsets exceeding the short coordinate range: normal representation
+  db::Point pts_large [] = {
+    db::Point (0, 0),
+    db::Point (0, 200),
+    db::Point (100, 300),
+    db::Point (100000, 300),
+    db::Point (100000, 0)
+  };
+
+  Ctr contour3;
+  contour3.assign (pts_large, pts_large + sizeof (pts_large) / sizeof (pts_large [0]), false);
+  EXPECT_EQ (contour3.is_compact (), false);
+  EXPECT_EQ (contour3.size (), size_t (5));
+  EXPECT_EQ (contour3[3], db::Point (100000, 300));
+  ms.clear ();
+  contour3.mem_stat (&ms, db::MemStatistics::None, 0);
+  EXPECT_EQ (ms.used, 5 * sizeof(db::Point) + sizeof(Ctr));
+
+  //  contours with three stored points are not compacted as this would not save memory
+  db::Point pts_triangle [] = {
+    db::Point (0, 0),
+    db::Point (0, 100),
+    db::Point (100, 0)
+  };
+
+  Ctr contour4;
+  contour4.assign (pts_triangle, pts_triangle + sizeof (pts_triangle) / sizeof (pts_triangle [0]), false);
+  EXPECT_EQ (contour4.is_compact (), false);
+  EXPECT_EQ (contour4.size (), size_t (3));
+  ms.clear ();
+  contour4.mem_stat (&ms, db::MemStatistics::None, 0);
+  EXPECT_EQ (ms.used, 3 * sizeof(db::Point) + sizeof(Ctr));
+
+  //  compact manhattan contours
+  db::Polygon p;
+  db::Point pts_ortho [] = {
+    db::Point (-1000, -1000),
+    db::Point (-1000, 1000),
+    db::Point (0, 1000),
+    db::Point (0, 500),
+    db::Point (500, 500),
+    db::Point (500, 0),
+    db::Point (1000, 0),
+    db::Point (1000, -1000)
+  };
+  p.assign_hull (pts_ortho, pts_ortho + sizeof (pts_ortho) / sizeof (pts_ortho [0]));
+  EXPECT_EQ (p.hull ().is_compact (), true);
+  EXPECT_EQ (p.hull ().is_rectilinear (), true);
+  EXPECT_EQ (p.to_string (), "(-1000,-1000;-1000,1000;0,1000;0,500;500,500;500,0;1000,0;1000,-1000)");
+  EXPECT_EQ (p.area (), 3250000);
+  EXPECT_EQ (p.transformed (db::Trans (db::Trans::r90)).to_string (), "(-1000,-1000;-1000,0;-500,0;-500,500;0,500;0,1000;1000,1000;1000,-1000)");
+
+  db::GenericRepository rep;
+  db::PolygonRef pref (p, rep);
+  EXPECT_EQ (pref.obj ().hull ().is_compact (), true);
+  EXPECT_EQ (pref.instantiate ().to_string (), "(-1000,-1000;-1000,1000;0,1000;0,500;500,500;500,0;1000,0;1000,-1000)");
+
+  std::string edges;
+  for (db::PolygonRef::polygon_edge_iterator e = pref.begin_edge (); ! e.at_end (); ++e) {
+    if (! edges.empty ()) {
+      edges += ";";
+    }
+    edges += (*e).to_string ();
+  }
+  EXPECT_EQ (edges, "(-1000,-1000;-1000,1000);(-1000,1000;0,1000);(0,1000;0,500);(0,500;500,500);(500,500;500,0);(500,0;1000,0);(1000,0;1000,-1000);(1000,-1000;-1000,-1000)");
+
+  //  box polygons are stored uncompressed with four points, hence they are compacted too
+  db::Polygon b (db::Box (0, 0, 100, 200));
+  EXPECT_EQ (b.hull ().is_compact (), true);
+  EXPECT_EQ (b.to_string (), "(0,0;0,200;100,200;100,0)");
+  EXPECT_EQ (b.box ().to_string (), "(0,0;100,200)");
+}
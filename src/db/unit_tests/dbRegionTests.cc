@@ -1605,6 +1605,46 @@ TEST(100_Processors)
   EXPECT_EQ (r.processed (db::ConvexDecomposition (db::PO_horizontal)).to_string (),     "(0,0;0,200;100,200;100,0);(100,400;100,500;200,500;200,400);(0,300;0,400;200,400;200,300)");
 }
 
+TEST(101_DensityCheck)
+{
+  db::Region r;
+  r.insert (db::Box (0, 0, 1000, 1000));
+  r.insert (db::Box (0, 0, 500, 500));   //  overlaps, counted once (merged semantics)
+  r.insert (db::Box (2000, 0, 3000, 500));
+
+  db::Region boundary;
+  boundary.insert (db::Box (0, 0, 4000, 1000));
+
+  EXPECT_EQ (r.density_check (1000, 1000, 1000, 1000, 0.4, 0.6, false, boundary).to_string (), "(2000,0;2000,1000;3000,1000;3000,0)");
+  EXPECT_EQ (r.density_check (1000, 1000, 1000, 1000, 0.4, 0.6, true, boundary).to_string (), "(0,0;0,1000;1000,1000;1000,0);(1000,0;1000,1000;2000,1000;2000,0);(3000,0;3000,1000;4000,1000;4000,0)");
+
+  //  without boundary the bounding box of the region is used
+  EXPECT_EQ (r.density_check (1000, 1000, 1000, 1000, 0.0, 0.1, false, db::Region ()).to_string (), "(1000,0;1000,1000;2000,1000;2000,0)");
+
+  //  sliding windows
+  EXPECT_EQ (r.density_check (1000, 1000, 500, 1000, 0.2, 0.6, false, boundary).to_string (), "(500,0;500,1000;1500,1000;1500,0);(1500,0;1500,1000;2500,1000;2500,0);(2000,0;2000,1000;3000,1000;3000,0);(2500,0;2500,1000;3500,1000;3500,0)");
+
+  //  windows are clipped at the boundary and the density refers to the clipped window
+  db::Region boundary2;
+  boundary2.insert (db::Box (0, 0, 2500, 1000));
+  EXPECT_EQ (r.density_check (1000, 1000, 1000, 1000, 0.4, 0.6, false, boundary2).to_string (), "(2000,0;2000,1000;2500,1000;2500,0)");
+
+  //  windows not overlapping a non-rectangular boundary are skipped
+  db::Region boundary3;
+  boundary3.insert (db::Box (0, 0, 1000, 1000));
+  boundary3.insert (db::Box (3000, 0, 4000, 1000));
+  EXPECT_EQ (r.density_check (1000, 1000, 1000, 1000, 0.0, 0.1, false, boundary3).to_string (), "(3000,0;3000,1000;4000,1000;4000,0)");
+
+  //  same result with multiple threads
+  db::Region rmt (r);
+  rmt.set_threads (4);
+  EXPECT_EQ (rmt.density_check (1000, 1000, 500, 1000, 0.2, 0.6, false, boundary).to_string (), r.density_check (1000, 1000, 500, 1000, 0.2, 0.6, false, boundary).to_string ());
+  EXPECT_EQ (rmt.density_check (100, 100, 50, 50, 0.0, 0.5, true, boundary).to_string (), r.density_check (100, 100, 50, 50, 0.0, 0.5, true, boundary).to_string ());
+
+  //  empty regions deliver zero density windows inside a boundary
+  EXPECT_EQ (db::Region ().density_check (1000, 1000, 1000, 1000, 0.0, 0.0, false, boundary2).to_string (), "(0,0;0,1000;1000,1000;1000,0);(1000,0;1000,1000;2000,1000;2000,0);(2000,0;2000,1000;2500,1000;2500,0)");
+}
+
 TEST(issue_228)
 {
   db::Region r;
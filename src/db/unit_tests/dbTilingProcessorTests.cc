@@ -29,6 +29,7 @@
 #include "gsiExpression.h"
 #include "gsiDecl.h"
 #include "dbWriter.h"
+#include "dbReader.h"
 #include "dbSaveLayoutOptions.h"
 #include "dbShapeProcessor.h"
 
@@ -448,3 +449,186 @@ TEST(5)
   EXPECT_EQ (sum, 2500000000);
   EXPECT_EQ (num, 134225);
 }
+
+class SumTilingOutputReceiver
+  : public db::TileOutputReceiver
+{
+public:
+  SumTilingOutputReceiver (double *sum)
+    : mp_sum (sum)
+  { }
+
+  void put (size_t /*ix*/, size_t /*iy*/, const db::Box & /*tile*/, size_t /*id*/, const tl::Variant &obj, double /*dbu*/, const db::ICplxTrans & /*trans*/, bool /*clip*/)
+  {
+    *mp_sum += obj.to_double ();
+  }
+
+private:
+  double *mp_sum;
+};
+
+//  Worker processes
+TEST(6)
+{
+  db::Layout ly;
+  unsigned int l1 = ly.insert_layer (db::LayerProperties (1, 0));
+  unsigned int l2 = ly.insert_layer (db::LayerProperties (2, 0));
+  unsigned int o1 = ly.insert_layer (db::LayerProperties (10, 0));
+  unsigned int q1 = ly.insert_layer (db::LayerProperties (20, 0));
+  db::cell_index_type top = ly.add_cell ("TOP");
+
+  for (size_t i = 0; i < 5000; ++i) {
+    db::Coord x = get_rand () % 1000000;
+    db::Coord y = get_rand () % 1000000;
+    ly.cell (top).shapes (l1).insert (db::Box (x, y, x + 10000, y + 10000));
+    x = get_rand () % 1000000;
+    y = get_rand () % 1000000;
+    ly.cell (top).shapes (l2).insert (db::Box (x, y, x + 10000, y + 10000));
+  }
+
+  db::Region r[2];
+  db::Edges e[2];
+  db::EdgePairs ep[2];
+  double sum[2] = { 0.0, 0.0 };
+
+  for (int mode = 0; mode < 2; ++mode) {
+
+    db::TilingProcessor tp;
+    tp.input ("i1", db::RecursiveShapeIterator (ly, ly.cell (top), l1));
+    tp.input ("i2", db::RecursiveShapeIterator (ly, ly.cell (top), l2));
+    tp.tile_size (100, 100);
+    if (mode > 0) {
+      tp.set_processes (3);
+    }
+    tp.output ("o1", ly, top, mode > 0 ? q1 : o1);
+    tp.output ("o2", r [mode]);
+    tp.output ("o3", e [mode]);
+    tp.output ("o4", ep [mode]);
+    tp.output ("o5", 0, new SumTilingOutputReceiver (&sum [mode]), db::ICplxTrans ());
+    tp.queue ("_output(o1, i1 ^ i2)");
+    tp.queue ("_output(o2, i1 & i2); _output(o3, i2.edges); _output(o4, i1.space_check(1000)); _output(o5, (i1 & _tile).area, false)");
+    tp.execute ("test");
+
+  }
+
+  EXPECT_EQ (ly.cell (top).shapes (o1).empty (), false);
+  db::ShapeProcessor sp;
+  db::Shapes x1;
+  sp.boolean (ly, ly.cell (top), o1, ly, ly.cell (top), q1, x1, db::BooleanOp::Xor, true);
+  EXPECT_EQ (x1.empty (), true);
+
+  EXPECT_EQ (r [0].empty (), false);
+  EXPECT_EQ ((r [0] ^ r [1]).empty (), true);
+  EXPECT_EQ (e [0].empty (), false);
+  EXPECT_EQ ((e [0] ^ e [1]).empty (), true);
+  EXPECT_EQ (ep [0].empty (), false);
+  EXPECT_EQ (ep [0].size (), ep [1].size ());
+  EXPECT_EQ (sum [0] > 0.0, true);
+  EXPECT_EQ (sum [0], sum [1]);
+
+  //  errors in the worker processes are reported
+  db::TilingProcessor tp;
+  tp.input ("i1", db::RecursiveShapeIterator (ly, ly.cell (top), l1));
+  tp.tile_size (100, 100);
+  tp.set_processes (2);
+  tp.output ("o1", r [1]);
+  tp.queue ("_output(o1, i1.does_not_exist)");
+
+  try {
+    tp.execute ("test");
+    EXPECT_EQ (true, false);
+  } catch (tl::Exception &ex) {
+    EXPECT_EQ (ex.msg ().find ("Errors occurred during processing") == 0, true);
+    //  the worker sends the actual message
+    EXPECT_EQ (ex.msg ().find ("does_not_exist") != std::string::npos, true);
+  }
+}
+
+//  Streaming output
+TEST(7)
+{
+  db::Layout ly;
+  unsigned int l1 = ly.insert_layer (db::LayerProperties (1, 0));
+  unsigned int l2 = ly.insert_layer (db::LayerProperties (2, 0));
+  db::cell_index_type top = ly.add_cell ("TOP");
+
+  for (size_t i = 0; i < 2000; ++i) {
+    db::Coord x = get_rand () % 1000000;
+    db::Coord y = get_rand () % 1000000;
+    ly.cell (top).shapes (l1).insert (db::Box (x, y, x + 10000, y + 10000));
+    x = get_rand () % 1000000;
+    y = get_rand () % 1000000;
+    ly.cell (top).shapes (l2).insert (db::Box (x, y, x + 10000, y + 10000));
+  }
+
+  db::Region ref_xor, ref_and;
+
+  //  a small buffer size forces multiple chunks, a big one a single cell
+  for (int mode = 0; mode < 2; ++mode) {
+
+    std::string fn = tmp_file ("stream_out.gds");
+
+    {
+      db::SaveLayoutOptions options;
+      options.set_format ("GDS2");
+
+      tl::OutputStream stream (fn);
+      db::TileOutputStreamWriter writer (stream, options, ly.dbu (), "OUT", mode == 0 ? 100 : 10000000);
+      unsigned int lxor = writer.add_layer (db::LayerProperties (10, 0));
+      unsigned int land = writer.add_layer (db::LayerProperties (11, 0));
+
+      db::TilingProcessor tp;
+      tp.input ("i1", db::RecursiveShapeIterator (ly, ly.cell (top), l1));
+      tp.input ("i2", db::RecursiveShapeIterator (ly, ly.cell (top), l2));
+      tp.tile_size (100, 100);
+      tp.set_threads (2);
+      tp.output ("o1", 0, new db::TileStreamOutputReceiver (&writer, lxor), db::ICplxTrans ());
+      tp.output ("o2", 0, new db::TileStreamOutputReceiver (&writer, land), db::ICplxTrans ());
+      tp.queue ("_output(o1, i1 ^ i2); _output(o2, i1 & i2)");
+      if (mode == 0) {
+        tp.output ("r1", ref_xor);
+        tp.output ("r2", ref_and);
+        tp.queue ("_output(r1, i1 ^ i2); _output(r2, i1 & i2)");
+      }
+      tp.execute ("test");
+
+      writer.finish ();
+      EXPECT_EQ (writer.shape_count (lxor) > 0, true);
+    }
+
+    db::Layout ly_in;
+    {
+      tl::InputStream stream (fn);
+      db::Reader reader (stream);
+      reader.read (ly_in);
+    }
+
+    std::pair<bool, db::cell_index_type> out_top = ly_in.cell_by_name ("OUT");
+    EXPECT_EQ (out_top.first, true);
+    if (mode == 1) {
+      EXPECT_EQ (ly_in.cells (), size_t (1));
+    } else {
+      EXPECT_EQ (ly_in.cells () > size_t (2), true);
+    }
+
+    int lin_xor = -1, lin_and = -1;
+    for (db::Layout::layer_iterator l = ly_in.begin_layers (); l != ly_in.end_layers (); ++l) {
+      if ((*l).second->log_equal (db::LayerProperties (10, 0))) {
+        lin_xor = int ((*l).first);
+      } else if ((*l).second->log_equal (db::LayerProperties (11, 0))) {
+        lin_and = int ((*l).first);
+      }
+    }
+    EXPECT_EQ (lin_xor >= 0, true);
+    EXPECT_EQ (lin_and >= 0, true);
+
+    db::Region r_xor (db::RecursiveShapeIterator (ly_in, ly_in.cell (out_top.second), (unsigned int) lin_xor));
+    db::Region r_and (db::RecursiveShapeIterator (ly_in, ly_in.cell (out_top.second), (unsigned int) lin_and));
+
+    EXPECT_EQ (r_xor.empty (), false);
+    EXPECT_EQ (r_and.empty (), false);
+    EXPECT_EQ ((r_xor ^ ref_xor).empty (), true);
+    EXPECT_EQ ((r_and ^ ref_and).empty (), true);
+
+  }
+}
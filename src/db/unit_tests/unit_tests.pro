@@ -67,12 +67,14 @@ SOURCES = \
     dbEdgePairRelationsTests.cc \
     dbEdgePairTests.cc \
     dbEdgeTests.cc \
+    dbContourAllocatorTests.cc \
     dbClipTests.cc \
     dbCellMappingTests.cc \
     dbCellHullGeneratorTests.cc \
     dbCellGraphUtilsTests.cc \
     dbCellTests.cc \
     dbBoxTreeTests.cc \
+    dbPackedBoxTreeTests.cc \
     dbBoxScannerTests.cc \
     dbBoxTests.cc \
     dbArrayTests.cc \
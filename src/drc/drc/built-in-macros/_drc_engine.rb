@@ -46,6 +46,11 @@ module DRC
       @log_file = nil
       @dss = nil
       @deep = false
+      @deep_memory_limit = 0
+      @lifetime = nil
+      @layers_released = false
+      @deep_cache = nil
+      @incremental_boxes = nil
       @netter = nil
       @netter_data = nil
 
@@ -133,6 +138,18 @@ module DRC
       DRCAreaAndPerimeter::new(r, 1.0, f)
     end
     
+    def tile_size(*args)
+      DRCTileSize::new(*args)
+    end
+    
+    def tile_step(*args)
+      DRCTileStep::new(*args)
+    end
+    
+    def tile_boundary(b)
+      DRCTileBoundary::new(b)
+    end
+    
     # %DRC%
     # @brief Defines SPICE output format (with options) 
     # @name write_spice
@@ -503,6 +520,94 @@ module DRC
       @tx = @ty = nil
     end
     
+    # %DRC%
+    # @name deep_memory_limit
+    # @brief Specifies a memory budget for the hierarchical layers in deep mode
+    # @synopsis deep_memory_limit(bytes)
+    #
+    # In deep mode, the hierarchical layers are kept in memory until the script ends.
+    # With a memory budget, the shapes of the least recently used layers are written
+    # to temporary files after an operation when all layers together exceed the
+    # given number of bytes. These layers are read back automatically when they are
+    # used again. The layers are written until three quarters of the budget are reached,
+    # so this does not happen after every operation. The polygons of the written layers
+    # are removed from memory too, unless they are still needed by a netlist extraction.
+    #
+    # The number of bytes can be given as a string with a "k", "M" or "G" suffix,
+    # e.g. "64G". A value of 0 (the default) disables the budget.
+    # In verbose mode, the number of layers written to disk and the time spent for
+    # reading them back are reported after each operation.
+    
+    def deep_memory_limit(bytes)
+      if bytes.is_a?(String) && bytes =~ /^\s*(\d+(?:\.\d*)?)\s*([kMG]?)\s*$/
+        f = { "" => 1, "k" => 1024, "M" => 1024 ** 2, "G" => 1024 ** 3 }[$2]
+        @deep_memory_limit = ($1.to_f * f).to_i
+      elsif bytes.is_a?(Integer)
+        @deep_memory_limit = bytes
+      else
+        raise("Invalid memory limit specification: #{bytes.inspect}")
+      end
+      @dss && @dss.memory_limit = @deep_memory_limit
+    end
+    
+    # %DRC%
+    # @name release_unused_layers
+    # @brief Releases intermediate layers after their last use
+    # @synopsis release_unused_layers
+    # @synopsis release_unused_layers(f)
+    #
+    # Layers assigned to local variables are kept until the script ends. With this
+    # option enabled, the script is analyzed and variables holding layers are reset
+    # once the last statement using them has been executed. The memory of these layers
+    # is freed by the next garbage collection which happens before each operation.
+    # Together with \deep_memory_limit this keeps the number of layers written to disk low.
+    #
+    # The analysis is conservative: variables used inside method definitions, lambdas
+    # or procs are kept and scripts using "eval", "binding" or similar features are
+    # not analyzed at all. The option is off by default. It applies to the statements
+    # executed after it has been enabled. "release_unused_layers(false)" disables it again.
+    # In verbose mode, the released layers are reported in the log.
+    #
+    # @code
+    # release_unused_layers
+    #
+    # m1 = input(1, 0)
+    # m1_sized = m1.sized(0.1.um)   # m1 is released after this statement
+    # ...
+    # @/code
+
+    def release_unused_layers(f = true)
+      if @lifetime
+        f ? @lifetime.enable : @lifetime.disable
+      end
+    end
+
+    # %DRC%
+    # @name deep_cache
+    # @brief Specifies a directory for caching the results of hierarchical operations
+    # @synopsis deep_cache(path)
+    # @synopsis deep_cache(nil)
+    #
+    # In deep mode, the results of layer operations can be stored in a directory
+    # and reused when the script is run again. A result is reused if the inputs
+    # of the operation are identical in shapes and hierarchy and the operation
+    # is called with the same parameters. This is useful when a deck is run again
+    # after small changes of the layout: only the operations depending on changed
+    # layers are computed again.
+    #
+    # The cache is opt-in and is not cleaned up automatically. Delete the directory
+    # to clear the cache. The directory is created if it does not exist yet.
+    # Operations in tiled or flat mode are not cached. Passing nil disables the cache.
+    # In verbose mode, results taken from the cache are reported in the log.
+    
+    def deep_cache(path)
+      if path
+        path = File.expand_path(path.to_s)
+        File.directory?(path) || Dir.mkdir(path)
+      end
+      @deep_cache = path
+    end
+    
     # %DRC%
     # @name is_deep?
     # @brief Returns true, if in deep mode
@@ -545,6 +650,26 @@ module DRC
       @bx = @by = nil
     end
     
+    # %DRC%
+    # @name tile_processes
+    # @brief Computes the tiles in worker processes instead of threads
+    # @synopsis tile_processes(n)
+    # In tiling mode, this function makes the tiles be computed in "n" worker 
+    # processes forked from the current process instead of in threads. This may 
+    # scale better than threads for large numbers of cores.
+    # Worker processes are only used in batch mode on Linux or macOS. In 
+    # other cases and with "n" being 1 or less, the tiles are computed in the 
+    # threads specified with \threads. Worker processes are not used by default.
+    #
+    # @code
+    # tiles(1000.um)
+    # tile_processes(16)
+    # @/code
+    
+    def tile_processes(n)
+      @tile_processes = n.to_i
+    end
+    
     # %DRC%
     # @name flat
     # @brief Disables tiling mode 
@@ -560,12 +685,45 @@ module DRC
     # @name threads
     # @brief Specifies the number of CPU cores to use in tiling mode
     # @synopsis threads(n)
+    # @synopsis threads(n, affinity)
     # If using threads, tiles are distributed on multiple CPU cores for
     # parallelization. Still, all tiles must be processed before the 
     # operation proceeds with the next statement.
+    # To compute the tiles in worker processes instead of threads, 
+    # use \tile_processes.
+    # In flat mode without tiling, the threads are used for splitting
+    # merge, sizing and boolean operations into bands which are computed
+    # in parallel. In LVS scripts, the threads are also used for comparing
+    # independent circuits of the netlists in parallel.
+    #
+    # In deep mode, the threads of the hierarchical processor can be pinned 
+    # to CPU cores with the "affinity" argument. This keeps the threads and 
+    # the data they produce on the same NUMA node on multi-socket machines.
+    # "affinity" can be:
+    #
+    # @ul
+    #   @li @b :compact @/b: fills the NUMA nodes one after another @/li
+    #   @li @b :spread @/b: distributes the threads round-robin over the NUMA nodes @/li
+    #   @li @b An array of CPU numbers @/b: thread n is pinned to the n-th CPU of the list @/li
+    #   @li @b nil or :none @/b: the threads are not pinned (the default) @/li
+    # @/ul
+    #
+    # @code
+    # deep
+    # threads(64, :compact)
+    # @/code
     
-    def threads(n)
+    def threads(n, affinity = nil)
       @tt = n.to_i
+      if affinity.is_a?(Array)
+        @thread_affinity = affinity.collect { |c| c.to_i }
+      elsif affinity == :compact || affinity == :spread
+        @thread_affinity = RBA::DeepShapeStore::thread_affinity_layout(@tt, affinity == :spread)
+      elsif affinity == nil || affinity == :none
+        @thread_affinity = nil
+      else
+        raise("Invalid affinity #{affinity.inspect} - must be :compact, :spread, :none or an array of CPU numbers")
+      end
     end
     
     # %DRC%
@@ -843,6 +1001,64 @@ module DRC
       
     end
 
+    # %DRC%
+    # @name incremental
+    # @brief Checks only the parts of the layout which changed against a previous version
+    # @synopsis incremental(previous_layout, previous_report, halo)
+    #
+    # This function compares the default source with the previous layout and confines
+    # the checks to the changed parts. The changed parts are made from the bounding boxes
+    # of all shapes and instances which are present in one layout only. Changes inside
+    # a cell count for every placement of that cell. "halo" extends these areas and
+    # must be at least as large as the largest distance a check or operation takes into
+    # account. The input layers will deliver the shapes touching the changed areas
+    # enlarged by twice the halo, so the checks see the full context.
+    #
+    # The markers from the previous report which touch the (enlarged) changed areas are
+    # replaced by the new markers. All other markers are taken over from the previous
+    # report. Only new markers touching the changed areas are reported.
+    #
+    # "incremental" needs to be called after \source and \report and before
+    # the first input is taken. Outputs to layouts will only receive the results of the
+    # changed areas. Operations which are not local - such as "with_area" on large
+    # merged polygons or connectivity-based checks - may render different results than a full run.
+    #
+    # @code
+    # source("chip_eco.gds")
+    # report("DRC", "chip_eco.lyrdb")
+    # incremental("chip.gds", "chip.lyrdb", 2.um)
+    # @/code
+    
+    def incremental(previous_layout, previous_report, halo)
+
+      @output_rdb || raise("'incremental' needs a report database - call 'report' before 'incremental'")
+    
+      src = source
+      
+      old_layout = RBA::Layout::new
+      old_layout.read(_make_path(previous_layout))
+      old_top = old_layout.cell(src.cell_name)
+      old_top || raise("Cell #{src.cell_name} not found in the previous layout #{previous_layout}")
+    
+      dirty = RBA::LayoutDiff::difference_region(old_top, src.cell_obj)
+      
+      ly_dbu = src.layout.dbu
+      @incremental_halo = _prep_value(halo) * self.dbu
+      area = dirty.sized((@incremental_halo / ly_dbu).ceil.to_i)
+      area.merge
+      @incremental_boxes = []
+      area.each { |p| @incremental_boxes << p.bbox.to_dtype(ly_dbu) }
+      
+      info("Incremental mode: #{@incremental_boxes.size} changed area(s)")
+
+      old_rdb = RBA::ReportDatabase::new("")
+      old_rdb.load(_make_path(previous_report))
+      n = _incremental_copy(old_rdb, false)
+      
+      info("Incremental mode: #{n} marker(s) taken over from #{previous_report}")
+      
+    end
+
     # %DRC%
     # @name report_netlist
     # @brief Specifies an extracted netlist report for output
@@ -1420,14 +1636,22 @@ CODE
         obj.enable_progress(desc)
       end
       
+      reloads = @dss ? [ @dss.reload_count, @dss.reload_time ] : [ 0, 0.0 ]
+
       t = RBA::Timer::new
       t.start
       GC.start # force a garbage collection before the operation to free unused memory
+      if @layers_released
+        @layers_released = false
+        @verbose && @dss && info("Memory used by the deep layers: #{'%.3f'%(@dss.memory_used / (1024.0 * 1024.0))}M")
+      end
       res = yield
       t.stop
 
       info("Elapsed: #{'%.3f'%(t.sys+t.user)}s")
 
+      _spill_deep(reloads)
+
       # disable progress
       if obj.is_a?(RBA::Region) || obj.is_a?(RBA::Edges) || obj.is_a?(RBA::EdgePairs)
         obj.disable_progress
@@ -1439,7 +1663,9 @@ CODE
     
     def _cmd(obj, method, *args)
       run_timed("\"#{method}\" in: #{src_line}", obj) do
-        obj.send(method, *args)
+        _cached(obj, method, args) do
+          obj.send(method, *args)
+        end
       end
     end
     
@@ -1459,6 +1685,7 @@ CODE
         tp.output("res", res)
         tp.input("self", obj)
         tp.threads = (@tt || 1)
+        tp.processes = _tp_processes
         args.each_with_index do |a,i|
           if a.is_a?(RBA::Edges) || a.is_a?(RBA::Region) || a.is_a?(RBA::EdgePairs) || a.is_a?(RBA::Texts)
             tp.input("a#{i}", a)
@@ -1476,11 +1703,17 @@ CODE
 
         if @dss
           @dss.threads = (@tt || 1)
+          @dss.thread_affinity = (@thread_affinity || [])
+        end
+        if obj.is_a?(RBA::Region)
+          obj.threads = (@tt || 0)
         end
 
         res = nil
         run_timed("\"#{method}\" in: #{src_line}", obj) do
-          res = obj.send(method, *args)
+          res = _cached(obj, method, args) do
+            obj.send(method, *args)
+          end
         end
 
       end
@@ -1508,6 +1741,7 @@ CODE
         tp.output("res", res)
         tp.input("self", obj)
         tp.threads = (@tt || 1)
+        tp.processes = _tp_processes
         tp.queue("_output(res, _tile ? self.#{method}(_tile.bbox) : self.#{method})")
         run_timed("\"#{method}\" in: #{src_line}", obj) do
           tp.execute("Tiled \"#{method}\" in: #{src_line}")
@@ -1519,6 +1753,7 @@ CODE
 
         if @dss
           @dss.threads = (@tt || 1)
+          @dss.thread_affinity = (@thread_affinity || [])
         end
 
         res = nil
@@ -1737,6 +1972,135 @@ CODE
       @dss
     end
 
+    def _spill_deep(reloads)
+      # Layers can only be written to disk between operations
+      if @dss && @deep_memory_limit > 0
+        n = @dss.reload_count - reloads[0]
+        if n > 0
+          info("Reloaded #{n} layer(s) from disk in #{'%.3f'%(@dss.reload_time - reloads[1])}s")
+        end
+        n = @dss.spill
+        if n > 0
+          info("Spilled #{n} layer(s) to disk")
+        end
+      end
+    end
+
+    def _release_layers(names)
+      # The variables are reset by the block. The layers are collected by the
+      # garbage collection which runs before the next operation (see run_timed).
+      yield
+      @layers_released = true
+      info("Released unused layer(s) #{names.join(", ")}")
+    end
+
+    # Methods modifying the object - these are never cached
+    CACHE_EXCLUDED_METHODS = [ :merge, :size, :snap, :move, :transform, :flatten ]
+    
+    # The file suffixes of the cached results by class
+    CACHE_SUFFIXES = { RBA::Region => "region", RBA::Edges => "edges", RBA::EdgePairs => "edge_pairs" }
+
+    def _cache_value(a)
+      if a.is_a?(RBA::Region) || a.is_a?(RBA::Edges) || a.is_a?(RBA::EdgePairs)
+        if !a.is_deep?
+          return nil
+        end
+        flags = []
+        if !a.is_a?(RBA::EdgePairs)
+          flags << (a.merged_semantics? ? "m" : "r")
+        end
+        if a.is_a?(RBA::Region)
+          flags << (a.strict_handling? ? "s" : "n")
+          flags << (a.min_coherence? ? "c" : "t")
+        end
+        return "#{a.class.name}[#{flags.join}]:#{'%x'%RBA::DeepShapeStore::layer_hash(a)}"
+      elsif a.is_a?(Array)
+        v = a.collect { |e| _cache_value(e) }
+        return v.index(nil) ? nil : "[" + v.join(",") + "]"
+      elsif a.is_a?(Numeric) || a.is_a?(String) || a.is_a?(Symbol) || a == true || a == false || a == nil
+        return a.inspect
+      elsif a.class.name =~ /^RBA::/ && a.to_s !~ /#</
+        # value objects such as boxes or enums
+        return "#{a.class.name}(#{a.to_s})"
+      end
+      nil
+    end
+    
+    def _cache_key(obj, method, args)
+      v = [ obj ] + args
+      v = v.collect { |a| _cache_value(a) }
+      if v.index(nil)
+        return nil
+      end
+      "#{v.shift}.#{method}(#{v.join(",")});#{@dss.max_vertex_count},#{@dss.max_area_ratio}"
+    end
+    
+    def _cache_file(key, cls)
+      # FNV-1a hash of the key - the key itself is stored inside the file
+      h = 0xcbf29ce484222325
+      key.each_byte { |b| h = ((h ^ b) * 0x100000001b3) & 0xffffffffffffffff }
+      File.join(@deep_cache, "#{'%016x'%h}.#{CACHE_SUFFIXES[cls]}")
+    end
+    
+    def _cached(obj, method, args, &block)
+    
+      key = nil
+      if @deep_cache && @dss && CACHE_SUFFIXES[obj.class] && !CACHE_EXCLUDED_METHODS.index(method)
+        key = _cache_key(obj, method, args)
+      end
+      
+      if !key
+        return yield
+      end
+      
+      CACHE_SUFFIXES.each do |cls,suffix|
+        file = _cache_file(key, cls)
+        if File.exist?(file)
+          res = nil
+          begin
+            res = RBA::DeepShapeStore::send("load_#{suffix}", key, file, obj)
+          rescue => ex
+            log("Unable to read cached result from #{file}: #{ex.to_s}")
+          end
+          if res
+            info("Result taken from cache: #{file}")
+            return res
+          end
+        end
+      end
+      
+      res = yield
+      
+      if CACHE_SUFFIXES[res.class] && !res.equal?(obj) && res.is_deep?
+        file = _cache_file(key, res.class)
+        tmp_file = file + ".#{$$}"
+        begin
+          RBA::DeepShapeStore::save_layer(res, key, tmp_file)
+          File.rename(tmp_file, file)
+        rescue => ex
+          File.exist?(tmp_file) && File.delete(tmp_file)
+          log("Unable to write result to cache #{file}: #{ex.to_s}")
+        end
+      end
+      
+      res
+      
+    end
+    
+    def _tp_processes
+      # Tiles are computed in worker processes in batch mode only - forking
+      # a process with a user interface is not considered safe.
+      if @tile_processes && @tile_processes > 1 && !(RBA.const_defined?(:Application) && RBA::Application::instance && RBA::Application::instance.main_window)
+        @tile_processes
+      else
+        0
+      end
+    end
+    
+    def _threads
+      @tt
+    end
+
     def _netter
       @netter ||= DRC::DRCNetter::new(self)
     end
@@ -1763,6 +2127,14 @@ CODE
       @generator = g
     end
 
+    def _lifetime
+      @lifetime
+    end
+
+    def _lifetime=(l)
+      @lifetime = l
+    end
+
     def _rdb_index
       @rdb_index
     end
@@ -1820,7 +2192,18 @@ CODE
        
       else
     
-        if box
+        if @incremental_boxes
+          # confine the input to the changed areas plus context
+          h = 2.0 * @incremental_halo
+          region = RBA::Region::new
+          @incremental_boxes.each do |b|
+            region.insert(RBA::Box::from_dbox(RBA::DBox::new(b.left - h, b.bottom - h, b.right + h, b.top + h) * (1.0 / layout.dbu)))
+          end
+          if box
+            region &= RBA::Region::new(box)
+          end
+          iter = RBA::RecursiveShapeIterator::new(layout, layout.cell(cell_index), layers, region, overlapping)
+        elsif box
           iter = RBA::RecursiveShapeIterator::new(layout, layout.cell(cell_index), layers, box, overlapping)
         else
           iter = RBA::RecursiveShapeIterator::new(layout, layout.cell(cell_index), layers)
@@ -1850,6 +2233,7 @@ CODE
           # object which keeps the DSS.
           @dss.text_property_name = "LABEL"
           @dss.text_enlargement = 1
+          @dss.memory_limit = @deep_memory_limit
           r = cls.new(iter, @dss, RBA::ICplxTrans::new(sf.to_f))
         else
           r = cls.new(iter, RBA::ICplxTrans::new(sf.to_f))
@@ -1866,6 +2250,72 @@ CODE
 
     end
     
+    def _incremental_touches?(item)
+      item.each_value do |v|
+        b = nil
+        if v.is_polygon?
+          b = v.polygon.bbox
+        elsif v.is_box?
+          b = v.box
+        elsif v.is_edge?
+          b = v.edge.bbox
+        elsif v.is_edge_pair?
+          b = v.edge_pair.bbox
+        elsif v.is_path?
+          b = v.path.bbox
+        elsif v.is_text?
+          b = v.text.bbox
+        end
+        if b && @incremental_boxes.find { |ib| ib.touches?(b) }
+          return true
+        end
+      end
+      false
+    end
+    
+    def _incremental_category(cat)
+      to_cat = @output_rdb.category_by_path(cat.path)
+      if !to_cat
+        if cat.parent
+          to_cat = @output_rdb.create_category(_incremental_category(cat.parent), cat.name)
+        else
+          to_cat = @output_rdb.create_category(cat.name)
+        end
+        to_cat.description = cat.description
+      end
+      to_cat
+    end
+    
+    # Copies the items touching (inside = true) or not touching (inside = false)
+    # the changed areas into the output report database
+    def _incremental_copy(rdb, inside)
+    
+      cells = {}
+      cats = {}
+      n = 0
+      
+      rdb.each_item do |item|
+      
+        if _incremental_touches?(item) != inside
+          next
+        end
+        
+        cell = (cells[item.cell_id] ||= begin
+          c = rdb.cell_by_id(item.cell_id)
+          @output_rdb.cell_by_qname(c.qname) || @output_rdb.create_cell(c.name, c.variant)
+        end)
+        cat = (cats[item.category_id] ||= _incremental_category(rdb.category_by_id(item.category_id)))
+        
+        new_item = @output_rdb.create_item(cell.rdb_id, cat.rdb_id)
+        item.each_value { |v| new_item.add_value(v) }
+        n += 1
+        
+      end
+      
+      n
+      
+    end
+    
     def _layout(name)
       @layout_sources[name].layout
     end
@@ -1881,7 +2331,15 @@ CODE
         cat = @output_rdb.create_category(args[0].to_s)
         args[1] && cat.description = args[1]
 
-        cat.scan_collection(@output_rdb_cell, RBA::CplxTrans::new(self.dbu), data)
+        if @incremental_boxes
+          # only markers from the changed areas are taken
+          rdb = RBA::ReportDatabase::new("")
+          rdb_cat = rdb.create_category(args[0].to_s)
+          rdb_cat.scan_collection(rdb.create_cell(@output_rdb_cell.name), RBA::CplxTrans::new(self.dbu), data)
+          _incremental_copy(rdb, true)
+        else
+          cat.scan_collection(@output_rdb_cell, RBA::CplxTrans::new(self.dbu), data)
+        end
       
       else 
 
@@ -533,6 +533,101 @@ CODE
 CODE
     end
     
+    # %DRC%
+    # @name with_density
+    # @brief Returns tiles whose density is within a given range
+    # @synopsis layer.with_density(min .. max [, options ])
+    # @synopsis layer.with_density(min, max [, options ])
+    #
+    # This method computes the density of the layer inside rectangular tiles
+    # and returns the tiles whose density is larger or equal to "min" and less or equal
+    # to "max". The density is a value between 0.0 (empty) and 1.0 (fully covered).
+    # "nil" can be given for "min" or "max" to indicate no lower or upper limit.
+    #
+    # The tiles are specified with the following options:
+    #
+    # @ul
+    #   @li @b tile_size(s) @/b or @b tile_size(w, h) @/b: the size of the tiles. This option is mandatory. @/li  
+    #   @li @b tile_step(s) @/b or @b tile_step(x, y) @/b: the step of the tiles. The default step is the tile size. A smaller step gives overlapping tiles (sliding windows). @/li  
+    #   @li @b tile_boundary(layer) @/b: the tiles cover the extent of the given layer. Tiles not overlapping this layer are not considered. By default, the extent of the layer itself is used. @/li  
+    # @/ul
+    #
+    # The tiles start at the lower left corner of the boundary's extent. Tiles extending beyond
+    # the extent are clipped and the density refers to the clipped tile.
+    #
+    # The density is computed on the whole layer, also in tiling mode. In deep mode, the computation
+    # is done hierarchically and the threads specified with \global#threads are used. Merged semantics applies.
+    #
+    # Example:
+    #
+    # @code
+    # low_density = metal1.with_density(0.0 .. 0.2, tile_size(100.um), tile_step(50.um))
+    # @/code
+    
+    # %DRC%
+    # @name without_density
+    # @brief Returns tiles whose density is not within a given range
+    # @synopsis layer.without_density(min .. max [, options ])
+    # @synopsis layer.without_density(min, max [, options ])
+    #
+    # This method is the inverse of \with_density. It returns the tiles whose 
+    # density is less than "min" or larger than "max". Usually, these are the violations of 
+    # a density rule. See \with_density for details about the options.
+    #
+    # This method is available for polygon layers only.
+    
+    [true, false].each do |inv|
+      mn = (inv ? "without" : "with") + "_density"
+      eval <<"CODE"
+      def #{mn}(*args)
+
+        requires_region("#{mn}")
+
+        limits = []
+        tile_size = nil
+        tile_step = nil
+        boundary = nil
+
+        n = 1
+        args.each do |a|
+          if a.is_a?(DRCTileSize)
+            tile_size = a.value.collect { |v| @engine._prep_value(v) }
+          elsif a.is_a?(DRCTileStep)
+            tile_step = a.value.collect { |v| @engine._prep_value(v) }
+          elsif a.is_a?(DRCTileBoundary)
+            (a.value.is_a?(DRCLayer) && a.value.data.is_a?(RBA::Region)) || raise("#{mn}: Argument to 'tile_boundary' must be a polygon layer")
+            boundary = a.value.data
+          elsif a.is_a?(Range)
+            limits += [ a.first, a.last ]
+          elsif a.is_a?(Float) || a.is_a?(1.class) || a == nil
+            limits << a
+          else
+            raise("#{mn}: Parameter #" + n.to_s + " does not have an expected type")
+          end
+          n += 1
+        end
+
+        if limits.size != 2
+          raise("#{mn}: A density range (min .. max or min, max) must be specified")
+        end
+        if !tile_size || tile_size.size < 1 || tile_size.size > 2
+          raise("#{mn}: A tile size must be specified with 'tile_size(s)' or 'tile_size(w, h)'")
+        end
+        if tile_step && (tile_step.size < 1 || tile_step.size > 2)
+          raise("#{mn}: 'tile_step' requires one or two values")
+        end
+
+        wx = tile_size[0]
+        wy = tile_size[-1]
+        sx = tile_step ? tile_step[0] : wx
+        sy = tile_step ? tile_step[-1] : wy
+
+        DRCLayer::new(@engine, @engine._cmd(@data, :density_check, wx, wy, sx, sy, (limits[0] || 0.0).to_f, (limits[1] || 1.0).to_f, #{inv.inspect}, boundary || RBA::Region::new))
+
+      end
+CODE
+    end
+    
     # %DRC%
     # @name rounded_corners
     # @brief Applies corner rounding to each corner of the polygon
@@ -0,0 +1,236 @@
+# $autorun-early
+
+module DRC
+
+  # A lifetime analysis for the layer variables of a DRC script
+  #
+  # Intermediate layers stay referenced by their local variables until
+  # the script ends. This analysis parses the script before it is run and
+  # determines the top-level statement where each local variable is used
+  # for the last time. While the script is executed, the variables are
+  # reset once the next top-level statement is reached, so the layers
+  # behind them can be released by the next garbage collection.
+  #
+  # The analysis is conservative: variables used inside method definitions,
+  # lambdas or procs (which may be executed later) are not considered and
+  # scripts using "eval", "binding" or similar features are left alone.
+  # Blocks passed to other methods are assumed to be executed immediately
+  # unless the script defines methods of its own.
+  #
+  # The analysis is opt-in: the script is parsed and traced only after
+  # "enable" has been called (see DRCEngine#release_unused_layers).
+
+  class DRCLifetime
+
+    # Methods which give access to local variables or create deferred code
+    DYNAMIC_METHODS = %w(eval binding local_variables local_variable_get local_variable_set
+                         local_variable_defined? instance_eval instance_exec class_eval module_eval)
+
+    DEFERRED_BLOCK_METHODS = %w(lambda proc define_method new)
+
+    # "text" and "path" are the script and the path as given to "instance_eval",
+    # "top" is the method from which the script is evaluated (the top-level frame of
+    # the script reports this method) and "release" is a Proc called with the names
+    # of the variables and a block which actually resets them.
+    def initialize(text, path, top, release)
+      @text = text
+      @path = path
+      @top = top
+      @release = release
+      @release_at = nil
+      @tp = nil
+    end
+
+    # Starts releasing the variables after their last use
+    def enable
+
+      if !@release_at
+        @release_at = {}
+        _analyze(@text)
+        @pending = @release_at.keys.sort
+      end
+
+      if !active?
+        return
+      end
+
+      @tp ||= TracePoint::new(:line) { |t| _trace(t) }
+      @tp.enabled? || @tp.enable
+
+    end
+
+    # Stops releasing variables
+    def disable
+      @tp && @tp.disable
+    end
+
+    # Returns true if there is anything to release
+    def active?
+      @release_at && !@release_at.empty?
+    end
+
+    def _analyze(text)
+
+      begin
+        require 'ripper'
+      rescue LoadError
+        return
+      end
+
+      # Needs TracePoint and binding access to local variables (Ruby 2.1 and later)
+      if !defined?(TracePoint) || !Binding.method_defined?(:local_variable_set)
+        return
+      end
+
+      sexp = Ripper.sexp(text)
+      if !sexp || sexp[0] != :program
+        # syntax errors are reported when the script is executed
+        return
+      end
+
+      stmts = sexp[1]
+      if !stmts.is_a?(Array)
+        return
+      end
+
+      @defines_methods = false
+      @dynamic = false
+      _scan_features(sexp)
+      if @dynamic
+        return
+      end
+
+      # last top-level statement using a variable and variables which
+      # must not be reset
+      last_use = {}
+      @unsafe = {}
+
+      lines = stmts.collect { |s| _line_of(s) }
+
+      stmts.each_with_index do |s,i|
+        _collect_vars(s, false) do |name|
+          last_use[name] = i
+        end
+      end
+
+      last_use.each do |name,i|
+        if !@unsafe[name]
+          # release when the next top-level statement starts
+          line = lines[(i + 1)..-1].find { |l| l && l > (lines[i] || 0) }
+          if line
+            (@release_at[line] ||= []) << name.to_sym
+          end
+        end
+      end
+
+    end
+
+    def _trace(t)
+
+      if @pending.empty? || t.path != @path
+        return
+      end
+
+      # only consider the top-level frame of the script (method definitions
+      # inside the script have their own scope)
+      if t.lineno < @pending[0] || t.method_id != @top
+        return
+      end
+
+      b = t.binding
+
+      names = []
+      while !@pending.empty? && @pending[0] <= t.lineno
+        @release_at[@pending.shift].each do |n|
+          if b.local_variable_defined?(n) && b.local_variable_get(n).is_a?(DRCLayer)
+            names << n
+          end
+        end
+      end
+
+      if !names.empty?
+        @release.call(names) do
+          names.each { |n| b.local_variable_set(n, nil) }
+        end
+      end
+
+    end
+
+    def _line_of(node)
+      if node.is_a?(Array)
+        if node[0].is_a?(Symbol) && node[0].to_s =~ /^@/ && node[2].is_a?(Array) && node[2][0].is_a?(Integer)
+          return node[2][0]
+        end
+        node.each do |n|
+          l = _line_of(n)
+          l && (return l)
+        end
+      end
+      nil
+    end
+
+    def _scan_features(node)
+      if node.is_a?(Array)
+        if node[0] == :def || node[0] == :defs
+          @defines_methods = true
+        elsif node[0] == :@ident && DYNAMIC_METHODS.index(node[1])
+          @dynamic = true
+        end
+        node.each { |n| _scan_features(n) }
+      end
+    end
+
+    # Delivers the local variables used inside the given node. "deferred"
+    # is true, if the node's code may be executed after the statement has
+    # finished.
+    def _collect_vars(node, deferred, &block)
+
+      if !node.is_a?(Array)
+        return
+      end
+
+      case node[0]
+
+      when :var_ref, :var_field
+        if node[1].is_a?(Array) && node[1][0] == :@ident
+          name = node[1][1]
+          deferred && (@unsafe[name] = true)
+          yield name
+        end
+        return
+
+      when :def, :defs, :class, :sclass, :module, :lambda
+        deferred = true
+
+      when :method_add_block
+        if @defines_methods || _deferred_block_call?(node[1])
+          deferred = true
+        end
+
+      end
+
+      node.each { |n| _collect_vars(n, deferred, &block) }
+
+    end
+
+    def _deferred_block_call?(call)
+      # the method name is the last identifier of the call expression (i.e. "lambda" in
+      # "lambda { ... }" or "new" in "Proc.new { ... }")
+      if call.is_a?(Array)
+        case call[0]
+        when :method_add_arg
+          return _deferred_block_call?(call[1])
+        when :fcall, :vcall, :command
+          return call[1].is_a?(Array) && DEFERRED_BLOCK_METHODS.index(call[1][1])
+        when :call, :command_call
+          m = call[3]
+          return m.is_a?(Array) && DEFERRED_BLOCK_METHODS.index(m[1])
+        end
+      end
+      false
+    end
+
+  end
+
+end
+
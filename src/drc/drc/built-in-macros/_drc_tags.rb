@@ -112,6 +112,30 @@ module DRC
     end
   end
 
+  # A wrapper for the tile size, step or boundary
+  # specification of the density check. The purpose
+  # of these classes is to identify the values by the class.
+  class DRCTileSize
+    attr_accessor :value
+    def initialize(*args)
+      self.value = args
+    end
+  end
+
+  class DRCTileStep
+    attr_accessor :value
+    def initialize(*args)
+      self.value = args
+    end
+  end
+
+  class DRCTileBoundary
+    attr_accessor :value
+    def initialize(v)
+      self.value = v
+    end
+  end
+
   # A wrapper for an input for the antenna check
   # This class is used to identify a region plus an
   # optional perimeter factor
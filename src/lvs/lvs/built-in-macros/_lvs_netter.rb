@@ -262,6 +262,7 @@ module LVS
     def _comparer
 
       comparer = RBA::NetlistComparer::new
+      comparer.threads = (@engine._threads || 0)
 
       # execute the configuration commands
       @comparer_config.each do |cc|
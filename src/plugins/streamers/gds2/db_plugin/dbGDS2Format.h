@@ -45,7 +45,8 @@ public:
   GDS2ReaderOptions ()
     : box_mode (1),
       allow_big_records (true),
-      allow_multi_xy_records (true)
+      allow_multi_xy_records (true),
+      threads (0)
   {
     //  .. nothing yet ..
   }
@@ -75,7 +76,17 @@ public:
    */
   bool allow_multi_xy_records;
 
-  /** 
+  /**
+   *  @brief The number of threads to use for decoding the cell bodies
+   *
+   *  If this property is 0 (the default), the file is read strictly serially.
+   *  Otherwise, the reader will scan the file for the cell structures and
+   *  decode the cell bodies in the given number of worker threads. The result
+   *  is the same as that of the serial reader.
+   */
+  unsigned int threads;
+
+  /**
    *  @brief Implementation of FormatSpecificReaderOptions
    */
   virtual FormatSpecificReaderOptions *clone () const
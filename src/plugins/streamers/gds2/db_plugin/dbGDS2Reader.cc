@@ -33,6 +33,128 @@
 namespace db
 {
 
+// ---------------------------------------------------------------
+//  GDS2CellBody definition and implementation
+
+/**
+ *  @brief The upper limits for the number of cell bodies and the number of bytes kept per thread
+ *
+ *  If more cell bodies are pending, the reader waits for the first ones
+ *  to finish before reading further cells.
+ */
+const size_t max_cell_bodies_per_thread = 16;
+const size_t max_cell_body_bytes_per_thread = 16 * 1024 * 1024;
+
+/**
+ *  @brief The raw data of a cell body and the result of decoding it
+ *
+ *  The cell body records are decoded by a separate GDS2Reader into a
+ *  separate layout. This layout is created by the main thread, so the
+ *  worker thread only fills it.
+ */
+class GDS2CellBody
+{
+public:
+  GDS2CellBody (const std::string &cn, size_t pos, size_t recnum, bool editable)
+    : cellname (cn), pos (pos), recnum (recnum), layout (editable), cell_index (0), done (false)
+  {
+    //  .. nothing yet ..
+  }
+
+  void process (GDS2Reader &parent)
+  {
+    try {
+      read (parent);
+    } catch (tl::Exception &ex) {
+      error = ex.msg ();
+    } catch (std::exception &ex) {
+      error = ex.what ();
+    } catch (...) {
+      set_done (parent, tl::to_string (tr ("Unspecific error")));
+      throw;
+    }
+
+    set_done (parent, error);
+  }
+
+  std::string cellname;
+  std::string data;
+  size_t pos, recnum;
+  db::Layout layout;
+  db::cell_index_type cell_index;
+  tl::vector<db::CellInstArray> instances;
+  tl::vector<db::CellInstArrayWithProperties> instances_with_props;
+  std::vector<std::string> warnings;
+  std::string error;
+  bool done;
+
+private:
+  void read (GDS2Reader &parent)
+  {
+    tl::InputMemoryStream ims (data.c_str (), data.size ());
+    tl::InputStream is (ims);
+
+    GDS2Reader reader (is);
+    reader.m_options = parent.m_options;
+    reader.m_common_options = parent.m_common_options;
+    reader.m_pos_offset = pos;
+    reader.m_recnum = recnum;
+    reader.mp_warnings = &warnings;
+
+    cell_index = reader.read_cell_body (layout, parent, cellname, instances, instances_with_props);
+  }
+
+  void set_done (GDS2Reader &parent, const std::string &err)
+  {
+    tl::MutexLocker locker (&parent.m_cell_body_lock);
+    error = err;
+    done = true;
+    parent.m_cell_body_done.wakeAll ();
+  }
+};
+
+/**
+ *  @brief The task object for decoding a cell body
+ */
+class GDS2CellBodyTask
+  : public tl::Task
+{
+public:
+  GDS2CellBodyTask (GDS2Reader *reader, GDS2CellBody *body)
+    : mp_reader (reader), mp_body (body)
+  {
+    //  .. nothing yet ..
+  }
+
+  void perform ()
+  {
+    mp_body->process (*mp_reader);
+  }
+
+private:
+  GDS2Reader *mp_reader;
+  GDS2CellBody *mp_body;
+};
+
+/**
+ *  @brief The worker decoding the cell bodies
+ */
+class GDS2CellBodyWorker
+  : public tl::Worker
+{
+public:
+  GDS2CellBodyWorker ()
+    : tl::Worker ()
+  {
+    //  .. nothing yet ..
+  }
+
+  void perform_task (tl::Task *task)
+  {
+    static_cast<GDS2CellBodyTask *> (task)->perform ();
+  }
+};
+
 // ---------------------------------------------------------------
 //  GDS2Reader
 
@@ -43,7 +165,10 @@ GDS2Reader::GDS2Reader (tl::InputStream &s)
     m_recptr (0),
     mp_rec_buf (0),
     m_stored_rec (0),
-    m_progress (tl::to_string (tr ("Reading GDS2 file")), 10000)
+    m_progress (tl::to_string (tr ("Reading GDS2 file")), 10000),
+    m_pos_offset (0),
+    mp_warnings (0),
+    m_cell_body_bytes (0)
 {
   m_progress.set_format (tl::to_string (tr ("%.0f MB")));
   m_progress.set_unit (1024 * 1024);
@@ -51,7 +176,7 @@ GDS2Reader::GDS2Reader (tl::InputStream &s)
 
 GDS2Reader::~GDS2Reader ()
 {
-  //  .. nothing yet ..
+  stop_cell_body_workers ();
 }
 
 const LayerMap &
@@ -64,7 +189,14 @@ GDS2Reader::read (db::Layout &layout, const db::LoadLayoutOptions &options)
   --m_recnum;
   m_reclen = 0;
 
-  return basic_read (layout, m_common_options.layer_map, m_common_options.create_other_layers, m_common_options.enable_text_objects, m_common_options.enable_properties, m_options.allow_multi_xy_records, m_options.box_mode, m_common_options.cell_conflict_resolution);
+  try {
+    const LayerMap &lm = basic_read (layout, m_common_options.layer_map, m_common_options.create_other_layers, m_common_options.enable_text_objects, m_common_options.enable_properties, m_options.allow_multi_xy_records, m_options.box_mode, m_common_options.cell_conflict_resolution);
+    stop_cell_body_workers ();
+    return lm;
+  } catch (...) {
+    stop_cell_body_workers ();
+    throw;
+  }
 }
 
 const LayerMap &
@@ -73,6 +205,120 @@ GDS2Reader::read (db::Layout &layout)
   return read (layout, db::LoadLayoutOptions ());
 }
 
+bool
+GDS2Reader::defer_cell_body (db::Layout &layout)
+{
+  if (m_options.threads == 0) {
+    return false;
+  }
+
+  GDS2CellBody *body = new GDS2CellBody (cellname (), stream_pos (), m_recnum, layout.is_editable ());
+  m_cell_bodies.push_back (body);
+
+  //  collect the raw records up to and including ENDSTR - the worker will decode them
+  short rec_id = 0;
+  do {
+
+    rec_id = get_record ();
+    progress_checkpoint ();
+
+    size_t l = m_reclen + 4;
+    char hdr [4] = { char (l >> 8), char (l), char (rec_id >> 8), char (rec_id) };
+    body->data.append (hdr, sizeof (hdr));
+    if (m_reclen > 0) {
+      body->data.append ((const char *) mp_rec_buf, m_reclen);
+    }
+
+  } while (rec_id != sENDSTR);
+
+  m_cell_body_bytes += body->data.size ();
+
+  if (! mp_cell_body_job.get ()) {
+    mp_cell_body_job.reset (new tl::Job<GDS2CellBodyWorker> (int (m_options.threads)));
+  }
+
+  mp_cell_body_job->schedule (new GDS2CellBodyTask (this, body));
+  if (! mp_cell_body_job->is_running ()) {
+    mp_cell_body_job->start ();
+  }
+
+  //  commit the bodies which are ready and wait for the first ones if too many are pending
+  while (! m_cell_bodies.empty ()) {
+
+    bool ready = false;
+    {
+      tl::MutexLocker locker (&m_cell_body_lock);
+      ready = m_cell_bodies.front ()->done;
+    }
+
+    if (ready || m_cell_bodies.size () > max_cell_bodies_per_thread * m_options.threads || m_cell_body_bytes > max_cell_body_bytes_per_thread * m_options.threads) {
+      commit_next_cell_body (layout);
+    } else {
+      break;
+    }
+
+  }
+
+  return true;
+}
+
+void
+GDS2Reader::finish_deferred_cell_bodies (db::Layout &layout)
+{
+  while (! m_cell_bodies.empty ()) {
+    commit_next_cell_body (layout);
+  }
+}
+
+void
+GDS2Reader::commit_next_cell_body (db::Layout &layout)
+{
+  GDS2CellBody *body = m_cell_bodies.front ();
+
+  {
+    tl::MutexLocker locker (&m_cell_body_lock);
+    while (! body->done) {
+      m_cell_body_done.wait (&m_cell_body_lock);
+    }
+  }
+
+  m_cell_bodies.pop_front ();
+  m_cell_body_bytes -= body->data.size ();
+
+  std::auto_ptr<GDS2CellBody> body_holder (body);
+
+  if (! body->error.empty ()) {
+    throw db::ReaderException (body->error);
+  }
+
+  for (std::vector<std::string>::const_iterator w = body->warnings.begin (); w != body->warnings.end (); ++w) {
+    tl::warn << *w;
+  }
+
+  commit_cell_body (layout, body->cellname, body->layout, body->cell_index, body->instances, body->instances_with_props);
+}
+
+void
+GDS2Reader::stop_cell_body_workers ()
+{
+  if (mp_cell_body_job.get ()) {
+    mp_cell_body_job->terminate ();
+    mp_cell_body_job.reset (0);
+  }
+
+  for (std::list<GDS2CellBody *>::const_iterator b = m_cell_bodies.begin (); b != m_cell_bodies.end (); ++b) {
+    delete *b;
+  }
+  m_cell_bodies.clear ();
+  m_cell_body_bytes = 0;
+}
+
+size_t
+GDS2Reader::stream_pos () const
+{
+  return m_stream.pos () + m_pos_offset;
+}
+
 void 
 GDS2Reader::unget_record (short rec_id)
 {  
@@ -253,7 +499,7 @@ GDS2Reader::get_xy_data (unsigned int &length)
 void  
 GDS2Reader::progress_checkpoint () 
 {
-  m_progress.set (m_stream.pos ());
+  m_progress.set (stream_pos ());
 }
 
 std::string
@@ -265,18 +511,25 @@ GDS2Reader::path () const
 void 
 GDS2Reader::error (const std::string &msg)
 {
-  throw GDS2ReaderException (msg, m_stream.pos (), m_recnum, cellname ().c_str ());
+  throw GDS2ReaderException (msg, stream_pos (), m_recnum, cellname ().c_str ());
 }
 
 void 
 GDS2Reader::warn (const std::string &msg) 
 {
-  // TODO: compress
-  tl::warn << msg 
-           << tl::to_string (tr (" (position=")) << m_stream.pos ()
-           << tl::to_string (tr (", record number=")) << m_recnum
-           << tl::to_string (tr (", cell=")) << cellname ().c_str ()
-           << ")";
+  std::string w = msg
+                + tl::to_string (tr (" (position=")) + tl::to_string (stream_pos ())
+                + tl::to_string (tr (", record number=")) + tl::to_string (m_recnum)
+                + tl::to_string (tr (", cell=")) + cellname ()
+                + ")";
+
+  if (mp_warnings) {
+    //  warnings of cell bodies read in worker threads are delivered later
+    mp_warnings->push_back (w);
+  } else {
+    // TODO: compress
+    tl::warn << w;
+  }
 }
 
 }
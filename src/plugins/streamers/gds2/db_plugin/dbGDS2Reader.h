@@ -37,10 +37,16 @@
 #include "tlProgress.h"
 #include "tlString.h"
 #include "tlStream.h"
+#include "tlThreadedWorkers.h"
+
+#include <list>
+#include <memory>
 
 namespace db
 {
 
+class GDS2CellBody;
+
 /**
  *  @brief Generic base class of GDS2 reader exceptions
  */
@@ -110,6 +116,8 @@ public:
   virtual const char *format () const { return "GDS2"; }
 
 private:
+  friend class GDS2CellBody;
+
   tl::InputStream &m_stream;
   size_t m_recnum;
   size_t m_reclen;
@@ -120,6 +128,20 @@ private:
   db::GDS2ReaderOptions m_options;
   db::CommonReaderOptions m_common_options;
   tl::AbsoluteProgress m_progress;
+  size_t m_pos_offset;
+  std::vector<std::string> *mp_warnings;
+  std::list<GDS2CellBody *> m_cell_bodies;
+  size_t m_cell_body_bytes;
+  tl::Mutex m_cell_body_lock;
+  tl::WaitCondition m_cell_body_done;
+  std::auto_ptr<tl::JobBase> mp_cell_body_job;
+
+  size_t stream_pos () const;
+  void commit_next_cell_body (db::Layout &layout);
+  void stop_cell_body_workers ();
+
+  virtual bool defer_cell_body (db::Layout &layout);
+  virtual void finish_deferred_cell_bodies (db::Layout &layout);
 
   virtual void error (const std::string &txt);
   virtual void warn (const std::string &txt);
@@ -24,6 +24,7 @@
 #include "dbGDS2ReaderBase.h"
 #include "dbGDS2.h"
 #include "dbArray.h"
+#include "dbLayoutUtils.h"
 
 #include "tlException.h"
 #include "tlString.h"
@@ -354,108 +355,244 @@ GDS2ReaderBase::do_read (db::Layout &layout)
 
       read_context_info_cell ();
 
+    } else if (m_context_info.find (m_cellname) == m_context_info.end () && defer_cell_body (layout)) {
+
+      //  the cell body will be read and committed later (proxy cells are always read immediately)
+
     } else {
 
+      //  commit the cells deferred before so the cells are created in the original order
+      finish_deferred_cell_bodies (layout);
+
       db::cell_index_type cell_index = make_cell (layout, m_cellname);
 
       db::Cell *cell = &layout.cell (cell_index);
 
-      std::map <tl::string, std::vector <std::string> >::const_iterator ctx = m_context_info.find (m_cellname);
-      if (ctx != m_context_info.end ()) {
-        GDS2ReaderLayerMapping layer_mapping (this, &layout, m_create_layers);
-        if (layout.recover_proxy_as (cell_index, ctx->second.begin (), ctx->second.end (), &layer_mapping)) {
-          //  ignore everything in that cell since it is created by the import:
-          cell = 0;
+      if (recover_proxy (layout, cell_index)) {
+        //  ignore everything in that cell since it is created by the import:
+        cell = 0;
+      }
+
+      read_cell_content (layout, cell, instances, instances_with_props);
+
+      if (cell) {
+
+        //  insert all instances collected
+        if (! instances.empty ()) {
+          cell->insert (instances.begin (), instances.end ());
         }
+        if (! instances_with_props.empty ()) {
+          cell->insert (instances_with_props.begin (), instances_with_props.end ());
+        }
+
       }
-      
-      long attr = 0;
-      db::PropertiesRepository::properties_set cell_properties;
 
-      //  read cell content
-      while ((rec_id = get_record ()) != sENDSTR) { 
+    }
 
-        progress_checkpoint ();
+    m_cellname = "";
+    first_cell = false;
 
-        if (cell == 0) {
+  }
 
-          //  ignore everything in proxy cells: these are created from the libraries or PCells.
+  finish_deferred_cell_bodies (layout);
 
-        } else if (rec_id == sPROPATTR) {
+  //  check, if the last record is a ENDLIB
+  if (rec_id != sENDLIB) {
+    error (tl::to_string (tr ("ENDLIB record expected")));
+  }
+}
 
-          attr = long (get_ushort ());
+bool
+GDS2ReaderBase::recover_proxy (db::Layout &layout, db::cell_index_type cell_index)
+{
+  std::map <tl::string, std::vector <std::string> >::const_iterator ctx = m_context_info.find (m_cellname);
+  if (ctx != m_context_info.end ()) {
+    GDS2ReaderLayerMapping layer_mapping (this, &layout, m_create_layers);
+    return layout.recover_proxy_as (cell_index, ctx->second.begin (), ctx->second.end (), &layer_mapping);
+  } else {
+    return false;
+  }
+}
 
-        } else if (rec_id == sPROPVALUE) {
+void
+GDS2ReaderBase::read_cell_content (db::Layout &layout, db::Cell *cell, tl::vector<db::CellInstArray> &instances, tl::vector<db::CellInstArrayWithProperties> &instances_with_props)
+{
+  long attr = 0;
+  db::PropertiesRepository::properties_set cell_properties;
 
-          const char *value = get_string ();
-          if (m_read_properties) {
-            cell_properties.insert (std::make_pair (layout.properties_repository ().prop_name_id (tl::Variant (attr)), tl::Variant (value)));
-          }
+  //  read cell content
+  short rec_id = 0;
+  while ((rec_id = get_record ()) != sENDSTR) {
 
-        } else if (rec_id == sBOUNDARY) {
+    progress_checkpoint ();
 
-          read_boundary (layout, *cell, false);
+    if (cell == 0) {
 
-        } else if (rec_id == sPATH) {
+      //  ignore everything in proxy cells: these are created from the libraries or PCells.
 
-          read_path (layout, *cell);
+    } else if (rec_id == sPROPATTR) {
 
-        } else if (rec_id == sSREF || rec_id == sAREF) {
+      attr = long (get_ushort ());
 
-          bool array = (rec_id == sAREF);
-          read_ref (layout, *cell, array, instances, instances_with_props);
+    } else if (rec_id == sPROPVALUE) {
 
-        } else if (rec_id == sTEXT) {
+      const char *value = get_string ();
+      if (m_read_properties) {
+        cell_properties.insert (std::make_pair (layout.properties_repository ().prop_name_id (tl::Variant (attr)), tl::Variant (value)));
+      }
 
-          read_text (layout, *cell);
+    } else if (rec_id == sBOUNDARY) {
 
-        } else if (rec_id == sBOX) {
+      read_boundary (layout, *cell, false);
 
-          if (m_box_mode == 1) {
-            read_box (layout, *cell);
-          } else if (m_box_mode == 2) {
-            read_boundary (layout, *cell, true);
-          } else if (m_box_mode == 3) {
-            error (tl::to_string (tr ("BOX record encountered (reader is configured to produce an error in this case)")));
-          } else {
-            while (get_record () != sENDEL) { }
-          }
+    } else if (rec_id == sPATH) {
 
-        } else if (rec_id == sNODE) {
+      read_path (layout, *cell);
 
-          //  NODE records are ignored.
-          while (get_record () != sENDEL) { }
+    } else if (rec_id == sSREF || rec_id == sAREF) {
 
-        } else {
-          error (tl::to_string (tr ("Invalid record or data type")));
-        }
-      
-      }
+      bool array = (rec_id == sAREF);
+      read_ref (layout, *cell, array, instances, instances_with_props);
 
-      //  insert all instances collected
-      if (! instances.empty ()) {
-        cell->insert (instances.begin (), instances.end ());
-      }
-      if (! instances_with_props.empty ()) {
-        cell->insert (instances_with_props.begin (), instances_with_props.end ());
-      }
+    } else if (rec_id == sTEXT) {
+
+      read_text (layout, *cell);
 
-      //  set the cell properties
-      if (! cell_properties.empty ()) {
-        cell->prop_id (layout.properties_repository ().properties_id (cell_properties));
+    } else if (rec_id == sBOX) {
+
+      if (m_box_mode == 1) {
+        read_box (layout, *cell);
+      } else if (m_box_mode == 2) {
+        read_boundary (layout, *cell, true);
+      } else if (m_box_mode == 3) {
+        error (tl::to_string (tr ("BOX record encountered (reader is configured to produce an error in this case)")));
+      } else {
+        while (get_record () != sENDEL) { }
       }
 
+    } else if (rec_id == sNODE) {
+
+      //  NODE records are ignored.
+      while (get_record () != sENDEL) { }
+
+    } else {
+      error (tl::to_string (tr ("Invalid record or data type")));
     }
 
-    m_cellname = "";
-    first_cell = false;
+  }
 
+  //  set the cell properties
+  if (cell && ! cell_properties.empty ()) {
+    cell->prop_id (layout.properties_repository ().properties_id (cell_properties));
   }
+}
 
-  //  check, if the last record is a ENDLIB
-  if (rec_id != sENDLIB) {
-    error (tl::to_string (tr ("ENDLIB record expected")));
+db::cell_index_type
+GDS2ReaderBase::read_cell_body (db::Layout &layout, const GDS2ReaderBase &parent, const std::string &cn, tl::vector<db::CellInstArray> &instances, tl::vector<db::CellInstArrayWithProperties> &instances_with_props)
+{
+  //  take the settings from the parent reader, but read every layer: the
+  //  layer mapping is done when the cell is committed.
+  m_layer_map = LayerMap ();
+  m_layer_map.prepare (layout);
+  m_create_layers = true;
+  m_read_texts = parent.m_read_texts;
+  m_read_properties = parent.m_read_properties;
+  m_allow_multi_xy_records = parent.m_allow_multi_xy_records;
+  m_box_mode = parent.m_box_mode;
+  m_dbu = parent.m_dbu;
+  m_dbuu = parent.m_dbuu;
+  m_libname = parent.m_libname;
+  m_cellname = cn;
+
+  layout.dbu (m_dbu);
+
+  db::cell_index_type cell_index = make_cell (layout, m_cellname);
+  read_cell_content (layout, &layout.cell (cell_index), instances, instances_with_props);
+
+  //  gives the cells their names
+  finish (layout);
+
+  return cell_index;
+}
+
+namespace
+{
+
+/**
+ *  @brief A cell index mapping for the instances of a cell committed by "commit_cell_body"
+ */
+struct CellBodyCellMapping
+{
+  CellBodyCellMapping (const std::vector<db::cell_index_type> &cm)
+    : cell_map (cm)
+  { }
+
+  db::cell_index_type operator() (db::cell_index_type ci) const
+  {
+    return cell_map [ci];
   }
+
+  const std::vector<db::cell_index_type> &cell_map;
+};
+
+}
+
+void
+GDS2ReaderBase::commit_cell_body (db::Layout &layout, const std::string &cn, const db::Layout &cell_layout, db::cell_index_type cell_layout_ci, tl::vector<db::CellInstArray> &instances, tl::vector<db::CellInstArrayWithProperties> &instances_with_props)
+{
+  //  this method may be called while another cell is being read, so restore the current cell name later
+  std::string org_cellname = m_cellname;
+  m_cellname = cn;
+
+  db::cell_index_type cell_index = make_cell (layout, m_cellname);
+
+  db::Cell &cell = layout.cell (cell_index);
+  const db::Cell &cell_body = cell_layout.cell (cell_layout_ci);
+
+  //  map the cells in the order of their appearance, so the cell indexes are the same
+  //  as with the serial reader
+  std::vector<db::cell_index_type> cell_map;
+  cell_map.reserve (cell_layout.cells ());
+  for (db::cell_index_type ci = 0; ci < cell_layout.cells (); ++ci) {
+    if (ci == cell_layout_ci) {
+      cell_map.push_back (cell_index);
+    } else {
+      cell_map.push_back (cell_for_instance (layout, cell_layout.cell_name (ci)));
+    }
+  }
+
+  db::PropertyMapper pm (layout, cell_layout);
+
+  //  layers are mapped in the order of their appearance too
+  for (db::Layout::layer_iterator l = cell_layout.begin_layers (); l != cell_layout.end_layers (); ++l) {
+    std::pair<bool, unsigned int> ll = open_dl (layout, LDPair ((*l).second->layer, (*l).second->datatype), m_create_layers);
+    if (ll.first && ! cell_body.shapes ((*l).first).empty ()) {
+      cell.shapes (ll.second).insert (cell_body.shapes ((*l).first), pm);
+    }
+  }
+
+  CellBodyCellMapping cm (cell_map);
+
+  for (tl::vector<db::CellInstArray>::iterator i = instances.begin (); i != instances.end (); ++i) {
+    i->object () = db::CellInst (cm (i->object ().cell_index ()));
+  }
+  for (tl::vector<db::CellInstArrayWithProperties>::iterator i = instances_with_props.begin (); i != instances_with_props.end (); ++i) {
+    i->object () = db::CellInst (cm (i->object ().cell_index ()));
+    i->properties_id (pm (i->properties_id ()));
+  }
+
+  if (! instances.empty ()) {
+    cell.insert (instances.begin (), instances.end ());
+  }
+  if (! instances_with_props.empty ()) {
+    cell.insert (instances_with_props.begin (), instances_with_props.end ());
+  }
+
+  if (cell_body.prop_id () != 0) {
+    cell.prop_id (pm (cell_body.prop_id ()));
+  }
+
+  m_cellname = org_cellname;
 }
 
 void
@@ -97,6 +97,47 @@ protected:
    */
   const std::string &cellname () const { return m_cellname; }
 
+  /**
+   *  @brief Reads the body of a single cell into a separate layout
+   *
+   *  This method is used by the multi-threaded reader to decode a cell body
+   *  independently from the main layout. The reader settings are taken from
+   *  "parent". The records are expected to start after the STRNAME record and
+   *  to end with ENDSTR. A new cell is created inside "layout" and the cells referenced
+   *  by instances are created in the order of their appearance. The instances are not
+   *  inserted but delivered through "instances" and "instances_with_props".
+   *
+   *  @return The index of the cell created in "layout"
+   */
+  db::cell_index_type read_cell_body (db::Layout &layout, const GDS2ReaderBase &parent, const std::string &cn, tl::vector<db::CellInstArray> &instances, tl::vector<db::CellInstArrayWithProperties> &instances_with_props);
+
+  /**
+   *  @brief Transfers a cell read by "read_cell_body" into the target layout
+   *
+   *  This method will create the cell, map the layers, properties and cells referenced
+   *  by instances exactly like the serial reader would have done. Proxy cells are
+   *  not deferred, hence this method does not need to consider them.
+   */
+  void commit_cell_body (db::Layout &layout, const std::string &cn, const db::Layout &cell_layout, db::cell_index_type cell_layout_ci, tl::vector<db::CellInstArray> &instances, tl::vector<db::CellInstArrayWithProperties> &instances_with_props);
+
+  /**
+   *  @brief Takes the body of a cell for deferred reading
+   *
+   *  This method is called after the STRNAME record has been read. If the implementation
+   *  decides to read the cell body later, it needs to consume all records up to and
+   *  including ENDSTR and return true. The default implementation returns false, which
+   *  means that the cell body is read immediately.
+   */
+  virtual bool defer_cell_body (db::Layout & /*layout*/) { return false; }
+
+  /**
+   *  @brief Finishes all deferred cell bodies
+   *
+   *  This method is called after the last cell has been read. It needs to commit
+   *  all cells which have been deferred by "defer_cell_body" but not committed yet.
+   */
+  virtual void finish_deferred_cell_bodies (db::Layout & /*layout*/) { }
+
 private:
   friend class GDS2ReaderLayerMapping;
 
@@ -119,6 +160,9 @@ private:
   void read_box (db::Layout &layout, db::Cell &cell);
   void read_ref (db::Layout &layout, db::Cell &cell, bool array, tl::vector<db::CellInstArray> &instances, tl::vector<db::CellInstArrayWithProperties> &insts_wp);
 
+  void read_cell_content (db::Layout &layout, db::Cell *cell, tl::vector<db::CellInstArray> &instances, tl::vector<db::CellInstArrayWithProperties> &insts_wp);
+  bool recover_proxy (db::Layout &layout, db::cell_index_type cell_index);
+
   void do_read (db::Layout &layout);
 
   std::pair <bool, unsigned int> open_dl (db::Layout &layout, const LDPair &dl, bool create);
@@ -533,3 +533,56 @@ TEST(4_CollectModeAdd)
   db::compare_layouts (_this, layout, fn_au, db::WriteGDS2, 1);
 }
 
+
+TEST(5_MultiThreaded)
+{
+  db::Manager m (false);
+  db::Layout layout (&m);
+
+  db::LoadLayoutOptions options;
+  db::LayerMap lm;
+
+  unsigned int n = 0;
+  lm.map_expr ("*/*: *+100/*", n++);
+  lm.map_expr ("1/*: */*", n++);
+  lm.map_expr ("1/10: 1/0", n++);
+  lm.map_expr ("1/20-30: 1/*+1000", n++);
+  lm.map_expr ("2/*", n++);
+  lm.map_expr ("2/10-20: */*", n++);
+  options.get_options<db::CommonReaderOptions> ().layer_map = lm;
+  options.get_options<db::GDS2ReaderOptions> ().threads = 4;
+
+  {
+    tl::InputStream file (tl::testsrc () + "/testdata/gds/alm.gds");
+    db::Reader reader (file);
+    reader.read (layout, options);
+  }
+
+  std::string fn_au (tl::testsrc () + "/testdata/gds/alm_au.gds");
+  db::compare_layouts (_this, layout, fn_au, db::WriteGDS2, 1);
+}
+
+TEST(5_MultiThreadedCollectModeAdd)
+{
+  db::Manager m (false);
+  db::Layout layout (&m);
+
+  db::LoadLayoutOptions options;
+  options.get_options<db::CommonReaderOptions> ().cell_conflict_resolution = db::CommonReader::AddToCell;
+  options.get_options<db::GDS2ReaderOptions> ().threads = 2;
+
+  {
+    tl::InputStream file (tl::testsrc () + "/testdata/gds/collect_basic.gds");
+    db::Reader reader (file);
+    reader.read (layout, options);
+  }
+
+  {
+    tl::InputStream file (tl::testsrc () + "/testdata/gds/collect_added.gds");
+    db::Reader reader (file);
+    reader.read (layout, options);
+  }
+
+  std::string fn_au (tl::testsrc () + "/testdata/gds/collect_add_au.gds");
+  db::compare_layouts (_this, layout, fn_au, db::WriteGDS2, 1);
+}
@@ -472,7 +472,8 @@ public:
       tl::make_member (&db::OASISWriterOptions::strict_mode, "strict-mode") +
       tl::make_member (&db::OASISWriterOptions::write_std_properties, "write-std-properties") +
       tl::make_member (&db::OASISWriterOptions::subst_char, "subst-char") +
-      tl::make_member (&db::OASISWriterOptions::permissive, "permissive")
+      tl::make_member (&db::OASISWriterOptions::permissive, "permissive") +
+      tl::make_member (&db::OASISWriterOptions::threads, "threads")
     );
   }
 };
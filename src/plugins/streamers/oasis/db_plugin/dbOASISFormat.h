@@ -43,7 +43,7 @@ public:
    *  @brief The constructor
    */
   OASISReaderOptions ()
-    : read_all_properties (false), expect_strict_mode (-1)
+    : read_all_properties (false), expect_strict_mode (-1), threads (0)
   {
     //  .. nothing yet ..
   }
@@ -70,6 +70,16 @@ public:
    */
   int expect_strict_mode;
 
+  /**
+   *  @brief The number of threads to use for inflating CBLOCKs
+   *
+   *  If this property is 0 (the default), compressed blocks are inflated by the
+   *  reader itself. Otherwise, the CBLOCKs following the current one are inflated
+   *  ahead in the given number of worker threads. This applies to uncompressed
+   *  local files only which can be mapped into memory.
+   */
+  unsigned int threads;
+
   /**
    *  @brief Implementation of FormatSpecificReaderOptions
    */
@@ -101,7 +111,7 @@ public:
    *  @brief The constructor
    */
   OASISWriterOptions ()
-    : compression_level (2), write_cblocks (false), strict_mode (false), recompress (false), permissive (false), write_std_properties (1), subst_char ("*")
+    : compression_level (2), write_cblocks (false), strict_mode (false), recompress (false), permissive (false), write_std_properties (1), subst_char ("*"), threads (0)
   {
     //  .. nothing yet ..
   }
@@ -166,6 +176,16 @@ public:
    */
   std::string subst_char;
 
+  /**
+   *  @brief The number of threads to use for producing the cell bodies
+   *
+   *  If this value is 0 (the default), the cells are written serially. Otherwise
+   *  the cell bodies are produced and CBLOCK-compressed in the given number of
+   *  worker threads and written to the file in the original order. The output
+   *  is identical to that of the serial writer.
+   */
+  unsigned int threads;
+
   /** 
    *  @brief Implementation of FormatSpecificWriterOptions
    */
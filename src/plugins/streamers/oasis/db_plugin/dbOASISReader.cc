@@ -32,6 +32,8 @@
 #include "tlException.h"
 #include "tlString.h"
 #include "tlClassRegistry.h"
+#include "tlDeflate.h"
+#include "tlThreadedWorkers.h"
 
 namespace db
 {
@@ -67,6 +69,314 @@ private:
   bool m_create;
 };
 
+// ---------------------------------------------------------------
+//  CBLOCK prefetching
+
+/**
+ *  @brief The maximum number of CBLOCKs inflated ahead per thread
+ */
+const size_t max_cblocks_per_thread = 4;
+
+/**
+ *  @brief The maximum number of uncompressed bytes held ahead per thread
+ */
+const size_t max_cblock_bytes_per_thread = 16 * 1024 * 1024;
+
+/**
+ *  @brief A CBLOCK inflated by a worker thread
+ */
+struct OASISCBlock
+{
+  OASISCBlock (const char *_cdata, size_t _comp, size_t _uncomp)
+    : cdata (_cdata), comp (_comp), uncomp (_uncomp), done (false), ok (false)
+  {
+    //  .. nothing yet ..
+  }
+
+  const char *cdata;
+  size_t comp, uncomp;
+  std::string data;
+  bool done, ok;
+};
+
+/**
+ *  @brief Inflates the CBLOCKs ahead of the reader
+ *
+ *  This object scans the raw file data for CBLOCK records following the one
+ *  the reader is about to read and has the workers inflate them. The reader
+ *  takes the uncompressed data with "take". Scanning stops at any record other
+ *  than CBLOCK, PAD or CELL and resumes at the next CBLOCK requested by the reader.
+ *  If a CBLOCK is not available or could not be inflated, "take" returns 0 and the
+ *  reader falls back to inflating the block itself.
+ */
+class OASISCBlockPrefetcher
+{
+public:
+  OASISCBlockPrefetcher (const char *data, size_t length, unsigned int threads);
+  ~OASISCBlockPrefetcher ();
+
+  const OASISCBlock *take (size_t pos, size_t comp, size_t uncomp);
+  void inflate (OASISCBlock *block);
+
+private:
+  const char *mp_data;
+  size_t m_length;
+  unsigned int m_threads;
+  size_t m_scan_pos;
+  bool m_scan_valid;
+  size_t m_pending_bytes;
+  std::map<size_t, OASISCBlock *> m_blocks;
+  tl::Mutex m_lock;
+  tl::WaitCondition m_block_done;
+  std::auto_ptr<tl::JobBase> mp_job;
+
+  void scan_ahead ();
+  void schedule (size_t pos, size_t comp, size_t uncomp);
+  bool read_uint (size_t &p, size_t &v) const;
+};
+
+/**
+ *  @brief The task object for inflating a CBLOCK
+ */
+class OASISCBlockTask
+  : public tl::Task
+{
+public:
+  OASISCBlockTask (OASISCBlockPrefetcher *prefetcher, OASISCBlock *block)
+    : mp_prefetcher (prefetcher), mp_block (block)
+  {
+    //  .. nothing yet ..
+  }
+
+  void perform ()
+  {
+    mp_prefetcher->inflate (mp_block);
+  }
+
+private:
+  OASISCBlockPrefetcher *mp_prefetcher;
+  OASISCBlock *mp_block;
+};
+
+/**
+ *  @brief The worker inflating the CBLOCKs
+ */
+class OASISCBlockWorker
+  : public tl::Worker
+{
+public:
+  OASISCBlockWorker ()
+    : tl::Worker ()
+  {
+    //  .. nothing yet ..
+  }
+
+  void perform_task (tl::Task *task)
+  {
+    static_cast<OASISCBlockTask *> (task)->perform ();
+  }
+};
+
+OASISCBlockPrefetcher::OASISCBlockPrefetcher (const char *data, size_t length, unsigned int threads)
+  : mp_data (data), m_length (length), m_threads (threads), m_scan_pos (0), m_scan_valid (false), m_pending_bytes (0)
+{
+  //  .. nothing yet ..
+}
+
+OASISCBlockPrefetcher::~OASISCBlockPrefetcher ()
+{
+  if (mp_job.get ()) {
+    mp_job->terminate ();
+    mp_job.reset (0);
+  }
+
+  for (std::map<size_t, OASISCBlock *>::const_iterator b = m_blocks.begin (); b != m_blocks.end (); ++b) {
+    delete b->second;
+  }
+  m_blocks.clear ();
+}
+
+const OASISCBlock *
+OASISCBlockPrefetcher::take (size_t pos, size_t comp, size_t uncomp)
+{
+  //  blocks before the requested one are not needed anymore - the reader has consumed them
+  while (! m_blocks.empty () && m_blocks.begin ()->first < pos) {
+
+    OASISCBlock *block = m_blocks.begin ()->second;
+
+    {
+      tl::MutexLocker locker (&m_lock);
+      while (! block->done) {
+        m_block_done.wait (&m_lock);
+      }
+    }
+
+    m_pending_bytes -= block->uncomp;
+    m_blocks.erase (m_blocks.begin ());
+    delete block;
+
+  }
+
+  std::map<size_t, OASISCBlock *>::const_iterator b = m_blocks.find (pos);
+  if (b == m_blocks.end ()) {
+    //  not scanned: the reader inflates this block, we continue behind it
+    m_scan_pos = pos + comp;
+    m_scan_valid = true;
+    scan_ahead ();
+    return 0;
+  }
+
+  scan_ahead ();
+
+  OASISCBlock *block = b->second;
+
+  {
+    tl::MutexLocker locker (&m_lock);
+    while (! block->done) {
+      m_block_done.wait (&m_lock);
+    }
+  }
+
+  if (block->ok && block->comp == comp && block->uncomp == uncomp) {
+    return block;
+  } else {
+    return 0;
+  }
+}
+
+void
+OASISCBlockPrefetcher::inflate (OASISCBlock *block)
+{
+  const size_t chunk = 16384;
+
+  std::string data;
+  bool ok = true;
+
+  try {
+
+    tl::InputMemoryStream ims (block->cdata, block->comp);
+    tl::InputStream is (ims);
+    tl::InflateFilter inflate (is);
+
+    data.reserve (block->uncomp);
+
+    for (size_t n = block->uncomp; n > 0 && ok; ) {
+      size_t nn = std::min (n, chunk);
+      const char *b = inflate.get (nn);
+      if (b) {
+        data.append (b, nn);
+        n -= nn;
+      } else {
+        ok = false;
+      }
+    }
+
+    //  the block must be consumed entirely - otherwise the reader needs to inflate it itself
+    ok = ok && inflate.at_end () && is.pos () == block->comp;
+
+  } catch (tl::Exception &) {
+    ok = false;
+  } catch (std::exception &) {
+    ok = false;
+  }
+
+  tl::MutexLocker locker (&m_lock);
+  block->data.swap (data);
+  block->ok = ok;
+  block->done = true;
+  m_block_done.wakeAll ();
+}
+
+bool
+OASISCBlockPrefetcher::read_uint (size_t &p, size_t &v) const
+{
+  v = 0;
+  unsigned int sh = 0;
+
+  while (p < m_length) {
+
+    if (sh >= sizeof (size_t) * 8) {
+      return false;
+    }
+
+    unsigned char c = (unsigned char) mp_data [p++];
+
+    v |= size_t (c & 0x7f) << sh;
+    sh += 7;
+
+    if ((c & 0x80) == 0) {
+      return true;
+    }
+
+  }
+
+  return false;
+}
+
+void
+OASISCBlockPrefetcher::scan_ahead ()
+{
+  while (m_scan_valid && m_scan_pos < m_length) {
+
+    if (! m_blocks.empty () && (m_blocks.size () >= max_cblocks_per_thread * m_threads || m_pending_bytes >= max_cblock_bytes_per_thread * m_threads)) {
+      break;
+    }
+
+    size_t p = m_scan_pos;
+    unsigned char r = (unsigned char) mp_data [p++];
+    size_t v = 0;
+
+    if (r == 0 /*PAD*/) {
+
+      m_scan_pos = p;
+
+    } else if (r == 13 /*CELL*/) {
+
+      m_scan_valid = read_uint (p, v);
+      m_scan_pos = p;
+
+    } else if (r == 14 /*CELL*/) {
+
+      m_scan_valid = read_uint (p, v) && v <= m_length - p;
+      m_scan_pos = p + v;
+
+    } else if (r == 34 /*CBLOCK*/) {
+
+      size_t type = 0, uncomp = 0, comp = 0;
+      m_scan_valid = read_uint (p, type) && type == 0 && read_uint (p, uncomp) && read_uint (p, comp) && comp <= m_length - p;
+      if (m_scan_valid) {
+        schedule (p, comp, uncomp);
+        m_scan_pos = p + comp;
+      }
+
+    } else {
+      m_scan_valid = false;
+    }
+
+  }
+}
+
+void
+OASISCBlockPrefetcher::schedule (size_t pos, size_t comp, size_t uncomp)
+{
+  if (m_blocks.find (pos) != m_blocks.end ()) {
+    return;
+  }
+
+  OASISCBlock *block = new OASISCBlock (mp_data + pos, comp, uncomp);
+  m_blocks.insert (std::make_pair (pos, block));
+  m_pending_bytes += uncomp;
+
+  if (! mp_job.get ()) {
+    mp_job.reset (new tl::Job<OASISCBlockWorker> (int (m_threads)));
+  }
+
+  mp_job->schedule (new OASISCBlockTask (this, block));
+  if (! mp_job->is_running ()) {
+    mp_job->start ();
+  }
+}
+
 // ---------------------------------------------------------------
 //  OASISReader
 
@@ -105,6 +415,7 @@ OASISReader::OASISReader (tl::InputStream &s)
     m_read_texts (true),
     m_read_properties (true),
     m_read_all_properties (false),
+    m_threads (0),
     m_s_gds_property_name_id (0),
     m_klayout_context_property_name_id (0)
 {
@@ -143,15 +454,25 @@ OASISReader::read (db::Layout &layout, const db::LoadLayoutOptions &options)
   m_create_layers = common_options.create_other_layers;
   m_read_all_properties = oasis_options.read_all_properties;
   m_expect_strict_mode = oasis_options.expect_strict_mode;
+  m_threads = oasis_options.threads;
 
   set_cell_conflict_resolution (common_options.cell_conflict_resolution);
 
+  //  CBLOCKs can be inflated ahead only if the whole file is available in memory
+  size_t length = 0;
+  const char *data = m_stream.direct_data (length);
+  if (m_threads > 0 && data) {
+    mp_cblock_prefetcher.reset (new OASISCBlockPrefetcher (data, length, m_threads));
+  }
+
   layout.start_changes ();
   try {
     do_read (layout);
+    mp_cblock_prefetcher.reset (0);
     finish (layout);
     layout.end_changes ();
   } catch (...) {
+    mp_cblock_prefetcher.reset (0);
     layout.end_changes ();
     throw;
   }
@@ -647,6 +968,31 @@ OASISReader::mark_start_table ()
   m_table_start = m_stream.pos ();
 }
 
+void
+OASISReader::read_cblock ()
+{
+  unsigned int type = get_uint ();
+  if (type != 0) {
+    error (tl::sprintf (tl::to_string (tr ("Invalid CBLOCK compression type %d")), type));
+  }
+
+  size_t uncomp = get_uint ();
+  size_t comp = get_uint ();
+
+  const OASISCBlock *block = 0;
+  if (mp_cblock_prefetcher.get ()) {
+    block = mp_cblock_prefetcher->take (m_stream.pos (), comp, uncomp);
+  }
+
+  if (block) {
+    //  deliver the data inflated by the workers
+    m_stream.inflated (block->data.c_str (), block->data.size (), block->comp);
+  } else {
+    //  put the stream into deflating mode
+    m_stream.inflate ();
+  }
+}
+
 void 
 OASISReader::read_offset_table ()
 {
@@ -1184,16 +1530,7 @@ OASISReader::do_read (db::Layout &layout)
 
     } else if (r == 34 /*CBLOCK*/) {
 
-      unsigned int type = get_uint ();
-      if (type != 0) {
-        error (tl::sprintf (tl::to_string (tr ("Invalid CBLOCK compression type %d")), type));
-      }
-
-      get_uint ();  // uncomp-byte-count - not needed
-      get_uint ();  // comp-byte-count - not needed
-
-      //  put the stream into deflating mode
-      m_stream.inflate ();
+      read_cblock ();
 
     } else {
       error (tl::sprintf (tl::to_string (tr ("Invalid record type on global level %d")), int (r)));
@@ -1382,16 +1719,7 @@ OASISReader::read_element_properties (db::PropertiesRepository &rep, bool ignore
      
     } else if (m == 34 /*CBLOCK*/) {
 
-      unsigned int type = get_uint ();
-      if (type != 0) {
-        error (tl::sprintf (tl::to_string (tr ("Invalid CBLOCK compression type %d")), type));
-      }
-
-      get_uint ();  // uncomp-byte-count - not needed
-      get_uint ();  // comp-byte-count - not needed
-
-      //  put the stream into deflating mode
-      m_stream.inflate ();
+      read_cblock ();
 
     } else if (m == 28 /*PROPERTY*/) {
 
@@ -3405,16 +3733,7 @@ OASISReader::do_read_cell (db::cell_index_type cell_index, db::Layout &layout)
 
     } else if (r == 34 /*CBLOCK*/) {
 
-      unsigned int type = get_uint ();
-      if (type != 0) {
-        error (tl::sprintf (tl::to_string (tr ("Invalid CBLOCK compression type %d")), type));
-      }
-
-      get_uint ();  // uncomp-byte-count - not needed
-      get_uint ();  // comp-byte-count - not needed
-
-      //  put the stream into deflating mode
-      m_stream.inflate ();
+      read_cblock ();
 
     } else {
       //  put the byte back into the stream
@@ -43,10 +43,13 @@
 
 #include <map>
 #include <set>
+#include <memory>
 
 namespace db
 {
 
+class OASISCBlockPrefetcher;
+
 /**
  *  @brief Generic base class of OASIS reader exceptions
  */
@@ -213,6 +216,8 @@ private:
   bool m_read_texts;
   bool m_read_properties;
   bool m_read_all_properties;
+  unsigned int m_threads;
+  std::auto_ptr<OASISCBlockPrefetcher> mp_cblock_prefetcher;
 
   std::map <unsigned long, db::property_names_id_type> m_propname_forward_references;
   std::map <unsigned long, std::string> m_propvalue_forward_references;
@@ -240,6 +245,8 @@ private:
 
   void mark_start_table ();
 
+  void read_cblock ();
+
   void read_offset_table ();
   bool read_repetition ();
   void read_pointlist (modal_variable <std::vector <db::Point> > &pointlist, bool for_polygon);
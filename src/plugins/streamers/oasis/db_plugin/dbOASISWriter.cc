@@ -26,8 +26,11 @@
 
 #include "tlDeflate.h"
 #include "tlMath.h"
+#include "tlThreadedWorkers.h"
 
 #include <math.h>
+#include <list>
+#include <memory>
 
 namespace db
 {
@@ -1596,89 +1599,33 @@ OASISWriter::write (db::Layout &layout, tl::OutputStream &stream, const db::Save
 
   }
 
-  std::vector <std::string> context_prop_strings;
+  if (m_options.threads > 0) {
 
-  for (std::vector<db::cell_index_type>::const_iterator cell = cells.begin (); cell != cells.end (); ++cell) {
+    write_cells_threaded (cells, cell_set, layers, options.write_context_info (), cell_positions);
 
-    m_progress.set (mp_stream->pos ());
-
-    //  cell body 
-    const db::Cell &cref (layout.cell (*cell));
-    mp_cell = &cref;
-
-    //  skip cell body if the cell is not to be written
-    if (skip_cell_body (cref)) {
-      continue;
-    }
-
-    //  cell header
-
-    cell_positions.insert (std::make_pair (*cell, mp_stream->pos ()));
-
-    write_record_id (13);  // CELL
-    write ((unsigned long) *cell);
-
-    reset_modal_variables ();
-
-    if (m_options.write_cblocks) {
-      begin_cblock ();
-    }
-
-    //  context information as property named KLAYOUT_CONTEXT
-    if (cref.is_proxy () && options.write_context_info ()) {
-
-      context_prop_strings.clear ();
-
-      if (layout.get_context_info (*cell, context_prop_strings)) {
-
-        write_record_id (28);
-        write_byte (char (0xf6));
-        std::map <std::string, unsigned long>::const_iterator pni = m_propnames.find (klayout_context_name);
-        tl_assert (pni != m_propnames.end ());
-        write (pni->second);
-
-        write ((unsigned long) context_prop_strings.size ());
+  } else {
 
-        for (std::vector <std::string>::const_iterator c = context_prop_strings.begin (); c != context_prop_strings.end (); ++c) {
-          write_byte (14); // b-string by reference number
-          std::map <std::string, unsigned long>::const_iterator psi = m_propstrings.find (*c);
-          tl_assert (psi != m_propstrings.end ());
-          write (psi->second);
-        }
+    for (std::vector<db::cell_index_type>::const_iterator cell = cells.begin (); cell != cells.end (); ++cell) {
 
-        mm_last_property_name = klayout_context_name;
-        mm_last_property_is_sprop = false;
-        mm_last_value_list.reset ();
+      m_progress.set (mp_stream->pos ());
 
+      //  skip cell body if the cell is not to be written
+      const db::Cell &cref (layout.cell (*cell));
+      if (skip_cell_body (cref)) {
+        continue;
       }
 
-    }
+      //  cell header
 
-    if (cref.prop_id () != 0) {
-      write_props (cref.prop_id ());
-    }
+      cell_positions.insert (std::make_pair (*cell, mp_stream->pos ()));
 
-    //  instances
-    if (cref.cell_instances () > 0) {
-      write_insts (cell_set);
-    }
+      write_record_id (13);  // CELL
+      write ((unsigned long) *cell);
 
-    //  shapes
-    for (std::vector <std::pair <unsigned int, db::LayerProperties> >::const_iterator l = layers.begin (); l != layers.end (); ++l) {
-      const db::Shapes &shapes = cref.shapes (l->first);
-      if (! shapes.empty ()) {
-        write_shapes (l->second, shapes);
-        m_progress.set (mp_stream->pos ());
-      }
-    }
+      write_cell_body (cref, cell_set, layers, options.write_context_info ());
 
-    //  end CBLOCK if required
-    if (m_options.write_cblocks) {
-      end_cblock ();
     }
 
-    //  end of cell
-
   }
 
   //  write cell table at the end in strict mode (in that mode we need the cell positions
@@ -1792,6 +1739,289 @@ OASISWriter::write (db::Layout &layout, tl::OutputStream &stream, const db::Save
   m_progress.set (mp_stream->pos ());
 }
 
+void
+OASISWriter::write_cell_body (const db::Cell &cref, const std::set <db::cell_index_type> &cell_set, const std::vector <std::pair <unsigned int, db::LayerProperties> > &layers, bool write_context_info)
+{
+  mp_cell = &cref;
+
+  reset_modal_variables ();
+
+  if (m_options.write_cblocks) {
+    begin_cblock ();
+  }
+
+  //  context information as property named KLAYOUT_CONTEXT
+  if (cref.is_proxy () && write_context_info) {
+
+    std::vector <std::string> context_prop_strings;
+    if (mp_layout->get_context_info (cref.cell_index (), context_prop_strings)) {
+
+      write_record_id (28);
+      write_byte (char (0xf6));
+      std::map <std::string, unsigned long>::const_iterator pni = m_propnames.find (klayout_context_name);
+      tl_assert (pni != m_propnames.end ());
+      write (pni->second);
+
+      write ((unsigned long) context_prop_strings.size ());
+
+      for (std::vector <std::string>::const_iterator c = context_prop_strings.begin (); c != context_prop_strings.end (); ++c) {
+        write_byte (14); // b-string by reference number
+        std::map <std::string, unsigned long>::const_iterator psi = m_propstrings.find (*c);
+        tl_assert (psi != m_propstrings.end ());
+        write (psi->second);
+      }
+
+      mm_last_property_name = klayout_context_name;
+      mm_last_property_is_sprop = false;
+      mm_last_value_list.reset ();
+
+    }
+
+  }
+
+  if (cref.prop_id () != 0) {
+    write_props (cref.prop_id ());
+  }
+
+  //  instances
+  if (cref.cell_instances () > 0) {
+    write_insts (cell_set);
+  }
+
+  //  shapes
+  for (std::vector <std::pair <unsigned int, db::LayerProperties> >::const_iterator l = layers.begin (); l != layers.end (); ++l) {
+    const db::Shapes &shapes = cref.shapes (l->first);
+    if (! shapes.empty ()) {
+      write_shapes (l->second, shapes);
+      m_progress.set (mp_stream->pos ());
+    }
+  }
+
+  //  end CBLOCK if required
+  if (m_options.write_cblocks) {
+    end_cblock ();
+  }
+}
+
+// ---------------------------------------------------------------------------------
+//  Multi-threaded production of cell bodies
+
+/**
+ *  @brief The maximum number of cell bodies pending per thread
+ */
+const size_t max_cell_bodies_per_thread = 16;
+
+/**
+ *  @brief A cell body produced by a worker
+ *
+ *  "data" receives the cell body as it would be written by the serial writer,
+ *  including the CBLOCKs. Serial bodies are written by the main thread instead.
+ */
+class OASISCellBody
+{
+public:
+  OASISCellBody (db::cell_index_type _cell_index, bool _serial)
+    : cell_index (_cell_index), serial (_serial), done (_serial)
+  {
+    //  .. nothing yet ..
+  }
+
+  void process (OASISWriter &writer, OASISWriter &parent, const std::set <db::cell_index_type> &cell_set, const std::vector <std::pair <unsigned int, db::LayerProperties> > &layers)
+  {
+    std::string err;
+
+    try {
+      tl::OutputStream os (data);
+      writer.mp_stream = &os;
+      writer.write_cell_body (writer.mp_layout->cell (cell_index), cell_set, layers, false);
+    } catch (tl::Exception &ex) {
+      err = ex.msg ();
+    } catch (std::exception &ex) {
+      err = ex.what ();
+    }
+
+    writer.mp_stream = 0;
+
+    tl::MutexLocker locker (&parent.m_cell_body_lock);
+    error = err;
+    done = true;
+    parent.m_cell_body_done.wakeAll ();
+  }
+
+  db::cell_index_type cell_index;
+  bool serial;
+  tl::OutputMemoryStream data;
+  std::string error;
+  bool done;
+};
+
+/**
+ *  @brief The task object for producing a cell body
+ */
+class OASISCellBodyTask
+  : public tl::Task
+{
+public:
+  OASISCellBodyTask (OASISWriter *parent, OASISCellBody *body, const std::set <db::cell_index_type> *cell_set, const std::vector <std::pair <unsigned int, db::LayerProperties> > *layers)
+    : mp_parent (parent), mp_body (body), mp_cell_set (cell_set), mp_layers (layers)
+  {
+    //  .. nothing yet ..
+  }
+
+  const OASISWriter &parent () const
+  {
+    return *mp_parent;
+  }
+
+  void perform (OASISWriter &writer)
+  {
+    mp_body->process (writer, *mp_parent, *mp_cell_set, *mp_layers);
+  }
+
+private:
+  OASISWriter *mp_parent;
+  OASISCellBody *mp_body;
+  const std::set <db::cell_index_type> *mp_cell_set;
+  const std::vector <std::pair <unsigned int, db::LayerProperties> > *mp_layers;
+};
+
+/**
+ *  @brief The worker producing the cell bodies
+ *
+ *  Each worker employs a writer of its own which is initialized from the
+ *  main writer on the first task.
+ */
+class OASISCellBodyWorker
+  : public tl::Worker
+{
+public:
+  OASISCellBodyWorker ()
+    : tl::Worker ()
+  {
+    //  .. nothing yet ..
+  }
+
+  void perform_task (tl::Task *task)
+  {
+    OASISCellBodyTask *cell_body_task = static_cast<OASISCellBodyTask *> (task);
+
+    //  NOTE: the writer is created inside the worker thread, so its progress is not reported
+    if (! mp_writer.get ()) {
+      mp_writer.reset (new OASISWriter ());
+      mp_writer->init_cell_body_writer (cell_body_task->parent ());
+    }
+
+    cell_body_task->perform (*mp_writer);
+  }
+
+private:
+  std::auto_ptr<OASISWriter> mp_writer;
+};
+
+void
+OASISWriter::init_cell_body_writer (const OASISWriter &parent)
+{
+  m_sf = parent.m_sf;
+  mp_layout = parent.mp_layout;
+  m_options = parent.m_options;
+  m_textstrings = parent.m_textstrings;
+  m_propnames = parent.m_propnames;
+  m_propstrings = parent.m_propstrings;
+  m_propname_id = parent.m_propname_id;
+  m_propstring_id = parent.m_propstring_id;
+  m_proptables_written = parent.m_proptables_written;
+}
+
+void
+OASISWriter::write_cells_threaded (const std::vector <db::cell_index_type> &cells, const std::set <db::cell_index_type> &cell_set, const std::vector <std::pair <unsigned int, db::LayerProperties> > &layers, bool write_context_info, std::map <db::cell_index_type, size_t> &cell_positions)
+{
+  //  the workers must not trigger lazy updates of the layout
+  mp_layout->update ();
+
+  tl::Job<OASISCellBodyWorker> job (int (m_options.threads));
+  std::list<OASISCellBody *> bodies;
+
+  try {
+
+    std::vector<db::cell_index_type>::const_iterator cell = cells.begin ();
+
+    while (cell != cells.end () || ! bodies.empty ()) {
+
+      if (cell != cells.end () && bodies.size () < max_cell_bodies_per_thread * m_options.threads) {
+
+        const db::Cell &cref (mp_layout->cell (*cell));
+
+        //  skip cell body if the cell is not to be written
+        if (! skip_cell_body (cref)) {
+
+          //  cells with context information are written by the main thread
+          bool serial = cref.is_proxy () && write_context_info;
+
+          OASISCellBody *body = new OASISCellBody (*cell, serial);
+          bodies.push_back (body);
+
+          if (! serial) {
+            job.schedule (new OASISCellBodyTask (this, body, &cell_set, &layers));
+            if (! job.is_running ()) {
+              job.start ();
+            }
+          }
+
+        }
+
+        ++cell;
+        continue;
+
+      }
+
+      //  write the next cell body in the original order
+
+      OASISCellBody *body = bodies.front ();
+
+      {
+        tl::MutexLocker locker (&m_cell_body_lock);
+        while (! body->done) {
+          m_cell_body_done.wait (&m_cell_body_lock);
+        }
+      }
+
+      bodies.pop_front ();
+      std::auto_ptr<OASISCellBody> body_holder (body);
+
+      if (! body->error.empty ()) {
+        throw tl::Exception (body->error);
+      }
+
+      m_progress.set (mp_stream->pos ());
+
+      //  cell header
+
+      cell_positions.insert (std::make_pair (body->cell_index, mp_stream->pos ()));
+
+      write_record_id (13);  // CELL
+      write ((unsigned long) body->cell_index);
+
+      if (body->serial) {
+        write_cell_body (mp_layout->cell (body->cell_index), cell_set, layers, write_context_info);
+      } else if (body->data.size () > 0) {
+        write_bytes (body->data.data (), body->data.size ());
+      }
+
+    }
+
+  } catch (...) {
+
+    job.terminate ();
+
+    for (std::list<OASISCellBody *>::const_iterator b = bodies.begin (); b != bodies.end (); ++b) {
+      delete *b;
+    }
+
+    throw;
+
+  }
+}
+
 void 
 OASISWriter::write (const Repetition &rep)
 {
@@ -33,6 +33,7 @@
 #include "dbHash.h"
 #include "tlProgress.h"
 #include "tlStream.h"
+#include "tlThreads.h"
 
 #include <string>
 
@@ -197,6 +198,9 @@ public:
   void write (const db::Polygon &polygon, db::properties_id_type prop_id, const db::Repetition &rep);
 
 private:
+  friend class OASISCellBody;
+  friend class OASISCellBodyWorker;
+
   tl::OutputStream *mp_stream;
   double m_sf;
   const db::Layout *mp_layout;
@@ -246,6 +250,9 @@ private:
   OASISWriterOptions m_options;
   tl::AbsoluteProgress m_progress;
 
+  tl::Mutex m_cell_body_lock;
+  tl::WaitCondition m_cell_body_done;
+
   void write_record_id (char b);
   void write_byte (char b);
   void write_bytes (const char *b, size_t n);
@@ -300,6 +307,10 @@ private:
   void emit_propstring_def (db::properties_id_type prop_id);
   void write_insts (const std::set <db::cell_index_type> &cell_set);
 
+  void write_cell_body (const db::Cell &cref, const std::set <db::cell_index_type> &cell_set, const std::vector <std::pair <unsigned int, db::LayerProperties> > &layers, bool write_context_info);
+  void write_cells_threaded (const std::vector <db::cell_index_type> &cells, const std::set <db::cell_index_type> &cell_set, const std::vector <std::pair <unsigned int, db::LayerProperties> > &layers, bool write_context_info, std::map <db::cell_index_type, size_t> &cell_positions);
+  void init_cell_body_writer (const OASISWriter &parent);
+
   void write_shapes (const db::LayerProperties &lprops, const db::Shapes &shapes);
 
   void write_props (db::properties_id_type prop_id);
@@ -53,6 +53,16 @@ static int get_oasis_expect_strict_mode (const db::LoadLayoutOptions *options)
   return options->get_options<db::OASISReaderOptions> ().expect_strict_mode;
 }
 
+static void set_oasis_threads (db::LoadLayoutOptions *options, unsigned int n)
+{
+  options->get_options<db::OASISReaderOptions> ().threads = n;
+}
+
+static unsigned int get_oasis_threads (const db::LoadLayoutOptions *options)
+{
+  return options->get_options<db::OASISReaderOptions> ().threads;
+}
+
 //  extend lay::LoadLayoutOptions with the OASIS options
 static
 gsi::ClassExt<db::LoadLayoutOptions> oasis_reader_options (
@@ -71,6 +81,19 @@ gsi::ClassExt<db::LoadLayoutOptions> oasis_reader_options (
   gsi::method_ext ("oasis_expect_strict_mode?", &get_oasis_expect_strict_mode,
     //  this method is mainly provided as access point for the generic interface
     "@hide"
+  ) +
+  gsi::method_ext ("oasis_threads=", &set_oasis_threads, gsi::arg ("n"),
+    "@brief Sets the number of threads to use for inflating compressed blocks of OASIS files\n"
+    "\n"
+    "If this property is non-zero, the reader will inflate the CBLOCK records ahead in the given number "
+    "of worker threads while decoding the uncompressed data. This is effective for uncompressed local files "
+    "only. The default is 0 which means the compressed blocks are inflated by the reader itself.\n"
+    "\nThis property has been added in version 0.27.\n"
+  ) +
+  gsi::method_ext ("oasis_threads", &get_oasis_threads,
+    "@brief Gets the number of threads to use for inflating compressed blocks of OASIS files\n"
+    "See \\oasis_threads= method for a description of this property."
+    "\nThis property has been added in version 0.27.\n"
   ),
   ""
 );
@@ -178,6 +201,16 @@ static std::string get_oasis_subst_char (const db::SaveLayoutOptions *options)
   return options->get_options<db::OASISWriterOptions> ().subst_char;
 }
 
+static void set_oasis_write_threads (db::SaveLayoutOptions *options, unsigned int n)
+{
+  options->get_options<db::OASISWriterOptions> ().threads = n;
+}
+
+static unsigned int get_oasis_write_threads (const db::SaveLayoutOptions *options)
+{
+  return options->get_options<db::OASISWriterOptions> ().threads;
+}
+
 //  extend lay::SaveLayoutOptions with the OASIS options
 static
 gsi::ClassExt<db::SaveLayoutOptions> oasis_writer_options (
@@ -288,6 +321,20 @@ gsi::ClassExt<db::SaveLayoutOptions> oasis_writer_options (
   gsi::method_ext ("oasis_compression_level", &get_oasis_compression,
     "@brief Get the OASIS compression level\n"
     "See \\oasis_compression_level= method for a description of the OASIS compression level."
+  ) +
+  gsi::method_ext ("oasis_threads=", &set_oasis_write_threads, gsi::arg ("n"),
+    "@brief Sets the number of threads to use for writing OASIS files\n"
+    "If this value is non-zero, the cell bodies are produced and CBLOCK-compressed in the given number of "
+    "worker threads. The file written is the same as the one produced by the serial writer. "
+    "The default is 0 which means the cells are written serially.\n"
+    "\n"
+    "This method has been introduced in version 0.27."
+  ) +
+  gsi::method_ext ("oasis_threads", &get_oasis_write_threads,
+    "@brief Gets the number of threads to use for writing OASIS files\n"
+    "See \\oasis_threads= method for a description of this property."
+    "\n"
+    "This method has been introduced in version 0.27."
   ),
   ""
 );
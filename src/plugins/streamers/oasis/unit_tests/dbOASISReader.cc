@@ -22,6 +22,7 @@
 
 
 #include "dbOASISReader.h"
+#include "dbOASISWriter.h"
 #include "dbTextWriter.h"
 #include "dbTestSupport.h"
 #include "tlLog.h"
@@ -79,7 +80,7 @@ compare_ref (tl::TestBase *_this, const char *test, const db::Layout &layout)
 }
 
 void
-run_test (tl::TestBase *_this, const char *test)
+run_test (tl::TestBase *_this, const char *test, unsigned int threads = 0)
 {
   db::Manager m (false);
   db::Layout layout (&m);
@@ -91,9 +92,14 @@ run_test (tl::TestBase *_this, const char *test)
   db::Reader reader (stream);
   reader.set_warnings_as_errors (true);
 
+  db::LoadLayoutOptions options;
+  db::OASISReaderOptions oasis_options;
+  oasis_options.threads = threads;
+  options.set_options (oasis_options);
+
   bool error = false;
   try {
-    reader.read (layout);
+    reader.read (layout, options);
   } catch (tl::Exception &ex) {
     tl::error << ex.msg ();
     error = true;
@@ -409,6 +415,70 @@ TEST(9_2)
   run_test (_this, "9.2");
 }
 
+//  CBLOCKs inflated by worker threads
+TEST(14_1_MultiThreaded)
+{
+  run_test (_this, "14.1", 4);
+}
+
+TEST(14_2_MultiThreaded)
+{
+  db::Manager m (false);
+  db::Layout layout_org (&m);
+
+  unsigned int l1 = layout_org.insert_layer (db::LayerProperties (1, 0));
+  unsigned int l2 = layout_org.insert_layer (db::LayerProperties (2, 0));
+
+  db::Cell &top = layout_org.cell (layout_org.add_cell ("TOP"));
+  for (int i = 0; i < 50; ++i) {
+    db::Cell &c = layout_org.cell (layout_org.add_cell (("C" + tl::to_string (i)).c_str ()));
+    for (int j = 0; j < 200 * (i % 5 + 1); ++j) {
+      c.shapes (l1).insert (db::Box (j * 10, i, j * 10 + 5, i + 1000 + j));
+      c.shapes (l2).insert (db::Polygon (db::Box (i, j * 7, i + 500 + j, j * 7 + 3)));
+    }
+    top.insert (db::CellInstArray (db::CellInst (c.cell_index ()), db::Trans (db::Vector (i * 20000, 0))));
+  }
+
+  std::string tmp_file = _this->tmp_file ("tmp_14_2.oas");
+
+  {
+    tl::OutputStream stream (tmp_file);
+    db::OASISWriter writer;
+    db::SaveLayoutOptions options;
+    db::OASISWriterOptions oasis_options;
+    oasis_options.write_cblocks = true;
+    options.set_options (oasis_options);
+    writer.write (layout_org, stream, options);
+  }
+
+  std::string text[2];
+
+  for (unsigned int threads = 0; threads < 2; ++threads) {
+
+    db::Layout layout (&m);
+
+    tl::InputStream stream (tmp_file);
+    db::Reader reader (stream);
+    reader.set_warnings_as_errors (true);
+
+    db::LoadLayoutOptions options;
+    db::OASISReaderOptions oasis_options;
+    oasis_options.threads = threads * 3;
+    options.set_options (oasis_options);
+    reader.read (layout, options);
+
+    tl::OutputStringStream os;
+    tl::OutputStream ostream (os);
+    db::TextWriter writer (ostream);
+    writer.write (layout);
+    text [threads] = os.string ();
+
+  }
+
+  EXPECT_EQ (text [0].empty (), false);
+  EXPECT_EQ (text [1] == text [0], true);
+}
+
 //  Tests add-on reading 
 TEST(99)
 {
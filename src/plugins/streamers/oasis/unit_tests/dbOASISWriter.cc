@@ -1805,3 +1805,84 @@ TEST(119_WithAndWithoutContext)
   }
 
 }
+
+static std::string write_to_string (tl::TestBase *_this, db::Layout &layout, const db::OASISWriterOptions &oasis_options, const char *name)
+{
+  std::string tmp_file = _this->tmp_file (name);
+
+  {
+    tl::OutputStream stream (tmp_file);
+    db::OASISWriter writer;
+    db::SaveLayoutOptions options;
+    options.set_options (oasis_options);
+    writer.write (layout, stream, options);
+  }
+
+  tl::InputStream stream (tmp_file);
+  return stream.read_all ();
+}
+
+//  Multi-threaded writer
+TEST(120_MultiThreaded)
+{
+  db::Layout layout;
+
+  unsigned int l1 = layout.insert_layer (db::LayerProperties (1, 0));
+  unsigned int l2 = layout.insert_layer (db::LayerProperties (2, 0));
+
+  db::PropertiesRepository::properties_set ps;
+  ps.insert (std::make_pair (layout.properties_repository ().prop_name_id (tl::Variant ("name")), tl::Variant ("value")));
+  db::properties_id_type pid = layout.properties_repository ().properties_id (ps);
+
+  db::Cell &top = layout.cell (layout.add_cell ("TOP"));
+
+  for (int i = 0; i < 40; ++i) {
+
+    db::Cell &c = layout.cell (layout.add_cell (("C" + tl::to_string (i)).c_str ()));
+
+    for (int j = 0; j < 100 * (i % 4 + 1); ++j) {
+      c.shapes (l1).insert (db::Box (j * 10, i, j * 10 + 5, i + 1000 + (j * 17) % 31));
+      c.shapes (l2).insert (db::PolygonWithProperties (db::Polygon (db::Box (i, j * 7, i + 500 + j, j * 7 + 3)), pid));
+    }
+    c.shapes (l1).insert (db::Text ("T" + tl::to_string (i), db::Trans (db::Vector (i, -i))));
+
+    top.insert (db::CellInstArray (db::CellInst (c.cell_index ()), db::Trans (db::Vector (i * 20000, 0))));
+
+  }
+
+  //  a big cell which needs more than one CBLOCK
+  db::Cell &big = layout.cell (layout.add_cell ("BIG"));
+  for (int j = 0; j < 100000; ++j) {
+    big.shapes (l1).insert (db::Box (j * 10, (j * 7919) % 1000, j * 10 + 5 + j % 3, (j * 7919) % 1000 + 20 + j % 7));
+  }
+  top.insert (db::CellInstArray (db::CellInst (big.cell_index ()), db::Trans ()));
+
+  db::OASISWriterOptions oasis_options;
+  oasis_options.write_cblocks = true;
+  oasis_options.strict_mode = true;
+
+  std::string serial = write_to_string (_this, layout, oasis_options, "tmp_120_serial.oas");
+
+  oasis_options.threads = 3;
+  std::string threaded = write_to_string (_this, layout, oasis_options, "tmp_120_threaded.oas");
+
+  EXPECT_EQ (serial.size () > 0, true);
+  EXPECT_EQ (threaded.size (), serial.size ());
+  EXPECT_EQ (threaded == serial, true);
+
+  //  the file can be read again
+  db::Layout layout2;
+  {
+    tl::InputStream stream (_this->tmp_file ("tmp_120_threaded.oas"));
+    db::Reader reader (stream);
+    reader.set_warnings_as_errors (true);
+    db::LoadLayoutOptions options;
+    db::OASISReaderOptions oasis_reader_options;
+    oasis_reader_options.expect_strict_mode = 1;
+    options.set_options (oasis_reader_options);
+    reader.read (layout2, options);
+  }
+
+  bool equal = db::compare_layouts (layout, layout2, db::layout_diff::f_verbose, 0);
+  EXPECT_EQ (equal, true);
+}
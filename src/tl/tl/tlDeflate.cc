@@ -26,52 +26,95 @@
 #include "tlAssert.h"
 
 #include <algorithm>
+#include <string.h>
 
 #include <zlib.h>
 
 namespace tl
 {
 
+// ------------------------------------------------------------------------
+//  BitStream implementation
+
+void
+BitStream::fill ()
+{
+  //  advance the stream over the bytes fully consumed
+  unsigned int consumed = m_bytes - (m_nbits + 7) / 8;
+  if (consumed > 0) {
+    mp_input->get (consumed, true /*bypass_deflate*/);
+    m_bytes -= consumed;
+  }
+
+  //  peek as many further bytes as fit into the bit buffer
+  for (unsigned int n = (64 - m_nbits) / 8; n > 0; --n) {
+    const unsigned char *c = (const unsigned char *) mp_input->get (m_bytes + n, true /*bypass_deflate*/);
+    if (c) {
+      mp_input->unget (m_bytes + n, true /*bypass_deflate*/);
+      for (const unsigned char *cc = c + m_bytes; cc != c + m_bytes + n; ++cc) {
+        m_bits |= uint64_t (*cc) << m_nbits;
+        m_nbits += 8;
+      }
+      m_bytes += n;
+      break;
+    }
+  }
+}
+
+void
+BitStream::finish ()
+{
+  //  the partial byte at the end of the data is consumed, the remaining bytes are not
+  unsigned int consumed = m_bytes - m_nbits / 8;
+  if (consumed > 0) {
+    mp_input->get (consumed, true /*bypass_deflate*/);
+  }
+
+  m_bits = 0;
+  m_nbits = 0;
+  m_bytes = 0;
+}
+
 // ------------------------------------------------------------------------
 //  The Huffmann decoder core
 
 /**
  *  @brief The decoder for Huffmann codes
  *
- *  The decoder keeps a Huffmann code tree and decodes a value from a bit stream
- *  using this tree. 
- *  As specified by RFC1951, the code tree is constructed from a list of code lengths
+ *  The decoder decodes a value from a bit stream using a lookup table which
+ *  is indexed with the next bits of the stream. Codes longer than the table
+ *  index are decoded with the canonical code tables.
+ *  For literals, the table entries may hold two symbols, so two literals can be
+ *  decoded with a single lookup.
+ *  As specified by RFC1951, the codes are constructed from a list of code lengths
  *  vs. value alone.
  */
 class HuffmannDecoder
 {
 public:
   /**
-   *  @brief Constructor
-   *  
-   *  Creates an empty code tree.
+   *  @brief The number of bits used for the lookup table index
    */
-  HuffmannDecoder ()
-  {
-    mp_codes = 0;
-    mp_bitmasks = 0;
-    m_max_bits = 0;
-    m_num_codes = 0;
-  }
+  static const unsigned int table_bits = 10;
+
+  /**
+   *  @brief The maximum number of bits for a code
+   */
+  static const unsigned int max_bits = 15;
 
   /**
-   *  @brief Destructor
+   *  @brief Constructor
+   *  
+   *  Creates an empty decoder.
    */
-  ~HuffmannDecoder ()
+  HuffmannDecoder ()
   {
-    if (mp_codes) {
-      delete [] mp_codes;
+    for (unsigned int i = 0; i < sizeof (m_table) / sizeof (m_table [0]); ++i) {
+      m_table [i] = 0;
     }
-    mp_codes = 0;
-    if (mp_bitmasks) {
-      delete [] mp_bitmasks;
+    for (unsigned int i = 0; i <= max_bits; ++i) {
+      m_count [i] = 0;
     }
-    mp_bitmasks = 0;
   }
 
   /**
@@ -82,8 +125,6 @@ public:
    */
   void fill_fixed_table_length ()
   {
-    reserve (9);
-
     unsigned short lengths [288];
     for (unsigned int i = 0; i < 144; ++i) {
       lengths[i] = 8;
@@ -109,8 +150,6 @@ public:
    */
   void fill_fixed_table_dist ()
   {
-    reserve (5);
-
     unsigned short lengths [32];
     for (unsigned int i = 0; i < 32; ++i) {
       lengths[i] = 5;
@@ -119,9 +158,9 @@ public:
   }
 
   /**
-   *  @brief Initialize the code tree from a list of lengths
+   *  @brief Initialize the decoder from a list of lengths
    *
-   *  This method initializes the code tree from a list of lengths, given 
+   *  This method initializes the decoder from a list of lengths, given 
    *  by the sequence [begin_lengths, end_lengths). The codes are assumed to 
    *  range from 0 to distance(begin_lengths, end_lengths).
    *  See RFC1951 for a description about the procedure.
@@ -129,46 +168,80 @@ public:
   template <class Iter>
   void init_codes (Iter begin_lengths, Iter end_lengths)
   {
-    const unsigned int MAX_BITS = 16;
-    unsigned short bl_count[MAX_BITS + 1];
-    unsigned short bitmasks[MAX_BITS + 1];
-    unsigned short next_code[MAX_BITS + 1];
-    unsigned int max_bits = 0;
-
-    for (unsigned int bits = 0; bits <= MAX_BITS; bits++) {
-      bl_count[bits] = 0;
+    unsigned short offsets [max_bits + 1];
+    unsigned short next_code [max_bits + 1];
+
+    for (unsigned int bits = 0; bits <= max_bits; bits++) {
+      m_count [bits] = 0;
     }
 
-    for (Iter l = begin_lengths; l != end_lengths; ++l) {
-      tl_assert (*l < MAX_BITS);
+    unsigned int n = 0;
+    for (Iter l = begin_lengths; l != end_lengths; ++l, ++n) {
+      tl_assert (*l <= max_bits);
       if (*l > 0) {
-        ++bl_count [*l];
+        ++m_count [*l];
       }
     }
+    tl_assert (n <= sizeof (m_symbols) / sizeof (m_symbols [0]));
 
+    //  the symbols in the order of their codes - used for the canonical decoding
     unsigned int code = 0;
-    for (unsigned int bits = 1; bits <= MAX_BITS; bits++) {
-      if (bl_count[bits - 1] > 0) {
-        max_bits = bits - 1;
+    offsets [1] = 0;
+    for (unsigned int bits = 1; bits <= max_bits; bits++) {
+      code = (code + m_count [bits - 1]) << 1;
+      next_code [bits] = code;
+      if (bits < max_bits) {
+        offsets [bits + 1] = offsets [bits] + m_count [bits];
       }
-      code = (code + bl_count[bits - 1]) << 1;
-      next_code[bits] = code;
     }
 
-    for (unsigned int bits = 0; bits <= max_bits; bits++) {
-      bitmasks [bits] = ((1 << bits) - 1) << (max_bits - bits);
+    for (unsigned int i = 0; i < sizeof (m_table) / sizeof (m_table [0]); ++i) {
+      m_table [i] = 0;
     }
 
-    reserve (max_bits);
-
     unsigned short symbol = 0;
     for (Iter l = begin_lengths; l != end_lengths; ++l, ++symbol) {
-      if (*l > 0) {
-        unsigned int code = next_code [*l]++;
-        code <<= (max_bits - *l);
-        mp_codes [code] = symbol;
-        mp_bitmasks [code] = bitmasks [*l];
-      } 
+
+      unsigned int bits = *l;
+      if (bits == 0) {
+        continue;
+      }
+
+      m_symbols [offsets [bits]++] = symbol;
+
+      unsigned int code = next_code [bits]++;
+      if (bits <= table_bits) {
+
+        //  the codes are stored most significant bit first, but the bit stream
+        //  delivers the least significant bit first: reverse the code for the table index
+        unsigned int rcode = 0;
+        for (unsigned int b = 0; b < bits; ++b) {
+          rcode = (rcode << 1) | ((code >> b) & 1);
+        }
+
+        uint32_t entry = make_entry (symbol, bits);
+        for (unsigned int i = rcode; i < (1u << table_bits); i += (1u << bits)) {
+          m_table [i] = entry;
+        }
+
+      }
+
+    }
+
+    //  combine pairs of literals which fit into the table index into one entry
+    if (n > 256) {
+      //  NOTE: going backwards, the second symbol is always taken from an entry not combined yet
+      for (unsigned int i = (1u << table_bits); i-- > 0; ) {
+        uint32_t e1 = m_table [i];
+        unsigned int l1 = entry_length (e1);
+        if (l1 > 0 && l1 < table_bits && entry_symbol (e1) < 256) {
+          uint32_t e2 = m_table [i >> l1];
+          unsigned int l2 = entry_length (e2);
+          if (l2 > 0 && l1 + l2 <= table_bits && entry_symbol (e2) < 256) {
+            m_table [i] = e1 + (l2 | (entry_symbol (e2) << 24) | (1u << 4));
+          }
+        }
+      }
     }
   }
 
@@ -176,43 +249,90 @@ public:
    *  @brief Decode the next value from a bit stream
    *
    *  This method takes the next value from the bit stream decoding the bits with
-   *  the code tree currently loaded.
+   *  the code currently loaded.
    */
   unsigned short decode (BitStream &s) const
   {
-    tl_assert (mp_codes != 0);
-
-    unsigned int m = m_num_codes / 2;
-    
-    unsigned int c = 0;
-    do {
-      if (s.get_bit ()) {
-        c |= m;
-      }
-      m >>= 1;
-    } while ((mp_bitmasks [c] & m) != 0);
+    s.ensure (max_bits);
+
+    uint32_t e = m_table [s.peek_bits (table_bits)];
+    if (entry_length (e) > 0 && (e & (1u << 4)) == 0) {
+      s.skip_bits (entry_length (e));
+      return entry_symbol (e);
+    } else {
+      return decode_slow (s);
+    }
+  }
 
-    return mp_codes [c];
+  /**
+   *  @brief Decode the next value or a pair of literals from a bit stream
+   *
+   *  If the next codes are two literals, both are delivered in "symbols" and 2 is returned.
+   *  Otherwise, a single symbol is delivered in "symbols [0]" and 1 is returned.
+   */
+  unsigned int decode_multi (BitStream &s, unsigned short *symbols) const
+  {
+    s.ensure (max_bits);
+
+    uint32_t e = m_table [s.peek_bits (table_bits)];
+    if (entry_length (e) > 0) {
+      s.skip_bits (entry_length (e));
+      symbols [0] = entry_symbol (e);
+      if ((e & (1u << 4)) != 0) {
+        symbols [1] = (unsigned short) (e >> 24);
+        return 2;
+      } else {
+        return 1;
+      }
+    } else {
+      symbols [0] = decode_slow (s);
+      return 1;
+    }
   }
 
 private:
-  unsigned short *mp_codes, *mp_bitmasks;
-  unsigned int m_num_codes, m_max_bits;
+  //  Table entries: bit 0..3: code length (0 for "not in table"), bit 4: two symbols,
+  //  bit 5..14: first symbol, bit 24..31: second symbol (a literal).
+  //  For two symbols, the code length is the total length of both codes.
+  uint32_t m_table [1 << table_bits];
+  unsigned short m_count [max_bits + 1];
+  unsigned short m_symbols [288];
+
+  static uint32_t make_entry (unsigned int symbol, unsigned int bits)
+  {
+    return uint32_t (bits) | (uint32_t (symbol) << 5);
+  }
 
-  void reserve (unsigned int max_bits)
+  static unsigned int entry_length (uint32_t e)
   {
-    m_num_codes = 1 << max_bits;
-    if (max_bits > m_max_bits) {
-      m_max_bits = max_bits;
-      if (mp_codes) {
-        delete [] mp_codes;
-      }
-      mp_codes = new unsigned short [m_num_codes];
-      if (mp_bitmasks) {
-        delete [] mp_bitmasks;
+    return e & 0xf;
+  }
+
+  static unsigned short entry_symbol (uint32_t e)
+  {
+    return (unsigned short) ((e >> 5) & 0x3ff);
+  }
+
+  unsigned short decode_slow (BitStream &s) const
+  {
+    //  canonical decoding, bit by bit (from RFC1951 and zlib's "puff")
+    unsigned int bits = s.peek_bits (max_bits);
+    int code = 0, first = 0, index = 0;
+    for (unsigned int len = 1; len <= max_bits; ++len) {
+      code |= (bits & 1);
+      bits >>= 1;
+      int count = m_count [len];
+      if (code - count < first) {
+        s.skip_bits (len);
+        return m_symbols [index + (code - first)];
       }
-      mp_bitmasks = new unsigned short [m_num_codes];
+      index += count;
+      first += count;
+      first <<= 1;
+      code <<= 1;
     }
+
+    throw tl::Exception (tl::to_string (tr ("Invalid Huffmann code (DEFLATE implementation)")));
   }
 };
 
@@ -247,7 +367,7 @@ InflateFilter::get (size_t n)
 {
   tl_assert (n < sizeof (m_buffer) / 2);
 
-  while ((m_b_insert + sizeof (m_buffer) - m_b_read) % sizeof (m_buffer) < n) {
+  while (available () < n) {
     if (! process ()) {
       throw tl::Exception (tl::to_string (tr ("Unexpected end of file (DEFLATE implementation)")));
     }
@@ -285,110 +405,126 @@ InflateFilter::at_end ()
   return m_at_end;
 }
 
-void 
+unsigned int
+InflateFilter::available () const
+{
+  return (m_b_insert - m_b_read) & buffer_mask;
+}
+
+inline void 
 InflateFilter::put_byte (char b) 
 {
   m_buffer [m_b_insert] = b;
-  m_b_insert = (m_b_insert + 1) % sizeof (m_buffer);
+  m_b_insert = (m_b_insert + 1) & buffer_mask;
 }
 
-void 
-InflateFilter::put_byte_dist (unsigned int d) 
+inline void
+InflateFilter::copy_dist (unsigned int d, unsigned int length)
 {
-  put_byte (m_buffer [(m_b_insert - d) % sizeof (m_buffer)]);
+  unsigned int from = (m_b_insert - d) & buffer_mask;
+  if (from + length <= sizeof (m_buffer) && m_b_insert + length <= sizeof (m_buffer) && (d >= length || d >= 8)) {
+
+    //  fast path: no wrap around - copy in chunks of d bytes (these do not overlap)
+    char *t = m_buffer + m_b_insert;
+    const char *f = m_buffer + from;
+    m_b_insert = (m_b_insert + length) & buffer_mask;
+    while (length >= d) {
+      memcpy (t, f, d);
+      t += d;
+      length -= d;
+    }
+    memcpy (t, f, length);
+
+  } else {
+    while (length-- > 0) {
+      put_byte (m_buffer [(m_b_insert - d) & buffer_mask]);
+    }
+  }
 }
 
 bool 
 InflateFilter::process ()
 {
-  while (true) {
+  //  decode a chunk of data, leaving enough room for a full get in the buffer
+  const unsigned int chunk = sizeof (m_buffer) / 4;
 
-    bool new_block = false;
+  unsigned int produced = 0;
 
-    if (m_uncompressed_length == 0) {
+  while (produced < chunk) {
 
-      m_uncompressed_length = -1;
-      new_block = true;
-
-    } else if (m_uncompressed_length > 0) {
+    if (m_uncompressed_length > 0) {
 
       put_byte (m_input.get_byte ());
       --m_uncompressed_length;
+      ++produced;
 
-    } else {
+    } else if (m_uncompressed_length < 0) {
 
-      unsigned int l = mp_lit_decoder->decode (m_input);
-      if (l < 256) {
+      unsigned short s [2];
+      if (mp_lit_decoder->decode_multi (m_input, s) == 2) {
 
-        put_byte (char (l));
+        put_byte (char (s [0]));
+        put_byte (char (s [1]));
+        produced += 2;
 
-      } else if (l == 256) {
+      } else {
 
-        new_block = true;
+        unsigned int l = s [0];
+        if (l < 256) {
 
-      } else {
+          put_byte (char (l));
+          ++produced;
 
-        unsigned int length = 0;
-        if (l < 265) {
-          length = l - 254;
-        } else if (l < 269) {
-          length = (l - 265) * 2 + 11 + m_input.get_bits (1);
-        } else if (l < 273) {
-          length = (l - 269) * 4 + 19 + m_input.get_bits (2);
-        } else if (l < 277) {
-          length = (l - 273) * 8 + 35 + m_input.get_bits (3);
-        } else if (l < 281) {
-          length = (l - 277) * 16 + 67 + m_input.get_bits (4);
-        } else if (l < 285) {
-          length = (l - 281) * 32 + 131 + m_input.get_bits (5);
-        } else {
-          length = 258;
-        }
+        } else if (l == 256) {
+
+          //  end of block
+          m_uncompressed_length = 0;
+
+        } else if (l > 285) {
+
+          throw tl::Exception (tl::to_string (tr ("Invalid length code: %d (DEFLATE implementation)")), l);
 
-        unsigned int d = mp_dist_decoder->decode (m_input);
-        unsigned int dist = 0;
-        if (d < 4) {
-          dist = d + 1;
-        } else if (d < 6) {
-          dist = (d - 4) * 2 + 5 + m_input.get_bits (1);
-        } else if (d < 8) {
-          dist = (d - 6) * 4 + 9 + m_input.get_bits (2);
-        } else if (d < 10) {
-          dist = (d - 8) * 8 + 17 + m_input.get_bits (3);
-        } else if (d < 12) {
-          dist = (d - 10) * 16 + 33 + m_input.get_bits (4);
-        } else if (d < 14) {
-          dist = (d - 12) * 32 + 65 + m_input.get_bits (5);
-        } else if (d < 16) {
-          dist = (d - 14) * 64 + 129 + m_input.get_bits (6);
-        } else if (d < 18) {
-          dist = (d - 16) * 128 + 257 + m_input.get_bits (7);
-        } else if (d < 20) {
-          dist = (d - 18) * 256 + 513 + m_input.get_bits (8);
-        } else if (d < 22) {
-          dist = (d - 20) * 512 + 1025 + m_input.get_bits (9);
-        } else if (d < 24) {
-          dist = (d - 22) * 1024 + 2049 + m_input.get_bits (10);
-        } else if (d < 26) {
-          dist = (d - 24) * 2048 + 4097 + m_input.get_bits (11);
-        } else if (d < 28) {
-          dist = (d - 26) * 4096 + 8193 + m_input.get_bits (12);
         } else {
-          dist = (d - 28) * 8192 + 16385 + m_input.get_bits (13);
-        }
 
-        while (length-- > 0) {
-          put_byte_dist (dist);
+          static const unsigned short length_base [] = {
+            3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+            35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+          };
+          static const unsigned char length_extra [] = {
+            0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+            3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+          };
+          static const unsigned short dist_base [] = {
+            1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+            257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+          };
+          static const unsigned char dist_extra [] = {
+            0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+            7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+          };
+
+          l -= 257;
+          unsigned int length = length_base [l] + m_input.get_bits (length_extra [l]);
+
+          unsigned int d = mp_dist_decoder->decode (m_input);
+          if (d >= 30) {
+            throw tl::Exception (tl::to_string (tr ("Invalid distance code: %d (DEFLATE implementation)")), d);
+          }
+          unsigned int dist = dist_base [d] + m_input.get_bits (dist_extra [d]);
+
+          copy_dist (dist, length);
+          produced += length;
+
         }
 
       }
 
-    }
-
-    if (new_block) {
+    } else {
 
       if (m_last_block) {
-        return false;
+        //  leave the stream behind the compressed data
+        m_input.finish ();
+        return produced > 0;
       }
 
       //  read new block header
@@ -404,6 +540,8 @@ InflateFilter::process ()
 
       } else if (t == 1 || t == 2) {
         
+        m_uncompressed_length = -1;
+
         if (t == 1) {
 
           //  KLUDGE: should use a different decoder object, so we save time to do this:
@@ -432,8 +570,9 @@ InflateFilter::process ()
           HuffmannDecoder ldecoder;
           ldecoder.init_codes (hclengths, hclengths + sizeof (hclengths) / sizeof (hclengths[0]));
 
-          unsigned int lengths [286 + 32];
+          unsigned int lengths [288 + 32];
           unsigned int nlengths = hlit + hdist;
+          tl_assert (nlengths <= sizeof (lengths) / sizeof (lengths [0]));
 
           for (unsigned int i = 0; i < nlengths; ) {
 
@@ -475,11 +614,11 @@ InflateFilter::process ()
         throw tl::Exception (tl::to_string (tr ("Invalid compression type: %d")), t);
       }
 
-    } else {
-      return true;
     }
 
   }
+
+  return true;
 }
 
 // ------------------------------------------------------------------------
@@ -29,6 +29,8 @@
 #include "tlStream.h"
 #include "tlException.h"
 
+#include <stdint.h>
+
 //  forware definition of the zlib stream structure - we can omit the zlib header here
 struct z_stream_s;
 
@@ -43,6 +45,12 @@ class HuffmannDecoder;
  *  This filter reads bytes from a tl::Stream and delivers bits, taken from
  *  these bytes. The bits are delivered in the order specified by the DEFLATE
  *  format specification (least significant bit first).
+ *
+ *  The bits are kept in a 64 bit buffer which is refilled with as many bytes
+ *  as possible at once. The bytes are only peeked from the stream - the stream
+ *  is not advanced beyond the first byte holding unconsumed bits. This way,
+ *  the stream is positioned exactly behind the DEFLATE data after "finish" was
+ *  called, even though more bytes may have been fetched into the bit buffer.
  */
 class TL_PUBLIC BitStream
 {
@@ -54,7 +62,7 @@ public:
    */
   BitStream (tl::InputStream &input)
     : mp_input (&input),
-      m_mask (0), m_byte (0)
+      m_bits (0), m_nbits (0), m_bytes (0)
   {
     // ...
   }
@@ -62,17 +70,12 @@ public:
   /**
    *  @brief Get a byte
    *
-   *  This method simply passes the byte.
+   *  This method delivers the next 8 bits.
    *  The method expects the next byte to be available.
    */
   unsigned char get_byte ()
   {
-    m_mask = 0;
-    const char *c = mp_input->get (1, true /*bypass_deflate*/);
-    if (c == 0) {
-      throw tl::Exception (tl::to_string (tr ("Unexpected end of file (DEFLATE implementation)")));
-    }
-    return *c;
+    return (unsigned char) get_bits (8);
   }
 
   /**
@@ -83,13 +86,7 @@ public:
    */
   bool get_bit ()
   {
-    if (m_mask == 0) {
-      m_byte = get_byte ();
-      m_mask = 0x01;
-    } 
-    bool b = ((m_byte & m_mask) != 0);
-    m_mask <<= 1;
-    return b;
+    return get_bits (1) != 0;
   }
 
   /**
@@ -98,31 +95,82 @@ public:
    *  This method gets the next n bits and delivers them as a single unsigned int,
    *  packing the first bit into the least signification bit. This is the specification
    *  for reading multiple bit values except Huffmann codes.
+   *  n must not be larger than 32.
    */
   unsigned int get_bits (unsigned int n)
   {
-    //  KLUDGE: take directly from the byte for performance.
-    unsigned int r = 0;
-    unsigned int m = 1;
-    while (n-- > 0) {
-      r |= get_bit () ? m : 0;
-      m <<= 1;
+    if (m_nbits < n) {
+      fill ();
+      if (m_nbits < n) {
+        throw tl::Exception (tl::to_string (tr ("Unexpected end of file (DEFLATE implementation)")));
+      }
     }
+    unsigned int r = (unsigned int) (m_bits & ((uint64_t (1) << n) - 1));
+    m_bits >>= n;
+    m_nbits -= n;
     return r;
   }
 
+  /**
+   *  @brief Makes sure at least n bits are available if possible
+   *
+   *  n must not be larger than 56. After this method, "peek_bits" can be used to
+   *  look ahead n bits. Less bits may be available at the end of the stream. In this
+   *  case, the missing bits are delivered as zeros.
+   */
+  void ensure (unsigned int n)
+  {
+    if (m_nbits < n) {
+      fill ();
+    }
+  }
+
+  /**
+   *  @brief Delivers the next n bits without consuming them
+   *
+   *  "ensure" needs to be called before to make sure the bits are available.
+   */
+  unsigned int peek_bits (unsigned int n) const
+  {
+    return (unsigned int) (m_bits & ((uint64_t (1) << n) - 1));
+  }
+
+  /**
+   *  @brief Consumes n bits which have been looked at with "peek_bits"
+   */
+  void skip_bits (unsigned int n)
+  {
+    if (n > m_nbits) {
+      throw tl::Exception (tl::to_string (tr ("Unexpected end of file (DEFLATE implementation)")));
+    }
+    m_bits >>= n;
+    m_nbits -= n;
+  }
+
   /**
    *  @brief Skip the next bits up to the next byte boundary
    */
   void skip_to_byte ()
   {
-    m_mask = 0;
+    skip_bits (m_nbits % 8);
   }
 
+  /**
+   *  @brief Finishes reading
+   *
+   *  This method advances the stream to the byte following the last bit consumed.
+   *  Bytes which have been fetched into the bit buffer but have not been used
+   *  are left in the stream.
+   */
+  void finish ();
+
 private:
   tl::InputStream *mp_input;
-  unsigned char m_mask;
-  unsigned char m_byte;
+  uint64_t m_bits;
+  unsigned int m_nbits;
+  unsigned int m_bytes;
+
+  void fill ();
 };
 
 
@@ -242,8 +290,11 @@ private:
   int m_uncompressed_length;
   HuffmannDecoder *mp_lit_decoder, *mp_dist_decoder;
 
+  static const unsigned int buffer_mask = sizeof (m_buffer) - 1;
+
+  unsigned int available () const;
   void put_byte (char b);
-  void put_byte_dist (unsigned int d);
+  void copy_dist (unsigned int d, unsigned int length);
   bool process ();
 
 };
@@ -30,10 +30,14 @@
 #include <stdio.h>
 #include <errno.h>
 #include <zlib.h>
+#include <limits>
 #ifdef _WIN32 
+#  define NOMINMAX
 #  include <io.h>
+#  include <windows.h>
 #else
 #  include <unistd.h>
+#  include <sys/mman.h>
 #endif
 
 #include "tlStream.h"
@@ -141,24 +145,46 @@ public:
 // ---------------------------------------------------------------
 //  InputStream implementation
 
+/**
+ *  @brief Creates the delegate for a local file
+ *
+ *  Uncompressed files are memory-mapped. Compressed files and files which
+ *  cannot be mapped are read through zlib.
+ */
+static InputStreamBase *
+open_local_file (const std::string &path)
+{
+  InputMemoryMappedFile *mapped_file = new InputMemoryMappedFile (path);
+  if (mapped_file->is_mapped ()) {
+    return mapped_file;
+  }
+
+  delete mapped_file;
+  return new InputZLibFile (path);
+}
+
 InputStream::InputStream (InputStreamBase &delegate)
-  : m_pos (0), mp_bptr (0), mp_delegate (&delegate), m_owns_delegate (false), mp_inflate (0)
+  : m_pos (0), mp_bptr (0), mp_direct_data (0), m_direct_length (0), mp_delegate (&delegate), m_owns_delegate (false), mp_inflate (0), mp_inflated_bptr (0), m_inflated_blen (0), m_inflated_consumed (0), m_inflated_skip (0)
 { 
   m_bcap = 4096; // initial buffer capacity
   m_blen = 0;
   mp_buffer = new char [m_bcap];
+
+  init_direct ();
 }
 
 InputStream::InputStream (InputStreamBase *delegate)
-  : m_pos (0), mp_bptr (0), mp_delegate (delegate), m_owns_delegate (true), mp_inflate (0)
+  : m_pos (0), mp_bptr (0), mp_direct_data (0), m_direct_length (0), mp_delegate (delegate), m_owns_delegate (true), mp_inflate (0), mp_inflated_bptr (0), m_inflated_blen (0), m_inflated_consumed (0), m_inflated_skip (0)
 {
   m_bcap = 4096; // initial buffer capacity
   m_blen = 0;
   mp_buffer = new char [m_bcap];
+
+  init_direct ();
 }
 
 InputStream::InputStream (const std::string &abstract_path)
-  : m_pos (0), mp_bptr (0), mp_delegate (0), m_owns_delegate (false), mp_inflate (0)
+  : m_pos (0), mp_bptr (0), mp_direct_data (0), m_direct_length (0), mp_delegate (0), m_owns_delegate (false), mp_inflate (0), mp_inflated_bptr (0), m_inflated_blen (0), m_inflated_consumed (0), m_inflated_skip (0)
 { 
   m_bcap = 4096; // initial buffer capacity
   m_blen = 0;
@@ -199,9 +225,9 @@ InputStream::InputStream (const std::string &abstract_path)
     mp_delegate = new InputPipe (ex.get ());
   } else if (ex.test ("file:")) {
     tl::URI uri (abstract_path);
-    mp_delegate = new InputZLibFile (uri.path ());
+    mp_delegate = open_local_file (uri.path ());
   } else {
-    mp_delegate = new InputZLibFile (abstract_path);
+    mp_delegate = open_local_file (abstract_path);
   }
 
   if (! mp_buffer) {
@@ -209,6 +235,21 @@ InputStream::InputStream (const std::string &abstract_path)
   }
 
   m_owns_delegate = true;
+
+  init_direct ();
+}
+
+void
+InputStream::init_direct ()
+{
+  if (mp_delegate) {
+    mp_direct_data = mp_delegate->direct_data (m_direct_length);
+  }
+
+  if (mp_direct_data) {
+    mp_bptr = mp_direct_data;
+    m_blen = m_direct_length;
+  }
 }
 
 std::string InputStream::absolute_path (const std::string &abstract_path)
@@ -269,7 +310,30 @@ InputStream::get (size_t n, bool bypass_inflate)
     }
   } 
 
-  if (m_blen < n) {
+  //  deliver the data from an uncompressed block if there is one
+  if (mp_inflated_bptr && ! bypass_inflate) {
+
+    if (m_inflated_blen >= n && m_inflated_blen > 0) {
+      const char *r = mp_inflated_bptr;
+      mp_inflated_bptr += n;
+      m_inflated_blen -= n;
+      m_inflated_consumed += n;
+      return r;
+    } else if (m_inflated_blen > 0) {
+      //  same behavior as InflateFilter: a get must not cross the end of the block
+      throw tl::Exception (tl::to_string (tr ("Unexpected end of file (DEFLATE implementation)")));
+    }
+
+    skip_inflated ();
+
+  }
+
+  if (m_blen < n && mp_direct_data) {
+
+    //  reading directly from the delegate's memory block: the data is exhausted
+    return 0;
+
+  } else if (m_blen < n) {
 
     //  to keep move activity low, allocate twice as much as required
     if (m_bcap < n * 2) {
@@ -308,10 +372,15 @@ InputStream::get (size_t n, bool bypass_inflate)
 }
 
 void
-InputStream::unget (size_t n)
+InputStream::unget (size_t n, bool bypass_inflate)
 {
-  if (mp_inflate) {
+  if (mp_inflate && ! bypass_inflate) {
     mp_inflate->unget (n);
+  } else if (mp_inflated_bptr && ! bypass_inflate) {
+    tl_assert (m_inflated_consumed >= n);
+    mp_inflated_bptr -= n;
+    m_inflated_blen += n;
+    m_inflated_consumed -= n;
   } else {
     mp_bptr -= n;
     m_blen += n;
@@ -354,6 +423,14 @@ InputStream::read_all ()
 
 void InputStream::copy_to (tl::OutputStream &os)
 {
+  if (mp_direct_data) {
+    os.put (mp_bptr, m_blen);
+    mp_bptr += m_blen;
+    m_pos += m_blen;
+    m_blen = 0;
+    return;
+  }
+
   const size_t chunk = 65536;
   char b [chunk];
   size_t read;
@@ -365,13 +442,58 @@ void InputStream::copy_to (tl::OutputStream &os)
 void
 InputStream::inflate ()
 {
-  tl_assert (mp_inflate == 0);
+  tl_assert (mp_inflate == 0 && mp_inflated_bptr == 0);
   mp_inflate = new tl::InflateFilter (*this);
 }
 
+void
+InputStream::inflated (const char *data, size_t size, size_t compressed_size)
+{
+  tl_assert (mp_inflate == 0 && mp_inflated_bptr == 0);
+
+  if (size == 0) {
+    //  nothing to deliver - just skip the compressed data
+    m_inflated_skip = compressed_size;
+    skip_inflated ();
+  } else {
+    mp_inflated_bptr = data;
+    m_inflated_blen = size;
+    m_inflated_consumed = 0;
+    m_inflated_skip = compressed_size;
+  }
+}
+
+void
+InputStream::skip_inflated ()
+{
+  mp_inflated_bptr = 0;
+  m_inflated_blen = 0;
+  m_inflated_consumed = 0;
+
+  const size_t chunk = 65536;
+
+  while (m_inflated_skip > 0) {
+    size_t n = mp_direct_data ? m_inflated_skip : std::min (m_inflated_skip, chunk);
+    if (! get (n, true)) {
+      break;
+    }
+    m_inflated_skip -= n;
+  }
+
+  m_inflated_skip = 0;
+}
+
 void
 InputStream::close ()
 {
+  //  the delegate's memory block becomes invalid when the delegate is closed
+  if (mp_direct_data) {
+    mp_direct_data = 0;
+    m_direct_length = 0;
+    mp_bptr = mp_buffer;
+    m_blen = 0;
+  }
+
   if (mp_delegate) {
     mp_delegate->close ();
   }
@@ -386,9 +508,20 @@ InputStream::reset ()
     mp_inflate = 0;
   } 
 
+  mp_inflated_bptr = 0;
+  m_inflated_blen = 0;
+  m_inflated_consumed = 0;
+  m_inflated_skip = 0;
+
+  if (mp_direct_data) {
+
+    mp_bptr = mp_direct_data;
+    m_blen = m_direct_length;
+    m_pos = 0;
+
   //  optimize for a reset in the first m_bcap bytes
   //  -> this reduces the reset calls on mp_delegate which may not support this
-  if (m_pos < m_bcap) {
+  } else if (m_pos < m_bcap) {
 
     m_blen += m_pos;
     mp_bptr = mp_buffer;
@@ -615,6 +748,135 @@ InputFile::filename () const
   return tl::filename (m_source);
 }
 
+// ---------------------------------------------------------------
+//  InputMemoryMappedFile implementation
+
+InputMemoryMappedFile::InputMemoryMappedFile (const std::string &path)
+  : mp_data (0), m_length (0), m_pos (0)
+#if defined(_WIN32)
+    , m_mapping_handle (0)
+#endif
+{
+  m_source = path;
+
+#if defined(_WIN32)
+
+  int fd = _wopen (tl::to_wstring (path).c_str (), _O_BINARY | _O_RDONLY | _O_SEQUENTIAL);
+  if (fd < 0) {
+    throw FileOpenErrorException (m_source, errno);
+  }
+
+  HANDLE fh = (HANDLE) _get_osfhandle (fd);
+  LARGE_INTEGER size;
+  if (GetFileType (fh) == FILE_TYPE_DISK && GetFileSizeEx (fh, &size) && size.QuadPart > 0 && (unsigned long long) size.QuadPart <= (unsigned long long) std::numeric_limits<size_t>::max ()) {
+
+    HANDLE mh = CreateFileMappingW (fh, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mh != NULL) {
+
+      const char *data = (const char *) MapViewOfFile (mh, FILE_MAP_READ, 0, 0, 0);
+      if (data) {
+        mp_data = data;
+        m_length = size_t (size.QuadPart);
+        m_mapping_handle = (void *) mh;
+      } else {
+        CloseHandle (mh);
+      }
+
+    }
+
+  }
+
+  _close (fd);
+
+#else
+
+  int fd = open (tl::string_to_system (path).c_str (), O_RDONLY);
+  if (fd < 0) {
+    throw FileOpenErrorException (m_source, errno);
+  }
+
+  struct stat st;
+  if (fstat (fd, &st) == 0 && S_ISREG (st.st_mode) && st.st_size > 0 && (unsigned long long) st.st_size <= (unsigned long long) std::numeric_limits<size_t>::max ()) {
+
+    void *data = mmap (0, size_t (st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED) {
+
+      mp_data = (const char *) data;
+      m_length = size_t (st.st_size);
+
+      //  the readers consume the data front to back: let the system read ahead aggressively
+      //  and drop pages already read
+#if defined(MADV_SEQUENTIAL)
+      madvise (data, m_length, MADV_SEQUENTIAL);
+#endif
+
+    }
+
+  }
+
+  ::close (fd);
+
+#endif
+
+  //  compressed files are not mapped - they need to be read through zlib
+  if (mp_data && m_length >= 2 && (unsigned char) mp_data [0] == 0x1f && (unsigned char) mp_data [1] == 0x8b) {
+    close ();
+  }
+}
+
+InputMemoryMappedFile::~InputMemoryMappedFile ()
+{
+  close ();
+}
+
+void
+InputMemoryMappedFile::close ()
+{
+  if (mp_data) {
+#if defined(_WIN32)
+    UnmapViewOfFile ((LPCVOID) mp_data);
+    CloseHandle ((HANDLE) m_mapping_handle);
+    m_mapping_handle = 0;
+#else
+    munmap ((void *) mp_data, m_length);
+#endif
+    mp_data = 0;
+    m_length = 0;
+    m_pos = 0;
+  }
+}
+
+size_t
+InputMemoryMappedFile::read (char *b, size_t n)
+{
+  if (m_pos + n > m_length) {
+    n = m_length - m_pos;
+  }
+  if (n > 0) {
+    memcpy (b, mp_data + m_pos, n);
+    m_pos += n;
+  }
+  return n;
+}
+
+void
+InputMemoryMappedFile::reset ()
+{
+  m_pos = 0;
+}
+
+std::string
+InputMemoryMappedFile::absolute_path () const
+{
+  return tl::absolute_file_path (m_source);
+}
+
+std::string
+InputMemoryMappedFile::filename () const
+{
+  return tl::filename (m_source);
+}
+
 // ---------------------------------------------------------------
 //  InputZLibFile implementation
 
@@ -101,6 +101,20 @@ public:
    *  @brief Gets the filename part of the source
    */
   virtual std::string filename () const = 0;
+
+  /**
+   *  @brief Gets the data as a single memory block if the delegate can provide one
+   *
+   *  Delegates which hold the whole data in memory (i.e. memory-mapped files) can
+   *  reimplement this method to return a pointer to the data and the length of the
+   *  block. InputStream will then deliver the data directly from this block without
+   *  copying it. The block needs to stay valid until the delegate is closed.
+   *  The default implementation returns 0.
+   */
+  virtual const char *direct_data (size_t & /*length*/) const
+  {
+    return 0;
+  }
 };
 
 // ---------------------------------------------------------------------------------
@@ -164,6 +178,12 @@ public:
     return "data";
   }
 
+  virtual const char *direct_data (size_t &length) const
+  {
+    length = m_length;
+    return mp_data;
+  }
+
 private:
   //  no copying
   InputMemoryStream (const InputMemoryStream &);
@@ -282,6 +302,80 @@ private:
   int m_fd;
 };
 
+/**
+ *  @brief A memory-mapped file delegate
+ *
+ *  Implements the reader for uncompressed local files by mapping them into memory.
+ *  InputStream delivers the data directly from the mapping, so the data is
+ *  not copied. The mapping is advised for sequential access, so the system can
+ *  read ahead.
+ *  Files which cannot be mapped (i.e. empty files, pipes, devices or compressed
+ *  files) are not rejected, but "is_mapped" will return false. In that case,
+ *  a different delegate needs to be used.
+ */
+class TL_PUBLIC InputMemoryMappedFile
+  : public InputStreamBase
+{
+public:
+  /**
+   *  @brief Open a file with the given path
+   *
+   *  This constructor will throw a FileOpenErrorException if
+   *  the file cannot be opened.
+   *
+   *  @param path The (relative) path of the file to open
+   */
+  InputMemoryMappedFile (const std::string &path);
+
+  /**
+   *  @brief Close the file
+   *
+   *  The destructor will automatically close the file.
+   */
+  virtual ~InputMemoryMappedFile ();
+
+  /**
+   *  @brief Returns true, if the file could be mapped
+   */
+  bool is_mapped () const
+  {
+    return mp_data != 0;
+  }
+
+  virtual size_t read (char *b, size_t n);
+
+  virtual void reset ();
+
+  virtual void close ();
+
+  virtual std::string source () const
+  {
+    return m_source;
+  }
+
+  virtual std::string absolute_path () const;
+
+  virtual std::string filename () const;
+
+  virtual const char *direct_data (size_t &length) const
+  {
+    length = m_length;
+    return mp_data;
+  }
+
+private:
+  //  no copying
+  InputMemoryMappedFile (const InputMemoryMappedFile &d);
+  InputMemoryMappedFile &operator= (const InputMemoryMappedFile &d);
+
+  std::string m_source;
+  const char *mp_data;
+  size_t m_length, m_pos;
+#if defined(_WIN32)
+  void *m_mapping_handle;
+#endif
+};
+
 /**
  *  @brief A simple pipe input delegate
  *
@@ -432,8 +526,9 @@ public:
    *  
    *  This call puts back the bytes read by a previous get call.
    *  Only one call can be made undone.
+   *  "bypass_inflate" needs to be the same as for the get call.
    */
-  void unget (size_t n);
+  void unget (size_t n, bool bypass_inflate = false);
 
   /**
    *  @brief Reads all remaining bytes into the string
@@ -464,6 +559,19 @@ public:
    */
   void inflate ();
 
+  /**
+   *  @brief Delivers an already uncompressed block instead of the next DEFLATE-compressed block
+   *
+   *  This is an alternative to "inflate" for the case the compressed block has been
+   *  uncompressed already - for example by a separate thread. Subsequent get() calls
+   *  will deliver the data from the given block. Once the block is consumed, the
+   *  "compressed_size" bytes of the compressed block are skipped and reading continues
+   *  behind the compressed block.
+   *  The block is not copied and needs to stay valid until it is consumed.
+   *  The stream must not be in inflate state yet.
+   */
+  void inflated (const char *data, size_t size, size_t compressed_size);
+
   /**
    *  @brief Obtain the current file position
    */
@@ -537,6 +645,25 @@ public:
   {
     return mp_delegate;
   }
+
+  /**
+   *  @brief Returns true, if the data is delivered directly from the delegate's memory block
+   */
+  bool is_direct () const
+  {
+    return mp_direct_data != 0;
+  }
+
+  /**
+   *  @brief Gets the delegate's memory block if the data is delivered directly from there
+   *
+   *  Returns 0 if the stream does not read from a memory block.
+   */
+  const char *direct_data (size_t &length) const
+  {
+    length = m_direct_length;
+    return mp_direct_data;
+  }
     
 protected:
   void reset_pos ()
@@ -549,12 +676,20 @@ private:
   char *mp_buffer;
   size_t m_bcap;
   size_t m_blen;
-  char *mp_bptr;
+  const char *mp_bptr;
+  const char *mp_direct_data;
+  size_t m_direct_length;
   InputStreamBase *mp_delegate;
   bool m_owns_delegate;
 
   //  inflate support 
   InflateFilter *mp_inflate;
+  const char *mp_inflated_bptr;
+  size_t m_inflated_blen, m_inflated_consumed, m_inflated_skip;
+
+  void skip_inflated ();
+
+  void init_direct ();
 
   //  No copying currently
   InputStream (const InputStream &);
@@ -25,10 +25,25 @@
 #include "tlLog.h"
 #include "tlProgress.h"
 #include "tlAssert.h"
+#include "tlFileUtils.h"
+#include "tlStream.h"
+#include "tlString.h"
 
 #include <memory>
+#include <map>
+#include <functional>
+#include <algorithm>
 #include <stdio.h>
 
+#if defined(_WIN32)
+#  define NOMINMAX
+#  include <windows.h>
+#elif defined(__linux__)
+#  include <pthread.h>
+#  include <sched.h>
+#  include <unistd.h>
+#endif
+
 namespace tl
 {
 
@@ -159,17 +174,114 @@ TaskList::put_front (Task *task)
   }
 }
 
+Task *
+TaskList::fetch_back ()
+{
+  Task *task = mp_last;
+
+  mp_last = task->mp_last;
+  if (! mp_last) {
+    mp_first = 0;
+  } else {
+    mp_last->mp_next = 0;
+  }
+
+  tl_assert (task->mp_next == 0);
+  task->mp_last = 0;
+
+  return task;
+}
+
+// -----------------------------------------------------------------------------
+//  tl::TaskQueue definition and implementation
+
+/**
+ *  @brief The task queue of one worker
+ *
+ *  The queue keeps one task list per priority. The owner takes the tasks from the 
+ *  front, other workers steal tasks from the back. Each queue has its own lock, so
+ *  workers don't contend for a single lock as long as they are busy with their 
+ *  own tasks.
+ *  This class is thread-safe.
+ */
+class TaskQueue
+{
+public:
+  TaskQueue ()
+    : m_size (0)
+  {
+    //  .. nothing yet ..
+  }
+
+  ~TaskQueue ()
+  {
+    clear ();
+  }
+
+  void put (Task *task)
+  {
+    tl::MutexLocker locker (&m_lock);
+
+    std::map<int, TaskList *, std::greater<int> >::iterator l = m_lists.find (task->priority ());
+    if (l == m_lists.end ()) {
+      l = m_lists.insert (std::make_pair (task->priority (), new TaskList ())).first;
+    }
+    l->second->put (task);
+
+    ++m_size;
+  }
+
+  Task *fetch (bool from_back)
+  {
+    //  quick check without locking
+    if (m_size.load () == 0) {
+      return 0;
+    }
+
+    tl::MutexLocker locker (&m_lock);
+
+    for (std::map<int, TaskList *, std::greater<int> >::iterator l = m_lists.begin (); l != m_lists.end (); ++l) {
+      if (! l->second->is_empty ()) {
+        --m_size;
+        return from_back ? l->second->fetch_back () : l->second->fetch ();
+      }
+    }
+
+    return 0;
+  }
+
+  void clear ()
+  {
+    tl::MutexLocker locker (&m_lock);
+
+    for (std::map<int, TaskList *, std::greater<int> >::iterator l = m_lists.begin (); l != m_lists.end (); ++l) {
+      //  deletes the tasks
+      delete l->second;
+    }
+    m_lists.clear ();
+
+    m_size.store (0);
+  }
+
+private:
+  tl::Mutex m_lock;
+  std::map<int, TaskList *, std::greater<int> > m_lists;
+  atomic::atomic<int> m_size;
+};
+
 // -----------------------------------------------------------------------------
 //  tl::JobBase implementation
 
 JobBase::JobBase (int nworkers)
-  : m_nworkers (nworkers), m_idle_workers (0), m_stopping (false), m_running (false)
+  : m_next_queue (0), m_nworkers (nworkers), m_idle_workers (0), m_stopping (false), m_running (false)
 {
   if (nworkers > 0) {
     mp_per_worker_task_lists = new TaskList[nworkers];
   } else {
     mp_per_worker_task_lists = 0;
   }
+
+  create_queues ();
 }
 
 JobBase::~JobBase ()
@@ -184,6 +296,44 @@ JobBase::~JobBase ()
     delete[] mp_per_worker_task_lists;
     mp_per_worker_task_lists = 0;
   }
+
+  drop_waiting_tasks ();
+
+  for (std::vector<TaskQueue *>::const_iterator q = m_queues.begin (); q != m_queues.end (); ++q) {
+    delete *q;
+  }
+  m_queues.clear ();
+}
+
+void
+JobBase::create_queues ()
+{
+  for (std::vector<TaskQueue *>::const_iterator q = m_queues.begin (); q != m_queues.end (); ++q) {
+    delete *q;
+  }
+  m_queues.clear ();
+
+  //  the synchronous mode uses a single queue
+  for (int i = 0; i < std::max (1, m_nworkers); ++i) {
+    m_queues.push_back (new TaskQueue ());
+  }
+}
+
+void
+JobBase::clear_queues ()
+{
+  for (std::vector<TaskQueue *>::const_iterator q = m_queues.begin (); q != m_queues.end (); ++q) {
+    (*q)->clear ();
+  }
+}
+
+void
+JobBase::drop_waiting_tasks ()
+{
+  for (std::set<Task *>::const_iterator t = m_waiting_tasks.begin (); t != m_waiting_tasks.end (); ++t) {
+    delete *t;
+  }
+  m_waiting_tasks.clear ();
 }
 
 void
@@ -226,7 +376,7 @@ JobBase::set_num_workers (int nworkers)
   terminate ();
 
   m_nworkers = nworkers;
-  m_idle_workers = 0;
+  m_idle_workers.store (0);
 
   if (mp_per_worker_task_lists) {
     delete[] mp_per_worker_task_lists;
@@ -237,6 +387,20 @@ JobBase::set_num_workers (int nworkers)
   } else {
     mp_per_worker_task_lists = 0;
   }
+
+  //  NOTE: tasks scheduled already are dropped
+  drop_waiting_tasks ();
+  create_queues ();
+}
+
+void
+JobBase::set_thread_affinity (const std::vector<int> &cpus)
+{
+  if (cpus != m_thread_affinity) {
+    //  the affinity is applied when the worker threads are started
+    terminate ();
+    m_thread_affinity = cpus;
+  }
 }
 
 void 
@@ -278,8 +442,9 @@ JobBase::start ()
     std::auto_ptr <Worker> sync_worker (create_worker ());
     setup_worker (sync_worker.get ());
 
-    while (! m_task_list.is_empty ()) {
-      std::auto_ptr<Task> task (m_task_list.fetch ());
+    Task *t;
+    while ((t = fetch_task (0)) != 0) {
+      std::auto_ptr<Task> task (t);
       try {
         sync_worker->perform_task (task.get ());
       } catch (TaskTerminatedException) {
@@ -295,15 +460,18 @@ JobBase::start ()
       } catch (...) {
         log_error (tl::to_string (tr ("Unspecific error")));
       }
+      task_done (task.get ());
     }
 
     //  clean up any remaining tasks
-    while (! m_task_list.is_empty ()) {
-      Task *task = m_task_list.fetch ();
-      if (task) {
-        delete task;
-      }
+    m_lock.lock ();
+    if (! m_waiting_tasks.empty ()) {
+      m_error_messages.push_back (tl::to_string (tr ("Tasks with unresolved dependencies have been dropped")));
     }
+    drop_waiting_tasks ();
+    m_lock.unlock ();
+
+    clear_queues ();
 
     finished ();
     m_running = false;
@@ -344,9 +512,8 @@ JobBase::stop ()
   m_stopping = true;
 
   //  Remove all pending tasks
-  while (! m_task_list.is_empty ()) {
-    delete m_task_list.fetch ();
-  }
+  clear_queues ();
+  drop_waiting_tasks ();
 
   if (! mp_workers.empty ()) {
 
@@ -374,6 +541,10 @@ JobBase::stop ()
     //  are idle.
   }
 
+  //  Drop tasks which have been scheduled while we were stopping
+  clear_queues ();
+  drop_waiting_tasks ();
+
   m_stopping = false;
   m_running = false;
 
@@ -422,25 +593,118 @@ JobBase::terminate ()
 void 
 JobBase::schedule (Task *task)
 {
-  m_lock.lock ();
+  if (task->m_pending_dependencies > 0) {
 
-  if (m_stopping) {
+    m_lock.lock ();
 
-    //  Don't allow tasks to be scheduled while stopping or exiting (waiting for m_queue_empty_condition)
-    delete task;
+    bool ready = false;
+    if (m_stopping) {
+      //  Don't allow tasks to be scheduled while stopping or exiting (waiting for m_queue_empty_condition)
+      delete task;
+    } else if (task->m_pending_dependencies > 0) {
+      //  Hold the task back until the tasks it depends on have been processed
+      m_waiting_tasks.insert (task);
+    } else {
+      ready = true;
+    }
+
+    m_lock.unlock ();
+
+    if (ready) {
+      enqueue (task);
+    }
 
   } else {
+    enqueue (task);
+  }
+}
 
-    //  Add the task to the task queue
-    m_task_list.put (task);
+void
+JobBase::enqueue (Task *task)
+{
+  //  NOTE: m_stopping is read without a lock. A task scheduled while the job is 
+  //  about to stop is dropped by stop () eventually.
+  if (m_stopping) {
+    delete task;
+    return;
+  }
+
+  //  Distribute the tasks over the worker queues
+  m_queues [(++m_next_queue) % (unsigned int) m_queues.size ()]->put (task);
 
+  //  Wake up an idle worker if there is one. Workers increment m_idle_workers and check
+  //  the queues again while holding the lock, so we cannot miss one going to sleep.
+  if (m_idle_workers.load () > 0) {
+    m_lock.lock ();
     if (m_running) {
-      m_task_available_condition.wakeAll ();
+      m_task_available_condition.wakeOne ();
+    }
+    m_lock.unlock ();
+  }
+}
+
+void
+JobBase::task_done (Task *task)
+{
+  if (task->m_dependent_tasks.empty ()) {
+    return;
+  }
+
+  std::vector<Task *> ready;
+
+  m_lock.lock ();
+
+  //  NOTE: while stopping, the dependent tasks may have been deleted already
+  if (! m_stopping) {
+
+    for (std::vector<Task *>::const_iterator d = task->m_dependent_tasks.begin (); d != task->m_dependent_tasks.end (); ++d) {
+
+      //  tasks not scheduled yet are enqueued when they are scheduled
+      if (--(*d)->m_pending_dependencies == 0) {
+        std::set<Task *>::iterator w = m_waiting_tasks.find (*d);
+        if (w != m_waiting_tasks.end ()) {
+          m_waiting_tasks.erase (w);
+          ready.push_back (*d);
+        }
+      }
+
     }
 
   }
 
   m_lock.unlock ();
+
+  //  NOTE: enqueue needs the lock itself
+  for (std::vector<Task *>::const_iterator r = ready.begin (); r != ready.end (); ++r) {
+    enqueue (*r);
+  }
+}
+
+Task *
+JobBase::fetch_task (int worker)
+{
+  int nq = int (m_queues.size ());
+
+  //  take a task from our own queue
+  Task *task = m_queues [worker]->fetch (false);
+
+  //  otherwise steal one from the other workers
+  for (int i = 1; i < nq && ! task; ++i) {
+    task = m_queues [(worker + i) % nq]->fetch (true);
+  }
+
+  return task;
+}
+
+Task *
+JobBase::fetch_task_or_control (int worker)
+{
+  //  worker-specific tasks (start, exit) go first
+  if (! mp_per_worker_task_lists [worker].is_empty ()) {
+    return mp_per_worker_task_lists [worker].fetch ();
+  } else {
+    return fetch_task (worker);
+  }
 }
 
 Task *
@@ -448,43 +712,49 @@ JobBase::get_task (int worker)
 {
   while (true) {
 
-    m_lock.lock ();
+    //  this does not need the job's lock
+    Task *task = fetch_task (worker);
+
+    if (! task) {
 
-    //  wait for new relevant entries in the task queue
-    while (m_task_list.is_empty () && mp_per_worker_task_lists [worker].is_empty ()) {
+      m_lock.lock ();
 
-      //  if the queue is empty, mark this worker as idle.
+      //  Mark this worker as idle before checking the queues again: enqueue () will
+      //  wake us up if a task arrives after this check.
       ++m_idle_workers;
 
-      //  signal empty queue if all workers are waiting
-      if (m_idle_workers == m_nworkers) {
-        if (! m_stopping) {
-          finished ();
+      task = fetch_task_or_control (worker);
+      if (! task) {
+
+        //  signal empty queue if all workers are waiting
+        if (m_idle_workers.load () == m_nworkers) {
+          if (! m_waiting_tasks.empty ()) {
+            m_error_messages.push_back (tl::to_string (tr ("Tasks with unresolved dependencies have been dropped")));
+            drop_waiting_tasks ();
+          }
+          if (! m_stopping) {
+            finished ();
+          }
+          m_running = false;
+          m_queue_empty_condition.wakeAll ();
+        }
+
+        //  wait until we receive a task
+        while (! task) {
+          mp_workers [worker]->set_idle (true);
+          m_task_available_condition.wait (&m_lock);
+          mp_workers [worker]->set_idle (false);
+          task = fetch_task_or_control (worker);
         }
-        m_running = false;
-        m_queue_empty_condition.wakeAll ();
-      }
 
-      //  wait until we receive a task
-      while (m_task_list.is_empty () && mp_per_worker_task_lists [worker].is_empty ()) {
-        mp_workers [worker]->set_idle (true);
-        m_task_available_condition.wait (&m_lock);
-        mp_workers [worker]->set_idle (false);
       }
 
       --m_idle_workers;
 
-    } 
+      m_lock.unlock ();
 
-    Task *task = 0;
-    if (! mp_per_worker_task_lists [worker].is_empty ()) {
-      task = mp_per_worker_task_lists [worker].fetch ();
-    } else if (! m_task_list.is_empty ()) {
-      task = m_task_list.fetch ();
     }
 
-    m_lock.unlock ();
-
     if (dynamic_cast <ExitTask *> (task) != 0) {
       delete task;
       //  stops the thread
@@ -583,10 +853,16 @@ Worker::run ()
 {
   WorkerProgressAdaptor progress_adaptor (this);
 
+  const std::vector<int> &cpus = mp_job->thread_affinity ();
+  if (! cpus.empty ()) {
+    set_current_thread_affinity (cpus [m_worker_index % int (cpus.size ())]);
+  }
+
   while (true)
   {
+    std::auto_ptr<Task> task;
     try {
-      std::auto_ptr<Task> task (mp_job->get_task (m_worker_index));
+      task.reset (mp_job->get_task (m_worker_index));
       perform_task (task.get ());
     } catch (TaskTerminatedException) {
       //  .. try again
@@ -600,6 +876,10 @@ Worker::run ()
     } catch (...) {
       mp_job->log_error (tl::to_string (tr ("Unspecific error")));
     }
+    if (task.get ()) {
+      //  release the tasks depending on this one
+      mp_job->task_done (task.get ());
+    }
   }
 }
 
@@ -615,5 +895,168 @@ Worker::stop_request ()
   m_stop_requested = true;
 }
 
+// -----------------------------------------------------------------------------
+//  Thread affinity implementation
+
+#if defined(__linux__)
+
+static std::vector<int>
+read_cpu_list (const std::string &path)
+{
+  std::vector<int> cpus;
+
+  try {
+
+    tl::InputStream is (path);
+    tl::TextInputStream ts (is);
+    std::string l = ts.get_line ();
+
+    //  format is like "0-15,32-47"
+    tl::Extractor ex (l.c_str ());
+    int from = 0;
+    while (ex.try_read (from)) {
+      int to = from;
+      if (ex.test ("-")) {
+        ex.read (to);
+      }
+      for (int i = from; i <= to; ++i) {
+        cpus.push_back (i);
+      }
+      if (! ex.test (",")) {
+        break;
+      }
+    }
+
+  } catch (...) {
+    //  ignore errors - no information
+    cpus.clear ();
+  }
+
+  return cpus;
+}
+
+#endif
+
+std::vector<std::vector<int> >
+cpus_per_node ()
+{
+  std::vector<std::vector<int> > nodes;
+
+#if defined(__linux__)
+
+  for (int n = 0; ; ++n) {
+    std::string path = tl::sprintf ("/sys/devices/system/node/node%d/cpulist", n);
+    if (! tl::file_exists (path)) {
+      break;
+    }
+    std::vector<int> cpus = read_cpu_list (path);
+    if (! cpus.empty ()) {
+      nodes.push_back (cpus);
+    }
+  }
+
+  if (nodes.empty ()) {
+    long ncpus = sysconf (_SC_NPROCESSORS_ONLN);
+    if (ncpus > 0) {
+      nodes.push_back (std::vector<int> ());
+      for (int i = 0; i < int (ncpus); ++i) {
+        nodes.back ().push_back (i);
+      }
+    }
+  }
+
+#elif defined(_WIN32)
+
+  SYSTEM_INFO si;
+  GetSystemInfo (&si);
+  if (si.dwNumberOfProcessors > 0) {
+    nodes.push_back (std::vector<int> ());
+    //  NOTE: without processor groups, only the first 64 CPUs can be addressed
+    for (int i = 0; i < int (si.dwNumberOfProcessors) && i < int (sizeof (DWORD_PTR) * 8); ++i) {
+      nodes.back ().push_back (i);
+    }
+  }
+
+#endif
+
+  return nodes;
+}
+
+std::vector<int>
+thread_affinity_layout (int nthreads, bool spread)
+{
+  std::vector<int> cpus;
+
+  std::vector<std::vector<int> > nodes = cpus_per_node ();
+  if (nodes.empty () || nthreads <= 0) {
+    return cpus;
+  }
+
+  if (spread) {
+
+    //  round-robin over the nodes
+    size_t i = 0;
+    while (int (cpus.size ()) < nthreads) {
+      bool any = false;
+      for (std::vector<std::vector<int> >::const_iterator n = nodes.begin (); n != nodes.end () && int (cpus.size ()) < nthreads; ++n) {
+        if (i < n->size ()) {
+          cpus.push_back ((*n) [i]);
+          any = true;
+        }
+      }
+      //  more threads than CPUs: start over
+      i = any ? i + 1 : 0;
+    }
+
+  } else {
+
+    //  fill one node after the other
+    while (int (cpus.size ()) < nthreads) {
+      for (std::vector<std::vector<int> >::const_iterator n = nodes.begin (); n != nodes.end () && int (cpus.size ()) < nthreads; ++n) {
+        for (std::vector<int>::const_iterator c = n->begin (); c != n->end () && int (cpus.size ()) < nthreads; ++c) {
+          cpus.push_back (*c);
+        }
+      }
+    }
+
+  }
+
+  return cpus;
+}
+
+bool
+set_current_thread_affinity (int cpu)
+{
+  if (cpu < 0) {
+    return false;
+  }
+
+#if defined(__linux__)
+
+  if (cpu >= CPU_SETSIZE) {
+    return false;
+  }
+
+  cpu_set_t cpuset;
+  CPU_ZERO (&cpuset);
+  CPU_SET (cpu, &cpuset);
+  return pthread_setaffinity_np (pthread_self (), sizeof (cpu_set_t), &cpuset) == 0;
+
+#elif defined(_WIN32)
+
+  if (cpu >= int (sizeof (DWORD_PTR) * 8)) {
+    return false;
+  }
+
+  return SetThreadAffinityMask (GetCurrentThread (), DWORD_PTR (1) << cpu) != 0;
+
+#else
+
+  //  not supported (i.e. macOS)
+  return false;
+
+#endif
+}
+
 }
 
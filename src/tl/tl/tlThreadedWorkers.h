@@ -26,6 +26,7 @@
 
 #include "tlCommon.h"
 #include "tlThreads.h"
+#include "atomic/atomic.h"
 
 #include <set>
 #include <vector>
@@ -53,11 +54,16 @@ namespace tl
  *      A job may be associated with multiple boss instances.
  *  3.) Workers: a job can be split into multiple tasks which are executed by the workers. A worker is
  *      a thread which receives tasks through a task queue.
+ *
+ *  Tasks are distributed over per-worker queues. A worker takes the tasks from its own queue
+ *  and steals tasks from the other queues if its own queue runs empty. Tasks can be given a
+ *  priority and can depend on other tasks (see \Task).
  */
 
 class Boss;
 class Worker;
 class Task;
+class TaskQueue;
 
 /**
  *  @brief A task list
@@ -101,6 +107,11 @@ public:
    */
   void put_front (Task *task);
 
+  /**
+   *  @brief Fetch the last task
+   */
+  Task *fetch_back ();
+
   /**
    *  @brief Get the next task without taking it
    */
@@ -157,9 +168,12 @@ public:
    *  This does not trigger the actual operation yet. It should be done separately before
    *  \start is called. However, it is possible to schedule jobs while the job is running and
    *  even from within other tasks.
-   *  It is guaranteed that the order of processing of the tasks is maintained. However, 
-   *  it is not guaranteed that previous tasks have been processed already because they
-   *  might be send to a different thread.
+   *  Tasks with a higher priority are started before tasks with a lower priority. Within the 
+   *  same priority, the order of scheduling is maintained within each worker queue. As tasks 
+   *  are distributed over the workers and idle workers steal tasks from others, there is no
+   *  global order of processing. Tasks which depend on other tasks are held back until the 
+   *  tasks they depend on have been processed.
+   *  The job takes over ownership of the task.
    */
   void schedule (Task *task);
 
@@ -202,6 +216,28 @@ public:
    */
   void set_num_workers (int workers);
 
+  /**
+   *  @brief Sets the CPUs the workers are pinned to
+   *
+   *  Worker n is pinned to CPU cpus[n % cpus.size ()]. An empty list disables pinning.
+   *  As memory is usually allocated on the NUMA node of the thread which touches it first,
+   *  pinning also keeps the data produced by a worker on the worker's node. Together with
+   *  "thread_affinity_layout" in "compact" mode, neighboring workers share a node and
+   *  workers steal tasks from their neighbors first.
+   *  This function will terminate the job. The new affinity is applied when the 
+   *  workers are started again. On platforms not supporting thread affinity, this 
+   *  setting is ignored.
+   */
+  void set_thread_affinity (const std::vector<int> &cpus);
+
+  /**
+   *  @brief Gets the CPUs the workers are pinned to
+   */
+  const std::vector<int> &thread_affinity () const
+  {
+    return m_thread_affinity;
+  }
+
   /**
    *  @brief Returns true if an error occurred during run()
    */
@@ -257,11 +293,14 @@ private:
   friend class Worker;
   friend class Boss;
 
-  TaskList m_task_list;
+  std::vector<TaskQueue *> m_queues;
+  std::set<Task *> m_waiting_tasks;
+  atomic::atomic<unsigned int> m_next_queue;
   TaskList *mp_per_worker_task_lists;
 
   int m_nworkers;
-  int m_idle_workers;
+  std::vector<int> m_thread_affinity;
+  atomic::atomic<int> m_idle_workers;
   bool m_stopping;
   bool m_running;
 
@@ -275,6 +314,13 @@ private:
   std::vector<std::string> m_error_messages;
 
   Task *get_task (int for_worker);
+  Task *fetch_task (int for_worker);
+  Task *fetch_task_or_control (int for_worker);
+  void task_done (Task *task);
+  void enqueue (Task *task);
+  void create_queues ();
+  void clear_queues ();
+  void drop_waiting_tasks ();
   void log_error (const std::string &s);
 };
 
@@ -396,6 +442,9 @@ private:
  *  This object must be reimplemented to provide specific
  *  information for a task. This is the base class of all
  *  task objects.
+ *
+ *  A task can be given a priority and dependencies on other tasks. 
+ *  Both need to be configured before the task is scheduled.
  */
 class TL_PUBLIC Task
 {
@@ -404,7 +453,7 @@ public:
    *  @brief Default ctor
    */
   Task () 
-    : mp_next (0), mp_last (0)
+    : mp_next (0), mp_last (0), m_priority (0), m_pending_dependencies (0)
   { }
 
   /**
@@ -413,10 +462,46 @@ public:
   virtual ~Task ()
   { }
 
+  /**
+   *  @brief Sets the priority of the task
+   *
+   *  Tasks with a higher priority are taken before tasks with a lower one. 
+   *  The default priority is 0.
+   */
+  void set_priority (int p)
+  {
+    m_priority = p;
+  }
+
+  /**
+   *  @brief Gets the priority of the task
+   */
+  int priority () const
+  {
+    return m_priority;
+  }
+
+  /**
+   *  @brief Makes this task depend on another one
+   *
+   *  This task is not started before the given task has been processed. Both tasks
+   *  need to be scheduled on the same job and the dependency needs to be established
+   *  before any of them is scheduled.
+   */
+  void add_dependency (Task *task)
+  {
+    task->m_dependent_tasks.push_back (this);
+    ++m_pending_dependencies;
+  }
+
 private:
   friend class TaskList;
+  friend class JobBase;
 
   Task *mp_next, *mp_last;
+  int m_priority;
+  int m_pending_dependencies;
+  std::vector<Task *> m_dependent_tasks;
 };
 
 /**
@@ -490,6 +575,31 @@ private:
   std::set<JobBase *> m_jobs;
 };
 
+/**
+ *  @brief Gets the CPUs of the system grouped by NUMA node
+ *
+ *  On systems without NUMA information, a single node with all CPUs is returned. 
+ *  If the CPUs cannot be determined, an empty list is returned.
+ */
+TL_PUBLIC std::vector<std::vector<int> > cpus_per_node ();
+
+/**
+ *  @brief Computes a thread-to-CPU assignment for the given number of threads
+ *
+ *  In "compact" mode (spread = false), the threads fill the NUMA nodes one after another.
+ *  In "spread" mode, the threads are distributed round-robin over the nodes.
+ *  The result is suitable for JobBase::set_thread_affinity.
+ */
+TL_PUBLIC std::vector<int> thread_affinity_layout (int nthreads, bool spread);
+
+/**
+ *  @brief Pins the current thread to the given CPU
+ *
+ *  Returns false if the thread could not be pinned or the platform does not support 
+ *  thread affinity.
+ */
+TL_PUBLIC bool set_current_thread_affinity (int cpu);
+
 }
 
 #endif
@@ -24,9 +24,13 @@
 #include "tlStream.h"
 #include "tlDeflate.h"
 #include "tlUnitTest.h"
+#include "tlTimer.h"
+#include "tlLog.h"
 
 #include "zlib.h"
 
+#include <cstring>
+
 TEST(1) 
 {
   unsigned char data[] = {
@@ -118,3 +122,203 @@ TEST(3)
   delete[] hello;
 }
 
+
+namespace
+{
+
+//  A stream delegate delivering the data in small pieces, so the
+//  InputStream's buffer is not a direct memory block
+class ChoppedInputStream
+  : public tl::InputStreamBase
+{
+public:
+  ChoppedInputStream (const std::string &data, size_t chunk)
+    : m_data (data), m_chunk (chunk), m_pos (0)
+  { }
+
+  virtual size_t read (char *b, size_t n)
+  {
+    n = std::min (std::min (n, m_chunk), m_data.size () - m_pos);
+    memcpy (b, m_data.c_str () + m_pos, n);
+    m_pos += n;
+    return n;
+  }
+
+  virtual void reset () { m_pos = 0; }
+  virtual void close () { }
+  virtual std::string source () const { return std::string (); }
+  virtual std::string absolute_path () const { return std::string (); }
+  virtual std::string filename () const { return std::string (); }
+
+private:
+  std::string m_data;
+  size_t m_chunk, m_pos;
+};
+
+}
+
+static std::string deflate_string (const std::string &data)
+{
+  tl::OutputStringStream oss;
+  tl::OutputStream os (oss);
+  tl::DeflateFilter fg (os);
+  fg.put (data.c_str (), data.size ());
+  fg.flush ();
+  return oss.string ();
+}
+
+static void inflate_and_check_end (tl::TestBase *_this, tl::InputStream &is, const std::string &data, const std::string &trailer)
+{
+  is.inflate ();
+  std::string out;
+  while (out.size () < data.size ()) {
+    size_t n = std::min (data.size () - out.size (), size_t (1000));
+    const char *c = is.get (n);
+    EXPECT_EQ (c != 0, true);
+    out += std::string (c, n);
+  }
+  EXPECT_EQ (out == data, true);
+
+  //  the stream has to be positioned right after the compressed data
+  const char *c = is.get (trailer.size ());
+  EXPECT_EQ (c != 0, true);
+  EXPECT_EQ (std::string (c, trailer.size ()), trailer);
+  EXPECT_EQ (is.get (1) == 0, true);
+}
+
+//  Stream position after inflating (fixed, dynamic and stored blocks)
+TEST(4)
+{
+  std::string trailer ("TRAILER");
+
+  std::vector<std::string> samples;
+  samples.push_back ("This is a test \\!");
+
+  std::string abc;
+  size_t r = 1;
+  for (size_t i = 0; i < 200000; ++i) {
+    r *= 12361;
+    r ^= (r >> 8);
+    abc += "abc" [r % 3];
+  }
+  samples.push_back (abc);
+
+  std::string noise;
+  for (size_t i = 0; i < 200000; ++i) {
+    r *= 12361;
+    r ^= (r >> 8);
+    noise += char (r >> 16);
+  }
+  samples.push_back (noise);
+
+  for (std::vector<std::string>::const_iterator s = samples.begin (); s != samples.end (); ++s) {
+
+    std::string deflated = deflate_string (*s) + trailer;
+
+    tl::InputMemoryStream ims (deflated.c_str (), deflated.size ());
+    tl::InputStream is (ims);
+    EXPECT_EQ (is.is_direct (), true);
+    inflate_and_check_end (_this, is, *s, trailer);
+
+    for (size_t chunk = trailer.size (); chunk < 30; chunk += 11) {
+      ChoppedInputStream cis (deflated, chunk);
+      tl::InputStream is (cis);
+      EXPECT_EQ (is.is_direct (), false);
+      inflate_and_check_end (_this, is, *s, trailer);
+    }
+
+  }
+}
+
+//  Inflates a sequence of raw deflate streams with zlib for reference
+static std::string zlib_inflate (const std::string &deflated)
+{
+  std::string out;
+
+  z_stream zs;
+  memset (&zs, 0, sizeof (zs));
+  inflateInit2 (&zs, -15 /* == raw deflate data*/);
+
+  zs.next_in = (Bytef *) deflated.c_str ();
+  zs.avail_in = (uInt) deflated.size ();
+
+  char buffer [16384];
+  while (zs.avail_in > 0) {
+    zs.next_out = (Bytef *) buffer;
+    zs.avail_out = sizeof (buffer);
+    int ret = inflate (&zs, Z_NO_FLUSH);
+    out.append (buffer, sizeof (buffer) - zs.avail_out);
+    if (ret == Z_STREAM_END) {
+      inflateReset (&zs);
+    } else if (ret != Z_OK) {
+      break;
+    }
+  }
+
+  inflateEnd (&zs);
+  return out;
+}
+
+//  Inflates a sequence of raw deflate streams with tl::InflateFilter
+static std::string tl_inflate (const std::string &deflated, const std::vector<size_t> &block_sizes)
+{
+  std::string out;
+
+  tl::InputMemoryStream ims (deflated.c_str (), deflated.size ());
+  tl::InputStream is (ims);
+
+  for (std::vector<size_t>::const_iterator b = block_sizes.begin (); b != block_sizes.end (); ++b) {
+    is.inflate ();
+    for (size_t p = 0; p < *b; p += 16384) {
+      size_t n = std::min (*b - p, size_t (16384));
+      const char *c = is.get (n);
+      if (! c) {
+        return out;
+      }
+      out.append (c, n);
+    }
+    //  makes the stream leave the compressed block
+    is.get (0);
+  }
+
+  return out;
+}
+
+//  Inflate throughput on OASIS data deflated in CBLOCK-like chunks compared to zlib
+TEST(5)
+{
+  std::string fn = tl::testsrc () + "/testdata/drc/drcSuiteTests_au3.oas";
+  tl::InputStream fs (fn);
+  std::string oas = fs.read_all ();
+
+  const size_t block_size = 65536;
+  std::vector<size_t> block_sizes;
+  std::string deflated;
+  for (size_t p = 0; p < oas.size (); p += block_size) {
+    block_sizes.push_back (std::min (block_size, oas.size () - p));
+    deflated += deflate_string (oas.substr (p, block_size));
+  }
+
+  const int repeat = 10;
+
+  tl::Timer timer_zlib;
+  timer_zlib.start ();
+  std::string out_zlib;
+  for (int i = 0; i < repeat; ++i) {
+    out_zlib = zlib_inflate (deflated);
+  }
+  timer_zlib.stop ();
+
+  tl::Timer timer_tl;
+  timer_tl.start ();
+  std::string out_tl;
+  for (int i = 0; i < repeat; ++i) {
+    out_tl = tl_inflate (deflated, block_sizes);
+  }
+  timer_tl.stop ();
+
+  EXPECT_EQ (out_zlib == oas, true);
+  EXPECT_EQ (out_tl == out_zlib, true);
+
+  tl::info << "Inflating " << oas.size () << " bytes " << repeat << " times: zlib " << timer_zlib.sec_wall () << "s, tl::InflateFilter " << timer_tl.sec_wall () << "s";
+}
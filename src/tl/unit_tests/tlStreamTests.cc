@@ -162,3 +162,84 @@ TEST(TextInputStream)
     EXPECT_EQ (tis.read_all (), "Hello, world!\nWith another line\n\nseparated by a LFCR and CRLF.");
   }
 }
+
+TEST(MemoryMappedFile)
+{
+  std::string fn = tmp_file ("test.bin");
+
+  {
+    tl::OutputStream os (fn, tl::OutputStream::OM_Plain);
+    for (int i = 0; i < 100000; ++i) {
+      os << tl::to_string (i % 10);
+    }
+  }
+
+  {
+    tl::InputStream is (fn);
+    EXPECT_EQ (is.is_direct (), true);
+
+    const char *b = is.get (3);
+    EXPECT_EQ (std::string (b, 3), "012");
+    EXPECT_EQ (is.pos (), size_t (3));
+
+    b = is.get (10000);
+    EXPECT_EQ (std::string (b, 4), "3456");
+    is.unget (10000);
+    EXPECT_EQ (is.pos (), size_t (3));
+
+    b = is.get (99997);
+    EXPECT_EQ (b != 0, true);
+    EXPECT_EQ (std::string (b + 99993, 4), "6789");
+    EXPECT_EQ (is.get (1) == 0, true);
+
+    is.reset ();
+    EXPECT_EQ (is.pos (), size_t (0));
+    EXPECT_EQ (is.read_all (5), "01234");
+    EXPECT_EQ (is.read_all ().size (), size_t (99995));
+  }
+
+  {
+    tl::InputMemoryMappedFile mf (fn);
+    EXPECT_EQ (mf.is_mapped (), true);
+    char b [4];
+    EXPECT_EQ (mf.read (b, sizeof (b)), sizeof (b));
+    EXPECT_EQ (std::string (b, sizeof (b)), "0123");
+  }
+}
+
+TEST(MemoryMappedFileCompressed)
+{
+  std::string fn = tmp_file ("test.txt.gz");
+
+  {
+    tl::OutputStream os (fn, tl::OutputStream::OM_Zlib);
+    os << "Hello, world!";
+  }
+
+  {
+    //  compressed files are not mapped
+    tl::InputMemoryMappedFile mf (fn);
+    EXPECT_EQ (mf.is_mapped (), false);
+  }
+
+  {
+    tl::InputStream is (fn);
+    EXPECT_EQ (is.is_direct (), false);
+    EXPECT_EQ (is.read_all (), "Hello, world!");
+  }
+}
+
+TEST(MemoryMappedFileEmpty)
+{
+  std::string fn = tmp_file ("empty.txt");
+
+  {
+    tl::OutputStream os (fn, tl::OutputStream::OM_Plain);
+  }
+
+  {
+    tl::InputStream is (fn);
+    EXPECT_EQ (is.is_direct (), false);
+    EXPECT_EQ (is.get (1) == 0, true);
+  }
+}
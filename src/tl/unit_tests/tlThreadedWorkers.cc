@@ -639,3 +639,168 @@ TEST(29)
   }
 }
 
+
+class OrderTask : public tl::Task
+{
+public:
+  OrderTask (int id) : m_id (id) { }
+  int m_id;
+};
+
+static tl::Mutex s_order_lock;
+static std::vector<int> s_order;
+
+class OrderWorker : public tl::Worker
+{
+public:
+  OrderWorker () : tl::Worker () { }
+
+protected:
+  void perform_task (tl::Task *task)
+  {
+    usleep (100);
+    tl::MutexLocker locker (&s_order_lock);
+    s_order.push_back (static_cast<OrderTask *> (task)->m_id);
+  }
+};
+
+static std::string order_string ()
+{
+  std::string s;
+  for (std::vector<int>::const_iterator i = s_order.begin (); i != s_order.end (); ++i) {
+    if (! s.empty ()) {
+      s += ",";
+    }
+    s += tl::to_string (*i);
+  }
+  return s;
+}
+
+//  priorities
+TEST(30)
+{
+  tl::Job<OrderWorker> job (0);
+
+  s_order.clear ();
+
+  for (int i = 0; i < 6; ++i) {
+    OrderTask *t = new OrderTask (i);
+    t->set_priority (i % 3);
+    job.schedule (t);
+  }
+
+  job.start ();
+  job.wait ();
+
+  EXPECT_EQ (order_string (), "2,5,1,4,0,3");
+}
+
+//  dependencies
+TEST(31)
+{
+  for (int nworkers = 0; nworkers <= 4; nworkers += 4) {
+
+    tl::Job<OrderWorker> job (nworkers);
+
+    for (int l = 0; l < 20; ++l) {
+
+      s_order.clear ();
+
+      //  a tree: 0 depends on 1..4, 1..4 depend on 5+4*(i-1)..8+4*(i-1)
+      std::vector<OrderTask *> tasks;
+      for (int i = 0; i < 21; ++i) {
+        tasks.push_back (new OrderTask (i));
+      }
+      for (int i = 1; i < 21; ++i) {
+        tasks [(i - 1) / 4]->add_dependency (tasks [i]);
+      }
+
+      //  schedule the top first to check it is held back
+      for (int i = 0; i < 21; ++i) {
+        job.schedule (tasks [i]);
+      }
+
+      job.start ();
+      job.wait ();
+
+      EXPECT_EQ (s_order.size (), size_t (21));
+      EXPECT_EQ (job.has_error (), false);
+
+      std::vector<int> pos (21, -1);
+      for (int i = 0; i < int (s_order.size ()); ++i) {
+        pos [s_order [i]] = i;
+      }
+      for (int i = 1; i < 21; ++i) {
+        EXPECT_EQ (pos [i] >= 0 && pos [i] < pos [(i - 1) / 4], true);
+      }
+
+    }
+
+  }
+}
+
+//  unresolved dependencies
+TEST(32)
+{
+  tl::Job<OrderWorker> job (2);
+
+  s_order.clear ();
+
+  OrderTask *a = new OrderTask (1);
+  OrderTask *b = new OrderTask (2);
+  a->add_dependency (b);
+  b->add_dependency (a);
+
+  job.schedule (a);
+  job.schedule (b);
+  job.schedule (new OrderTask (3));
+
+  job.start ();
+  job.wait ();
+
+  EXPECT_EQ (order_string (), "3");
+  EXPECT_EQ (job.has_error (), true);
+}
+
+//  thread affinity
+TEST(40)
+{
+  std::vector<std::vector<int> > nodes = tl::cpus_per_node ();
+
+  std::set<int> all_cpus;
+  for (std::vector<std::vector<int> >::const_iterator n = nodes.begin (); n != nodes.end (); ++n) {
+    all_cpus.insert (n->begin (), n->end ());
+  }
+
+  for (int spread = 0; spread < 2; ++spread) {
+
+    std::vector<int> cpus = tl::thread_affinity_layout (5, spread != 0);
+    if (nodes.empty ()) {
+      EXPECT_EQ (cpus.empty (), true);
+    } else {
+      EXPECT_EQ (cpus.size (), size_t (5));
+      for (std::vector<int>::const_iterator c = cpus.begin (); c != cpus.end (); ++c) {
+        EXPECT_EQ (all_cpus.find (*c) != all_cpus.end (), true);
+      }
+    }
+
+    MyJob job (4);
+    job.set_thread_affinity (cpus);
+    EXPECT_EQ (job.thread_affinity () == cpus, true);
+
+    s_sum[0].reset ();
+    s_sum[1].reset ();
+    s_sum[2].reset ();
+    s_sum[3].reset ();
+
+    for (int i = 0; i < 100; ++i) {
+      job.schedule (new MyTask (100));
+    }
+
+    job.start ();
+    job.wait ();
+
+    EXPECT_EQ (s_sum[0].sum () + s_sum[1].sum() + s_sum[2].sum() + s_sum[3].sum (), 10000);
+
+  }
+}